@@ -1,201 +1,176 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+
 #include "buffer/buffer_pool_manager.h"
 #include "glog/logging.h"
-#include "page/bitmap_page.h"
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
-        : pool_size_(pool_size), disk_manager_(disk_manager) {
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size_);
-  for (size_t i = 0; i < pool_size_; i++) {
-    free_list_.emplace_back(i);
+BufferPoolManager::~BufferPoolManager() {
+  StopWarmUp();
+  StopPrefetcher();
+}
+
+bool BufferPoolManager::FlushLogFor(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  if(log_manager_ == nullptr){
+    return true;
+  }
+  lsn_t max_lsn = INVALID_LSN;
+  for(auto &page : pages){
+    lsn_t lsn;
+    memcpy(&lsn, page.second + Page::OFFSET_LSN, sizeof(lsn_t));
+    max_lsn = std::max(max_lsn, lsn);
   }
+  return log_manager_->Flush(max_lsn);
 }
 
-BufferPoolManager::~BufferPoolManager() {
-  FlushAllPage();
-  delete[] pages_;//maybe unused?
-  delete replacer_;
+void BufferPoolManager::PrefetchChain(page_id_t page_id, size_t depth, std::function<page_id_t(Page *)> next_page_id,
+                                      std::shared_ptr<BufferRing> ring) {
+  if(page_id == INVALID_PAGE_ID || depth == 0){
+    return;
+  }
+  std::scoped_lock<std::mutex> lock(prefetch_mutex_);
+  if(!prefetcher_running_){
+    prefetcher_running_ = true;
+    prefetcher_ = std::thread(&BufferPoolManager::PrefetcherLoop, this);
+  }
+  // a scan which has moved on does not need its old hints any more
+  if(prefetch_queue_.size() >= static_cast<size_t>(PREFETCH_QUEUE_SIZE)){
+    prefetch_queue_.pop_front();
+  }
+  prefetch_queue_.push_back({page_id, depth, std::move(next_page_id), std::move(ring)});
+  prefetch_cv_.notify_one();
 }
 
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-  // 1.     Search the page table for the requested page (P).
-  latch_.lock();
-  auto table_iter = page_table_.find(page_id);
-  // 1.1    If P exists, pin it and return it immediately.
-  if(table_iter != page_table_.end()){
-    frame_id_t frame_id = table_iter->second;
-    replacer_->Pin(frame_id);
-    Page *page = &pages_[frame_id];
-    page->pin_count_++;
-    latch_.unlock();
-    return page;
-  }
-  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  //        Note that pages are always found from the free list first.
-  else{
-    frame_id_t replace_frame_id;
-    if(!free_list_.empty()){//find a free page (R) from the free list
-      replace_frame_id = free_list_.front();
-      free_list_.pop_front();
-    }
-    else if(replacer_->Victim(&replace_frame_id)){//find a replacement page (R) from the replacer
-      // 2.     If R is dirty, write it back to the disk.
-      if(pages_[replace_frame_id].IsDirty())
-        FlushPage(pages_[replace_frame_id].GetPageId());
-      // 3.     Delete R from the page table and insert P.
-      //latch?
-    }
-    else{
-      LOG(INFO)<<"Cna't find a replacement page"<<std::endl;
-      latch_.unlock();
-      return nullptr;
+void BufferPoolManager::StopPrefetcher() {
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_mutex_);
+    if(!prefetcher_running_){
+      return;
     }
-    //use pageid to erase
-    page_table_.erase(pages_[replace_frame_id].GetPageId());
-    page_table_.emplace(page_id, replace_frame_id);
-    // 4.     Update P's metadata
-    Page *page = &pages_[replace_frame_id];
-    page->page_id_ = page_id;
-    page->pin_count_ = 0;
-    page->is_dirty_ = false;
-    page->pin_count_++;
-    //read in the page content from disk
-    disk_manager_->ReadPage(page_id, page->data_);
-    replacer_->Pin(replace_frame_id);
-    //return a pointer to P.
-    latch_.unlock();
-    return page;
+    prefetcher_running_ = false;
+    prefetch_queue_.clear();
   }
+  prefetch_cv_.notify_all();
+  prefetcher_.join();
 }
 
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-  latch_.lock();
-  // 1.   If all the pages in the buffer pool are pinned, return nullptr.
-  if(CheckAllPinned()){
-    LOG(INFO)<<"All pinned"<<std::endl;
-    latch_.unlock();
-    return nullptr;
-  }
-  page_id_t n_page_id = AllocatePage();
-  if(n_page_id == INVALID_PAGE_ID){
-    LOG(INFO)<<"AllocatePage failed"<<std::endl;
-    latch_.unlock();
-    return nullptr;
-  }
-  //debug
-  //LOG(INFO)<<"page_id: "<<n_page_id<<endl;
-  // 2.   Pick a victim page P from either the free list or the replacer.
-  // Always pick from the free list first.
-  frame_id_t frame_id;
-  if(!free_list_.empty()){//find a replacement page (P) from the free list
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  }
-  else if(replacer_->Victim(&frame_id)){//find a replacement page (P) from the replacer
-    if(pages_[frame_id].IsDirty()) FlushPage(pages_[frame_id].GetPageId());
-    // 3.   Update P's metadata, zero out memory and add P to the page table.
-  }
-  else{
-    DeallocatePage(n_page_id);
-    latch_.unlock();
-    return nullptr;
-  }
-  page_table_.erase(pages_[frame_id].GetPageId());
-  page_table_.emplace(n_page_id, frame_id);
-  Page *page = &pages_[frame_id];
-  page->ResetMemory();
-  page->is_dirty_ = false;
-  page->pin_count_ = 1;
-  page->page_id_ = n_page_id;
-  replacer_->Pin(frame_id);
-  //FlushPage(n_page_id);
-  // 4.   Set the page ID output parameter. Return a pointer to P.
-  page_id = n_page_id;
-  latch_.unlock();
-  return page;
+void BufferPoolManager::PrefetcherLoop() {
+  std::unique_lock<std::mutex> lock(prefetch_mutex_);
+  while(true){
+    prefetch_cv_.wait(lock, [this] { return !prefetcher_running_ || !prefetch_queue_.empty(); });
+    if(!prefetcher_running_){
+      break;
+    }
+    PrefetchRequest request = std::move(prefetch_queue_.front());
+    prefetch_queue_.pop_front();
+    lock.unlock();
+    page_id_t page_id = request.page_id;
+    for(size_t i = 0; i < request.depth && page_id != INVALID_PAGE_ID; i++){
+      page_id = ReadAhead(page_id, request.next_page_id, request.ring.get());
+    }
+    lock.lock();
+  }
 }
 
-bool BufferPoolManager::DeletePage(page_id_t page_id) {
-  latch_.lock();
-    // 1.   Search the page table for the requested page (P).
-  auto table_iter = page_table_.find(page_id);
-  // 1.   If P does not exist, return true.
-  if(table_iter == page_table_.end()) {
-    latch_.unlock();
-    return true;
+bool BufferPoolManager::DumpResidentPages(const std::string &file_name) {
+  std::vector<page_id_t> page_ids = GetResidentPages();
+  std::vector<char> buf(2 * sizeof(uint32_t) + page_ids.size() * sizeof(page_id_t));
+  uint32_t magic = WARM_UP_DUMP_MAGIC;
+  uint32_t count = page_ids.size();
+  memcpy(buf.data(), &magic, sizeof(magic));
+  memcpy(buf.data() + sizeof(magic), &count, sizeof(count));
+  memcpy(buf.data() + 2 * sizeof(uint32_t), page_ids.data(), count * sizeof(page_id_t));
+  // write a new file and rename it, so that a crash never leaves a torn dump behind. The file is synced before the
+  // rename, and its directory after, otherwise the rename may reach the disk before the content or not at all.
+  std::string tmp_file_name = file_name + ".tmp";
+  int fd = open(tmp_file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0){
+    LOG(ERROR)<<"Can't open buffer pool dump "<<tmp_file_name<<std::endl;
+    return false;
   }
-  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-  if(pages_[page_table_[page_id]].GetPinCount() != 0) {
-    latch_.unlock();
+  size_t written = 0;
+  while(written < buf.size()){
+    ssize_t n = write(fd, buf.data() + written, buf.size() - written);
+    if(n < 0 && errno == EINTR){
+      continue;
+    }
+    if(n <= 0){
+      break;
+    }
+    written += n;
+  }
+  bool ok = written == buf.size() && fsync(fd) == 0;
+  ok = close(fd) == 0 && ok;
+  if(!ok){
+    LOG(ERROR)<<"Can't write buffer pool dump "<<tmp_file_name<<std::endl;
+    remove(tmp_file_name.c_str());
     return false;
   }
-  // 0.   Make sure you call DeallocatePage!
-  DeallocatePage(page_id);
-  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  frame_id_t frame_id = page_table_[page_id];
-  page_table_.erase(page_id);
-  free_list_.emplace_back(frame_id);
-  //Update P's metadata
-  pages_[frame_id].ResetMemory();
-  pages_[frame_id].page_id_ = INVALID_PAGE_ID;
-  pages_[frame_id].is_dirty_ = false;
-  pages_[frame_id].pin_count_ = 0;
-  latch_.unlock();
-  return true;
+  if(rename(tmp_file_name.c_str(), file_name.c_str()) != 0){
+    return false;
+  }
+  size_t slash = file_name.find_last_of('/');
+  std::string dir_name = slash == std::string::npos ? "." : file_name.substr(0, std::max<size_t>(slash, 1));
+  int dir_fd = open(dir_name.c_str(), O_RDONLY | O_DIRECTORY);
+  if(dir_fd < 0){
+    return false;
+  }
+  ok = fsync(dir_fd) == 0;
+  close(dir_fd);
+  return ok;
 }
 
-bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  latch_.lock();
-  auto table_iter = page_table_.find(page_id);
-  if(table_iter != page_table_.end()){
-    frame_id_t frame_id = table_iter->second;
-    if(is_dirty) pages_[frame_id].is_dirty_ = true;
-    if(pages_[frame_id].GetPinCount() == 0){
-      //this page has been moved into replacer
-      latch_.unlock();
-      return false;
+size_t BufferPoolManager::WarmUp(const std::string &file_name) {
+  std::ifstream in(file_name, std::ios::binary);
+  if(!in.is_open()){
+    return 0;
+  }
+  uint32_t magic = 0, count = 0;
+  in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  in.read(reinterpret_cast<char *>(&count), sizeof(count));
+  if(!in.good() || magic != WARM_UP_DUMP_MAGIC){
+    LOG(WARNING)<<"Ignore invalid buffer pool dump "<<file_name<<std::endl;
+    return 0;
+  }
+  std::vector<page_id_t> page_ids(count);
+  in.read(reinterpret_cast<char *>(page_ids.data()), count * sizeof(page_id_t));
+  if(!in.good()){
+    LOG(WARNING)<<"Ignore truncated buffer pool dump "<<file_name<<std::endl;
+    return 0;
+  }
+  // keep the most recently used pages which fit in the free frames, and read them in the order of their offsets
+  BufferPoolStats stats = GetStats();
+  size_t free_frames = stats.pool_size - stats.resident_pages;
+  if(page_ids.size() > free_frames){
+    page_ids.resize(free_frames);
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  StopWarmUp();
+  warmer_running_ = true;
+  warmer_ = std::thread([this, page_ids] {
+    std::unique_ptr<PageIOQueue> io_queue = disk_manager_->NewIOQueue();
+    size_t window = io_queue->GetQueueDepth();
+    for(size_t begin = 0; begin < page_ids.size() && warmer_running_; begin += window){
+      size_t end = std::min(page_ids.size(), begin + window);
+      ReadAheadPages(std::vector<page_id_t>(page_ids.begin() + begin, page_ids.begin() + end), io_queue.get());
     }
-    pages_[frame_id].pin_count_--;
-    if(pages_[frame_id].GetPinCount() == 0)
-    //need to add into replacer
-      replacer_->Unpin(frame_id);
-    latch_.unlock();
-    return true;
-  }
-  latch_.unlock();
-  return false;
+  });
+  return page_ids.size();
 }
 
-bool BufferPoolManager::FlushPage(page_id_t page_id) {//write back
-  latch_.lock();
-  auto table_iter = page_table_.find(page_id);
-  if(table_iter == page_table_.end() || page_id==INVALID_PAGE_ID) {
-    latch_.unlock();
-    return false;
+void BufferPoolManager::WaitForWarmUp() {
+  if(warmer_.joinable()){
+    warmer_.join();
   }
-  disk_manager_->WritePage(page_id, pages_[table_iter->second].GetData());
-  latch_.unlock();
-  return true;
 }
 
-bool BufferPoolManager::FlushAllPage() {
-  latch_.lock();
-  if(page_table_.empty()) {
-    latch_.unlock();
-    return false;
-  }
-  auto iter = page_table_.begin();
-  while(true){
-    if(iter == page_table_.end()) break;
-    if(FlushPage(iter->first));
-    else{
-      latch_.unlock();
-      return false;
-    }
-    iter++;
-  }
-  latch_.unlock();
-  return true;
+void BufferPoolManager::StopWarmUp() {
+  warmer_running_ = false;
+  WaitForWarmUp();
 }
 
 page_id_t BufferPoolManager::AllocatePage() {
@@ -210,28 +185,3 @@ void BufferPoolManager::DeallocatePage(page_id_t page_id) {
 bool BufferPoolManager::IsPageFree(page_id_t page_id) {
   return disk_manager_->IsPageFree(page_id);
 }
-
-
-// Only used for debug
-bool BufferPoolManager::CheckAllPinned() {
-  bool res = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].pin_count_ == 0) {
-      res = false;
-      break;
-    }
-  }
-  return res;
-}
-
-// Only used for debug
-bool BufferPoolManager::CheckAllUnpinned() {
-  bool res = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].pin_count_ != 0) {
-      res = false;
-      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
-    }
-  }
-  return res;
-}
\ No newline at end of file
@@ -0,0 +1,854 @@
+#include <algorithm>
+#include <chrono>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "glog/logging.h"
+#include "page/bitmap_page.h"
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                                     ReplacerType replacer_type)
+        : BufferPoolManager(disk_manager), pool_size_(pool_size), page_table_(pool_size), replacer_type_(replacer_type) {
+  for (size_t i = 0; i < pool_size_; i++) {
+    pages_.emplace_back();
+  }
+  replacer_ = NewReplacer(pool_size_);
+  for (size_t i = 0; i < pool_size_; i++) {
+    free_list_.emplace_back(i);
+  }
+  unpinned_frames_.store(pool_size_);
+  last_unpinned_.resize(pool_size_, 0);
+  pin_started_.resize(pool_size_);
+  pin_lsn_.resize(pool_size_, INVALID_LSN);
+  flush_states_.reset(new std::atomic<uint8_t>[pool_size_]);
+  for (size_t i = 0; i < pool_size_; i++) {
+    flush_states_[i].store(kFlushNone);
+  }
+}
+
+BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  StopWarmUp();
+  StopPrefetcher();
+  StopFlusher();
+  FlushAllPage();
+  delete replacer_;
+}
+
+Replacer *BufferPoolManagerInstance::NewReplacer(size_t num_pages) {
+  switch (replacer_type_) {
+    case kLRUKReplacer:
+      return new LRUKReplacer(num_pages);
+    case kClockReplacer:
+      return new ClockReplacer(num_pages);
+    case kLRUReplacer:
+    default:
+      return new LRUReplacer(num_pages);
+  }
+}
+
+bool BufferPoolManagerInstance::Resize(size_t pool_size) {
+  if(pool_size == 0){
+    return false;
+  }
+  // The flusher and the prefetcher work on frames without holding the latch, let them go while the frames change.
+  bool flusher_running;
+  size_t low_watermark, high_watermark;
+  {
+    std::scoped_lock<std::mutex> lock(flusher_mutex_);
+    flusher_running = flusher_running_;
+    low_watermark = low_watermark_;
+    high_watermark = high_watermark_;
+  }
+  StopFlusher();
+  StopPrefetcher();
+  size_t old_size;
+  {
+    std::scoped_lock<recursive_mutex> lock(latch_);
+    old_size = pool_size_;
+    if(pool_size < old_size){
+      ShrinkFrames(pool_size);
+    } else {
+      GrowFrames(pool_size);
+    }
+  }
+  if(flusher_running){
+    StartFlusher(low_watermark * pool_size / old_size, high_watermark * pool_size / old_size);
+  }
+  return true;
+}
+
+void BufferPoolManagerInstance::GrowFrames(size_t pool_size) {
+  for (size_t i = pool_size_; i < pool_size; i++) {
+    if(i == pages_.size()){
+      pages_.emplace_back();
+    }
+    // a frame dropped by an earlier shrink may still hold a pinned page, or a dirty one which could not be written
+    // back, it is back in the pool with it
+    if(pages_[i].page_id_ != INVALID_PAGE_ID){
+      draining_frames_--;
+      if(pages_[i].pin_count_ == 0){
+        unpinned_frames_++;
+      }
+      continue;
+    }
+    free_list_.emplace_back(i);
+    unpinned_frames_++;
+  }
+  ResizeFrameState(pool_size);
+}
+
+void BufferPoolManagerInstance::ShrinkFrames(size_t pool_size) {
+  // The Page objects of the dropped frames are kept, a caller may still hold a pointer to one of them, and a later
+  // grow takes them back.
+  for (size_t i = pool_size; i < pool_size_; i++) {
+    Page *page = &pages_[i];
+    if(page->page_id_ == INVALID_PAGE_ID){
+      unpinned_frames_--;
+      continue;
+    }
+    // 1.   A pinned page stays where it is until its last unpin, see RetireFrame.
+    if(page->pin_count_ > 0){
+      draining_frames_++;
+      continue;
+    }
+    // 2.   Evict the other pages, writing back the dirty ones. A dirty page which can't be written stays in its
+    //      frame like a pinned one.
+    unpinned_frames_--;
+    if(page->IsDirty() && !FlushPage(page->page_id_)){
+      draining_frames_++;
+      continue;
+    }
+    page_table_.Erase(page->page_id_);
+    page->page_id_ = INVALID_PAGE_ID;
+    evictions_++;
+  }
+  free_list_.remove_if([pool_size](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= pool_size; });
+  ResizeFrameState(pool_size);
+}
+
+void BufferPoolManagerInstance::RetireFrame(frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  if(page->IsDirty() && !FlushPage(page->page_id_)){
+    // tried again on the next last unpin
+    return;
+  }
+  page_table_.Erase(page->page_id_);
+  page->page_id_ = INVALID_PAGE_ID;
+  draining_frames_--;
+  evictions_++;
+}
+
+void BufferPoolManagerInstance::ResizeFrameState(size_t pool_size) {
+  // Everything kept per frame covers the dropped frames too, they may still hold a pinned page.
+  size_t num_frames = pages_.size();
+  size_t old_frames = last_unpinned_.size();
+  pool_size_ = pool_size;
+  page_table_.Resize(num_frames);
+  last_unpinned_.resize(num_frames, 0);
+  pin_started_.resize(num_frames);
+  pin_lsn_.resize(num_frames, INVALID_LSN);
+  if(num_frames != old_frames){
+    std::unique_ptr<std::atomic<uint8_t>[]> flush_states(new std::atomic<uint8_t>[num_frames]);
+    for (size_t i = 0; i < num_frames; i++) {
+      flush_states[i].store(i < old_frames ? flush_states_[i].load() : static_cast<uint8_t>(kFlushNone));
+    }
+    flush_states_ = std::move(flush_states);
+  }
+  // A new replacer tracks the frame ids in the new range, the evictable frames are handed over in the order they
+  // were unpinned, which is all an LRU order needs. The access history kept by LRU-K starts over.
+  std::vector<frame_id_t> evictable;
+  for (size_t i = 0; i < pool_size_; i++) {
+    if(pages_[i].page_id_ != INVALID_PAGE_ID && pages_[i].pin_count_ == 0){
+      evictable.push_back(i);
+    }
+  }
+  std::sort(evictable.begin(), evictable.end(), [this](frame_id_t a, frame_id_t b) {
+    return last_unpinned_[a] < last_unpinned_[b];
+  });
+  delete replacer_;
+  replacer_ = NewReplacer(pool_size_);
+  for (auto frame_id : evictable) {
+    replacer_->Unpin(frame_id);
+  }
+}
+
+Page *BufferPoolManagerInstance::FetchPage(page_id_t page_id, BufferRing *ring) {
+  // 1.     Search the page table for the requested page (P).
+  LockLatch();
+  frame_id_t frame_id;
+  // 1.1    If P exists, pin it and return it immediately.
+  if(page_table_.Find(page_id, &frame_id)){
+    CancelBackgroundFlush(frame_id);
+    // a frame dropped by a shrink is not tracked by the replacer
+    if(static_cast<size_t>(frame_id) < pool_size_){
+      replacer_->Pin(frame_id);
+    }
+    Page *page = &pages_[frame_id];
+    if(page->pin_count_++ == 0){
+      StartPin(frame_id);
+      // a dropped frame is not counted as unpinned
+      if(static_cast<size_t>(frame_id) < pool_size_){
+        unpinned_frames_--;
+      }
+    }
+    hits_++;
+    latch_.unlock();
+    return page;
+  }
+  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
+  //        Note that pages are always found from the free list first.
+  else{
+    frame_id_t replace_frame_id;
+    // 2.     If R is dirty, write it back to the disk.
+    // 3.     Delete R from the page table and insert P.
+    bool found = ring == nullptr ? FindReplaceFrame(replace_frame_id) : FindRingFrame(ring, page_id, replace_frame_id);
+    if(!found){
+      LOG(INFO)<<"Cna't find a replacement page"<<std::endl;
+      latch_.unlock();
+      return nullptr;
+    }
+    misses_++;
+    page_table_.Insert(page_id, replace_frame_id);
+    // 4.     Update P's metadata
+    Page *page = &pages_[replace_frame_id];
+    page->page_id_ = page_id;
+    page->pin_count_ = 0;
+    page->is_dirty_ = false;
+    page->pin_count_++;
+    //read in the page content from disk
+    disk_manager_->ReadPage(page_id, page->data_);
+    replacer_->Pin(replace_frame_id);
+    StartPin(replace_frame_id);
+    unpinned_frames_--;
+    //return a pointer to P.
+    latch_.unlock();
+    return page;
+  }
+}
+
+Page *BufferPoolManagerInstance::NewPage(page_id_t &page_id) {
+  LockLatch();
+  // 1.   If all the pages in the buffer pool are pinned, return nullptr.
+  if(CheckAllPinned()){
+    LOG(INFO)<<"All pinned"<<std::endl;
+    new_page_failures_++;
+    latch_.unlock();
+    return nullptr;
+  }
+  page_id_t n_page_id = AllocatePage();
+  if(n_page_id == INVALID_PAGE_ID){
+    LOG(INFO)<<"AllocatePage failed"<<std::endl;
+    new_page_failures_++;
+    latch_.unlock();
+    return nullptr;
+  }
+  //debug
+  //LOG(INFO)<<"page_id: "<<n_page_id<<endl;
+  Page *page = NewPageFrame(n_page_id);
+  if(page == nullptr){
+    DeallocatePage(n_page_id);
+    new_page_failures_++;
+    latch_.unlock();
+    return nullptr;
+  }
+  // 4.   Set the page ID output parameter. Return a pointer to P.
+  page_id = n_page_id;
+  latch_.unlock();
+  return page;
+}
+
+Page *BufferPoolManagerInstance::NewPageFrame(page_id_t page_id) {
+  std::scoped_lock<recursive_mutex> lock(latch_);
+  // 2.   Pick a victim page P from either the free list or the replacer.
+  // Always pick from the free list first.
+  // 3.   Update P's metadata, zero out memory and add P to the page table.
+  frame_id_t frame_id;
+  if(!FindReplaceFrame(frame_id)){
+    return nullptr;
+  }
+  page_table_.Insert(page_id, frame_id);
+  Page *page = &pages_[frame_id];
+  page->ResetMemory();
+  page->is_dirty_ = false;
+  page->pin_count_ = 1;
+  page->page_id_ = page_id;
+  replacer_->Pin(frame_id);
+  StartPin(frame_id);
+  unpinned_frames_--;
+  //FlushPage(n_page_id);
+  return page;
+}
+
+bool BufferPoolManagerInstance::DeletePage(page_id_t page_id) {
+  LockLatch();
+    // 1.   Search the page table for the requested page (P).
+  frame_id_t frame_id;
+  // 1.   If P does not exist, return true.
+  if(!page_table_.Find(page_id, &frame_id)) {
+    latch_.unlock();
+    return true;
+  }
+  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
+  if(pages_[frame_id].GetPinCount() != 0) {
+    latch_.unlock();
+    return false;
+  }
+  // 0.   Make sure you call DeallocatePage!
+  DeallocatePage(page_id);
+  WriteEpoch(page_id)++;
+  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
+  CancelBackgroundFlush(frame_id);
+  page_table_.Erase(page_id);
+  if(static_cast<size_t>(frame_id) < pool_size_){
+    free_list_.emplace_back(frame_id);
+  } else {
+    // a dirty page which could not be written back when its frame was dropped, the frame is retired now
+    draining_frames_--;
+  }
+  //Update P's metadata
+  MarkClean(frame_id);
+  pages_[frame_id].ResetMemory();
+  pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+  pages_[frame_id].pin_count_ = 0;
+  latch_.unlock();
+  return true;
+}
+
+bool BufferPoolManagerInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  LockLatch();
+  frame_id_t frame_id;
+  if(page_table_.Find(page_id, &frame_id)){
+    if(is_dirty) MarkDirty(frame_id);
+    if(pages_[frame_id].GetPinCount() == 0){
+      //this page has been moved into replacer
+      latch_.unlock();
+      return false;
+    }
+    pages_[frame_id].pin_count_--;
+    if(pages_[frame_id].GetPinCount() == 0 && static_cast<size_t>(frame_id) >= pool_size_){
+      //the frame has been dropped by a shrink meanwhile
+      RecordPinDuration(frame_id);
+      RetireFrame(frame_id);
+    } else if(pages_[frame_id].GetPinCount() == 0){
+      //need to add into replacer
+      replacer_->Unpin(frame_id);
+      last_unpinned_[frame_id] = ++unpin_clock_;
+      RecordPinDuration(frame_id);
+      unpinned_frames_++;
+    }
+    latch_.unlock();
+    return true;
+  }
+  latch_.unlock();
+  return false;
+}
+
+bool BufferPoolManagerInstance::FlushPage(page_id_t page_id) {//write back
+  LockLatch();
+  frame_id_t frame_id;
+  if(page_id==INVALID_PAGE_ID || !page_table_.Find(page_id, &frame_id)) {
+    latch_.unlock();
+    return false;
+  }
+  CancelBackgroundFlush(frame_id);
+  // an older snapshot being written by the flusher must not land after this write
+  WaitForBackgroundWrite(page_id);
+  if(log_manager_ != nullptr && !log_manager_->Flush(pages_[frame_id].GetLSN())){
+    latch_.unlock();
+    return false;
+  }
+  disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
+  WriteEpoch(page_id)++;
+  if(pages_[frame_id].IsDirty()){
+    dirty_writebacks_++;
+  }
+  MarkClean(frame_id);
+  latch_.unlock();
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushAllPage() {
+  std::scoped_lock<recursive_mutex> lock(latch_);
+  if(page_table_.Empty()) {
+    return false;
+  }
+  // Only the dirty pages need to be written, the disk manager sorts them by their offset in the file
+  // and writes adjacent ones together.
+  std::vector<std::pair<page_id_t, const char *>> dirty_pages;
+  CollectCheckpointPages(dirty_pages);
+  if(!FlushLogFor(dirty_pages)){
+    return false;
+  }
+  disk_manager_->WritePages(std::move(dirty_pages));
+  CleanCheckpointPages();
+  return true;
+}
+
+void BufferPoolManagerInstance::CollectCheckpointPages(std::vector<std::pair<page_id_t, const char *>> &pages) {
+  std::scoped_lock<recursive_mutex> lock(latch_);
+  for(size_t i = 0; i < pages_.size(); i++){
+    Page *page = &pages_[i];
+    // a pinned page may have been modified without being reported yet
+    if(page->page_id_ != INVALID_PAGE_ID && (page->is_dirty_ || page->pin_count_ > 0)){
+      CancelBackgroundFlush(i);
+      WaitForBackgroundWrite(page->page_id_);
+      if(page->is_dirty_){
+        dirty_writebacks_++;
+      }
+      // the latch is held until the pages are written, no read ahead can check the epoch in between
+      WriteEpoch(page->page_id_)++;
+      pages.emplace_back(page->page_id_, page->GetData());
+    }
+  }
+}
+
+void BufferPoolManagerInstance::CleanCheckpointPages() {
+  std::scoped_lock<recursive_mutex> lock(latch_);
+  for(size_t i = 0; i < pages_.size(); i++){
+    if(pages_[i].pin_count_ == 0){
+      MarkClean(i);
+    }
+  }
+}
+
+std::unordered_map<page_id_t, uint64_t> BufferPoolManagerInstance::GetDirtyPageTable() {
+  std::scoped_lock<recursive_mutex> lock(latch_);
+  std::unordered_map<page_id_t, uint64_t> dirty_pages = dirty_page_table_;
+  if(log_manager_ != nullptr){
+    // a page is marked dirty when it is unpinned, the changes logged while it is pinned may already be in it
+    for(size_t i = 0; i < pages_.size(); i++){
+      if(pages_[i].pin_count_ > 0 && !pages_[i].is_dirty_){
+        dirty_pages.emplace(pages_[i].page_id_, pin_lsn_[i]);
+      }
+    }
+  }
+  return dirty_pages;
+}
+
+void BufferPoolManagerInstance::MarkDirty(frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  if(!page->is_dirty_){
+    page->is_dirty_ = true;
+    // the changes made since the page was pinned are not on the disk, they all have a larger LSN
+    dirty_page_table_.emplace(page->page_id_, log_manager_ != nullptr ? pin_lsn_[frame_id] : ++dirty_clock_);
+  }
+}
+
+void BufferPoolManagerInstance::MarkClean(frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  if(page->is_dirty_){
+    page->is_dirty_ = false;
+    dirty_page_table_.erase(page->page_id_);
+  }
+  // a page still pinned is on the disk as it is now, only its later changes can dirty it again
+  if(page->pin_count_ > 0 && log_manager_ != nullptr){
+    pin_lsn_[frame_id] = log_manager_->GetNextLSN();
+  }
+}
+
+BufferPoolStats BufferPoolManagerInstance::GetStats() {
+  BufferPoolStats stats;
+  {
+    std::scoped_lock<recursive_mutex> lock(latch_);
+    stats.pool_size = pool_size_;
+    stats.resident_pages = page_table_.Size();
+    stats.dirty_pages = dirty_page_table_.size();
+    stats.pinned_pages = pool_size_ - unpinned_frames_.load() + draining_frames_;
+  }
+  stats.hits = hits_.load();
+  stats.misses = misses_.load();
+  stats.evictions = evictions_.load();
+  stats.dirty_writebacks = dirty_writebacks_.load();
+  stats.foreground_flushes = foreground_flushes_.load();
+  stats.background_flushes = background_flushes_.load();
+  stats.prefetched_pages = prefetched_pages_.load();
+  stats.new_page_failures = new_page_failures_.load();
+  stats.latch_wait_ns = latch_wait_ns_.load();
+  for(size_t i = 0; i < PIN_HISTOGRAM_BUCKETS; i++){
+    stats.pin_duration_histogram[i] = pin_histogram_[i].load();
+  }
+  return stats;
+}
+
+void BufferPoolManagerInstance::LockLatch() {
+  if(latch_.try_lock()){
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  latch_.lock();
+  latch_wait_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BufferPoolManagerInstance::StartPin(frame_id_t frame_id) {
+  pin_started_[frame_id] = std::chrono::steady_clock::now();
+  pin_lsn_[frame_id] = log_manager_ != nullptr ? log_manager_->GetNextLSN() : INVALID_LSN;
+}
+
+void BufferPoolManagerInstance::RecordPinDuration(frame_id_t frame_id) {
+  auto duration = std::chrono::steady_clock::now() - pin_started_[frame_id];
+  uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  pin_histogram_[BufferPoolStats::GetPinBucket(us)]++;
+}
+
+bool BufferPoolManagerInstance::FindReplaceFrame(frame_id_t &frame_id, bool foreground) {
+  std::scoped_lock<recursive_mutex> lock(latch_);
+  if(unpinned_frames_.load() == 0){//every frame is pinned, neither a free frame nor a victim exists
+    return false;
+  }
+  if(!free_list_.empty()){//find a free page from the free list
+    frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  }
+  if(!replacer_->Victim(&frame_id)){//find a replacement page from the replacer
+    return false;
+  }
+  Page *victim = &pages_[frame_id];
+  if(victim->IsDirty()){
+    // the background flusher did not catch up, write it back now
+    if(foreground){
+      foreground_flushes_++;
+    }
+    flusher_cv_.notify_one();
+    if(!FlushPage(victim->GetPageId())){
+      // the page can't be written before its log, it stays
+      replacer_->Unpin(frame_id);
+      return false;
+    }
+  }
+  evictions_++;
+  //use pageid to erase
+  page_table_.Erase(victim->GetPageId());
+  return true;
+}
+
+bool BufferPoolManagerInstance::FindRingFrame(BufferRing *ring, page_id_t page_id, frame_id_t &frame_id) {
+  std::scoped_lock<recursive_mutex> lock(latch_);
+  auto &slots = ring->GetSlots(this);
+  if(slots.slots.size() < ring->GetSize()){
+    // the ring grows with frames taken from the buffer pool
+    if(!FindReplaceFrame(frame_id)){
+      return false;
+    }
+    slots.slots.push_back({frame_id, page_id});
+    return true;
+  }
+  auto &slot = slots.slots[slots.next];
+  Page *page = static_cast<size_t>(slot.frame_id) < pool_size_ ? &pages_[slot.frame_id] : nullptr;
+  if(page != nullptr && page->page_id_ == slot.page_id && page->pin_count_ == 0){
+    // recycle the oldest page of the ring, the caller pins the frame which takes it out of the replacer
+    if(page->IsDirty() && !FlushPage(page->page_id_)){
+      return false;
+    }
+    frame_id = slot.frame_id;
+    evictions_++;
+    page_table_.Erase(page->page_id_);
+  } else if(!FindReplaceFrame(frame_id)){
+    // the frame has been taken by somebody else, replace it with another one
+    return false;
+  }
+  slot = {frame_id, page_id};
+  slots.next = (slots.next + 1) % slots.slots.size();
+  return true;
+}
+
+void BufferPoolManagerInstance::CancelBackgroundFlush(frame_id_t frame_id) {
+  if(flush_states_[frame_id].load() == kFlushNone){
+    return;
+  }
+  std::scoped_lock<std::mutex> lock(flush_io_latch_);
+  flush_states_[frame_id].store(kFlushCancelled);
+}
+
+void BufferPoolManagerInstance::WaitForBackgroundWrite(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(flush_io_latch_);
+  flush_io_cv_.wait(lock, [this, page_id] { return flush_in_flight_.count(page_id) == 0; });
+}
+
+void BufferPoolManagerInstance::StartFlusher(size_t low_watermark, size_t high_watermark) {
+  StopFlusher();
+  std::scoped_lock<std::mutex> lock(flusher_mutex_);
+  low_watermark_ = low_watermark;
+  high_watermark_ = std::max(low_watermark, high_watermark);
+  flusher_running_ = true;
+  flusher_ = std::thread(&BufferPoolManagerInstance::FlusherLoop, this);
+}
+
+void BufferPoolManagerInstance::StopFlusher() {
+  {
+    std::scoped_lock<std::mutex> lock(flusher_mutex_);
+    if(!flusher_running_){
+      return;
+    }
+    flusher_running_ = false;
+  }
+  flusher_cv_.notify_all();
+  flusher_.join();
+}
+
+void BufferPoolManagerInstance::FlusherLoop() {
+  std::unique_ptr<PageIOQueue> io_queue = disk_manager_->NewIOQueue();
+  std::unique_lock<std::mutex> lock(flusher_mutex_);
+  while(flusher_running_){
+    flusher_cv_.wait_for(lock, std::chrono::milliseconds(FLUSHER_INTERVAL_MS));
+    if(!flusher_running_){
+      break;
+    }
+    lock.unlock();
+    BackgroundFlush(io_queue.get());
+    lock.lock();
+  }
+}
+
+void BufferPoolManagerInstance::BackgroundFlush(PageIOQueue *io_queue) {
+  // 1.   Look at the frames the replacer is going to evict next, a few of them at a time under the latch, so that the
+  //      flusher neither scans the whole pool nor holds up the fetches for long. The pages which will be written back
+  //      are the ones which would be written back in the foreground otherwise.
+  std::vector<frame_id_t> next_victims = replacer_->NextVictims(high_watermark_);
+  size_t clean_frames;
+  {
+    std::scoped_lock<recursive_mutex> lock(latch_);
+    clean_frames = free_list_.size();
+  }
+  std::vector<frame_id_t> dirty_frames;
+  for(size_t begin = 0; begin < next_victims.size(); begin += FLUSHER_SCAN_BATCH){
+    size_t end = std::min(next_victims.size(), begin + FLUSHER_SCAN_BATCH);
+    std::scoped_lock<recursive_mutex> lock(latch_);
+    for(size_t i = begin; i < end; i++){
+      Page *page = &pages_[next_victims[i]];
+      if(page->page_id_ == INVALID_PAGE_ID || page->pin_count_ > 0){
+        continue;
+      }
+      if(!page->is_dirty_){
+        clean_frames++;
+      } else if(flush_states_[next_victims[i]].load() == kFlushNone){
+        dirty_frames.emplace_back(next_victims[i]);
+      }
+    }
+  }
+  if(clean_frames >= low_watermark_ || dirty_frames.empty()){
+    return;
+  }
+  // 2.   Take a snapshot of the dirty pages, unless they have been pinned or written back in the meantime.
+  std::vector<std::pair<frame_id_t, page_id_t>> batch;
+  std::vector<char> snapshots;
+  size_t num_flush = std::min(dirty_frames.size(), high_watermark_ - clean_frames);
+  snapshots.resize(num_flush * PAGE_SIZE);
+  for(size_t begin = 0; begin < num_flush; begin += FLUSHER_SCAN_BATCH){
+    size_t end = std::min(num_flush, begin + FLUSHER_SCAN_BATCH);
+    std::scoped_lock<recursive_mutex> lock(latch_);
+    for(size_t i = begin; i < end; i++){
+      frame_id_t frame_id = dirty_frames[i];
+      Page *page = &pages_[frame_id];
+      if(page->page_id_ == INVALID_PAGE_ID || page->pin_count_ > 0 || !page->is_dirty_){
+        continue;
+      }
+      memcpy(&snapshots[batch.size() * PAGE_SIZE], page->GetData(), PAGE_SIZE);
+      flush_states_[frame_id].store(kFlushQueued);
+      batch.emplace_back(frame_id, page->page_id_);
+    }
+  }
+  // 3.   Write back the snapshots without holding the latch, unless the frame has been used in the meantime.
+  //      Their changes must be in the log on the disk first. flush_io_latch_ is only held to move a page from one
+  //      state to the next, never while waiting for a write.
+  if(log_manager_ != nullptr){
+    std::vector<std::pair<page_id_t, const char *>> pages;
+    for(size_t i = 0; i < batch.size(); i++){
+      pages.emplace_back(batch[i].second, &snapshots[i * PAGE_SIZE]);
+    }
+    if(!FlushLogFor(pages)){
+      std::scoped_lock<recursive_mutex> lock(latch_);
+      for(auto &item : batch){
+        flush_states_[item.first].store(kFlushNone);
+      }
+      return;
+    }
+  }
+  std::vector<PageIOCompletion> completions;
+  size_t next = 0;
+  while(next < batch.size() || io_queue->GetPending() > 0){
+    for(; next < batch.size(); next++){
+      std::scoped_lock<std::mutex> lock(flush_io_latch_);
+      if(flush_states_[batch[next].first].load() != kFlushQueued){
+        continue;
+      }
+      if(!io_queue->PrepareWrite(batch[next].second, &snapshots[next * PAGE_SIZE], next)){
+        break;
+      }
+      flush_in_flight_.insert(batch[next].second);
+    }
+    completions.clear();
+    io_queue->Wait(completions, 1);
+    {
+      std::scoped_lock<std::mutex> lock(flush_io_latch_);
+      for(auto &completion : completions){
+        auto &item = batch[completion.tag];
+        WriteEpoch(item.second)++;
+        flush_in_flight_.erase(item.second);
+        if(completion.ok && flush_states_[item.first].load() == kFlushQueued){
+          flush_states_[item.first].store(kFlushDone);
+        }
+      }
+    }
+    flush_io_cv_.notify_all();
+  }
+  // 4.   Mark the written pages clean.
+  std::scoped_lock<recursive_mutex> lock(latch_);
+  for(auto &item : batch){
+    frame_id_t frame_id = item.first;
+    if(flush_states_[frame_id].load() == kFlushDone && pages_[frame_id].page_id_ == item.second){
+      MarkClean(frame_id);
+      background_flushes_++;
+      dirty_writebacks_++;
+    }
+    flush_states_[frame_id].store(kFlushNone);
+  }
+}
+
+std::vector<page_id_t> BufferPoolManagerInstance::GetResidentPages() {
+  std::scoped_lock<recursive_mutex> lock(latch_);
+  std::vector<std::pair<uint64_t, page_id_t>> pages;
+  for(size_t i = 0; i < pages_.size(); i++){
+    if(pages_[i].page_id_ != INVALID_PAGE_ID){
+      // a pinned page is being used right now
+      uint64_t last_used = pages_[i].pin_count_ > 0 ? UINT64_MAX : last_unpinned_[i];
+      pages.emplace_back(last_used, pages_[i].page_id_);
+    }
+  }
+  std::sort(pages.begin(), pages.end(), std::greater<>());
+  std::vector<page_id_t> res;
+  for(auto &page : pages){
+    res.push_back(page.second);
+  }
+  return res;
+}
+
+void BufferPoolManagerInstance::ReadAheadPages(const std::vector<page_id_t> &page_ids, PageIOQueue *io_queue) {
+  // 1.   Pick the pages which are not in the pool yet, as many as there are free frames.
+  std::vector<page_id_t> to_read;
+  std::vector<uint64_t> epochs;
+  {
+    std::scoped_lock<recursive_mutex> lock(latch_);
+    for(auto page_id : page_ids){
+      frame_id_t frame_id;
+      if(to_read.size() < free_list_.size() && page_id >= 0 && !page_table_.Find(page_id, &frame_id)
+         && !IsPageFree(page_id)){
+        to_read.push_back(page_id);
+        epochs.push_back(WriteEpoch(page_id).load());
+      }
+    }
+  }
+  // 2.   Read them together without holding the latch.
+  std::vector<char> data(to_read.size() * PAGE_SIZE);
+  std::vector<PageIOCompletion> completions;
+  for(size_t i = 0; i < to_read.size(); i++){
+    while(!io_queue->PrepareRead(to_read[i], &data[i * PAGE_SIZE], i)){
+      io_queue->Wait(completions, 1);
+    }
+  }
+  io_queue->Wait(completions, io_queue->GetPending());
+  // 3.   Install them into the frames which are still free. The pages which have been written meanwhile might have
+  //      been read before the write, they are read again one by one.
+  std::vector<page_id_t> stale;
+  {
+    std::scoped_lock<recursive_mutex> lock(latch_);
+    for(auto &completion : completions){
+      page_id_t page_id = to_read[completion.tag];
+      frame_id_t frame_id;
+      if(!completion.ok || free_list_.empty() || page_table_.Find(page_id, &frame_id)){
+        continue;
+      }
+      if(WriteEpoch(page_id).load() != epochs[completion.tag]){
+        stale.push_back(page_id);
+      } else {
+        InstallReadAhead(page_id, &data[completion.tag * PAGE_SIZE], nullptr);
+      }
+    }
+  }
+  auto end_of_chain = [](Page *) { return INVALID_PAGE_ID; };
+  for(auto page_id : stale){
+    ReadAhead(page_id, end_of_chain, nullptr);
+  }
+}
+
+page_id_t BufferPoolManagerInstance::ReadAhead(page_id_t page_id, const std::function<page_id_t(Page *)> &next_page_id,
+                                       BufferRing *ring) {
+  // 1.   If the page is already in the pool, just follow the chain.
+  uint64_t epoch;
+  {
+    std::scoped_lock<recursive_mutex> lock(latch_);
+    frame_id_t frame_id;
+    if(page_table_.Find(page_id, &frame_id)){
+      return NextOnChain(&pages_[frame_id], next_page_id);
+    }
+    epoch = WriteEpoch(page_id).load();
+  }
+  if(page_id < 0 || IsPageFree(page_id)){
+    return INVALID_PAGE_ID;
+  }
+  // 2.   Read the page without holding the latch.
+  char data[PAGE_SIZE];
+  disk_manager_->ReadPage(page_id, data);
+  // 3.   Install the page unless it has been brought in or written meanwhile, the read might be stale then.
+  std::scoped_lock<recursive_mutex> lock(latch_);
+  frame_id_t frame_id;
+  if(page_table_.Find(page_id, &frame_id)){
+    return NextOnChain(&pages_[frame_id], next_page_id);
+  }
+  if(WriteEpoch(page_id).load() != epoch){
+    return INVALID_PAGE_ID;
+  }
+  Page *page = InstallReadAhead(page_id, data, ring);
+  return page == nullptr ? INVALID_PAGE_ID : NextOnChain(page, next_page_id);
+}
+
+page_id_t BufferPoolManagerInstance::NextOnChain(Page *page, const std::function<page_id_t(Page *)> &next_page_id) {
+  // The page latch can't be waited for while holding the pool latch, a writer may hold it and wait for the pool.
+  // The frame can't be reused as long as the pool latch is held, so the link is read optimistically.
+  for(int i = 0; i < OPTIMISTIC_READ_RETRIES; i++){
+    uint64_t version;
+    if(!page->OptimisticRLatch(&version)){
+      continue;
+    }
+    page_id_t res = next_page_id(page);
+    if(page->ValidateOptimisticRead(version)){
+      return res;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+Page *BufferPoolManagerInstance::InstallReadAhead(page_id_t page_id, const char *data, BufferRing *ring) {
+  frame_id_t frame_id;
+  bool found = ring == nullptr ? FindReplaceFrame(frame_id, false) : FindRingFrame(ring, page_id, frame_id);
+  if(!found){
+    return nullptr;
+  }
+  Page *page = &pages_[frame_id];
+  memcpy(page->data_, data, PAGE_SIZE);
+  page->page_id_ = page_id;
+  page->pin_count_ = 0;
+  page->is_dirty_ = false;
+  page_table_.Insert(page_id, frame_id);
+  replacer_->Unpin(frame_id);
+  prefetched_pages_++;
+  return page;
+}
+
+bool BufferPoolManagerInstance::CheckAllPinned() {
+  return unpinned_frames_.load() == 0;
+}
+
+// Only used for debug
+bool BufferPoolManagerInstance::CheckAllUnpinned() {
+  if (unpinned_frames_.load() == pool_size_ && draining_frames_ == 0) {
+    return true;
+  }
+  bool res = true;
+  for (size_t i = 0; i < pages_.size(); i++) {
+    if (pages_[i].pin_count_ != 0) {
+      res = false;
+      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
+    }
+  }
+  return res;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "buffer/clock_replacer.h"
+#include "common/macros.h"
+
+ClockReplacer::ClockReplacer(size_t num_pages) : num_pages_(num_pages), states_(new atomic<uint8_t>[num_pages]) {
+  for (size_t i = 0; i < num_pages_; i++) {
+    states_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+ClockReplacer::~ClockReplacer() = default;
+
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock<mutex> lock(victim_latch_);
+  // each full round clears all the reference bits, so the loop ends unless frames keep being unpinned concurrently
+  while (size_.load() > 0) {
+    size_t current = hand_;
+    hand_ = (hand_ + 1) % num_pages_;
+    uint8_t state = states_[current].load();
+    if (!(state & EVICTABLE)) {
+      continue;
+    }
+    if (state & REFERENCED) {
+      // second chance, a concurrent Pin/Unpin wins if it changes the state in between
+      states_[current].compare_exchange_strong(state, EVICTABLE);
+      continue;
+    }
+    if (states_[current].compare_exchange_strong(state, 0)) {
+      size_.fetch_sub(1);
+      *frame_id = static_cast<frame_id_t>(current);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Invalid frame id.");
+  if (states_[frame_id].exchange(0) & EVICTABLE) {
+    size_.fetch_sub(1);
+  }
+}
+
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Invalid frame id.");
+  if (!(states_[frame_id].exchange(EVICTABLE | REFERENCED) & EVICTABLE)) {
+    size_.fetch_add(1);
+  }
+}
+
+std::vector<frame_id_t> ClockReplacer::NextVictims(size_t max_frames) {
+  std::scoped_lock<mutex> lock(victim_latch_);
+  // the hand takes the unreferenced frames on its first round, clearing the reference bits of the other ones, and
+  // takes those on its second round
+  std::vector<frame_id_t> res;
+  for (uint8_t referenced : {static_cast<uint8_t>(0), REFERENCED}) {
+    for (size_t i = 0; i < num_pages_ && res.size() < max_frames; i++) {
+      size_t current = (hand_ + i) % num_pages_;
+      uint8_t state = states_[current].load();
+      if ((state & EVICTABLE) && (state & REFERENCED) == referenced) {
+        res.push_back(static_cast<frame_id_t>(current));
+      }
+    }
+  }
+  return res;
+}
+
+size_t ClockReplacer::Size() {
+  return size_.load();
+}
@@ -0,0 +1,71 @@
+#include "buffer/lru_k_replacer.h"
+#include "common/macros.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k)
+        : num_pages_(num_pages), k_(k), history_(num_pages * k, 0), access_count_(num_pages, 0),
+          evictable_(num_pages, false) {
+  ASSERT(k_ > 0, "K must be positive.");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+LRUKReplacer::EvictKey LRUKReplacer::GetEvictKey(frame_id_t frame_id) const {
+  size_t count = access_count_[frame_id];
+  const uint64_t *history = &history_[frame_id * k_];
+  if (count < k_) {
+    // infinite backward k-distance, ordered by the earliest access (0 if never accessed)
+    return {0, count == 0 ? 0 : history[0]};
+  }
+  // the slot to be overwritten next holds the k-th most recent access
+  return {1, history[count % k_]};
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock<mutex> lock(latch_);
+  if (evict_set_.empty()) {
+    return false;
+  }
+  frame_id_t victim = evict_set_.begin()->second;
+  evict_set_.erase(evict_set_.begin());
+  evictable_[victim] = false;
+  // the frame will hold another page, forget about the history
+  access_count_[victim] = 0;
+  *frame_id = victim;
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Invalid frame id.");
+  std::scoped_lock<mutex> lock(latch_);
+  if (evictable_[frame_id]) {
+    evict_set_.erase({GetEvictKey(frame_id), frame_id});
+    evictable_[frame_id] = false;
+  }
+  // record the access
+  history_[frame_id * k_ + access_count_[frame_id] % k_] = ++current_timestamp_;
+  access_count_[frame_id]++;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Invalid frame id.");
+  std::scoped_lock<mutex> lock(latch_);
+  if (evictable_[frame_id]) {
+    return;
+  }
+  evictable_[frame_id] = true;
+  evict_set_.emplace(GetEvictKey(frame_id), frame_id);
+}
+
+std::vector<frame_id_t> LRUKReplacer::NextVictims(size_t max_frames) {
+  std::scoped_lock<mutex> lock(latch_);
+  std::vector<frame_id_t> res;
+  for (auto it = evict_set_.begin(); it != evict_set_.end() && res.size() < max_frames; ++it) {
+    res.push_back(it->second);
+  }
+  return res;
+}
+
+size_t LRUKReplacer::Size() {
+  std::scoped_lock<mutex> lock(latch_);
+  return evict_set_.size();
+}
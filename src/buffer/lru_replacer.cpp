@@ -56,6 +56,15 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
   latch_.unlock();
 }
 
+std::vector<frame_id_t> LRUReplacer::NextVictims(size_t max_frames) {
+  std::scoped_lock<mutex> lock(latch_);
+  std::vector<frame_id_t> res;
+  for(auto it = lru_list_.rbegin(); it != lru_list_.rend() && res.size() < max_frames; ++it){
+    res.push_back(*it);
+  }
+  return res;
+}
+
 size_t LRUReplacer::Size() {
   return this->lru_list_.size();
 }
\ No newline at end of file
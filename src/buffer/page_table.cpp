@@ -0,0 +1,96 @@
+#include <algorithm>
+
+#include "buffer/page_table.h"
+#include "common/macros.h"
+
+PageTable::PageTable(size_t capacity) { AllocateSlots(capacity); }
+
+void PageTable::AllocateSlots(size_t capacity) {
+  capacity_ = capacity;
+  num_slots_ = 2;
+  shift_ = 63;
+  while (num_slots_ < 2 * capacity_) {
+    num_slots_ <<= 1;
+    shift_--;
+  }
+  mask_ = num_slots_ - 1;
+  slots_.reset(new uint64_t[num_slots_]);
+  std::fill(slots_.get(), slots_.get() + num_slots_, kEmptySlot);
+}
+
+void PageTable::Resize(size_t capacity) {
+  ASSERT(Size() <= capacity, "Page table does not fit.");
+  std::unique_ptr<uint64_t[]> old_slots = std::move(slots_);
+  size_t old_num_slots = num_slots_;
+  AllocateSlots(capacity);
+  size_ = 0;
+  for (size_t i = 0; i < old_num_slots; i++) {
+    uint64_t slot = old_slots[i];
+    if (slot != kEmptySlot) {
+      Insert(UnpackPageId(slot), UnpackFrameId(slot));
+    }
+  }
+}
+
+bool PageTable::Find(page_id_t page_id, frame_id_t *frame_id) const {
+  size_t i = Locate(page_id);
+  if (i == num_slots_) {
+    return false;
+  }
+  *frame_id = UnpackFrameId(slots_[i]);
+  return true;
+}
+
+size_t PageTable::Locate(page_id_t page_id) const {
+  for (size_t i = Home(page_id);; i = (i + 1) & mask_) {
+    uint64_t slot = slots_[i];
+    if (slot == kEmptySlot) {
+      return num_slots_;
+    }
+    if (UnpackPageId(slot) == page_id) {
+      return i;
+    }
+  }
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  ASSERT(page_id != INVALID_PAGE_ID, "Invalid page id.");
+  size_t i = Home(page_id);
+  while (true) {
+    uint64_t slot = slots_[i];
+    if (slot == kEmptySlot) {
+      ASSERT(Size() < capacity_, "Page table is full.");
+      size_++;
+      break;
+    }
+    if (UnpackPageId(slot) == page_id) {
+      break;
+    }
+    i = (i + 1) & mask_;
+  }
+  slots_[i] = Pack(page_id, frame_id);
+}
+
+bool PageTable::Erase(page_id_t page_id) {
+  size_t hole = Locate(page_id);
+  if (hole == num_slots_) {
+    return false;
+  }
+  // move back the following entries of the cluster which can not be found any more once the hole is emptied,
+  // i.e. the ones whose home is not cyclically within (hole, next]
+  for (size_t next = (hole + 1) & mask_;; next = (next + 1) & mask_) {
+    uint64_t slot = slots_[next];
+    if (slot == kEmptySlot) {
+      break;
+    }
+    size_t home = Home(UnpackPageId(slot));
+    bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+    if (!stays) {
+      slots_[hole] = slot;
+      hole = next;
+    }
+  }
+  slots_[hole] = kEmptySlot;
+  size_--;
+  return true;
+}
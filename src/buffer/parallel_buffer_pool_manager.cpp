@@ -0,0 +1,243 @@
+#include <algorithm>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "glog/logging.h"
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                                                     DiskManager *disk_manager, ReplacerType replacer_type)
+        : BufferPoolManager(disk_manager), pool_size_(pool_size) {
+  ASSERT(num_instances > 0 && pool_size >= num_instances, "Invalid number of buffer pool instances.");
+  // the first (pool_size % num_instances) instances get one more frame
+  for (size_t i = 0; i < num_instances; i++) {
+    size_t instance_size = pool_size / num_instances + (i < pool_size % num_instances ? 1 : 0);
+    instances_.emplace_back(new BufferPoolManagerInstance(instance_size, disk_manager, replacer_type));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // the prefetcher and the warm up work on the instances, stop them before they go away
+  StopWarmUp();
+  StopPrefetcher();
+  for (auto instance : instances_) {
+    delete instance;
+  }
+}
+
+bool ParallelBufferPoolManager::Resize(size_t pool_size) {
+  size_t num_instances = instances_.size();
+  if (pool_size < num_instances) {
+    return false;
+  }
+  // The frames are shared out like in the constructor, so that either all the instances grow or all of them shrink.
+  StopPrefetcher();
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_[i]->Resize(pool_size / num_instances + (i < pool_size % num_instances ? 1 : 0));
+  }
+  pool_size_ = pool_size;
+  return true;
+}
+
+Page *ParallelBufferPoolManager::FetchPage(page_id_t page_id, BufferRing *ring) {
+  return GetInstance(page_id)->FetchPage(page_id, ring);
+}
+
+bool ParallelBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetInstance(page_id)->FlushPage(page_id);
+}
+
+bool ParallelBufferPoolManager::FlushAllPage() {
+  // Collect the dirty pages of all the instances, so that adjacent pages held by different instances
+  // can still be written together.
+  bool res = false;
+  std::vector<std::pair<page_id_t, const char *>> dirty_pages;
+  std::vector<std::unique_lock<recursive_mutex>> locks;
+  for (auto instance : instances_) {
+    locks.emplace_back(instance->latch_);
+    res = res || !instance->page_table_.Empty();
+    instance->CollectCheckpointPages(dirty_pages);
+  }
+  if (!FlushLogFor(dirty_pages)) {
+    return false;
+  }
+  disk_manager_->WritePages(std::move(dirty_pages));
+  for (auto instance : instances_) {
+    instance->CleanCheckpointPages();
+  }
+  return res;
+}
+
+Page *ParallelBufferPoolManager::NewPage(page_id_t &page_id) {
+  // The page id decides which instance holds the page, so allocate it first and give it back on failure.
+  page_id_t n_page_id = AllocatePage();
+  if (n_page_id == INVALID_PAGE_ID) {
+    new_page_failures_++;
+    LOG(INFO) << "AllocatePage failed" << std::endl;
+    return nullptr;
+  }
+  size_t num_instances = instances_.size();
+  for (size_t i = 0; i < num_instances; i++) {
+    size_t instance = (n_page_id + i) % num_instances;
+    if (instances_[instance]->CheckAllPinned()) {
+      continue;
+    }
+    page_id_t instance_page_id = i == 0 ? n_page_id : AllocatePageOf(instance, n_page_id);
+    if (instance_page_id == INVALID_PAGE_ID) {
+      continue;
+    }
+    Page *page = instances_[instance]->NewPageFrame(instance_page_id);
+    if (page == nullptr) {
+      // all its frames have been pinned meanwhile
+      if (instance_page_id != n_page_id) {
+        DeallocatePage(instance_page_id);
+      }
+      continue;
+    }
+    if (instance_page_id != n_page_id) {
+      DeallocatePage(n_page_id);
+    }
+    page_id = instance_page_id;
+    return page;
+  }
+  DeallocatePage(n_page_id);
+  new_page_failures_++;
+  return nullptr;
+}
+
+page_id_t ParallelBufferPoolManager::AllocatePageOf(size_t instance, page_id_t after) {
+  size_t num_instances = instances_.size();
+  auto page_id = static_cast<page_id_t>(after + (instance + num_instances - after % num_instances) % num_instances);
+  // the pages above the lowest free one are seldom allocated, the first candidate usually is free
+  for (; page_id < MAX_VALID_PAGE_ID; page_id += static_cast<page_id_t>(num_instances)) {
+    if (page_id != after && disk_manager_->AllocatePageAt(page_id)) {
+      return page_id;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+bool ParallelBufferPoolManager::DeletePage(page_id_t page_id) {
+  return GetInstance(page_id)->DeletePage(page_id);
+}
+
+bool ParallelBufferPoolManager::CheckAllPinned() {
+  for (auto instance : instances_) {
+    if (!instance->CheckAllPinned()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ParallelBufferPoolManager::CheckAllUnpinned() {
+  bool res = true;
+  for (auto instance : instances_) {
+    res = instance->CheckAllUnpinned() && res;
+  }
+  return res;
+}
+
+void ParallelBufferPoolManager::SetLogManager(LogManager *log_manager) {
+  log_manager_ = log_manager;
+  for (auto instance : instances_) {
+    instance->SetLogManager(log_manager);
+  }
+}
+
+void ParallelBufferPoolManager::StartFlusher(size_t low_watermark, size_t high_watermark) {
+  for (auto instance : instances_) {
+    size_t share = instance->GetPoolSize();
+    instance->StartFlusher(low_watermark * share / pool_size_, high_watermark * share / pool_size_);
+  }
+}
+
+void ParallelBufferPoolManager::StopFlusher() {
+  for (auto instance : instances_) {
+    instance->StopFlusher();
+  }
+}
+
+uint64_t ParallelBufferPoolManager::GetForegroundFlushCount() {
+  uint64_t res = 0;
+  for (auto instance : instances_) {
+    res += instance->GetForegroundFlushCount();
+  }
+  return res;
+}
+
+uint64_t ParallelBufferPoolManager::GetBackgroundFlushCount() {
+  uint64_t res = 0;
+  for (auto instance : instances_) {
+    res += instance->GetBackgroundFlushCount();
+  }
+  return res;
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  for (auto instance : instances_) {
+    stats += instance->GetStats();
+  }
+  // NewPage is served by this object, the failures of NewPageFrame are not counted by the instances
+  stats.new_page_failures += new_page_failures_.load();
+  return stats;
+}
+
+std::unordered_map<page_id_t, uint64_t> ParallelBufferPoolManager::GetDirtyPageTable() {
+  std::unordered_map<page_id_t, uint64_t> res;
+  for (auto instance : instances_) {
+    auto dirty_page_table = instance->GetDirtyPageTable();
+    res.insert(dirty_page_table.begin(), dirty_page_table.end());
+  }
+  return res;
+}
+
+uint64_t ParallelBufferPoolManager::GetPrefetchCount() {
+  uint64_t res = 0;
+  for (auto instance : instances_) {
+    res += instance->GetPrefetchCount();
+  }
+  return res;
+}
+
+page_id_t ParallelBufferPoolManager::ReadAhead(page_id_t page_id,
+                                               const std::function<page_id_t(Page *)> &next_page_id,
+                                               BufferRing *ring) {
+  return GetInstance(page_id)->ReadAhead(page_id, next_page_id, ring);
+}
+
+std::vector<page_id_t> ParallelBufferPoolManager::GetResidentPages() {
+  std::vector<std::vector<page_id_t>> instance_pages;
+  size_t max_size = 0;
+  for (auto instance : instances_) {
+    instance_pages.emplace_back(instance->GetResidentPages());
+    max_size = std::max(max_size, instance_pages.back().size());
+  }
+  std::vector<page_id_t> res;
+  for (size_t i = 0; i < max_size; i++) {
+    for (auto &pages : instance_pages) {
+      if (i < pages.size()) {
+        res.push_back(pages[i]);
+      }
+    }
+  }
+  return res;
+}
+
+void ParallelBufferPoolManager::ReadAheadPages(const std::vector<page_id_t> &page_ids, PageIOQueue *io_queue) {
+  std::vector<std::vector<page_id_t>> instance_pages(instances_.size());
+  for (auto page_id : page_ids) {
+    instance_pages[page_id % instances_.size()].push_back(page_id);
+  }
+  for (size_t i = 0; i < instances_.size(); i++) {
+    if (!instance_pages[i].empty()) {
+      instances_[i]->ReadAheadPages(instance_pages[i], io_queue);
+    }
+  }
+}
@@ -78,9 +78,9 @@ uint32_t CatalogMeta::GetSerializedSize() const {
 CatalogMeta::CatalogMeta() {}
 
 CatalogManager::CatalogManager(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager,
-                               LogManager *log_manager, bool init)
+                               LogManager *log_manager, bool init, VersionStore *version_store)
         : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager),
-          log_manager_(log_manager), heap_(new SimpleMemHeap()) {
+          log_manager_(log_manager), version_store_(version_store), heap_(new SimpleMemHeap()) {
   //init: true if it's the first time to access a db instance
   if(init){
     //create the catalog meta page
@@ -131,7 +131,8 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
     return DB_FAILED;
   }
   table_id_t table_id = next_table_id_;
-  TableHeap *table_heap = TableHeap::Create(buffer_pool_manager_, schema, txn, log_manager_, lock_manager_,heap_);
+  TableHeap *table_heap = TableHeap::Create(buffer_pool_manager_, schema, txn, log_manager_, lock_manager_,heap_,
+                                            version_store_);
   if(!table_heap){
     LOG(INFO)<<"FAILED TO CREATE TABLE HEAP"<<endl;
     return DB_FAILED;
@@ -387,7 +388,7 @@ dberr_t CatalogManager::LoadTable(const table_id_t table_id, const page_id_t pag
   if(offset == 0)
     return DB_FAILED;
   TableHeap *table_heap = TableHeap::Create(buffer_pool_manager_, table_meta -> GetFirstPageId(), table_meta->GetSchema(),
-              log_manager_, lock_manager_,heap_);
+              log_manager_, lock_manager_,heap_, version_store_);
   table_info->Init(table_meta, table_heap);
   //add to catalog_meta_
   catalog_meta_ -> table_meta_pages_[table_id] = page_id;
@@ -51,13 +51,13 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast, ExecuteContext *context) {
     case kNodeDropIndex:
       return ExecuteDropIndex(ast, context);
     case kNodeSelect:
-      return ExecuteSelect(ast, context);
+      return ExecuteInTransaction(ast, context, &ExecuteEngine::ExecuteSelect);
     case kNodeInsert:
-      return ExecuteInsert(ast, context);
+      return ExecuteInTransaction(ast, context, &ExecuteEngine::ExecuteInsert);
     case kNodeDelete:
-      return ExecuteDelete(ast, context);
+      return ExecuteInTransaction(ast, context, &ExecuteEngine::ExecuteDelete);
     case kNodeUpdate:
-      return ExecuteUpdate(ast, context);
+      return ExecuteInTransaction(ast, context, &ExecuteEngine::ExecuteUpdate);
     case kNodeTrxBegin:
       return ExecuteTrxBegin(ast, context);
     case kNodeTrxCommit:
@@ -68,6 +68,10 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast, ExecuteContext *context) {
       return ExecuteExecfile(ast, context);
     case kNodeQuit:
       return ExecuteQuit(ast, context);
+    case kNodeShowStatus:
+      return ExecuteShowStatus(ast, context);
+    case kNodeSetVariable:
+      return ExecuteSetVariable(ast, context);
     default:
       break;
   }
@@ -142,6 +146,80 @@ dberr_t ExecuteEngine::ExecuteShowTables(pSyntaxNode ast, ExecuteContext *contex
   return DB_SUCCESS;
 }
 
+dberr_t ExecuteEngine::ExecuteShowStatus(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteShowStatus" << std::endl;
+#endif
+  // STATUS is not a keyword of the parser, any SHOW <identifier> gets here
+  string name = ast->child_->val_;
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+  if(name != "status"){
+    std::cout<<"Unknown statement SHOW "<<ast->child_->val_<<std::endl;
+    return DB_FAILED;
+  }
+  if(cur_db == nullptr){
+    std::cout<<"No database selected"<<std::endl;
+    return DB_FAILED;
+  }
+  BufferPoolStats stats = cur_db->bpm_->GetStats();
+  std::cout<<"----- Buffer Pool Status -----"<<std::endl;
+  auto print = [](const char *name, auto value) {
+    std::cout<<std::left<<std::setw(24)<<name<<value<<std::endl;
+  };
+  print("pool_size", stats.pool_size);
+  print("resident_pages", stats.resident_pages);
+  print("dirty_pages", stats.dirty_pages);
+  print("pinned_pages", stats.pinned_pages);
+  print("hits", stats.hits);
+  print("misses", stats.misses);
+  print("hit_rate", stats.HitRate());
+  print("evictions", stats.evictions);
+  print("dirty_writebacks", stats.dirty_writebacks);
+  print("foreground_flushes", stats.foreground_flushes);
+  print("background_flushes", stats.background_flushes);
+  print("prefetched_pages", stats.prefetched_pages);
+  print("new_page_failures", stats.new_page_failures);
+  print("latch_wait_us", stats.latch_wait_ns / 1000);
+  std::cout<<"----- Pin Duration -----"<<std::endl;
+  for(size_t i = 0; i < PIN_HISTOGRAM_BUCKETS; i++){
+    // the range of durations the bucket counts, e.g. [4, 8)us
+    string upper = i == PIN_HISTOGRAM_BUCKETS - 1 ? "inf"
+                                                  : std::to_string(BufferPoolStats::GetPinBucketLowerBound(i + 1));
+    string bucket = "[" + std::to_string(BufferPoolStats::GetPinBucketLowerBound(i)) + ", " + upper + ")us";
+    print(bucket.c_str(), stats.pin_duration_histogram[i]);
+  }
+  std::cout<<std::right;
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteSetVariable(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteSetVariable" << std::endl;
+#endif
+  string name = ast->child_->val_;
+  string value = ast->child_->next_->val_;
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+  if(name != "buffer_pool_size"){
+    std::cout<<"Unknown variable "<<name<<std::endl;
+    return DB_FAILED;
+  }
+  if(cur_db == nullptr){
+    std::cout<<"No database selected"<<std::endl;
+    return DB_FAILED;
+  }
+  if(value.find('.') != string::npos || value[0] == '-' || atoll(value.c_str()) <= 0){
+    std::cout<<"buffer_pool_size must be a positive integer"<<std::endl;
+    return DB_FAILED;
+  }
+  size_t pool_size = atoll(value.c_str());
+  if(!cur_db->bpm_->Resize(pool_size)){
+    std::cout<<"Can't resize the buffer pool to "<<pool_size<<" frames, some pages are in use"<<std::endl;
+    return DB_FAILED;
+  }
+  std::cout<<"buffer_pool_size = "<<cur_db->bpm_->GetPoolSize()<<std::endl;
+  return DB_SUCCESS;
+}
+
 dberr_t ExecuteEngine::ExecuteCreateTable(pSyntaxNode ast, ExecuteContext *context) {
 #ifdef ENABLE_EXECUTE_DEBUG
   LOG(INFO) << "ExecuteCreateTable" << std::endl;
@@ -232,6 +310,11 @@ dberr_t ExecuteEngine::ExecuteDropTable(pSyntaxNode ast, ExecuteContext *context
 #ifdef ENABLE_EXECUTE_DEBUG
   LOG(INFO) << "ExecuteDropTable" << std::endl;
 #endif
+  if (context->txn_ != nullptr) {
+    // a rollback of the transaction would undo its changes of the table and of its indexes
+    cout << "Can't drop a table in a transaction" << endl;
+    return DB_FAILED;
+  }
   //return DB_FAILED;
   dberr_t is_Drop = cur_db->catalog_mgr_->DropTable(ast->child_->val_);
   if(is_Drop == DB_TABLE_NOT_EXIST) std::cout<<"Table isn't exist"<<std::endl;
@@ -318,6 +401,11 @@ dberr_t ExecuteEngine::ExecuteDropIndex(pSyntaxNode ast, ExecuteContext *context
 #ifdef ENABLE_EXECUTE_DEBUG
   LOG(INFO) << "ExecuteDropIndex" << std::endl;
 #endif
+  if (context->txn_ != nullptr) {
+    // a rollback of the transaction would undo its changes of the index
+    cout << "Can't drop an index in a transaction" << endl;
+    return DB_FAILED;
+  }
   vector<TableInfo* > Tables;
   cur_db->catalog_mgr_->GetTables(Tables);
   for(auto iter = Tables.begin(); iter < Tables.end(); ++iter)
@@ -338,19 +426,19 @@ dberr_t ExecuteEngine::ExecuteDropIndex(pSyntaxNode ast, ExecuteContext *context
   return DB_FAILED;
 }
 
-vector<Row*> rec_sel(pSyntaxNode sn, std::vector<Row*>& r, TableInfo* t, CatalogManager* c){
+vector<Row*> rec_sel(pSyntaxNode sn, std::vector<Row*>& r, TableInfo* t, CatalogManager* c, Transaction* txn = nullptr){
   if(sn == nullptr) return r;
   if(sn->type_ == kNodeConnector){
 
     vector<Row*> ans;
     if(strcmp(sn->val_,"and") == 0){
-      auto r1 = rec_sel(sn->child_,r,t,c);
-      ans = rec_sel(sn->child_->next_,r1,t,c);
+      auto r1 = rec_sel(sn->child_,r,t,c,txn);
+      ans = rec_sel(sn->child_->next_,r1,t,c,txn);
       return ans;
     }
     else if(strcmp(sn->val_,"or") == 0){
-      auto r1 = rec_sel(sn->child_,r,t,c);
-      auto r2 = rec_sel(sn->child_->next_,r,t,c);
+      auto r1 = rec_sel(sn->child_,r,t,c,txn);
+      auto r2 = rec_sel(sn->child_->next_,r,t,c,txn);
       for(uint32_t i=0;i<r1.size();i++){
         ans.push_back(r1[i]);
       }
@@ -394,7 +482,9 @@ vector<Row*> rec_sel(pSyntaxNode sn, std::vector<Row*>& r, TableInfo* t, Catalog
         vect_benchmk.push_back(benchmk);
 
         vector <IndexInfo*> indexes;
-        c->GetTableIndexes(t->GetTableName(),indexes);
+        if(!t->GetTableHeap()->IndexMayMissRows(txn)){
+          c->GetTableIndexes(t->GetTableName(),indexes);
+        }
         for(auto p=indexes.begin();p<indexes.end();p++){
           if((*p)->GetIndexKeySchema()->GetColumnCount()==1){
             if((*p)->GetIndexKeySchema()->GetColumns()[0]->GetName()==col_name){
@@ -405,7 +495,11 @@ vector<Row*> rec_sel(pSyntaxNode sn, std::vector<Row*>& r, TableInfo* t, Catalog
               for(auto q:result){
                 if(q.GetPageId()<0) continue;
                 Row *tr = new Row(q);
-                t->GetTableHeap()->GetTuple(tr,nullptr);
+                if(!t->GetTableHeap()->GetTuple(tr,txn)){
+                  // not in the snapshot of the transaction
+                  delete tr;
+                  continue;
+                }
                 ans.push_back(tr);
               }
               return ans;
@@ -450,7 +544,9 @@ vector<Row*> rec_sel(pSyntaxNode sn, std::vector<Row*>& r, TableInfo* t, Catalog
         vect_benchmk.push_back(benchmk);
 
         vector <IndexInfo*> indexes;
-        c->GetTableIndexes(t->GetTableName(),indexes);
+        if(!t->GetTableHeap()->IndexMayMissRows(txn)){
+          c->GetTableIndexes(t->GetTableName(),indexes);
+        }
         for(auto p=indexes.begin();p<indexes.end();p++){
           if((*p)->GetIndexKeySchema()->GetColumnCount()==1){
             if((*p)->GetIndexKeySchema()->GetColumns()[0]->GetName()==col_name){
@@ -467,7 +563,11 @@ vector<Row*> rec_sel(pSyntaxNode sn, std::vector<Row*>& r, TableInfo* t, Catalog
                 if(q.GetPageId()<0) continue;
                 // cout<<"index found"<<endl;
                 Row *tr = new Row(q);
-                t->GetTableHeap()->GetTuple(tr,nullptr);
+                if(!t->GetTableHeap()->GetTuple(tr,txn)){
+                  // not in the snapshot of the transaction
+                  delete tr;
+                  continue;
+                }
                 ans.push_back(tr);
               }
               return ans;
@@ -838,7 +938,7 @@ dberr_t ExecuteEngine::ExecuteSelect(pSyntaxNode ast, ExecuteContext *context) {
   std::cout<< std::endl;
   std::cout<<"+---------------------------------+"<< std::endl;
   // print out each row
-  for(TableIterator p=tableheap->Begin(nullptr);p!=tableheap->End();++p)
+  for(TableIterator p=tableheap->Begin(context->txn_, kBulkReadAccess);p!=tableheap->End();++p)
   {
       bool flagprint=true;
       if(flagcompare){
@@ -930,7 +1030,7 @@ dberr_t ExecuteEngine::ExecuteSelect(pSyntaxNode ast, ExecuteContext *context) {
   if(range->next_->next_==nullptr)
   {
     int cnt=0;
-    for(auto it=tableinfo->GetTableHeap()->Begin(nullptr);it!=tableinfo->GetTableHeap()->End();it++){
+    for(auto it=tableinfo->GetTableHeap()->Begin(context->txn_, kBulkReadAccess);it!=tableinfo->GetTableHeap()->End();it++){
       for(uint32_t j=0;j<columns.size();j++){
         if(it->GetField(columns[j])->IsNull()){
           cout<<"null";
@@ -950,11 +1050,11 @@ dberr_t ExecuteEngine::ExecuteSelect(pSyntaxNode ast, ExecuteContext *context) {
   {
     pSyntaxNode cond = range->next_->next_->child_;
     vector<Row*> origin_rows;
-    for(auto it=tableinfo->GetTableHeap()->Begin(nullptr);it!=tableinfo->GetTableHeap()->End();it++){
+    for(auto it=tableinfo->GetTableHeap()->Begin(context->txn_, kBulkReadAccess);it!=tableinfo->GetTableHeap()->End();it++){
       Row* tp = new Row(*it);
       origin_rows.push_back(tp);
     }    
-    auto ptr_rows  = rec_sel(cond, *&origin_rows,tableinfo,cur_db->catalog_mgr_);
+    auto ptr_rows  = rec_sel(cond, *&origin_rows,tableinfo,cur_db->catalog_mgr_,context->txn_);
     
     for(auto it=ptr_rows.begin();it!=ptr_rows.end();it++){
       for(uint32_t j=0;j<columns.size();j++){
@@ -1126,7 +1226,7 @@ dberr_t ExecuteEngine::ExecuteInsert(pSyntaxNode ast, ExecuteContext *context) {
  //   ASSERT(tableinfo!=nullptr,"TableInfo is Null!");
 
     TableHeap* tableheap=tableinfo->GetTableHeap();
-    bool Is_Insert=tableheap->InsertTuple(row,nullptr);//insert with tableheap
+    bool Is_Insert=tableheap->InsertTuple(row,context->txn_);//insert with tableheap
 
     if(Is_Insert==false)
     {
@@ -1149,7 +1249,7 @@ dberr_t ExecuteEngine::ExecuteInsert(pSyntaxNode ast, ExecuteContext *context) {
                     index_fields.push_back(fields[tmp]);
             }
             Row index_row(index_fields);
-            dberr_t IsInsert=(*p)->GetIndex()->InsertEntry(index_row,row.GetRowId(),nullptr);
+            dberr_t IsInsert=(*p)->GetIndex()->InsertEntry(index_row,row.GetRowId(),context->txn_);
             //cout<<"RowID: "<<row.GetRowId().Get()<<endl;
             if(IsInsert==DB_FAILED)
             {
@@ -1165,9 +1265,9 @@ dberr_t ExecuteEngine::ExecuteInsert(pSyntaxNode ast, ExecuteContext *context) {
                             index_fields_already.push_back(fields[tmp_already]);
                     }
                     Row index_row_already(index_fields_already);
-                    (*q)->GetIndex()->RemoveEntry(index_row_already,row.GetRowId(),nullptr);
+                    (*q)->GetIndex()->RemoveEntry(index_row_already,row.GetRowId(),context->txn_);
                 }
-                tableheap->MarkDelete(row.GetRowId(),nullptr);
+                tableheap->MarkDelete(row.GetRowId(),context->txn_);
                 return IsInsert;
             }
             //else
@@ -1197,21 +1297,21 @@ dberr_t ExecuteEngine::ExecuteDelete(pSyntaxNode ast, ExecuteContext *context) {
     vector<Row*> tar;
 
     if(del->next_==nullptr){//锟斤拷取锟斤拷锟斤拷选锟斤拷锟斤拷锟斤拷锟斤拷row锟斤拷锟斤拷锟斤拷vector<Row*> tar锟斤拷
-      for(auto it=tableinfo->GetTableHeap()->Begin(nullptr);it!=tableinfo->GetTableHeap()->End();it++){
+      for(auto it=tableinfo->GetTableHeap()->Begin(context->txn_, kBulkReadAccess);it!=tableinfo->GetTableHeap()->End();it++){
         Row* tp = new Row(*it);
         tar.push_back(tp);
       }
     }
     else{
       vector<Row*> origin_rows;
-      for(auto it=tableinfo->GetTableHeap()->Begin(nullptr);it!=tableinfo->GetTableHeap()->End();it++){
+      for(auto it=tableinfo->GetTableHeap()->Begin(context->txn_, kBulkReadAccess);it!=tableinfo->GetTableHeap()->End();it++){
         Row* tp = new Row(*it);
         origin_rows.push_back(tp);
       }
-      tar  = rec_sel(del->next_->child_, *&origin_rows,tableinfo,cur_db->catalog_mgr_);
+      tar  = rec_sel(del->next_->child_, *&origin_rows,tableinfo,cur_db->catalog_mgr_,context->txn_);
     }
     for(auto it:tar){
-      tableheap->ApplyDelete(it->GetRowId(),nullptr);
+      tableheap->ApplyDelete(it->GetRowId(),context->txn_);
     }
     cout<<"Delete Success, Affects "<<tar.size()<<" Record!"<<endl;
     vector <IndexInfo*> indexes;//锟斤拷锟斤拷锟斤拷锟斤拷锟斤拷锟斤拷锟斤拷锟絠ndexinfo
@@ -1226,7 +1326,7 @@ dberr_t ExecuteEngine::ExecuteDelete(pSyntaxNode ast, ExecuteContext *context) {
           }
         }
         Row index_row(index_fields);
-        (*p)->GetIndex()->RemoveEntry(index_row,j->GetRowId(),nullptr);
+        (*p)->GetIndex()->RemoveEntry(index_row,j->GetRowId(),context->txn_);
       }
     }
     return DB_SUCCESS;
@@ -1251,7 +1351,7 @@ dberr_t ExecuteEngine::ExecuteUpdate(pSyntaxNode ast, ExecuteContext *context) {
 
   if(updates->next_==nullptr)
   {
-    for(auto it=tableinfo->GetTableHeap()->Begin(nullptr);it!=tableinfo->GetTableHeap()->End();it++){
+    for(auto it=tableinfo->GetTableHeap()->Begin(context->txn_, kBulkReadAccess);it!=tableinfo->GetTableHeap()->End();it++){
       Row* tp = new Row(*it);
       tar.push_back(tp);
     }
@@ -1259,11 +1359,11 @@ dberr_t ExecuteEngine::ExecuteUpdate(pSyntaxNode ast, ExecuteContext *context) {
   }
   else{
     vector<Row*> origin_rows;
-    for(auto it=tableinfo->GetTableHeap()->Begin(nullptr);it!=tableinfo->GetTableHeap()->End();it++){
+    for(auto it=tableinfo->GetTableHeap()->Begin(context->txn_, kBulkReadAccess);it!=tableinfo->GetTableHeap()->End();it++){
       Row* tp = new Row(*it);
       origin_rows.push_back(tp);
     }
-    tar  = rec_sel(updates->next_->child_, *&origin_rows,tableinfo,cur_db->catalog_mgr_);
+    tar  = rec_sel(updates->next_->child_, *&origin_rows,tableinfo,cur_db->catalog_mgr_,context->txn_);
     // cout<<"---- part "<<tar.size()<<" ----"<<endl;
   }
   updates = updates->child_;
@@ -1297,32 +1397,86 @@ dberr_t ExecuteEngine::ExecuteUpdate(pSyntaxNode ast, ExecuteContext *context) {
     updates = updates->next_;
   }
   for(auto it:tar){
-    tableheap->UpdateTuple(*it,it->GetRowId(),nullptr);
+    tableheap->UpdateTuple(*it,it->GetRowId(),context->txn_);
   }
   cout<<"Update Success, Affects "<<tar.size()<<" Record!"<<endl;
   return DB_SUCCESS;
 }
 
+dberr_t ExecuteEngine::ExecuteInTransaction(pSyntaxNode ast, ExecuteContext *context,
+                                            dberr_t (ExecuteEngine::*execute)(pSyntaxNode, ExecuteContext *)) {
+  if (cur_db == nullptr || cur_db->txn_mgr_ == nullptr) {
+    return (this->*execute)(ast, context);
+  }
+  // a statement outside of a transaction commits by itself
+  bool autocommit = context->txn_ == nullptr;
+  if (autocommit) {
+    context->txn_ = cur_db->txn_mgr_->Begin();
+  }
+  dberr_t res = (this->*execute)(ast, context);
+  if (context->txn_->GetState() == kAborted) {
+    // chosen to break a deadlock, or it changed a row changed by another one since it started
+    cout << "Transaction aborted, it conflicts with another one" << endl;
+    cur_db->txn_mgr_->Abort(context->txn_);
+    context->txn_ = nullptr;
+    return DB_FAILED;
+  }
+  if (autocommit) {
+    bool committed = cur_db->txn_mgr_->Commit(context->txn_);
+    context->txn_ = nullptr;
+    if (!committed) {
+      cout << "Commit failed, the log can't be written" << endl;
+      return DB_FAILED;
+    }
+  }
+  return res;
+}
+
 dberr_t ExecuteEngine::ExecuteTrxBegin(pSyntaxNode ast, ExecuteContext *context) {
 #ifdef ENABLE_EXECUTE_DEBUG
   LOG(INFO) << "ExecuteTrxBegin" << std::endl;
 #endif
-
-  return DB_FAILED;
+  if (cur_db == nullptr || cur_db->txn_mgr_ == nullptr) {
+    cout << "No database with a log selected" << endl;
+    return DB_FAILED;
+  }
+  if (context->txn_ != nullptr) {
+    cout << "Transaction already started" << endl;
+    return DB_FAILED;
+  }
+  context->txn_ = cur_db->txn_mgr_->Begin();
+  return DB_SUCCESS;
 }
 
 dberr_t ExecuteEngine::ExecuteTrxCommit(pSyntaxNode ast, ExecuteContext *context) {
 #ifdef ENABLE_EXECUTE_DEBUG
   LOG(INFO) << "ExecuteTrxCommit" << std::endl;
 #endif
-  return DB_FAILED;
+  if (context->txn_ == nullptr) {
+    cout << "No transaction started" << endl;
+    return DB_FAILED;
+  }
+  bool committed = cur_db->txn_mgr_->Commit(context->txn_);
+  context->txn_ = nullptr;
+  if (!committed) {
+    cout << "Commit failed, the log can't be written" << endl;
+    return DB_FAILED;
+  }
+  return DB_SUCCESS;
 }
 
 dberr_t ExecuteEngine::ExecuteTrxRollback(pSyntaxNode ast, ExecuteContext *context) {
 #ifdef ENABLE_EXECUTE_DEBUG
   LOG(INFO) << "ExecuteTrxRollback" << std::endl;
 #endif
-  return DB_FAILED;
+  if (context->txn_ == nullptr) {
+    cout << "No transaction started" << endl;
+    return DB_FAILED;
+  }
+  // the changes of the table pages are undone from the log, the ones of the indexes from the transaction
+  cur_db->txn_mgr_->Abort(context->txn_);
+  context->txn_ = nullptr;
+  return DB_SUCCESS;
 }
 
 dberr_t ExecuteEngine::ExecuteExecfile(pSyntaxNode ast, ExecuteContext *context) {
@@ -1,42 +1,159 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
-#include <list>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
-#include "buffer/lru_replacer.h"
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/buffer_ring.h"
+#include "buffer/replacer.h"
+#include "common/macros.h"
 #include "page/page.h"
-#include "page/disk_file_meta_page.h"
 #include "storage/disk_manager.h"
+#include "transaction/log_manager.h"
 
 using namespace std;
 
+/**
+ * BufferPoolManager is the interface of the buffer pools, see BufferPoolManagerInstance for a pool of frames and
+ * ParallelBufferPoolManager for a pool split into several instances.
+ *
+ * It also runs what does not depend on how the frames are managed: the prefetcher following the read ahead hints,
+ * and the warm up from a dump of the resident pages.
+ */
 class BufferPoolManager {
 public:
-  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+  explicit BufferPoolManager(DiskManager *disk_manager) : disk_manager_(disk_manager) {}
 
-  ~BufferPoolManager();
+  /** The sub classes stop the prefetcher and the warm up first, they call back into them. */
+  virtual ~BufferPoolManager();
 
-  Page *FetchPage(page_id_t page_id);
+  DISALLOW_COPY(BufferPoolManager);
 
-  bool UnpinPage(page_id_t page_id, bool is_dirty);
+  /**
+   * @param ring if not null, a page which is not in the pool yet is read into a frame of this ring
+   */
+  virtual Page *FetchPage(page_id_t page_id, BufferRing *ring = nullptr) = 0;
+
+  virtual bool UnpinPage(page_id_t page_id, bool is_dirty) = 0;
 
-  bool FlushPage(page_id_t page_id);
+  /**
+   * @return false if the page is not in the pool, or can't be written because the log can't be written before it
+   */
+  virtual bool FlushPage(page_id_t page_id) = 0;
 
-  bool FlushAllPage();
+  virtual bool FlushAllPage() = 0;
 
-  Page *NewPage(page_id_t &page_id);
+  virtual Page *NewPage(page_id_t &page_id) = 0;
 
-  bool DeletePage(page_id_t page_id);
+  virtual bool DeletePage(page_id_t page_id) = 0;
 
   bool IsPageFree(page_id_t page_id);
 
-  bool CheckAllPinned();
+  /** @return true if no frame is free or evictable, in O(1) so that NewPage can fail fast */
+  virtual bool CheckAllPinned() = 0;
 
-  bool CheckAllUnpinned();
+  virtual bool CheckAllUnpinned() = 0;
+
+  /** @return the total number of frames managed by this buffer pool */
+  virtual size_t GetPoolSize() = 0;
 
-private:
+  /**
+   * Grow or shrink the buffer pool while it is in use. New frames are added to the free list, shrinking evicts the
+   * pages held by the frames which are dropped and writes back the dirty ones. A pinned page in a dropped frame stays
+   * valid, it is evicted once it is unpinned.
+   * @return false if the pool size is invalid
+   */
+  virtual bool Resize(size_t pool_size) = 0;
+
+  /**
+   * Start the background flusher thread. Whenever fewer than low_watermark of the free frames and the next
+   * high_watermark victims of the replacer are clean, it writes back the dirty ones among those victims, so that
+   * victims rarely need to be written back by the thread looking for a frame.
+   */
+  virtual void StartFlusher(size_t low_watermark, size_t high_watermark) = 0;
+
+  /**
+   * Stop the background flusher thread if it is running.
+   */
+  virtual void StopFlusher() = 0;
+
+  /** @return number of dirty victims written back synchronously while looking for a free frame */
+  virtual uint64_t GetForegroundFlushCount() = 0;
+
+  /** @return number of dirty pages cleaned by the background flusher */
+  virtual uint64_t GetBackgroundFlushCount() = 0;
+
+  /**
+   * Hint that the pages on a chain will be read soon. A background thread brings up to depth pages of the chain,
+   * starting from page_id, into free frames or frames of victims, without pinning them.
+   * @param next_page_id returns the page following the given page on the chain, or INVALID_PAGE_ID at the end
+   * @param ring if not null, pages are read into frames of this ring
+   */
+  virtual void PrefetchChain(page_id_t page_id, size_t depth, std::function<page_id_t(Page *)> next_page_id,
+                             std::shared_ptr<BufferRing> ring = nullptr);
+
+  /**
+   * Make the pool follow the WAL rule: before a dirty page is written, the log is flushed up to the LSN of the page.
+   */
+  virtual void SetLogManager(LogManager *log_manager) { log_manager_ = log_manager; }
+
+  /**
+   * Tell the disk manager how a range of pages is going to be read, see DiskManager::AdviseAccess.
+   */
+  void AdviseAccess(AccessHint hint, page_id_t page_id, size_t num_pages) {
+    disk_manager_->AdviseAccess(hint, page_id, num_pages);
+  }
+
+  /** @return number of pages read by the prefetcher */
+  virtual uint64_t GetPrefetchCount() = 0;
+
+  /**
+   * @return the pages in the pool, the most recently used ones first
+   */
+  virtual std::vector<page_id_t> GetResidentPages() = 0;
+
+  /**
+   * Save the ids of the pages in the pool, so that a restarted pool can warm up from them, e.g. on shutdown.
+   * @return false if the file can't be written
+   */
+  bool DumpResidentPages(const std::string &file_name);
+
+  /**
+   * Start reading the pages saved by DumpResidentPages in the background, in the order of their offsets in the file.
+   * Only free frames are filled, so the warm up never evicts a page fetched meanwhile. At most as many pages as there
+   * are free frames are read, the most recently used ones are preferred.
+   * @return the number of pages to be read, 0 if there is no usable dump
+   */
+  size_t WarmUp(const std::string &file_name);
+
+  /**
+   * Wait until the pages of the last WarmUp have been read.
+   */
+  void WaitForWarmUp();
+
+  /**
+   * @return a snapshot of the statistics of the pool, e.g. to tell whether it is large enough
+   */
+  virtual BufferPoolStats GetStats() = 0;
+
+  /**
+   * @return the dirty pages in the pool, and when each of them was dirtied for the first time since its last write
+   * back. With a log manager, this is the recovery LSN of the page: its changes which may not be on the disk are
+   * logged from there on, and a pinned page is in it too, from when it was pinned. Otherwise, a counter increased on
+   * every clean to dirty transition.
+   */
+  virtual std::unordered_map<page_id_t, uint64_t> GetDirtyPageTable() = 0;
+
+protected:
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
    */
@@ -47,15 +164,61 @@ private:
    */
   void DeallocatePage(page_id_t page_id);
 
+  /**
+   * Read a page ahead if it is not in the pool yet.
+   * @return the page following page_id on the chain, INVALID_PAGE_ID if the read ahead should stop
+   */
+  virtual page_id_t ReadAhead(page_id_t page_id, const std::function<page_id_t(Page *)> &next_page_id,
+                              BufferRing *ring) = 0;
+
+  /**
+   * Read pages which are not in the pool yet into free frames, never evicting anything. The reads are kept in flight
+   * together on io_queue.
+   */
+  virtual void ReadAheadPages(const std::vector<page_id_t> &page_ids, PageIOQueue *io_queue) = 0;
+
+  /**
+   * Stop the prefetcher thread if it is running, pending requests are dropped.
+   */
+  void StopPrefetcher();
+
+  /**
+   * Stop the warm up if it is running, the pages which have not been read yet are skipped.
+   */
+  void StopWarmUp();
+
+  /**
+   * Flush the log up to the largest LSN of the pages about to be written, for the WAL rule
+   * @return false if the log can't be written, the pages must not be written then
+   */
+  bool FlushLogFor(const std::vector<std::pair<page_id_t, const char *>> &pages);
 
-private:
-  size_t pool_size_;                                        // number of pages in buffer pool
-  Page *pages_;                                             // array of pages
   DiskManager *disk_manager_;                               // pointer to the disk manager.
-  std::unordered_map<page_id_t, frame_id_t> page_table_;    // to keep track of pages
-  Replacer *replacer_;                                      // to find an unpinned page for replacement
-  std::list<frame_id_t> free_list_;                         // to find a free page for replacement
-  recursive_mutex latch_;                                   // to protect shared data structure
+  LogManager *log_manager_{nullptr};                        // the log flushed before pages are written, if any
+  std::atomic<uint64_t> new_page_failures_{0};              // NewPage calls which found no frame
+
+private:
+  /**
+   * Main loop of the prefetcher thread.
+   */
+  void PrefetcherLoop();
+
+  /** A chain of pages to read ahead */
+  struct PrefetchRequest {
+    page_id_t page_id;
+    size_t depth;
+    std::function<page_id_t(Page *)> next_page_id;
+    std::shared_ptr<BufferRing> ring;
+  };
+
+  std::thread prefetcher_;                                  // prefetcher thread, started by the first hint
+  bool prefetcher_running_{false};                          // protected by prefetch_mutex_
+  std::deque<PrefetchRequest> prefetch_queue_;              // pending hints, the oldest ones are dropped first
+  std::mutex prefetch_mutex_;
+  std::condition_variable prefetch_cv_;
+
+  std::thread warmer_;                                      // reads the pages of a dump, see WarmUp
+  std::atomic<bool> warmer_running_{false};
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
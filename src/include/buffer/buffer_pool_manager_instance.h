@@ -0,0 +1,241 @@
+#ifndef MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+#define MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
+#include "page/disk_file_meta_page.h"
+
+/**
+ * BufferPoolManagerInstance keeps pages in a fixed number of frames, on their way to and from the disk. The frames
+ * are found through the page table, and a replacer picks the page to evict when none is free.
+ */
+class BufferPoolManagerInstance : public BufferPoolManager {
+  friend class ParallelBufferPoolManager;
+
+public:
+  explicit BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                     ReplacerType replacer_type = kLRUReplacer);
+
+  ~BufferPoolManagerInstance() override;
+
+  Page *FetchPage(page_id_t page_id, BufferRing *ring = nullptr) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  bool FlushPage(page_id_t page_id) override;
+
+  bool FlushAllPage() override;
+
+  Page *NewPage(page_id_t &page_id) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  bool CheckAllPinned() override;
+
+  bool CheckAllUnpinned() override;
+
+  size_t GetPoolSize() override { return pool_size_; }
+
+  bool Resize(size_t pool_size) override;
+
+  void StartFlusher(size_t low_watermark, size_t high_watermark) override;
+
+  void StopFlusher() override;
+
+  uint64_t GetForegroundFlushCount() override { return foreground_flushes_.load(); }
+
+  uint64_t GetBackgroundFlushCount() override { return background_flushes_.load(); }
+
+  uint64_t GetPrefetchCount() override { return prefetched_pages_.load(); }
+
+  std::vector<page_id_t> GetResidentPages() override;
+
+  BufferPoolStats GetStats() override;
+
+  std::unordered_map<page_id_t, uint64_t> GetDirtyPageTable() override;
+
+protected:
+  page_id_t ReadAhead(page_id_t page_id, const std::function<page_id_t(Page *)> &next_page_id,
+                      BufferRing *ring) override;
+
+  void ReadAheadPages(const std::vector<page_id_t> &page_ids, PageIOQueue *io_queue) override;
+
+private:
+  /** @return a new replacer of the type of this pool */
+  Replacer *NewReplacer(size_t num_pages);
+
+  /**
+   * Add frames at the end of the pool, called with the latch held. The frames dropped by an earlier shrink are taken
+   * back first.
+   */
+  void GrowFrames(size_t pool_size);
+
+  /**
+   * Drop the frames at the end of the pool, called with the latch held. A frame holding a pinned page keeps it until
+   * the page is unpinned for the last time, the other pages are evicted right away.
+   */
+  void ShrinkFrames(size_t pool_size);
+
+  /**
+   * Evict the page of a dropped frame on its last unpin, called with the latch held.
+   */
+  void RetireFrame(frame_id_t frame_id);
+
+  /**
+   * Resize everything kept per frame once the frames have been added or dropped.
+   */
+  void ResizeFrameState(size_t pool_size);
+
+  /**
+   * Bring an already allocated page id into a frame of this pool, the page is zeroed and pinned.
+   * @return nullptr if there is no frame can be used
+   */
+  Page *NewPageFrame(page_id_t page_id);
+
+  /**
+   * Put a page which has been read ahead into a free frame or the frame of a victim, called with the latch held.
+   * @return nullptr if all the frames are pinned
+   */
+  Page *InstallReadAhead(page_id_t page_id, const char *data, BufferRing *ring);
+
+  /**
+   * Follow the chain from a page in the pool without waiting for its latch, called with the latch held.
+   * @return INVALID_PAGE_ID if writers kept changing the page
+   */
+  page_id_t NextOnChain(Page *page, const std::function<page_id_t(Page *)> &next_page_id);
+
+  /** @return the counter of the writes of page_id, the pages share WRITE_EPOCH_SLOTS counters */
+  inline std::atomic<uint64_t> &WriteEpoch(page_id_t page_id) { return write_epochs_[page_id % WRITE_EPOCH_SLOTS]; }
+
+  /**
+   * Take a frame from the free list, or evict a victim and write it back if it is dirty.
+   * @param foreground whether the caller waits for the frame, only used for statistics
+   * @return false if all the frames are pinned
+   */
+  bool FindReplaceFrame(frame_id_t &frame_id, bool foreground = true);
+
+  /**
+   * Take a frame for page_id from the ring. Once the ring is full, its oldest page is evicted if nobody uses it.
+   * @return false if all the frames are pinned
+   */
+  bool FindRingFrame(BufferRing *ring, page_id_t page_id, frame_id_t &frame_id);
+
+  /**
+   * Lock latch_, and account the time spent waiting for it.
+   */
+  void LockLatch();
+
+  /**
+   * Record when the frame got its first pin, in time and in the log, called with the latch held.
+   */
+  void StartPin(frame_id_t frame_id);
+
+  /**
+   * Add the time the frame has been pinned to the pin duration histogram, called when its last pin is released.
+   */
+  void RecordPinDuration(frame_id_t frame_id);
+
+  /**
+   * Make sure the background flusher neither writes nor cleans the frame, called before the frame is used.
+   * Does not wait for a write already in flight, see WaitForBackgroundWrite.
+   */
+  void CancelBackgroundFlush(frame_id_t frame_id);
+
+  /**
+   * Wait until the background flusher is not writing the page any more, called before the page is written in the
+   * foreground so that the older snapshot can't overwrite it.
+   */
+  void WaitForBackgroundWrite(page_id_t page_id);
+
+  /**
+   * Collect the pages a checkpoint has to write: the dirty ones, and the pinned ones which may be modified.
+   */
+  void CollectCheckpointPages(std::vector<std::pair<page_id_t, const char *>> &pages);
+
+  /**
+   * Mark the unpinned pages clean once the checkpoint has written them.
+   */
+  void CleanCheckpointPages();
+
+  /**
+   * Mark the page in the frame dirty, and record it in the dirty page table if it was clean.
+   */
+  void MarkDirty(frame_id_t frame_id);
+
+  /**
+   * Mark the page in the frame clean after it has been written back, or dropped.
+   */
+  void MarkClean(frame_id_t frame_id);
+
+  /**
+   * Main loop of the background flusher thread.
+   */
+  void FlusherLoop();
+
+  /**
+   * One round of the background flusher, the writes are kept in flight together on io_queue.
+   */
+  void BackgroundFlush(PageIOQueue *io_queue);
+
+  size_t pool_size_;                                        // number of pages in buffer pool
+  std::deque<Page> pages_;                                  // frames, never moved or freed by a resize
+  PageTable page_table_;                                    // to keep track of pages
+  Replacer *replacer_;                                      // to find an unpinned page for replacement
+  ReplacerType replacer_type_{kLRUReplacer};
+  std::list<frame_id_t> free_list_;                         // to find a free page for replacement
+  std::atomic<size_t> unpinned_frames_{0};                  // free frames plus frames with a zero pin count
+  size_t draining_frames_{0};                               // dropped frames which still hold a pinned page
+  recursive_mutex latch_;                                   // to protect shared data structure
+  std::vector<uint64_t> last_unpinned_;                     // when the frame was unpinned for the last time
+  uint64_t unpin_clock_{0};                                 // increased on every last unpin
+  std::atomic<uint64_t> foreground_flushes_{0};             // dirty victims written back while fetching
+  std::atomic<uint64_t> background_flushes_{0};             // dirty pages cleaned by the flusher
+  std::unordered_map<page_id_t, uint64_t> dirty_page_table_;// dirty pages and when they were first dirtied
+  uint64_t dirty_clock_{0};                                 // increased on every clean to dirty transition
+
+  /** State of a frame in a round of the background flusher */
+  enum FlushState : uint8_t { kFlushNone = 0, kFlushQueued, kFlushDone, kFlushCancelled };
+
+  std::thread flusher_;                                     // background flusher thread
+  bool flusher_running_{false};                             // protected by flusher_mutex_
+  size_t low_watermark_{0};                                 // flush when fewer clean evictable frames than this
+  size_t high_watermark_{0};                                // flush until this many clean evictable frames
+  std::mutex flusher_mutex_;                                // to sleep and wake up the flusher
+  std::condition_variable flusher_cv_;
+  std::mutex flush_io_latch_;                               // protects the flush states and the writes in flight
+  std::condition_variable flush_io_cv_;                     // notified when background writes complete
+  std::unordered_set<page_id_t> flush_in_flight_;           // pages being written by the flusher
+  std::unique_ptr<std::atomic<uint8_t>[]> flush_states_;    // FlushState of every frame
+  std::atomic<uint64_t> write_epochs_[WRITE_EPOCH_SLOTS]{}; // increased on every page write, to detect stale reads
+
+  std::atomic<uint64_t> prefetched_pages_{0};               // pages read by the prefetcher
+
+  /** Statistics, see BufferPoolStats */
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> evictions_{0};
+  std::atomic<uint64_t> dirty_writebacks_{0};
+  std::atomic<uint64_t> latch_wait_ns_{0};
+  std::atomic<uint64_t> pin_histogram_[PIN_HISTOGRAM_BUCKETS]{};
+  std::vector<std::chrono::steady_clock::time_point> pin_started_;  // when the frame was pinned the first time
+  std::vector<lsn_t> pin_lsn_;                              // next LSN of the log then, or when it was last cleaned
+};
+
+#endif  // MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
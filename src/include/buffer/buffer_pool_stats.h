@@ -0,0 +1,73 @@
+#ifndef MINISQL_BUFFER_POOL_STATS_H
+#define MINISQL_BUFFER_POOL_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/config.h"
+
+/**
+ * A snapshot of the statistics of a buffer pool, see BufferPoolManager::GetStats.
+ *
+ * The counters are accumulated since the buffer pool was created, the page counts describe the pool at the moment
+ * the snapshot was taken. Bucket 0 of the pin duration histogram counts the pins released within 1 microsecond,
+ * bucket i counts the ones released within [2^(i-1), 2^i) microseconds, and the last bucket all the longer ones.
+ */
+struct BufferPoolStats {
+  size_t pool_size{0};              // number of frames
+  size_t resident_pages{0};         // frames holding a page
+  size_t dirty_pages{0};            // frames holding a page which is not written back yet
+  size_t pinned_pages{0};           // frames which can not be evicted
+  uint64_t hits{0};                 // FetchPage calls finding the page in the pool
+  uint64_t misses{0};               // FetchPage calls reading the page from disk
+  uint64_t evictions{0};            // pages evicted to make room for another one
+  uint64_t dirty_writebacks{0};     // dirty pages written back, whoever wrote them
+  uint64_t foreground_flushes{0};   // dirty victims written back by the thread looking for a frame
+  uint64_t background_flushes{0};   // dirty pages written back by the background flusher
+  uint64_t prefetched_pages{0};     // pages read ahead
+  uint64_t new_page_failures{0};    // NewPage calls returning nullptr
+  uint64_t latch_wait_ns{0};        // time spent waiting for the latch of the pool
+  uint64_t pin_duration_histogram[PIN_HISTOGRAM_BUCKETS]{};
+
+  /** @return the bucket of the pin duration histogram counting a pin released within us microseconds */
+  static inline size_t GetPinBucket(uint64_t us) {
+    size_t bucket = 0;
+    while (us > 0 && bucket < PIN_HISTOGRAM_BUCKETS - 1) {
+      us >>= 1;
+      bucket++;
+    }
+    return bucket;
+  }
+
+  /** @return the smallest duration in microseconds counted by a bucket of the pin duration histogram */
+  static inline uint64_t GetPinBucketLowerBound(size_t bucket) { return bucket == 0 ? 0 : 1ull << (bucket - 1); }
+
+  /** @return the fraction of FetchPage calls served without reading the disk */
+  inline double HitRate() const {
+    uint64_t total = hits + misses;
+    return total == 0 ? 0 : 1.0 * hits / total;
+  }
+
+  /** Add up the statistics of another buffer pool, e.g. of another instance */
+  BufferPoolStats &operator+=(const BufferPoolStats &other) {
+    pool_size += other.pool_size;
+    resident_pages += other.resident_pages;
+    dirty_pages += other.dirty_pages;
+    pinned_pages += other.pinned_pages;
+    hits += other.hits;
+    misses += other.misses;
+    evictions += other.evictions;
+    dirty_writebacks += other.dirty_writebacks;
+    foreground_flushes += other.foreground_flushes;
+    background_flushes += other.background_flushes;
+    prefetched_pages += other.prefetched_pages;
+    new_page_failures += other.new_page_failures;
+    latch_wait_ns += other.latch_wait_ns;
+    for (size_t i = 0; i < PIN_HISTOGRAM_BUCKETS; i++) {
+      pin_duration_histogram[i] += other.pin_duration_histogram[i];
+    }
+    return *this;
+  }
+};
+
+#endif  // MINISQL_BUFFER_POOL_STATS_H
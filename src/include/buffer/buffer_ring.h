@@ -0,0 +1,60 @@
+#ifndef MINISQL_BUFFER_RING_H
+#define MINISQL_BUFFER_RING_H
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+class BufferPoolManager;
+
+/**
+ * How a reader is going to access the pages it fetches.
+ */
+enum AccessStrategy {
+  kNormalAccess = 0,  // pages compete for the whole buffer pool
+  kBulkReadAccess     // pages only go through a small ring of frames, e.g. large sequential scans
+};
+
+/**
+ * BufferRing is a small private set of frames used by a bulk reader, e.g. a full table scan. Once the ring is full,
+ * a page read by the reader replaces the oldest page of the ring instead of a victim of the replacer, so that a large
+ * scan does not wipe out the rest of the buffer pool.
+ *
+ * The ring only remembers which frames it used, the frames stay owned by the buffer pool: a frame which has been
+ * pinned by somebody else, or reused for another page, is simply replaced by a new one taken from the buffer pool.
+ * The slots of every buffer pool instance are protected by the latch of that instance.
+ */
+class BufferRing {
+  friend class BufferPoolManagerInstance;
+
+public:
+  explicit BufferRing(size_t size = BUFFER_RING_SIZE) : size_(size) {}
+
+  /** @return the max number of frames used in every buffer pool instance */
+  inline size_t GetSize() const { return size_; }
+
+private:
+  struct Slot {
+    frame_id_t frame_id;
+    page_id_t page_id;
+  };
+
+  struct Slots {
+    std::vector<Slot> slots;
+    size_t next{0};                                       // oldest slot, replaced first once the ring is full
+  };
+
+  /** @return the slots of the given buffer pool instance */
+  Slots &GetSlots(const BufferPoolManager *owner) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    return slots_[owner];
+  }
+
+  size_t size_;
+  std::mutex latch_;                                      // protects the map, not the slots
+  std::unordered_map<const BufferPoolManager *, Slots> slots_;
+};
+
+#endif  // MINISQL_BUFFER_RING_H
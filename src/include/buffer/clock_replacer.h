@@ -0,0 +1,59 @@
+#ifndef MINISQL_CLOCK_REPLACER_H
+#define MINISQL_CLOCK_REPLACER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Every frame owns an atomic state word holding its "evictable" flag and its reference bit. Pin and Unpin only swap
+ * that word, so they are wait-free and never allocate. Victim sweeps the clock hand over the frames, clearing the
+ * reference bits it passes, and takes the first evictable frame whose reference bit is already cleared.
+ */
+class ClockReplacer : public Replacer {
+public:
+  /**
+   * Create a new ClockReplacer.
+   * @param num_pages the maximum number of pages the ClockReplacer will be required to store
+   */
+  explicit ClockReplacer(size_t num_pages);
+
+  /**
+   * Destroys the ClockReplacer.
+   */
+  ~ClockReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  std::vector<frame_id_t> NextVictims(size_t max_frames) override;
+
+  size_t Size() override;
+
+private:
+  static constexpr uint8_t EVICTABLE = 1;
+  static constexpr uint8_t REFERENCED = 2;
+
+  size_t num_pages_;
+  // state word of every frame, combination of EVICTABLE and REFERENCED
+  unique_ptr<atomic<uint8_t>[]> states_;
+  // number of evictable frames
+  atomic<size_t> size_{0};
+  // position of the clock hand, only moved by Victim
+  size_t hand_{0};
+  // serializes the sweeps of the clock hand
+  mutex victim_latch_;
+};
+
+#endif  // MINISQL_CLOCK_REPLACER_H
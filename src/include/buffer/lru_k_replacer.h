@@ -0,0 +1,72 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The backward K-distance of a frame is the time elapsed since its K-th most recent access. The victim is the
+ * evictable frame with the largest backward K-distance. Frames accessed less than K times have an infinite
+ * K-distance and are evicted first, the one with the earliest access goes first among them. A single scan thus only
+ * evicts pages touched once, and keeps the pages which are repeatedly referenced.
+ *
+ * An access is recorded every time a frame is pinned.
+ */
+class LRUKReplacer : public Replacer {
+public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of accesses remembered for every frame
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = 2);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  std::vector<frame_id_t> NextVictims(size_t max_frames) override;
+
+  size_t Size() override;
+
+private:
+  /** (has less than k accesses ? 0 : 1, timestamp of the k-th most recent or the earliest access) */
+  using EvictKey = pair<uint64_t, uint64_t>;
+
+  /** @return the key to order frame_id among the evictable frames, the smaller one is evicted first */
+  EvictKey GetEvictKey(frame_id_t frame_id) const;
+
+private:
+  size_t num_pages_;
+  size_t k_;
+  // logical clock, increased on every access
+  uint64_t current_timestamp_{0};
+  // the last k access timestamps of every frame, stored as a ring of k slots per frame
+  vector<uint64_t> history_;
+  // number of accesses of every frame, only the last k of them are kept in history_
+  vector<size_t> access_count_;
+  // whether a frame can be victimized
+  vector<bool> evictable_;
+  // evictable frames ordered by their evict key
+  set<pair<EvictKey, frame_id_t>> evict_set_;
+  //latch
+  mutex latch_;
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
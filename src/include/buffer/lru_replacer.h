@@ -33,6 +33,8 @@ public:
 
   void Unpin(frame_id_t frame_id) override;
 
+  std::vector<frame_id_t> NextVictims(size_t max_frames) override;
+
   size_t Size() override;
 
 private:
@@ -0,0 +1,83 @@
+#ifndef MINISQL_PAGE_TABLE_H
+#define MINISQL_PAGE_TABLE_H
+
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+
+/**
+ * PageTable maps the page ids resident in a buffer pool to their frames.
+ *
+ * It is an open addressing hash table with linear probing, whose slots are allocated once from the number of frames
+ * and kept at most half full, so that neither a lookup nor an update allocates memory or chases pointers. A slot packs
+ * the page id and the frame id into a single word, erased entries are closed up by shifting the following entries
+ * backward instead of leaving tombstones.
+ *
+ * It is not thread safe, the caller serializes lookups and updates, e.g. with the latch of the buffer pool, which it
+ * holds anyway to pin the frame it found.
+ */
+class PageTable {
+public:
+  /**
+   * @param capacity the maximum number of entries, i.e. the number of frames of the buffer pool
+   */
+  explicit PageTable(size_t capacity);
+
+  /**
+   * @return false if the page is not in the table
+   */
+  bool Find(page_id_t page_id, frame_id_t *frame_id) const;
+
+  /**
+   * Map page_id to frame_id, replacing the frame of page_id if it is already in the table.
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @return false if the page is not in the table
+   */
+  bool Erase(page_id_t page_id);
+
+  /**
+   * Change the maximum number of entries, the entries are rehashed into new slots.
+   */
+  void Resize(size_t capacity);
+
+  inline size_t Size() const { return size_; }
+
+  inline bool Empty() const { return Size() == 0; }
+
+private:
+  static constexpr uint64_t kEmptySlot = ~0ULL;
+
+  static inline uint64_t Pack(page_id_t page_id, frame_id_t frame_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+
+  static inline page_id_t UnpackPageId(uint64_t slot) { return static_cast<page_id_t>(slot >> 32); }
+
+  static inline frame_id_t UnpackFrameId(uint64_t slot) { return static_cast<frame_id_t>(slot & 0xffffffffULL); }
+
+  /** @return the slot a page id hashes to, i.e. where its probe sequence starts */
+  inline size_t Home(page_id_t page_id) const {
+    // fibonacci hashing spreads the consecutive page ids over the table
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL) >> shift_;
+  }
+
+  /** Allocate empty slots for the given capacity */
+  void AllocateSlots(size_t capacity);
+
+  /** @return the slot holding page_id, or the number of slots if it is not in the table */
+  size_t Locate(page_id_t page_id) const;
+
+private:
+  size_t capacity_;
+  size_t num_slots_;                                        // a power of 2, at least twice the capacity
+  size_t mask_;
+  int shift_;                                               // 64 - log2(num_slots_)
+  std::unique_ptr<uint64_t[]> slots_;
+  size_t size_{0};
+};
+
+#endif  // MINISQL_PAGE_TABLE_H
@@ -0,0 +1,98 @@
+#ifndef MINISQL_PARALLEL_BUFFER_POOL_MANAGER_H
+#define MINISQL_PARALLEL_BUFFER_POOL_MANAGER_H
+
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+
+/**
+ * ParallelBufferPoolManager splits the frames into several independent BufferPoolManagerInstance. Every instance
+ * owns its frames, page table, replacer and latch, and a page is always served by instance (page_id % num_instances),
+ * so that threads working on different pages seldom contend on the same latch.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+public:
+  /**
+   * @param num_instances number of buffer pool instances
+   * @param pool_size total number of frames, shared out among the instances
+   * @param disk_manager disk manager shared by all the instances
+   * @param replacer_type replacement policy of every instance
+   */
+  explicit ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                     ReplacerType replacer_type = kLRUReplacer);
+
+  ~ParallelBufferPoolManager() override;
+
+  /** The frames are shared out among the instances again, the number of instances does not change. */
+  bool Resize(size_t pool_size) override;
+
+  Page *FetchPage(page_id_t page_id, BufferRing *ring = nullptr) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  bool FlushPage(page_id_t page_id) override;
+
+  bool FlushAllPage() override;
+
+  /**
+   * The page is created in the instance of the lowest free page id, or in the next instance which has a frame to
+   * spare with the lowest free page id it serves, so that a fully pinned instance does not fail every NewPage.
+   */
+  Page *NewPage(page_id_t &page_id) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  bool CheckAllPinned() override;
+
+  bool CheckAllUnpinned() override;
+
+  size_t GetPoolSize() override { return pool_size_; }
+
+  void SetLogManager(LogManager *log_manager) override;
+
+  /** Every instance runs its own flusher, the watermarks are shared out like the frames. */
+  void StartFlusher(size_t low_watermark, size_t high_watermark) override;
+
+  void StopFlusher() override;
+
+  uint64_t GetForegroundFlushCount() override;
+
+  uint64_t GetBackgroundFlushCount() override;
+
+  /** The statistics of all the instances added up. */
+  BufferPoolStats GetStats() override;
+
+  std::unordered_map<page_id_t, uint64_t> GetDirtyPageTable() override;
+
+  uint64_t GetPrefetchCount() override;
+
+  /** The pages of the instances interleaved, so that each of them keeps its most recently used pages first. */
+  std::vector<page_id_t> GetResidentPages() override;
+
+  /** @return the number of buffer pool instances */
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
+protected:
+  /** The chain is followed by the prefetcher of this object, every page is read into the instance holding it. */
+  page_id_t ReadAhead(page_id_t page_id, const std::function<page_id_t(Page *)> &next_page_id,
+                      BufferRing *ring) override;
+
+  void ReadAheadPages(const std::vector<page_id_t> &page_ids, PageIOQueue *io_queue) override;
+
+private:
+  /** @return the buffer pool instance responsible for page_id */
+  inline BufferPoolManagerInstance *GetInstance(page_id_t page_id) {
+    return instances_[page_id % instances_.size()];
+  }
+
+  /**
+   * Allocate the lowest free page id above after which is served by the given instance
+   * @return INVALID_PAGE_ID if there is none
+   */
+  page_id_t AllocatePageOf(size_t instance, page_id_t after);
+
+  size_t pool_size_;                                        // total number of frames of the instances
+  std::vector<BufferPoolManagerInstance *> instances_;
+};
+
+#endif  // MINISQL_PARALLEL_BUFFER_POOL_MANAGER_H
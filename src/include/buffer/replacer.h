@@ -2,8 +2,19 @@
 #define MINISQL_REPLACER_H
 
 #include <cstdio>
+#include <vector>
+
 #include "common/config.h"
 
+/**
+ * Replacement policies which can be chosen when a buffer pool is constructed.
+ */
+enum ReplacerType {
+  kLRUReplacer = 0,
+  kLRUKReplacer,
+  kClockReplacer
+};
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -32,6 +43,13 @@ public:
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Look at the frames Victim would remove next, if nothing is pinned or unpinned in the meantime.
+   * @param max_frames the maximum number of frames returned
+   * @return the frames in the order they would be victimized
+   */
+  virtual std::vector<frame_id_t> NextVictims(size_t max_frames) = 0;
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
@@ -66,8 +66,11 @@ private:
  */
 class CatalogManager {
 public:
+  /**
+   * @param version_store the older versions of the rows read by the transactions, given to the table heaps if any
+   */
   explicit CatalogManager(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager,
-                          LogManager *log_manager, bool init);
+                          LogManager *log_manager, bool init, VersionStore *version_store = nullptr);
 
   ~CatalogManager();
 
@@ -102,6 +105,7 @@ private:
   [[maybe_unused]] BufferPoolManager *buffer_pool_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
   [[maybe_unused]] LogManager *log_manager_;
+  VersionStore *version_store_;
   [[maybe_unused]] CatalogMeta *catalog_meta_;
   [[maybe_unused]] std::atomic<table_id_t> next_table_id_;
   [[maybe_unused]] std::atomic<index_id_t> next_index_id_;
@@ -15,6 +15,26 @@ static constexpr int INDEX_ROOTS_PAGE_ID = 1;        // logical page id of the i
 
 static constexpr int PAGE_SIZE = 4096;               // size of a data page in byte
 static constexpr int DEFAULT_BUFFER_POOL_SIZE = 2048;// default size of buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_INSTANCES = 1;// default number of buffer pool instances
+static constexpr int FLUSHER_INTERVAL_MS = 50;       // how often the background flusher wakes up by itself
+static constexpr size_t FLUSHER_SCAN_BATCH = 32;     // frames the background flusher looks at per hold of the latch
+static constexpr int READ_AHEAD_PAGES = 8;           // number of pages read ahead by a sequential scan
+static constexpr int PREFETCH_QUEUE_SIZE = 16;       // max number of pending prefetch requests
+static constexpr size_t WRITE_EPOCH_SLOTS = 256;     // write counters of a buffer pool, shared by page id modulo
+static constexpr int BUFFER_RING_SIZE = 32;          // number of frames a bulk reader may use in a buffer pool
+static constexpr size_t PIN_HISTOGRAM_BUCKETS = 16;  // buckets of the pin duration histogram, powers of 2 in us
+static constexpr int OPTIMISTIC_READ_RETRIES = 3;    // optimistic page reads before falling back to the latch
+static constexpr size_t ASYNC_IO_QUEUE_DEPTH = 32;   // max number of page I/Os a thread keeps in flight
+static constexpr uint32_t PREALLOCATION_PAGES = 1024;// pages the db file is grown by at once, 0 to grow page by page
+static constexpr size_t LOG_BUFFER_SIZE = 32 * PAGE_SIZE;// size of each of the two log buffers
+static constexpr int LOG_FLUSH_INTERVAL_MS = 20;     // how often the log flush thread wakes up by itself
+static constexpr int CHECKPOINT_INTERVAL_MS = 10000; // how often a fuzzy checkpoint is taken
+static constexpr size_t MAX_CHECKPOINT_DELETED_ROWS = LOG_BUFFER_SIZE / 32;// deleted rows a checkpoint lists at most
+static constexpr size_t LOCK_TABLE_SHARDS = 16;      // number of independently latched parts of the lock table
+static constexpr int DEADLOCK_DETECTION_INTERVAL_MS = 50;// how often the wait-for graph is searched for cycles
+static constexpr size_t VERSION_STORE_SHARDS = 16;   // number of independently latched parts of the version store
+static constexpr int VERSION_GC_INTERVAL = 64;       // transactions ended between two garbage collections of versions
+static constexpr uint32_t WARM_UP_DUMP_MAGIC = 0x504d4442;  // "BDMP", first word of a buffer pool dump file
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
 static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;    // max length of varchar
@@ -24,7 +44,7 @@ static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;    // max length of v
 using page_id_t = int32_t;
 using frame_id_t = int32_t;
 using txn_id_t = int32_t;
-using lsn_t = int32_t;
+using lsn_t = int64_t;
 using column_id_t = uint32_t;
 using index_id_t = uint32_t;
 using table_id_t = uint32_t;
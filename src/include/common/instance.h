@@ -4,25 +4,60 @@
 #include <memory>
 #include <string>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "catalog/catalog.h"
 #include "common/config.h"
 #include "common/dberr.h"
 #include "storage/disk_manager.h"
+#include "transaction/lock_manager.h"
+#include "transaction/log_manager.h"
+#include "transaction/recovery_manager.h"
+#include "transaction/txn_manager.h"
 
 class DBStorageEngine {
 public:
   explicit DBStorageEngine(std::string db_name, bool init = true,
-                           uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE)
+                           uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE,
+                           uint32_t buffer_pool_instances = DEFAULT_BUFFER_POOL_INSTANCES,
+                           ReplacerType replacer_type = kLRUReplacer,
+                           DiskReadMode read_mode = kReadPread,
+                           PageCompression compression = kCompressionNone,
+                           bool enable_logging = true)
           : db_file_name_(std::move(db_name)), init_(init) {
     // Init database file if needed
     if (init_) {
       remove(db_file_name_.c_str());
+      remove(GetWarmUpFileName().c_str());
     }
     // Initialize components
-    disk_mgr_ = new DiskManager(db_file_name_);
-    bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
-    catalog_mgr_ = new CatalogManager(bpm_, nullptr, nullptr, init);
+    disk_mgr_ = new DiskManager(db_file_name_, kSyncOnCheckpoint, read_mode, compression);
+    if (buffer_pool_instances > 1) {
+      bpm_ = new ParallelBufferPoolManager(buffer_pool_instances, buffer_pool_size, disk_mgr_, replacer_type);
+    } else {
+      bpm_ = new BufferPoolManagerInstance(buffer_pool_size, disk_mgr_, replacer_type);
+    }
+    // The changes of the table pages go to the log, which is written ahead of the pages. An existing database is
+    // recovered from it, in case it was not shut down cleanly. The transactions lock the rows they use.
+    if (enable_logging) {
+      log_mgr_ = new LogManager(disk_mgr_);
+      lock_mgr_ = new LockManager();
+      lock_mgr_->RunDeadlockDetection();
+      txn_mgr_ = new TransactionManager(log_mgr_, bpm_, lock_mgr_);
+      bpm_->SetLogManager(log_mgr_);
+      recovery_mgr_ = new RecoveryManager(disk_mgr_, bpm_, log_mgr_, txn_mgr_);
+      if (!init_) {
+        recovery_mgr_->Recover();
+      }
+      log_mgr_->RunFlushThread();
+      recovery_mgr_->RunCheckpointThread();
+      txn_mgr_->RunGarbageCollectionThread();
+    }
+    // Keep some clean frames ready for eviction so that fetches seldom wait on a write back
+    bpm_->StartFlusher(buffer_pool_size / 16, buffer_pool_size / 8);
+    // The transactions read their snapshot of the tables from the versions kept by the transaction manager
+    catalog_mgr_ = new CatalogManager(bpm_, lock_mgr_, log_mgr_, init,
+                                      txn_mgr_ != nullptr ? txn_mgr_->GetVersionStore() : nullptr);
     // Allocate static page for db storage engine
     if (init) {
       page_id_t id;
@@ -35,19 +70,38 @@ public:
     } else {
       ASSERT(!bpm_->IsPageFree(CATALOG_META_PAGE_ID), "Invalid catalog meta page.");
       ASSERT(!bpm_->IsPageFree(INDEX_ROOTS_PAGE_ID), "Invalid header page.");
+      // Bring back the pages which were in the pool at the last shutdown
+      bpm_->WarmUp(GetWarmUpFileName());
     }
   }
 
   ~DBStorageEngine() {
+    delete recovery_mgr_;
+    if (txn_mgr_ != nullptr) {
+      // it removes rows from the pages of the buffer pool
+      txn_mgr_->StopGarbageCollectionThread();
+    }
     delete catalog_mgr_;
+    bpm_->DumpResidentPages(GetWarmUpFileName());
     delete bpm_;
+    delete txn_mgr_;
+    delete lock_mgr_;
+    delete log_mgr_;
     delete disk_mgr_;
   }
 
+  /** @return the file keeping the pages in the buffer pool across restarts */
+  std::string GetWarmUpFileName() const { return db_file_name_ + ".bpdump"; }
+
 public:
   DiskManager *disk_mgr_;
   BufferPoolManager *bpm_;
   CatalogManager *catalog_mgr_;
+  // null without logging
+  LogManager *log_mgr_{nullptr};
+  TransactionManager *txn_mgr_{nullptr};
+  LockManager *lock_mgr_{nullptr};
+  RecoveryManager *recovery_mgr_{nullptr};
   std::string db_file_name_;
   bool init_;
 };
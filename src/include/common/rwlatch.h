@@ -1,9 +1,11 @@
 #ifndef MINISQL_RWLATCH_H
 #define MINISQL_RWLATCH_H
 
+#include <atomic>
 #include <climits>
 #include <condition_variable>
 #include <mutex>
+#include <thread>
 #include "macros.h"
 
 
@@ -85,4 +87,160 @@ private:
   bool writer_entered_{false};
 };
 
+/**
+ * Reader-Writer latch kept in a single atomic word, the drop-in replacement of ReaderWriterLatch used by pages.
+ *
+ * An uncontended RLock/RUnlock or WLock/WUnlock is a single compare-and-swap on the word. A thread which can't take
+ * the latch spins briefly, since the latches of pages are usually held for a few hundred instructions, and then parks
+ * on a condition variable. The mutex of the condition variable is only touched by parked threads and by the threads
+ * waking them up.
+ *
+ * With writer preference, a writer waiting for the latch keeps new readers out, so that a stream of readers can not
+ * starve it. Without it, readers get in as long as no writer holds the latch, which gives more read throughput.
+ */
+class HybridReaderWriterLatch {
+  static constexpr uint32_t WRITER = 1U << 31;                // set while a writer holds the latch
+  static constexpr uint32_t WAITING_WRITER = 1U << 16;        // one writer waiting, with writer preference
+  static constexpr uint32_t WAITING_WRITER_MASK = WRITER - WAITING_WRITER;
+  static constexpr uint32_t READER_MASK = WAITING_WRITER - 1;  // number of readers holding the latch
+  static constexpr uint32_t SPIN_COUNT = 64;
+
+public:
+  explicit HybridReaderWriterLatch(bool prefer_writer = true) : prefer_writer_(prefer_writer) {}
+
+  ~HybridReaderWriterLatch() = default;
+
+  DISALLOW_COPY(HybridReaderWriterLatch);
+
+  /**
+   * Acquire a write latch.
+   */
+  void WLock() {
+    if (TryWLock()) {
+      return;
+    }
+    if (prefer_writer_) {
+      state_.fetch_add(WAITING_WRITER);
+    }
+    uint32_t spins = 0;
+    while (!TryWLockOnce(prefer_writer_ ? WAITING_WRITER : 0)) {
+      if (spins++ < SPIN_COUNT) {
+        Pause(spins);
+      } else {
+        Park([this] { return (state_.load() & (WRITER | READER_MASK)) == 0; });
+      }
+    }
+  }
+
+  /**
+   * @return false if the latch is held
+   */
+  bool TryWLock() { return TryWLockOnce(0); }
+
+  /**
+   * Release a write latch.
+   */
+  void WUnlock() {
+    state_.fetch_sub(WRITER);
+    WakeUp();
+  }
+
+  /**
+   * Acquire a read latch.
+   */
+  void RLock() {
+    uint32_t spins = 0;
+    while (!TryRLock()) {
+      if (spins++ < SPIN_COUNT) {
+        Pause(spins);
+      } else {
+        Park([this] { return CanRead(state_.load()); });
+      }
+    }
+  }
+
+  /**
+   * @return false if a writer holds the latch, or waits for it with writer preference
+   */
+  bool TryRLock() {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    while (CanRead(state)) {
+      if (state_.compare_exchange_weak(state, state + 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Release a read latch.
+   */
+  void RUnlock() {
+    uint32_t state = state_.fetch_sub(1);
+    ASSERT((state & READER_MASK) != 0, "RUnlock failed.");
+    // only writers wait for the readers to leave
+    if ((state & READER_MASK) == 1) {
+      WakeUp();
+    }
+  }
+
+private:
+  inline bool CanRead(uint32_t state) const {
+    return (state & WRITER) == 0 && (state & READER_MASK) != READER_MASK &&
+           !(prefer_writer_ && (state & WAITING_WRITER_MASK) != 0);
+  }
+
+  /**
+   * Take the write latch if it is free, and withdraw the waiting mark of the caller at the same time.
+   */
+  inline bool TryWLockOnce(uint32_t waiting) {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    while ((state & (WRITER | READER_MASK)) == 0) {
+      if (state_.compare_exchange_weak(state, state - waiting + WRITER)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static inline void Pause(uint32_t spins) {
+    if (spins < SPIN_COUNT / 2) {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    } else {
+      // let the holder run if it shares our core
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * Sleep until ready() may have become true. Whoever changes the state checks parked_ afterwards, and a parked thread
+   * checks the state after it has been counted in parked_, so a wake up can't be missed in between.
+   */
+  template <typename Ready>
+  void Park(Ready ready) {
+    parked_.fetch_add(1);
+    {
+      std::unique_lock<std::mutex> latch(park_mutex_);
+      park_cv_.wait(latch, ready);
+    }
+    parked_.fetch_sub(1);
+  }
+
+  inline void WakeUp() {
+    if (parked_.load() != 0) {
+      // a parked thread is either about to check the state, or waiting on the condition variable
+      { std::lock_guard<std::mutex> guard(park_mutex_); }
+      park_cv_.notify_all();
+    }
+  }
+
+  std::atomic<uint32_t> state_{0};
+  std::atomic<uint32_t> parked_{0};                           // threads sleeping on park_cv_
+  const bool prefer_writer_;
+  std::mutex park_mutex_;
+  std::condition_variable park_cv_;
+};
+
 #endif  // MINISQL_RWLATCH_H
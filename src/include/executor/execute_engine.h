@@ -77,6 +77,14 @@ private:
 
   dberr_t ExecuteUpdate(pSyntaxNode ast, ExecuteContext *context);
 
+  /**
+   * Run a statement reading or changing rows in the transaction of the context. Outside of a transaction, the
+   * statement runs in a transaction of its own, which commits with it when the database is logged. A transaction
+   * aborted to break a deadlock, or for changing a row changed since it started, is rolled back.
+   */
+  dberr_t ExecuteInTransaction(pSyntaxNode ast, ExecuteContext *context,
+                               dberr_t (ExecuteEngine::*execute)(pSyntaxNode, ExecuteContext *));
+
   dberr_t ExecuteTrxBegin(pSyntaxNode ast, ExecuteContext *context);
 
   dberr_t ExecuteTrxCommit(pSyntaxNode ast, ExecuteContext *context);
@@ -87,10 +95,14 @@ private:
 
   dberr_t ExecuteQuit(pSyntaxNode ast, ExecuteContext *context);
 
+  dberr_t ExecuteShowStatus(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteSetVariable(pSyntaxNode ast, ExecuteContext *context);
+
 private:
   [[maybe_unused]] std::unordered_map<std::string, DBStorageEngine *> dbs_;  /** all opened databases */
   [[maybe_unused]] std::string current_db_;  /** current database */
-  DBStorageEngine * cur_db;
+  DBStorageEngine * cur_db{nullptr};  /** current database, null until USE */
 };
 
 #endif //MINISQL_EXECUTE_ENGINE_H
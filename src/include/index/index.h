@@ -14,6 +14,9 @@ public:
 
   virtual ~Index() {}
 
+  /**
+   * @param txn if not null, the transaction making the change, which undoes it if it aborts
+   */
   virtual dberr_t InsertEntry(const Row &key, RowId row_id, Transaction *txn) = 0;
 
   virtual dberr_t RemoveEntry(const Row &key, RowId row_id, Transaction *txn) = 0;
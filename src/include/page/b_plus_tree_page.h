@@ -22,9 +22,9 @@ enum class IndexPageType {
  * It actually serves as a header part for each B+ tree page and
  * contains information shared by both leaf page and internal page.
  *
- * Header format (size in byte, 24 bytes in total):
+ * Header format (size in byte, 28 bytes in total):
  * ----------------------------------------------------------------------------
- * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
+ * | PageType (4) | LSN (8) | CurrentSize (4) | MaxSize (4) |
  * ----------------------------------------------------------------------------
  * | ParentPageId (4) | PageId(4) |
  * ----------------------------------------------------------------------------
@@ -62,7 +62,8 @@ public:
 private:
   // member variable, attributes that both internal and leaf page share
   [[maybe_unused]] IndexPageType page_type_;
-  [[maybe_unused]] lsn_t lsn_;
+  // at Page::OFFSET_LSN like in every page, so it is not aligned
+  [[maybe_unused]] char lsn_[sizeof(lsn_t)];
   [[maybe_unused]] int size_;
   [[maybe_unused]] int max_size_;
   [[maybe_unused]] page_id_t parent_page_id_;
@@ -6,6 +6,13 @@
 #include "common/macros.h"
 #include "common/config.h"
 
+/**
+ * BitmapPage records which pages of an extent are allocated, one bit per page.
+ *
+ * next_free_page_ is a hint kept with the bits: no page below it is free. Allocation starts scanning there, 64 pages
+ * at a time, so allocating the pages of an extent one after another costs O(1) amortized instead of a scan from the
+ * start of the bitmap every time.
+ */
 template<size_t PageSize>
 class BitmapPage {
 public:
@@ -20,6 +27,11 @@ public:
    */
   bool AllocatePage(uint32_t &page_offset);
 
+  /**
+   * @return true if the page at page_offset was free and is allocated now
+   */
+  bool AllocatePageAt(uint32_t page_offset);
+
   /**
    * @return true if successfully de-allocate a page.
    */
@@ -30,6 +42,11 @@ public:
    */
   bool IsPageFree(uint32_t page_offset) const;
 
+  /**
+   * @return number of allocated pages in the extent
+   */
+  uint32_t GetAllocatedPages() const { return page_allocated_; }
+
   //get data
   unsigned char* GetBitmap_Data(void){return bytes;}
 
@@ -46,8 +63,21 @@ private:
    */
   bool IsPageFreeLow(uint32_t byte_index, uint8_t bit_index) const;
 
+  /**
+   * @return the bits of pages [64 * word_index, 64 * word_index + 64), the lowest bit for the first page
+   */
+  inline uint64_t LoadWord(size_t word_index) const {
+    uint64_t word = 0;
+    for (size_t i = 8; i > 0; i--) {
+      word = (word << 8) | bytes[word_index * 8 + i - 1];
+    }
+    return word;
+  }
+
   /** Note: need to update if modify page structure. */
   static constexpr size_t MAX_CHARS = PageSize - 2 * sizeof(uint32_t);
+  static constexpr size_t MAX_WORDS = MAX_CHARS / 8;
+  static_assert(MAX_CHARS % 8 == 0, "The bitmap is scanned 64 bits at a time.");
   // MAX_CHARS: #byte
   // content = page size - page meta size(2*sizeof(uint32_t))  => unit of byte
   // bitmap stores everything in the unit of bit
@@ -55,7 +85,7 @@ private:
 private:
   /** The space occupied by all members of the class should be equal to the PageSize */
   [[maybe_unused]] uint32_t page_allocated_=0;//add:=0
-  [[maybe_unused]] uint32_t next_free_page_=0;//add:=0
+  [[maybe_unused]] uint32_t next_free_page_=0;//add:=0, no page below it is free
   [[maybe_unused]] unsigned char bytes[MAX_CHARS]={0};//add:=0
 };
 
@@ -6,10 +6,22 @@
 
 #include "page/bitmap_page.h"
 
-static constexpr page_id_t MAX_VALID_PAGE_ID = (PAGE_SIZE - 8) / 4 * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+/** Marks a meta page which records its format version, the last word but one of the page */
+static constexpr uint32_t DISK_FILE_MAGIC = 0x4D53514C;
+/**
+ * Version of the layout of the pages of a db file.
+ * 0: no magic nor version, the meta page has two more extent counters. Bitmap pages hold their allocation counter
+ *    and free page hint before the bits, but the hint was not maintained by every release.
+ * 1: magic and version at the end of the meta page.
+ * 2: the LSN in the header of the table pages and the B+ tree pages is 8 bytes long instead of 4.
+ */
+static constexpr uint32_t DISK_FILE_FORMAT_VERSION = 2;
 
-//(PAGE_SIZE - 8) -> bytes of num_allocated_pages_ and uint32_t num_extents_
-//every page need 4 bytes to store information
+//(PAGE_SIZE - 16) -> bytes of num_allocated_pages_, num_extents_, magic_ and version_
+//every extent needs 4 bytes to store its number of used pages
+static constexpr size_t META_EXTENT_SLOTS = (PAGE_SIZE - 16) / 4;
+
+static constexpr page_id_t MAX_VALID_PAGE_ID = META_EXTENT_SLOTS * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
 
 class DiskFileMetaPage {
 public:
@@ -28,11 +40,18 @@ public:
     return extent_used_page_[extent_id];
   }
 
+  /**
+   * @return the format version of the file, 0 if the meta page was written before the version was recorded
+   */
+  uint32_t GetFormatVersion() const { return magic_ == DISK_FILE_MAGIC ? version_ : 0; }
+
   //ctor
   explicit DiskFileMetaPage(char* meta_data){
     memcpy(&num_allocated_pages_, meta_data, sizeof(uint32_t));
     memcpy(&num_extents_, meta_data + sizeof(uint32_t), sizeof(uint32_t));
-    memcpy(extent_used_page_, meta_data + 2 * sizeof(uint32_t), (PAGE_SIZE - 8) / 4 * sizeof(uint32_t));
+    memcpy(extent_used_page_, meta_data + 2 * sizeof(uint32_t), META_EXTENT_SLOTS * sizeof(uint32_t));
+    memcpy(&magic_, meta_data + PAGE_SIZE - 2 * sizeof(uint32_t), sizeof(uint32_t));
+    memcpy(&version_, meta_data + PAGE_SIZE - sizeof(uint32_t), sizeof(uint32_t));
   }
   DiskFileMetaPage(){}
 
@@ -40,7 +59,11 @@ public:
 public:
   uint32_t num_allocated_pages_;
   uint32_t num_extents_;   // each extent consists with a bit map and BIT_MAP_SIZE pages
-  uint32_t extent_used_page_[(PAGE_SIZE - 8) / 4]={0}; //record the #used pages of the extent_id extent
+  uint32_t extent_used_page_[META_EXTENT_SLOTS]={0}; //record the #used pages of the extent_id extent
+  uint32_t magic_{DISK_FILE_MAGIC};
+  uint32_t version_{DISK_FILE_FORMAT_VERSION};
 };
 
+static_assert(sizeof(DiskFileMetaPage) == PAGE_SIZE, "The meta page must fill a page.");
+
 #endif //MINISQL_DISK_FILE_META_PAGE_H
@@ -1,6 +1,7 @@
 #ifndef MINISQL_PAGE_H
 #define MINISQL_PAGE_H
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 #include <shared_mutex>
@@ -16,6 +17,7 @@
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
+  friend class BufferPoolManagerInstance;
 
 public:
   DISALLOW_COPY(Page)
@@ -38,11 +40,18 @@ public:
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline bool IsDirty() { return is_dirty_; }
 
-  /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  /** Acquire the page write latch, optimistic readers are told about the write by an odd version. */
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -50,6 +59,23 @@ public:
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start an optimistic read, which takes no latch at all. The reader copies what it needs out of the page, and may
+   * only use the copy once ValidateOptimisticRead has confirmed that no writer has latched the page meanwhile. The
+   * copied values can be torn until then, so offsets read from the page must be bounds checked before being followed.
+   * @return false if a writer holds the page right now
+   */
+  inline bool OptimisticRLatch(uint64_t *version) {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0;
+  }
+
+  /** @return true if the page has not been written since OptimisticRLatch returned version */
+  inline bool ValidateOptimisticRead(uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -58,9 +84,9 @@ public:
 
 protected:
   static_assert(sizeof(page_id_t) == 4);
-  static_assert(sizeof(lsn_t) == 4);
+  static_assert(sizeof(lsn_t) == 8);
 
-  static constexpr size_t SIZE_PAGE_HEADER = 8;
+  static constexpr size_t SIZE_PAGE_HEADER = 12;
   static constexpr size_t OFFSET_PAGE_START = 0;
   static constexpr size_t OFFSET_LSN = 4;
 
@@ -77,7 +103,9 @@ private:
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
   bool is_dirty_ = false;
   /** Page latch. */
-  ReaderWriterLatch rwlatch_;
+  HybridReaderWriterLatch rwlatch_;
+  /** Increased when the write latch is taken and when it is released, odd while a writer holds the page. */
+  std::atomic<uint64_t> version_{0};
 };
 
 #endif  // MINISQL_PAGE_H
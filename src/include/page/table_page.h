@@ -10,7 +10,7 @@
  *
  *  Header format (size in bytes):
  *  ----------------------------------------------------------------------------
- *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) |
+ *  | PageId (4)| LSN (8)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) |
  *  ----------------------------------------------------------------------------
  *  ----------------------------------------------------------------
  *  | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
@@ -25,6 +25,7 @@
 #include "transaction/lock_manager.h"
 #include "transaction/log_manager.h"
 #include "transaction/transaction.h"
+#include "transaction/version_store.h"
 
 class TablePage : public Page {
 public:
@@ -57,11 +58,73 @@ public:
 
   bool GetTuple(Row *row, Schema *schema, Transaction *txn, LockManager *lock_manager);
 
+  /**
+   * Same as GetTuple, but reads the tuple optimistically without taking the page latch. Falls back to the read latch
+   * after OPTIMISTIC_READ_RETRIES reads have been overlapped by a writer. The caller must not hold the page latch.
+   */
+  bool GetTupleOptimistic(Row *row, Schema *schema, Transaction *txn, LockManager *lock_manager);
+
   bool GetFirstTupleRid(RowId *first_rid);
 
   bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
 
+  /**
+   * Read the version of a tuple which a transaction sees, from the page or from the version store. The page must be
+   * latched.
+   */
+  bool GetVisibleTuple(Row *row, Schema *schema, Transaction *txn, VersionStore *version_store);
+
+  /**
+   * Find the first tuple from slot_num on which a transaction sees. The page must be latched.
+   */
+  bool GetFirstVisibleTupleRid(uint32_t slot_num, RowId *rid, Transaction *txn, VersionStore *version_store);
+
+  /**
+   * Copy the serialized tuple of a slot
+   * @return false if the slot holds no tuple, or a deleted one
+   */
+  bool GetTupleData(uint32_t slot_num, std::string *tuple);
+
+  /**
+   * @return true if the slot holds a tuple marked as deleted, which is not removed yet
+   */
+  bool IsMarkedDeleted(uint32_t slot_num);
+
+  /**
+   * Apply again the change of a log record, for the redo of the recovery. The page must be in the state the change
+   * was made from, i.e. its LSN is below the one of the record. A new page record initializes the new page, and links
+   * the previous page to it.
+   */
+  void Redo(const LogRecord &record);
+
+  /**
+   * Revert the change of a log record of txn, and log the reverse change as a compensation record
+   */
+  void Undo(const LogRecord &record, Transaction *txn, LogManager *log_manager);
+
 private:
+  /**
+   * Append a log record of a change of the page, and stamp its LSN into the page and into the transaction
+   */
+  void Log(LogRecord &record, Transaction *txn, LogManager *log_manager);
+
+  /**
+   * Lock the row of a slot for an insert, without waiting. A slot emptied by a transaction which is still running stays
+   * locked by it until it ends, its rollback puts the tuple back there.
+   * @return false if the slot can't be taken now
+   */
+  bool LockSlot(uint32_t slot_num, Transaction *txn, LockManager *lock_manager);
+
+  /**
+   * Put a serialized tuple into an empty slot, or into a new slot at the end of the slot array
+   */
+  void InsertTupleAt(uint32_t slot_num, const std::string &tuple);
+
+  /**
+   * Replace the tuple in a slot by a serialized tuple, which must fit in the page
+   */
+  void UpdateTupleAt(uint32_t slot_num, const std::string &tuple);
+
   uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
 
   void SetFreeSpacePointer(uint32_t free_space_pointer) {
@@ -101,14 +164,14 @@ private:
 private:
   static_assert(sizeof(page_id_t) == 4);
   static constexpr uint64_t DELETE_MASK = (1U << (8 * sizeof(uint32_t) - 1));
-  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
+  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 28;
   static constexpr size_t SIZE_TUPLE = 8;
-  static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
-  static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
-  static constexpr size_t OFFSET_FREE_SPACE = 16;
-  static constexpr size_t OFFSET_TUPLE_COUNT = 20;
-  static constexpr size_t OFFSET_TUPLE_OFFSET = 24;
-  static constexpr size_t OFFSET_TUPLE_SIZE = 28;
+  static constexpr size_t OFFSET_PREV_PAGE_ID = 12;
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 16;
+  static constexpr size_t OFFSET_FREE_SPACE = 20;
+  static constexpr size_t OFFSET_TUPLE_COUNT = 24;
+  static constexpr size_t OFFSET_TUPLE_OFFSET = 28;
+  static constexpr size_t OFFSET_TUPLE_SIZE = 32;
 
 public:
   static constexpr size_t SIZE_MAX_ROW = PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE;
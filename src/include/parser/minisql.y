@@ -7,6 +7,8 @@
   int yyerror(char* error);
 %}
 
+%define api.header.include {"parser/minisql_yacc.h"}
+
 %union {
 	pSyntaxNode syntax_node;
 }
@@ -27,7 +29,7 @@
 %type <syntax_node> sql_select select_columns column_values column_value operator
 %type <syntax_node> connector where_conditions where_condition
 %type <syntax_node> sql_insert sql_delete sql_update update_values update_value
-%type <syntax_node> sql_quit sql_exec_file
+%type <syntax_node> sql_quit sql_exec_file sql_show_status sql_set_variable
 
 %%
 
@@ -58,6 +60,8 @@ sql:
   | sql_trx_rollback { $$ = $1; }
   | sql_quit { $$ = $1; }
   | sql_exec_file { $$ = $1; }
+  | sql_show_status { $$ = $1; }
+  | sql_set_variable { $$ = $1; }
   ;
 
 sql_create_database:
@@ -195,6 +199,22 @@ sql_show_indexes:
   }
   ;
 
+sql_show_status:
+  SHOW IDENTIFIER {
+    /* STATUS is not a keyword, so that it can still be used as a column name, the executor checks the name */
+    $$ = CreateSyntaxNode(kNodeShowStatus, NULL);
+    SyntaxNodeAddChildren($$, $2);
+  }
+  ;
+
+sql_set_variable:
+  SET IDENTIFIER EQ NUMBER {
+    $$ = CreateSyntaxNode(kNodeSetVariable, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddChildren($$, $4);
+  }
+  ;
+
 sql_select:
   SELECT select_columns FROM IDENTIFIER {
     $$ = CreateSyntaxNode(kNodeSelect, NULL);
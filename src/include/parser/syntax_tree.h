@@ -43,7 +43,9 @@ typedef enum {
   kNodeIndexType, /** type of index */
   kNodeTrxBegin, /** begin transaction command */
   kNodeTrxCommit, /** commit transaction command */
-  kNodeTrxRollback /** rollback transaction command */
+  kNodeTrxRollback, /** rollback transaction command */
+  kNodeShowStatus, /** show status command */
+  kNodeSetVariable /** set variable command, eg: set buffer_pool_size = 4096 */
 } SyntaxNodeType;
 
 /**
@@ -0,0 +1,162 @@
+#ifndef MINISQL_COMPRESSED_PAGE_STORE_H
+#define MINISQL_COMPRESSED_PAGE_STORE_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+/**
+ * CompressedPageStore keeps the compressed images of the pages of a db file in a slot file next to it.
+ *
+ * A page is compressed with LZPageCodec when it is written, and stored if it shrinks to MAX_COMPRESSED_SIZE or less.
+ * Its image, prefixed by its length, is packed into a slot of whole SLOT_SIZE units, found through an indirection map
+ * from the physical page id. A page which is rewritten keeps its slot as long as its image needs as many units,
+ * otherwise it moves to another slot, written before the map points to it.
+ *
+ * Slot file format:
+ * | Header | Slots and map regions | .... |
+ * The header is the first unit, it holds two copies of the location of the map, written in turn. The map is saved by
+ * Sync and Close into the map region of the copy not in use, so the map of the other copy stays valid until the new
+ * one is complete. A slot left by a page is reused only once a map without it is saved, so that the pages of the last
+ * saved map are found after a crash, as they were then or rewritten in place since.
+ *
+ * The map has its own latch, the slots are read and written outside of it: the buffer pool never reads or writes a
+ * page while it is being written.
+ */
+class CompressedPageStore {
+public:
+  /**
+   * Open the slot file, or create it if it does not exist
+   * @param max_page_id the map entries of pages from this one on are invalid
+   * @throw std::exception if the file can't be opened
+   */
+  CompressedPageStore(const std::string &file_name, page_id_t max_page_id);
+
+  ~CompressedPageStore() { Close(false); }
+
+  DISALLOW_COPY(CompressedPageStore);
+
+  /**
+   * Read the page if it is stored compressed
+   * @return the number of bytes read from the slot file, 0 if the page is not stored here
+   */
+  size_t ReadPage(page_id_t physical_page_id, char *page_data);
+
+  /**
+   * Store the page compressed if it compresses well enough, otherwise drop the image stored so far.
+   * @return false if the page must be written uncompressed
+   */
+  bool WritePage(page_id_t physical_page_id, const char *page_data);
+
+  /**
+   * Force the slots written so far and the map to the disk
+   */
+  void Sync();
+
+  /**
+   * Save the map and close the slot file
+   */
+  void Close(bool sync);
+
+  /**
+   * Number of pages stored compressed, used for statistics
+   */
+  size_t GetNumPages();
+
+  /**
+   * Number of bytes of compressed images written, used for statistics
+   */
+  uint64_t GetNumBytesWritten() const { return num_bytes_written_.load(); }
+
+  static constexpr size_t SLOT_SIZE = 256;
+  static constexpr size_t MAX_COMPRESSED_SIZE = PAGE_SIZE * 3 / 4;
+  static constexpr size_t MAX_SLOT_UNITS = MAX_COMPRESSED_SIZE / SLOT_SIZE;
+
+private:
+  /** A slot of the slot file, units is 0 if the page is not stored compressed */
+  struct Slot {
+    uint32_t offset{0};                                     // in units
+    uint32_t units{0};
+  };
+
+  /** A map entry in the slot file */
+  struct MapEntry {
+    page_id_t physical_page_id;
+    Slot slot;
+  };
+
+  /** A copy of the header of the slot file */
+  struct Header {
+    uint32_t magic;
+    uint32_t num_entries;
+    uint32_t num_units;                                     // size of the slot file when the map was saved
+    Slot map_region;                                        // may be larger than the map, to let it grow
+    uint64_t sequence;                                      // the valid copy with the larger one is in use
+    uint64_t checksum;
+  };
+
+  static constexpr uint32_t MAGIC = 0x4d4c5a53;               // "SZLM"
+  static constexpr size_t HEADER_UNITS = 1;
+  static constexpr size_t HEADER_COPY_SIZE = SLOT_SIZE / 2;
+  static_assert(sizeof(Header) <= HEADER_COPY_SIZE, "A copy of the header must fit in half a unit.");
+
+  static uint64_t Checksum(const Header &header);
+
+  /**
+   * Load the map of the header copy in use, drop the entries which don't fit in the file, and put the gaps between
+   * the slots into the free lists
+   */
+  void LoadMap();
+
+  /**
+   * Save the map if it changed since it was saved last, and free the slots it does not use any more
+   * @param sync whether the slots and the map are forced to the disk
+   * @return false if the map can't be written, the map saved before stays in use then
+   */
+  bool SaveMap(bool sync);
+
+  /**
+   * Stop using the slot of a page, the slot is freed once a map without it is saved
+   */
+  void DropSlot(Slot &slot);
+
+  /**
+   * @return offset in units of a free slot of units units, the file grows if there is none
+   */
+  uint32_t AllocateSlot(uint32_t units);
+
+  /**
+   * Put units from offset on into the free lists, cut into slots of at most MAX_SLOT_UNITS units
+   */
+  void FreeUnits(uint32_t offset, uint32_t units);
+
+  bool SyncFile();
+
+  bool WriteAt(const char *data, size_t size, size_t offset);
+
+  bool ReadAt(char *data, size_t size, size_t offset);
+
+  int fd_{-1};
+  std::string file_name_;
+  page_id_t max_page_id_;
+  std::mutex latch_;
+  // indexed by physical page id
+  std::vector<Slot> slots_;
+  // free_slots_[u] are the offsets of the free slots of u units
+  std::vector<uint32_t> free_slots_[MAX_SLOT_UNITS + 1];
+  // slots left by pages since the map was saved, the saved map may still point to them
+  std::vector<Slot> dropped_slots_;
+  // size of the slot file in units, with the header and the map regions
+  uint32_t num_units_{HEADER_UNITS};
+  // map_regions_[s % 2] is the map region of the header copy of sequence s
+  Slot map_regions_[2];
+  uint64_t sequence_{0};
+  bool map_dirty_{false};
+  std::atomic<uint64_t> num_bytes_written_{0};
+};
+
+#endif  // MINISQL_COMPRESSED_PAGE_STORE_H
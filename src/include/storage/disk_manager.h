@@ -2,14 +2,53 @@
 #define DISK_MGR_H
 
 #include <atomic>
-#include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
+#include "storage/compressed_page_store.h"
+#include "storage/page_io_queue.h"
+
+/**
+ * When the pages written by a DiskManager are forced to the disk with fdatasync. Without a sync they are handed over
+ * to the OS, which survives a crash of the process but not of the machine.
+ */
+enum SyncPolicy {
+  kSyncNever,         // leave it to the OS, e.g. for temporary databases and tests
+  kSyncOnCheckpoint,  // after a batch of pages is written by WritePages, e.g. FlushAllPage, and on Close
+  kSyncAlways         // after every write
+};
+
+/**
+ * How a DiskManager reads pages from the db file.
+ */
+enum DiskReadMode {
+  kReadPread,         // a pread syscall per page
+  kReadMmap           // a memcpy from a read only mapping of the file, for read mostly databases
+};
+
+/**
+ * Whether a DiskManager compresses the pages it writes, see CompressedPageStore.
+ */
+enum PageCompression {
+  kCompressionNone,
+  kCompressionLZ      // the pages which compress well are stored in the slot file, the others in the db file
+};
+
+/**
+ * How the pages of the db file are going to be read, passed on to the OS to tune its read ahead.
+ */
+enum AccessHint {
+  kAccessHintNormal,
+  kAccessHintSequential,  // e.g. table heap scans
+  kAccessHintRandom       // e.g. index probes
+};
 
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
@@ -20,19 +59,22 @@
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
  */
 class DiskManager {
+  friend class PageIOQueue;
+
 public:
-  explicit DiskManager(const std::string &db_file);
+  /**
+   * Open the db file, or create it if it does not exist.
+   * With kReadMmap, the file is mapped as it is when opened. Writes still go through pwrite, the mapping sees them
+   * through the page cache, and pages appended to the file later are read with pread.
+   * With kCompressionLZ, the compressed pages go to the slot file, GetSlotFileName. A db file which already has a
+   * slot file is always opened with compression.
+   * @throw std::exception if the file can't be opened, or its format version is not DISK_FILE_FORMAT_VERSION
+   */
+  explicit DiskManager(const std::string &db_file, SyncPolicy sync_policy = kSyncOnCheckpoint,
+                       DiskReadMode read_mode = kReadPread, PageCompression compression = kCompressionNone);
 
   ~DiskManager() {
-    memcpy(meta_data_, &(Meta_Page_->num_allocated_pages_), sizeof(uint32_t));
-    memcpy(meta_data_ + sizeof(uint32_t), &(Meta_Page_->num_extents_), sizeof(uint32_t));
-    memcpy(meta_data_ + 2 * sizeof(uint32_t), Meta_Page_->extent_used_page_, (PAGE_SIZE - 8) / 4 * sizeof(uint32_t));
-    WritePhysicalPage(META_PAGE_ID, meta_data_);
-    uint32_t SIZE = DiskManager::BITMAP_SIZE;
-    for(uint32_t extent = 0; extent < Meta_Page_->num_extents_; extent++){
-      WritePhysicalPage(extent*( SIZE + 1 ) + 1, (char *)Bitmap_Page_[extent].GetBitmap_Data());
-    //delete Bitmap_Page_[extent];
-    }
+    WriteMetaData();
     delete Meta_Page_;
     if (!closed) {
       Close();
@@ -40,7 +82,7 @@ public:
   }
 
   /**
-   * Read page from specific page_id
+   * Read page from specific page_id, may run concurrently with other reads and writes of different pages
    * Note: page_id = 0 is reserved for disk meta page
    */
   void ReadPage(page_id_t logical_page_id, char *page_data);
@@ -51,12 +93,66 @@ public:
    */
   void WritePage(page_id_t logical_page_id, const char *page_data);
 
+  /**
+   * Write a batch of pages, sorted by their physical offset. Pages which are adjacent in the file are written
+   * together with one single vectored write, straight from their buffers, and the writes are kept in flight together
+   * when io_uring is available.
+   * @param pages pairs of logical page id and page data
+   */
+  void WritePages(std::vector<std::pair<page_id_t, const char *>> pages);
+
+  /**
+   * Append size bytes to the log file, GetLogFileName, and force them to the disk unless the policy is kSyncNever
+   * @return false if the bytes could not be written or synced, they may be partly in the log then
+   */
+  bool WriteLog(const char *log_data, size_t size);
+
+  /**
+   * Read up to size bytes of the log file starting at offset
+   * @return the number of bytes read, 0 at the end of the log
+   */
+  size_t ReadLog(char *log_data, size_t size, size_t offset);
+
+  /**
+   * Overwrite size bytes of the log file at offset, e.g. its header, and force them to the disk unless the policy is
+   * kSyncNever
+   * @return false if the bytes could not be written or synced
+   */
+  bool WriteLogAt(const char *log_data, size_t size, size_t offset);
+
+  /**
+   * Cut the log file down to size bytes, e.g. to drop a record torn by a crash
+   */
+  void TruncateLog(size_t size);
+
+  /**
+   * Give the space of size bytes of the log file at offset back to the file system. The file keeps its size, the
+   * bytes read as zeros from then on.
+   * @return false if the file system can't free a part of a file
+   */
+  bool DiscardLog(size_t offset, size_t size);
+
+  /** @return size of the log file */
+  size_t GetLogSize();
+
+  /**
+   * Create a queue to keep several page I/Os in flight, see PageIOQueue.
+   * @param use_io_uring false to get the synchronous backend even if io_uring is available
+   */
+  std::unique_ptr<PageIOQueue> NewIOQueue(size_t queue_depth = ASYNC_IO_QUEUE_DEPTH, bool use_io_uring = true);
+
   /**
    * Get next free page from disk
    * @return logical page id of allocated page
    */
   page_id_t AllocatePage();
 
+  /**
+   * Allocate a given page, e.g. to redo the allocation of a page which was lost in a crash
+   * @return false if the page is allocated already
+   */
+  bool AllocatePageAt(page_id_t logical_page_id);
+
   /**
    * Free this page and reset bit map
    */
@@ -67,11 +163,48 @@ public:
    */
   bool IsPageFree(page_id_t logical_page_id);
 
+  /**
+   * Force the pages written so far to the disk, unless the policy is kSyncNever.
+   */
+  void Sync();
+
+  /**
+   * Write the meta page and the bitmap pages and force them to the disk with the pages written so far, unless the
+   * policy is kSyncNever. Without it the allocations are only saved when the disk manager is destroyed.
+   */
+  void FlushMetaData();
+
   /**
    * Shut down the disk manager and close all the file resources.
    */
   void Close();
 
+  SyncPolicy GetSyncPolicy() const { return sync_policy_; }
+
+  /**
+   * @return the store of the compressed pages, nullptr without compression
+   */
+  CompressedPageStore *GetCompressedPageStore() const { return compressed_pages_.get(); }
+
+  static std::string GetSlotFileName(const std::string &db_file) { return db_file + ".slots"; }
+
+  static std::string GetLogFileName(const std::string &db_file) { return db_file + ".log"; }
+
+  /**
+   * Set how many pages the db file is grown by when a page beyond its end is allocated, 0 to let every write past
+   * the end grow the file by itself.
+   */
+  void SetPreallocationPages(uint32_t num_pages) { preallocation_pages_ = num_pages; }
+
+  /**
+   * Tell the OS how the pages from logical_page_id on are going to be read, so that a scan and index probes running
+   * together don't override each other's hint. The range ends with the extent of its first page, the only run of
+   * pages known to be contiguous in the file. A sequential hint asks for the read ahead of the range, with madvise
+   * on the mapping or posix_fadvise on the file. The other hints only apply to the mapping, posix_fadvise would apply
+   * them to the whole file.
+   */
+  void AdviseAccess(AccessHint hint, page_id_t logical_page_id, size_t num_pages);
+
   /**
    * Get Meta Page
    * Note: Used only for debug
@@ -80,47 +213,156 @@ public:
     return meta_data_;
   }
 
+  /**
+   * Number of write calls issued to the db file, used for statistics
+   */
+  uint64_t GetNumWrites() const { return num_writes_.load(); }
+
+  /**
+   * Number of pages read from the db file, used for statistics
+   */
+  uint64_t GetNumReads() const { return num_reads_.load(); }
+
+  /**
+   * Number of page reads served by the mapping of the file, used for statistics
+   */
+  uint64_t GetNumMappedReads() const { return num_mapped_reads_.load(); }
+
+  /**
+   * Number of bytes read from the db file and the slot file, used for statistics
+   */
+  uint64_t GetNumBytesRead() const { return num_bytes_read_.load(); }
+
+  /**
+   * Number of fdatasync calls of the db file, used for statistics
+   */
+  uint64_t GetNumSyncs() const { return num_syncs_.load(); }
+
+  /**
+   * Number of fallocate calls growing the db file, used for statistics
+   */
+  uint64_t GetNumPreallocations() const { return num_preallocations_.load(); }
+
   //bool ReleaseAll();
 
   static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+  static constexpr size_t MAX_EXTENTS = MAX_VALID_PAGE_ID / BITMAP_SIZE;
 
 private:
   /**
-   * Helper function to get disk file size
+   * Grow the cached file size after a write ending at end
    */
-  int GetFileSize(const std::string &file_name);
+  void ExtendFileSize(size_t end);
+
+  /**
+   * Make sure the space of a newly allocated physical page is reserved in the file, growing the file by a whole
+   * chunk of preallocation_pages_ pages with fallocate if it isn't. Called with db_io_latch_ held.
+   */
+  void Preallocate(page_id_t physical_page_id);
 
   /**
    * Read physical page from disk
    */
   void ReadPhysicalPage(page_id_t physical_page_id, char *page_data);
 
+  /**
+   * Open the log file the first time it is used. Called with log_io_latch_ held.
+   * @return false if it can't be opened
+   */
+  bool OpenLog();
+
   /**
    * Write data to physical page in disk
    */
   void WritePhysicalPage(page_id_t physical_page_id, const char *page_data);
 
+  /**
+   * Write num_pages physically contiguous pages starting at physical_page_id with one pwritev call, as long as the
+   * run is not longer than IOV_MAX pages
+   * @param pages one iovec per page
+   * @return false on an I/O error
+   */
+  bool WritePhysicalPages(page_id_t physical_page_id, const iovec *pages, size_t num_pages);
+
+  /**
+   * Account a write of num_pages pages starting at physical_page_id once it is done
+   */
+  void WriteCompleted(page_id_t physical_page_id, size_t num_pages);
+
   /**
    * Map logical page id to physical page id
    */
-  page_id_t MapPageId(page_id_t logical_page_id);
+  static page_id_t MapPageId(page_id_t logical_page_id);
+
+  /**
+   * @return false for the meta page and the bitmap pages, which are never compressed
+   */
+  static bool IsDataPage(page_id_t physical_page_id);
+
+  /**
+   * @return the first extent with a free page, opened or not, MAX_EXTENTS if the file is full
+   */
+  uint32_t FindExtentWithFreePage() const;
+
+  /**
+   * Record whether an extent has a free page in extent_has_free_
+   */
+  void SetExtentHasFree(uint32_t extent, bool has_free);
+
+  /**
+   * Copy the counters of the meta page changed by an allocation in extent into meta_data_
+   */
+  void UpdateMetaData(uint32_t extent);
+
+  /**
+   * Write the meta page and the bitmap pages
+   */
+  void WriteMetaData();
 
 private:
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of the db file, pages are read and written at their offset so that no cursor is shared
+  int db_fd_{-1};
+  // descriptor of the log file, opened by the first log I/O, and its size which is where the log is appended
+  int log_fd_{-1};
+  size_t log_size_{0};
+  std::recursive_mutex log_io_latch_;
   std::string file_name_;
-  // with multiple buffer pool instances, need to protect file access
+  SyncPolicy sync_policy_;
+  // size of the db file, reads beyond it return zeros without a syscall
+  std::atomic<size_t> file_size_{0};
+  // read only mapping of the first map_size_ bytes of the file with kReadMmap
+  char *map_{nullptr};
+  size_t map_size_{0};
+  // the file is grown by preallocation_pages_ at once, the space up to preallocated_size_ is reserved
+  uint32_t preallocation_pages_{PREALLOCATION_PAGES};
+  size_t preallocated_size_{0};
+  // with multiple buffer pool instances, need to protect the allocation of pages
   std::recursive_mutex db_io_latch_;
   //the file is open or closed
   bool closed{false};
+  //number of write calls, page reads, syncs and preallocations
+  std::atomic<uint64_t> num_writes_{0};
+  std::atomic<uint64_t> num_reads_{0};
+  std::atomic<uint64_t> num_syncs_{0};
+  std::atomic<uint64_t> num_mapped_reads_{0};
+  std::atomic<uint64_t> num_preallocations_{0};
+  std::atomic<uint64_t> num_bytes_read_{0};
+  // the compressed pages with kCompressionLZ
+  std::unique_ptr<CompressedPageStore> compressed_pages_;
+  // keeps the writes of WritePages in flight, created by the first call
+  std::unique_ptr<PageIOQueue> write_queue_;
+  std::mutex write_queue_latch_;
   //meta_data
   // uint32_t num_allocated_pages_+
   // uint32_t num_extents_+
-  // uint32_t extent_used_page_
+  // uint32_t extent_used_page_+
+  // uint32_t magic_, version_ at the end of the page
   char meta_data_[PAGE_SIZE];
   //adding necessary data structures
   //bit_maps
   BitmapPage<PAGE_SIZE> Bitmap_Page_[MAX_VALID_PAGE_ID/BITMAP_SIZE];
+  //bit e is set if extent e has a free page, so that the allocation finds one 64 extents at a time
+  uint64_t extent_has_free_[(MAX_EXTENTS + 63) / 64]{};
   //meta_page
   DiskFileMetaPage *Meta_Page_;
   //
@@ -0,0 +1,36 @@
+#ifndef MINISQL_LZ_PAGE_CODEC_H
+#define MINISQL_LZ_PAGE_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * LZPageCodec is a small LZ77 codec of the LZ4 family, fast enough to compress every page written to the disk.
+ *
+ * Compressed format: a sequence of
+ * | token (1B) | literal length (0+B) | literals | match offset (2B) | match length (0+B) |
+ * the high 4 bits of the token are the number of literals, the low 4 bits the length of the match minus MIN_MATCH,
+ * and 15 means that more bytes follow, each adding up to 255. The last sequence only has literals.
+ */
+class LZPageCodec {
+public:
+  /**
+   * Compress len bytes of src into dst.
+   * @return the compressed size, 0 if it does not fit into capacity bytes
+   */
+  static size_t Compress(const char *src, size_t len, char *dst, size_t capacity);
+
+  /**
+   * Decompress len bytes of src into exactly dst_len bytes of dst.
+   * @return false if src is not a valid compressed block of dst_len bytes
+   */
+  static bool Decompress(const char *src, size_t len, char *dst, size_t dst_len);
+
+  static constexpr size_t MIN_MATCH = 4;
+  static constexpr size_t MAX_OFFSET = UINT16_MAX;
+
+private:
+  static constexpr int HASH_BITS = 12;
+};
+
+#endif  // MINISQL_LZ_PAGE_CODEC_H
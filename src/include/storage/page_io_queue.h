@@ -0,0 +1,104 @@
+#ifndef MINISQL_PAGE_IO_QUEUE_H
+#define MINISQL_PAGE_IO_QUEUE_H
+
+#include <cstdint>
+#include <memory>
+#include <sys/uio.h>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+class DiskManager;
+
+/** A page I/O which has finished */
+struct PageIOCompletion {
+  uint64_t tag;                                             // given when the I/O was prepared
+  bool ok;                                                  // false on an I/O error
+};
+
+/**
+ * PageIOQueue keeps several page reads and writes of a DiskManager in flight at the same time.
+ *
+ * I/Os are prepared into the queue, issued together by Submit, and reaped by Wait. The buffers of an I/O must stay
+ * valid until it has completed. A queue is used by a single thread, e.g. the background flusher, every thread which
+ * wants to overlap its I/Os creates its own queue with DiskManager::NewIOQueue.
+ *
+ * The io_uring backend hands a whole batch to the kernel with a single syscall. Where io_uring is not available the
+ * synchronous backend performs the I/Os one by one with pread/pwrite in Submit, so the callers never need to care
+ * which one they got.
+ */
+class PageIOQueue {
+public:
+  virtual ~PageIOQueue() = default;
+
+  DISALLOW_COPY(PageIOQueue);
+
+  /**
+   * Queue the read of a logical page into data.
+   * @return false if queue depth I/Os are already prepared or in flight, Wait for some of them first
+   */
+  bool PrepareRead(page_id_t logical_page_id, char *data, uint64_t tag);
+
+  /**
+   * Queue the write of a logical page from data.
+   * @return false if queue depth I/Os are already prepared or in flight, Wait for some of them first
+   */
+  bool PrepareWrite(page_id_t logical_page_id, const char *data, uint64_t tag);
+
+  /**
+   * Issue the prepared I/Os.
+   * @return the number of I/Os issued
+   */
+  virtual size_t Submit() = 0;
+
+  /**
+   * Wait until at least min_complete I/Os have completed, or until nothing is in flight any more, and append all
+   * the completed ones to completions.
+   * @return the number of completions appended
+   */
+  virtual size_t Wait(std::vector<PageIOCompletion> &completions, size_t min_complete) = 0;
+
+  /** @return number of I/Os prepared or in flight */
+  size_t GetPending() const { return pending_; }
+
+  size_t GetQueueDepth() const { return queue_depth_; }
+
+  /** @return true if the I/Os really overlap, i.e. the queue is backed by io_uring */
+  virtual bool IsAsync() const = 0;
+
+protected:
+  friend class DiskManager;
+
+  PageIOQueue(DiskManager *disk_manager, size_t queue_depth) : disk_manager_(disk_manager), queue_depth_(queue_depth) {}
+
+  /**
+   * Queue an I/O of num_pages physically contiguous pages, one iovec per page, used by the disk manager for runs of
+   * adjacent pages. The iovecs of a run of more than one page must stay valid until the I/O has completed, the one of
+   * a single page is copied.
+   */
+  virtual bool PreparePhysical(page_id_t physical_page_id, const iovec *pages, size_t num_pages, bool is_write,
+                               uint64_t tag) = 0;
+
+  /** Synchronous I/Os and accounting of the disk manager, for the backends */
+  bool WriteSync(page_id_t physical_page_id, const iovec *pages, size_t num_pages);
+  void ReadSync(page_id_t physical_page_id, const iovec *pages, size_t num_pages);
+  void ReadCompleted(size_t num_pages);
+  void WriteCompleted(page_id_t physical_page_id, size_t num_pages);
+
+  /**
+   * @return an io_uring backed queue, or nullptr if io_uring can't be used on this system
+   */
+  static std::unique_ptr<PageIOQueue> NewIoUringQueue(DiskManager *disk_manager, int fd, size_t queue_depth);
+
+  /**
+   * @return a queue performing the I/Os synchronously
+   */
+  static std::unique_ptr<PageIOQueue> NewSyncQueue(DiskManager *disk_manager, size_t queue_depth);
+
+  DiskManager *disk_manager_;
+  size_t queue_depth_;
+  size_t pending_{0};
+};
+
+#endif  // MINISQL_PAGE_IO_QUEUE_H
@@ -11,16 +11,22 @@ class TableHeap {
   friend class TableIterator;
 
 public:
+  /**
+   * @param version_store the older versions of the rows, for the snapshot reads of the transactions; without it the
+   * reads see the newest version
+   */
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, Schema *schema, Transaction *txn,
-                           LogManager *log_manager, LockManager *lock_manager, MemHeap *heap) {
+                           LogManager *log_manager, LockManager *lock_manager, MemHeap *heap,
+                           VersionStore *version_store = nullptr) {
     void *buf = heap->Allocate(sizeof(TableHeap));
-    return new(buf) TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager);
+    return new(buf) TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager, version_store);
   }
 
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                           LogManager *log_manager, LockManager *lock_manager, MemHeap *heap) {
+                           LogManager *log_manager, LockManager *lock_manager, MemHeap *heap,
+                           VersionStore *version_store = nullptr) {
     void *buf = heap->Allocate(sizeof(TableHeap));
-    return new(buf) TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager);
+    return new(buf) TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager, version_store);
   }
 
   ~TableHeap() {}
@@ -72,15 +78,22 @@ public:
    */
   bool GetTuple(Row *row, Transaction *txn);
 
+  /**
+   * @return true if an index lookup may miss rows the transaction sees: the entries of a deleted row are removed with
+   * the delete, while an older snapshot still sees the row. The rows are to be read by a scan of the table then.
+   */
+  bool IndexMayMissRows(Transaction *txn) const { return IsSnapshotRead(txn) && version_store_->HasDeletedRows(); }
+
   /**
    * Free table heap and release storage in disk file
    */
   void FreeHeap();
 
   /**
+   * @param strategy kBulkReadAccess makes the iterator read the pages through a buffer ring, for large scans
    * @return the begin iterator of this table
    */
-  TableIterator Begin(Transaction *txn);
+  TableIterator Begin(Transaction *txn, AccessStrategy strategy = kNormalAccess);
 
   /**
    * @return the end iterator of this table
@@ -97,36 +110,64 @@ private:
    * create table heap and initialize first page
    */
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, Schema *schema, Transaction *txn,
-                     LogManager *log_manager, LockManager *lock_manager) :
+                     LogManager *log_manager, LockManager *lock_manager, VersionStore *version_store) :
           buffer_pool_manager_(buffer_pool_manager),
           schema_(schema),
           log_manager_(log_manager),
-          lock_manager_(lock_manager) {
-    buffer_pool_manager_->NewPage(first_page_id_);
-    cur_pid_ = first_page_id_;
-    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(cur_pid_));
+          lock_manager_(lock_manager),
+          version_store_(version_store) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_));
     ASSERT(page != nullptr,"Can't create new page!");
+    cur_pid_ = first_page_id_;
     page->Init(cur_pid_,INVALID_PAGE_ID,log_manager_,txn);
+    buffer_pool_manager_->UnpinPage(cur_pid_, true);
     // first_page_id_=INVALID_PAGE_ID;
     // cur_pid_=INVALID_PAGE_ID;
     // ASSERT(false, "Not implemented yet.");
   };
 
+  /**
+   * Hint the buffer pool to read the pages following page_id on the page chain ahead of a scan
+   */
+  void ReadAhead(page_id_t page_id, const std::shared_ptr<BufferRing> &ring);
+
+  /**
+   * Lock a row for a transaction, if there is a lock manager. The lock is taken before the latch of the page, so that
+   * no thread waits for a lock while it holds a latch.
+   * @return false if the transaction is aborted
+   */
+  bool LockRow(const RowId &rid, Transaction *txn, LockMode mode);
+
+  /**
+   * Save the version of a row on a write latched page before a transaction changes it, if the reads are snapshots
+   * @param deleted whether the change deletes the row
+   * @return false if the transaction is aborted, since the row was changed after its snapshot
+   */
+  bool SaveVersion(TablePage *page, const RowId &rid, Transaction *txn, bool deleted);
+
+  /**
+   * @return true if the reads of the transaction are snapshot reads, which take no lock
+   */
+  inline bool IsSnapshotRead(Transaction *txn) const { return version_store_ != nullptr && txn != nullptr; }
+
   /**
    * load existing table heap by first_page_id
    */
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                     LogManager *log_manager, LockManager *lock_manager)
+                     LogManager *log_manager, LockManager *lock_manager, VersionStore *version_store)
           : buffer_pool_manager_(buffer_pool_manager),
             first_page_id_(first_page_id),
             schema_(schema),
             log_manager_(log_manager),
-            lock_manager_(lock_manager) {
+            lock_manager_(lock_manager),
+            version_store_(version_store) {
     auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id));          
     for(cur_pid_ = first_page_id_; page->GetNextPageId() != INVALID_PAGE_ID; ){
+      buffer_pool_manager_->UnpinPage(cur_pid_, false);
       cur_pid_ = page->GetNextPageId();
       page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(cur_pid_));
     }
+    buffer_pool_manager_->UnpinPage(cur_pid_, false);
   }
 
 private:
@@ -135,7 +176,8 @@ private:
   page_id_t cur_pid_;
   Schema *schema_;
   [[maybe_unused]] LogManager *log_manager_;
-  [[maybe_unused]] LockManager *lock_manager_;
+  LockManager *lock_manager_;
+  VersionStore *version_store_;
 };
 
 #endif  // MINISQL_TABLE_HEAP_H
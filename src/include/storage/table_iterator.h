@@ -1,6 +1,9 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <memory>
+
+#include "buffer/buffer_ring.h"
 #include "common/rowid.h"
 #include "record/row.h"
 #include "transaction/transaction.h"
@@ -12,7 +15,11 @@ class TableIterator {
 
 public:
   // you may define your own constructor based on your member variables
-  TableIterator(TableHeap* table_heap,TablePage* page,RowId rid);
+  /**
+   * @param txn the transaction reading the rows, which sees a snapshot of them if the table keeps their versions
+   */
+  TableIterator(TableHeap* table_heap,TablePage* page,RowId rid,std::shared_ptr<BufferRing> ring = nullptr,
+                Transaction *txn = nullptr);
   explicit TableIterator();
 
   explicit TableIterator(const TableIterator &other);
@@ -45,6 +52,8 @@ TableHeap* table_heap_;
  Row *row_;
  RowId rid_;
  TablePage *page_;
+ std::shared_ptr<BufferRing> ring_;  // frames the scan reads its pages into, null for normal access
+ Transaction *txn_;  // the transaction of a snapshot read, null to read the newest rows
 };
 
 #endif //MINISQL_TABLE_ITERATOR_H
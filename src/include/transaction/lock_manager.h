@@ -1,13 +1,159 @@
 #ifndef MINISQL_LOCK_MANAGER_H
 #define MINISQL_LOCK_MANAGER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "common/rowid.h"
+#include "transaction/transaction.h"
+
+enum class LockMode { kShared, kExclusive };
+
 /**
  * LockManager handles transactions asking for locks on records.
  *
- * Implemented by student self.
+ * The rows are locked in shared or exclusive mode, and the locks are held until the transaction ends (strict two
+ * phase locking). The requests of a row are queued and granted in order: a shared request waits for the exclusive
+ * requests ahead of it, an exclusive request for all of them. A shared lock may be upgraded to an exclusive one,
+ * its request then goes ahead of the waiting ones.
+ *
+ * The lock table is split in shards by row, each with its own latch, so that the transactions locking different rows
+ * seldom wait for each other's latch.
+ *
+ * A background thread builds the wait-for graph of the waiting transactions and breaks its cycles by aborting the
+ * youngest transaction of each. The aborted transaction gets false from the lock call, and must be rolled back.
  */
 class LockManager {
+public:
+  LockManager() : shards_(new Shard[LOCK_TABLE_SHARDS]) {}
+
+  /** Stop the deadlock detection */
+  ~LockManager();
+
+  DISALLOW_COPY(LockManager);
+
+  /**
+   * Acquire a shared lock on a row, waiting for the conflicting locks
+   * @return true if the row is locked, false if the transaction is aborted
+   */
+  bool LockShared(Transaction *txn, const RowId &rid);
+
+  /**
+   * Acquire an exclusive lock on a row, upgrading the shared lock of the transaction if it has one
+   * @return true if the row is locked, false if the transaction is aborted
+   */
+  bool LockExclusive(Transaction *txn, const RowId &rid);
+
+  /**
+   * Upgrade a shared lock to an exclusive one. Only one transaction at a time may wait for the upgrade of a row, the
+   * other ones are aborted since they would deadlock.
+   * @return true if the row is locked in exclusive mode, false if the transaction is aborted
+   */
+  bool LockUpgrade(Transaction *txn, const RowId &rid);
+
+  /**
+   * Acquire an exclusive lock on a row only if nobody else holds or waits for a lock on it, without waiting, e.g. to
+   * claim a free slot of a page under its latch
+   * @return true if the row is locked in exclusive mode
+   */
+  bool TryLockExclusive(Transaction *txn, const RowId &rid);
+
+  /**
+   * @return true if some transaction holds or waits for a lock on the row
+   */
+  bool IsLocked(const RowId &rid);
+
+  /**
+   * Release the lock of a transaction on a row
+   * @return false if the transaction has no lock on the row
+   */
+  bool Unlock(Transaction *txn, const RowId &rid);
+
+  /**
+   * Release all the locks of a transaction, when it ends
+   */
+  void UnlockAll(Transaction *txn);
+
+  /**
+   * Start a thread searching for deadlocks every interval_ms
+   */
+  void RunDeadlockDetection(int interval_ms = DEADLOCK_DETECTION_INTERVAL_MS);
+
+  void StopDeadlockDetection();
+
+  /**
+   * Search the wait-for graph for cycles once, and abort the youngest transaction of each
+   * @return number of transactions aborted
+   */
+  size_t DetectDeadlocks();
+
+  /**
+   * Number of transactions aborted to break a deadlock, used for statistics
+   */
+  uint64_t GetNumDeadlocks() const { return num_deadlocks_.load(); }
+
+private:
+  struct LockRequest {
+    LockRequest(Transaction *txn, LockMode mode) : txn_(txn), mode_(mode) {}
+
+    Transaction *txn_;
+    LockMode mode_;
+    bool granted_{false};
+  };
+
+  /** The requests of a row in the order they came, but for an upgrade which goes ahead of the waiting ones */
+  struct LockRequestQueue {
+    std::list<LockRequest> requests_;
+    std::condition_variable cv_;
+    // a transaction is waiting to upgrade its shared lock
+    bool upgrading_{false};
+  };
+
+  struct Shard {
+    std::mutex latch_;
+    std::unordered_map<RowId, LockRequestQueue> lock_table_;
+  };
+
+  inline Shard &GetShard(const RowId &rid) { return shards_[std::hash<RowId>()(rid) % LOCK_TABLE_SHARDS]; }
+
+  /**
+   * Queue a request for a lock and wait until it is granted
+   * @return true if granted, false if the transaction is aborted
+   */
+  bool Lock(Transaction *txn, const RowId &rid, LockMode mode);
+
+  /**
+   * Wait until a request is granted, or its transaction aborted
+   * @return true if granted
+   */
+  static bool WaitForGrant(LockRequestQueue &queue, std::unique_lock<std::mutex> &lock,
+                           std::list<LockRequest>::iterator request);
+
+  /** @return true if the request is compatible with the granted requests and the ones ahead of it */
+  static bool IsGrantable(const LockRequestQueue &queue, std::list<LockRequest>::const_iterator request);
+
+  /**
+   * Remove the request of a transaction from the queue of a row, the requests behind it may be granted
+   * @return false if the transaction has no request for the row
+   */
+  static bool RemoveRequest(Shard &shard, const RowId &rid, Transaction *txn);
+
+  void DeadlockDetectionLoop(int interval_ms);
 
+  std::unique_ptr<Shard[]> shards_;
+  std::thread detection_thread_;
+  bool detection_running_{false};
+  std::mutex detection_latch_;
+  std::condition_variable detection_cv_;
+  std::atomic<uint64_t> num_deadlocks_{0};
 };
 
-#endif //MINISQL_LOCK_MANAGER_H
+#endif  // MINISQL_LOCK_MANAGER_H
@@ -1,15 +1,153 @@
 #ifndef MINISQL_LOG_MANAGER_H
 #define MINISQL_LOG_MANAGER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "transaction/log_record.h"
+#include "transaction/transaction.h"
+
+class DiskManager;
+
 /**
  * LogManager maintains a separate thread that is awakened whenever the
  * log buffer is full or whenever a timeout happens.
  * When the thread is awakened, the log buffer's content is written into the disk log file.
  *
- * Implemented by student self
+ * The records are appended to an in memory log buffer, which is swapped with a second buffer when it is written,
+ * so that appending never waits for the disk unless both buffers are full. A committing transaction waits for its
+ * commit record to be flushed: the commits which arrive while a flush is in progress are written together by the
+ * next one, sharing a single write and sync of the log file (group commit).
+ *
+ * The buffer pool asks for the log to be flushed up to the LSN of a page before it writes the page (WAL rule).
+ *
+ * The LSN of a record is its offset in the log file, which starts with a header:
+ * | Magic (4) | CheckpointLSN (8) |
+ * CheckpointLSN is the begin record of the last complete checkpoint, where the recovery starts reading the log.
+ * The records no recovery reads any more are discarded: the log file keeps its size, so that the LSNs stay offsets in
+ * it, but their space is given back to the file system.
  */
 class LogManager {
+public:
+  explicit LogManager(DiskManager *disk_manager);
+
+  /** Stop the flush thread and flush what is left in the log buffer */
+  ~LogManager();
+
+  DISALLOW_COPY(LogManager);
+
+  /**
+   * Start the flush thread, without it the log is only flushed by Flush and when the log buffer is full
+   */
+  void RunFlushThread();
+
+  void StopFlushThread();
+
+  /**
+   * Append a record to the log buffer, waiting for a flush if it is full
+   * @param txn if not null, the transaction of the record, whose last LSN is updated before any later record is
+   * appended, so that a checkpoint never misses a record of a running transaction
+   * @return the LSN given to the record, also set in log_record
+   */
+  lsn_t AppendLogRecord(LogRecord *log_record, Transaction *txn = nullptr);
+
+  /**
+   * Wait until the log is on the disk up to lsn, e.g. for a commit record or for the last change of a page which is
+   * about to be written. An LSN which was never handed out is taken as the last one which was.
+   * @return false if the log can't be written, see HasFailed
+   */
+  bool Flush(lsn_t lsn);
+
+  /**
+   * @return true once a write of the log has failed. The log is not written any more then: the records after the
+   * failed write could land behind a hole. Nothing appended since the last successful write becomes durable.
+   */
+  bool HasFailed() const { return failed_.load(); }
+
+  /** @return LSN of the last record appended */
+  lsn_t GetLastLSN();
+
+  /**
+   * @return LSN the next record will be given, read without waiting: any record appended later has an LSN at least
+   * as large
+   */
+  lsn_t GetNextLSN() const { return next_lsn_.load(); }
+
+  /** @return LSN of the last record on the disk, or a bound of the LSNs on the disk before the first flush */
+  lsn_t GetPersistentLSN() const { return persistent_lsn_.load(); }
+
+  /**
+   * Read the record at lsn, flushing the log first if it is still in the log buffer
+   * @return false if there is no valid record at lsn
+   */
+  bool ReadLogRecord(lsn_t lsn, LogRecord *log_record);
+
+  /** @return the begin record of the last complete checkpoint, INVALID_LSN if there is none */
+  lsn_t GetCheckpointLSN();
+
+  /**
+   * Record the begin record of a checkpoint in the log header, once the whole checkpoint is on the disk
+   * @return false if the header could not be written
+   */
+  bool SetCheckpointLSN(lsn_t lsn);
+
+  /**
+   * Discard the records below lsn, e.g. the ones older than every record the last checkpoint needs. They can't be
+   * read any more.
+   * @return false if their space can't be given back
+   */
+  bool Discard(lsn_t lsn);
+
+  /**
+   * Cut the log at lsn, e.g. where a record torn by a crash starts. Only before anything is appended.
+   */
+  void Truncate(lsn_t lsn);
+
+  /**
+   * Number of writes of the log buffer to the log file, used for statistics
+   */
+  uint64_t GetNumFlushes() const { return num_flushes_.load(); }
+
+  static constexpr uint32_t LOG_MAGIC = 0x32474c4d;  // "MLG2", the LSNs are 8 bytes long
+  static constexpr size_t LOG_HEADER_SIZE = 12;
+
+private:
+  /**
+   * Write the log buffer to the log file, or wait for the write in progress. Called with latch_ held through lock,
+   * which is released during the write.
+   */
+  void FlushBuffer(std::unique_lock<std::mutex> &lock);
+
+  void FlushThreadLoop();
 
+  DiskManager *disk_manager_;
+  std::mutex latch_;
+  // records are appended to log_buffer_, flush_buffer_ is the one being written
+  std::unique_ptr<char[]> log_buffer_;
+  std::unique_ptr<char[]> flush_buffer_;
+  size_t log_buffer_offset_{0};
+  // only changed with latch_ held, see GetNextLSN
+  std::atomic<lsn_t> next_lsn_{0};
+  lsn_t last_lsn_{INVALID_LSN};
+  std::atomic<lsn_t> persistent_lsn_{INVALID_LSN};
+  // a write of the log is in progress
+  bool flushing_{false};
+  // someone waits for the log buffer to be flushed
+  bool flush_requested_{false};
+  // wakes up the flush thread
+  std::condition_variable flush_cv_;
+  // signaled when the log buffer is swapped, and when a write of the log is done
+  std::condition_variable flushed_cv_;
+  std::thread flush_thread_;
+  bool flush_thread_running_{false};
+  std::atomic<uint64_t> num_flushes_{0};
+  // a write of the log failed, persistent_lsn_ does not move any more
+  std::atomic<bool> failed_{false};
 };
 
-#endif //MINISQL_LOG_MANAGER_H
+#endif  // MINISQL_LOG_MANAGER_H
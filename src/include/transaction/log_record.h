@@ -0,0 +1,138 @@
+#ifndef MINISQL_LOG_RECORD_H
+#define MINISQL_LOG_RECORD_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/rowid.h"
+
+enum LogRecordType {
+  kInvalidLog,
+  kInsertLog,          // a tuple inserted into a table page
+  kMarkDeleteLog,      // a tuple marked as deleted
+  kApplyDeleteLog,     // a tuple deleted for good
+  kRollbackDeleteLog,  // a mark delete undone
+  kUpdateLog,          // a tuple updated in place
+  kNewPageLog,         // a table page appended to a table heap
+  kFreePageLog,        // a table page freed with its table heap
+  kBeginLog,           // not written any more, a transaction logs nothing before its first change
+  kCommitLog,
+  kAbortLog,
+  kBeginCheckpointLog,
+  kEndCheckpointLog    // the active transactions and the dirty pages of a checkpoint
+};
+
+/**
+ * LogRecord is a record of the write ahead log, describing a change of one table page or the begin and the end of a
+ * transaction. The tuples are logged as they are serialized in the page. The LSN of a record is its offset in the log
+ * file.
+ *
+ * A change made while undoing a transaction is logged as a compensation record (CLR): a tuple record whose UndoNextLSN
+ * is the record to be undone next, so that an undo interrupted by a crash resumes where it stopped.
+ *
+ * Log record format (size in bytes):
+ * | Size (4) | LSN (8) | TxnId (4) | PrevLSN (8) | UndoNextLSN (8) | Type (4) |
+ * followed by, for the tuple records:
+ * | RowId (8) | TupleSize (4) | Tuple | (NewTupleSize (4) | NewTuple |, kUpdateLog only)
+ * for kNewPageLog and kFreePageLog:
+ * | PrevPageId (4) | PageId (4) |
+ * and for kEndCheckpointLog:
+ * | NumTxns (4) | (TxnId (4) | LastLSN (8)) ... | NumPages (4) | (PageId (4) | RecLSN (8)) ... |
+ * | NumRows (4) | RowId (8) ... |
+ */
+class LogRecord {
+public:
+  LogRecord() = default;
+
+  /** A begin, commit or abort record */
+  LogRecord(LogRecordType type, txn_id_t txn_id, lsn_t prev_lsn);
+
+  /** A record of a change of a single tuple */
+  LogRecord(LogRecordType type, txn_id_t txn_id, lsn_t prev_lsn, const RowId &rid, std::string tuple);
+
+  /** An update record */
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, const RowId &rid, std::string old_tuple, std::string new_tuple);
+
+  /** A new page record */
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, page_id_t prev_page_id, page_id_t page_id);
+
+  /** A free page record, the page is not redone from the records before it */
+  explicit LogRecord(page_id_t page_id);
+
+  /**
+   * The end record of a checkpoint started by the record at begin_lsn
+   * @param active_txns the running transactions and the LSN of their last record
+   * @param dirty_pages the dirty pages and their recovery LSN, the first record which may not be on the disk
+   * @param deleted_rows the rows marked as deleted which are kept on their page for the snapshots of the transactions
+   */
+  LogRecord(lsn_t begin_lsn, std::vector<std::pair<txn_id_t, lsn_t>> active_txns,
+            std::vector<std::pair<page_id_t, lsn_t>> dirty_pages, std::vector<RowId> deleted_rows);
+
+  /** @return size of the serialized record */
+  uint32_t GetSize() const { return size_; }
+
+  void SerializeTo(char *buf) const;
+
+  /**
+   * Read a record out of the len bytes of buf
+   * @return false if buf does not hold a whole valid record
+   */
+  static bool DeserializeFrom(const char *buf, size_t len, LogRecord *record);
+
+  inline LogRecordType GetType() const { return type_; }
+
+  inline lsn_t GetLSN() const { return lsn_; }
+
+  inline void SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+  inline txn_id_t GetTxnId() const { return txn_id_; }
+
+  inline lsn_t GetPrevLSN() const { return prev_lsn_; }
+
+  /** Make the record a compensation record, undo_next_lsn being the next record to undo */
+  inline void SetUndoNextLSN(lsn_t undo_next_lsn) { undo_next_lsn_ = undo_next_lsn; }
+
+  inline lsn_t GetUndoNextLSN() const { return undo_next_lsn_; }
+
+  inline bool IsCompensation() const { return undo_next_lsn_ != INVALID_LSN; }
+
+  inline const RowId &GetRowId() const { return rid_; }
+
+  /** @return the tuple of a tuple record, the old tuple of an update */
+  inline const std::string &GetTuple() const { return tuple_; }
+
+  inline const std::string &GetNewTuple() const { return new_tuple_; }
+
+  inline page_id_t GetPrevPageId() const { return prev_page_id_; }
+
+  inline page_id_t GetPageId() const { return page_id_; }
+
+  inline const std::vector<std::pair<txn_id_t, lsn_t>> &GetActiveTransactions() const { return active_txns_; }
+
+  inline const std::vector<std::pair<page_id_t, lsn_t>> &GetDirtyPages() const { return dirty_pages_; }
+
+  inline const std::vector<RowId> &GetDeletedRows() const { return deleted_rows_; }
+
+  static constexpr uint32_t HEADER_SIZE = 36;
+
+private:
+  uint32_t size_{HEADER_SIZE};
+  lsn_t lsn_{INVALID_LSN};
+  txn_id_t txn_id_{INVALID_TXN_ID};
+  lsn_t prev_lsn_{INVALID_LSN};
+  lsn_t undo_next_lsn_{INVALID_LSN};
+  LogRecordType type_{kInvalidLog};
+  RowId rid_;
+  std::string tuple_;
+  std::string new_tuple_;
+  page_id_t prev_page_id_{INVALID_PAGE_ID};
+  page_id_t page_id_{INVALID_PAGE_ID};
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns_;
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages_;
+  std::vector<RowId> deleted_rows_;
+};
+
+#endif  // MINISQL_LOG_RECORD_H
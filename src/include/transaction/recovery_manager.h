@@ -0,0 +1,109 @@
+#ifndef MINISQL_RECOVERY_MANAGER_H
+#define MINISQL_RECOVERY_MANAGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "buffer/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+#include "transaction/log_manager.h"
+#include "transaction/txn_manager.h"
+
+/**
+ * RecoveryManager brings the table pages back to a consistent state after a crash, ARIES style, and takes the fuzzy
+ * checkpoints which bound how much of the log the recovery reads.
+ *
+ * A checkpoint does not stop the database: it logs the running transactions, the dirty pages with their recovery LSN
+ * and the deleted rows kept for the snapshots between a begin and an end record, and then saves the begin LSN in the
+ * log header. The pages dirty since before
+ * the previous checkpoint are written first, so the redo never starts more than about two checkpoint intervals back.
+ * Once the checkpoint is on the disk, the log below the oldest record its recovery may read is discarded.
+ *
+ * The recovery runs in three passes:
+ * - analysis reads the log from the last checkpoint to rebuild the running transactions and the dirty pages;
+ * - redo repeats every logged change from the smallest recovery LSN on, skipping the pages whose LSN shows they
+ *   already have it, and the allocations of new pages which were not saved;
+ * - undo aborts the transactions which were running, as a ROLLBACK would.
+ * The rows still marked as deleted then are removed from their page, no snapshot needs them any more.
+ * Only the table pages are logged, the B+ tree indexes and the catalog are not recovered.
+ */
+class RecoveryManager {
+public:
+  RecoveryManager(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, LogManager *log_manager,
+                  TransactionManager *txn_manager)
+      : disk_manager_(disk_manager),
+        buffer_pool_manager_(buffer_pool_manager),
+        log_manager_(log_manager),
+        txn_manager_(txn_manager) {}
+
+  /** Stop the checkpoint thread */
+  ~RecoveryManager();
+
+  DISALLOW_COPY(RecoveryManager);
+
+  /**
+   * Recover from the log, before the tables are used, and take a checkpoint
+   */
+  void Recover();
+
+  /**
+   * Take a fuzzy checkpoint
+   */
+  void Checkpoint();
+
+  /**
+   * Start a thread taking a checkpoint every interval_ms
+   */
+  void RunCheckpointThread(int interval_ms = CHECKPOINT_INTERVAL_MS);
+
+  void StopCheckpointThread();
+
+  /**
+   * Number of records read by the redo of the last recovery, used for statistics
+   */
+  uint64_t GetNumRedoRecords() const { return num_redo_records_.load(); }
+
+  /**
+   * Number of checkpoints taken, used for statistics
+   */
+  uint64_t GetNumCheckpoints() const { return num_checkpoints_.load(); }
+
+private:
+  /**
+   * Read the records of the log from lsn to the end of the valid records
+   * @return LSN where the valid records end
+   */
+  lsn_t ScanLog(lsn_t lsn, const std::function<void(const LogRecord &)> &visit);
+
+  /**
+   * Redo a record on one of its pages, unless the page already has the change
+   */
+  void RedoPage(const LogRecord &record, page_id_t page_id, const std::unordered_map<page_id_t, lsn_t> &dirty_pages);
+
+  /**
+   * Write a page with its latch held, so that no change is half written
+   */
+  void WritePage(page_id_t page_id);
+
+  void CheckpointThreadLoop(int interval_ms);
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  LogManager *log_manager_;
+  TransactionManager *txn_manager_;
+  // one checkpoint at a time
+  std::mutex checkpoint_latch_;
+  lsn_t last_checkpoint_lsn_{INVALID_LSN};
+  std::thread checkpoint_thread_;
+  bool checkpoint_thread_running_{false};
+  std::mutex thread_latch_;
+  std::condition_variable checkpoint_cv_;
+  std::atomic<uint64_t> num_redo_records_{0};
+  std::atomic<uint64_t> num_checkpoints_{0};
+};
+
+#endif  // MINISQL_RECOVERY_MANAGER_H
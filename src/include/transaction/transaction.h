@@ -1,13 +1,102 @@
 #ifndef MINISQL_TRANSACTION_H
 #define MINISQL_TRANSACTION_H
 
+#include <atomic>
+#include <unordered_set>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "common/rowid.h"
+#include "record/row.h"
+
+class Index;
+
+enum TransactionState { kRunning, kCommitted, kAborted };
+
+/** An entry a transaction has inserted into an index or removed from it, the indexes are not logged */
+struct IndexWriteRecord {
+  IndexWriteRecord(bool is_insert, Index *index, const Row &key, RowId rid)
+      : is_insert_(is_insert), index_(index), key_(key), rid_(rid) {}
+
+  bool is_insert_;
+  Index *index_;
+  Row key_;
+  RowId rid_;
+};
+
 /**
  * Transaction tracks information related to a transaction.
  *
- * Implemented by student self
-*/
+ * The changes of a transaction are chained in the log through the previous LSN of their records, starting from the
+ * last record it has written. The LSN of its first and last record may be read by a checkpoint while it runs. A
+ * transaction which only reads writes no record at all.
+ *
+ * The row locks it holds are released when it ends. The deadlock detector may abort a transaction from another
+ * thread, by setting its state while it waits for a lock.
+ *
+ * It reads the rows as of its read timestamp, the commit timestamp of the last transaction committed when it started.
+ *
+ * Its changes of the indexes are kept in its index write set, to be undone if it aborts.
+ */
 class Transaction {
+public:
+  explicit Transaction(txn_id_t txn_id = INVALID_TXN_ID) : txn_id_(txn_id) {}
+
+  DISALLOW_COPY(Transaction);
+
+  inline txn_id_t GetTransactionId() const { return txn_id_; }
+
+  inline TransactionState GetState() const { return state_.load(); }
+
+  inline void SetState(TransactionState state) { state_.store(state); }
+
+  /** @return LSN of the last log record written by the transaction */
+  inline lsn_t GetPrevLSN() const { return prev_lsn_.load(); }
+
+  inline void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_.store(prev_lsn); }
+
+  /** @return LSN of the first log record of the transaction, INVALID_LSN until it writes one */
+  inline lsn_t GetBeginLSN() const { return begin_lsn_.load(); }
+
+  inline void SetBeginLSN(lsn_t begin_lsn) { begin_lsn_.store(begin_lsn); }
+
+  /** @return the rows locked in shared mode, only changed by the lock manager */
+  inline std::unordered_set<RowId> &GetSharedLockSet() { return shared_lock_set_; }
+
+  /** @return the rows locked in exclusive mode, only changed by the lock manager */
+  inline std::unordered_set<RowId> &GetExclusiveLockSet() { return exclusive_lock_set_; }
+
+  inline bool IsSharedLocked(const RowId &rid) const { return shared_lock_set_.count(rid) > 0; }
+
+  inline bool IsExclusiveLocked(const RowId &rid) const { return exclusive_lock_set_.count(rid) > 0; }
+
+  inline uint64_t GetReadTs() const { return read_ts_; }
+
+  inline void SetReadTs(uint64_t read_ts) { read_ts_ = read_ts; }
+
+  /** @return the commit timestamp, 0 until the transaction commits */
+  inline uint64_t GetCommitTs() const { return commit_ts_; }
+
+  inline void SetCommitTs(uint64_t commit_ts) { commit_ts_ = commit_ts; }
+
+  /** @return the rows whose older version the transaction has saved, only changed by the version store */
+  inline std::unordered_set<RowId> &GetWriteSet() { return write_set_; }
+
+  /** @return the changes of the indexes, oldest first */
+  inline std::vector<IndexWriteRecord> &GetIndexWriteSet() { return index_write_set_; }
 
+private:
+  txn_id_t txn_id_;
+  std::atomic<TransactionState> state_{kRunning};
+  std::atomic<lsn_t> prev_lsn_{INVALID_LSN};
+  std::atomic<lsn_t> begin_lsn_{INVALID_LSN};
+  std::unordered_set<RowId> shared_lock_set_;
+  std::unordered_set<RowId> exclusive_lock_set_;
+  uint64_t read_ts_{0};
+  uint64_t commit_ts_{0};
+  std::unordered_set<RowId> write_set_;
+  std::vector<IndexWriteRecord> index_write_set_;
 };
 
 #endif  // MINISQL_TRANSACTION_H
@@ -0,0 +1,141 @@
+#ifndef MINISQL_TXN_MANAGER_H
+#define MINISQL_TXN_MANAGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "transaction/log_manager.h"
+#include "transaction/transaction.h"
+#include "transaction/version_store.h"
+
+class BufferPoolManager;
+class LockManager;
+
+/**
+ * TransactionManager starts and ends the transactions, and logs the end of those which have changed something. A
+ * transaction which only reads writes nothing to the log, and its commit does not wait for a flush.
+ *
+ * An aborted transaction is undone by following its records back through the log, each change being reverted and
+ * logged as a compensation record. The row locks of a transaction are released once it has ended.
+ *
+ * A transaction reads the snapshot of the transactions committed before it started: it gets the last commit
+ * timestamp as its read timestamp, and its commit the next one. The older versions of the rows are kept in the version
+ * store until no running transaction reads them any more.
+ */
+class TransactionManager {
+public:
+  /**
+   * @param buffer_pool_manager the pool of the table pages changed by the transactions, needed to abort them
+   * @param lock_manager the lock manager of the row locks taken by the transactions, if any
+   */
+  explicit TransactionManager(LogManager *log_manager, BufferPoolManager *buffer_pool_manager = nullptr,
+                              LockManager *lock_manager = nullptr)
+      : log_manager_(log_manager), buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager) {}
+
+  /** Stop the garbage collection thread */
+  ~TransactionManager();
+
+  DISALLOW_COPY(TransactionManager);
+
+  /**
+   * Start a transaction, owned by the transaction manager until it ends
+   */
+  Transaction *Begin();
+
+  /**
+   * Commit a transaction, once its commit record is on the disk. The transaction can't be used any more.
+   * @return false if the commit record can't be written, see LogManager::HasFailed. Whether the transaction is
+   * committed is only known after the recovery at the next start then.
+   */
+  bool Commit(Transaction *txn);
+
+  /**
+   * Undo the changes of a transaction and end it. The transaction can't be used any more.
+   */
+  void Abort(Transaction *txn);
+
+  /**
+   * Take over a transaction which was running when the database crashed, found in the log by the recovery
+   * @param last_lsn LSN of the last record of the transaction
+   * @return the transaction, to be aborted
+   */
+  Transaction *Resume(txn_id_t txn_id, lsn_t last_lsn);
+
+  /** @return the running transactions which have written a record and the LSN of their last one, for a checkpoint */
+  std::vector<std::pair<txn_id_t, lsn_t>> GetActiveTransactions();
+
+  /**
+   * @return LSN of the first record of the oldest running transaction, below which an abort reads nothing, or
+   * INVALID_LSN if no running transaction has written a record
+   */
+  lsn_t GetOldestBeginLSN();
+
+  /** @return number of running transactions */
+  size_t GetNumRunning();
+
+  /**
+   * Drop the versions no running transaction reads any more, and remove the rows whose delete every one of them sees
+   * from their page. Done every VERSION_GC_INTERVAL transactions ended, by the garbage collection thread if it runs.
+   */
+  void CollectGarbage();
+
+  /**
+   * Start a thread collecting the garbage every VERSION_GC_INTERVAL transactions ended, so that the commits and the
+   * aborts never do it themselves
+   */
+  void RunGarbageCollectionThread();
+
+  void StopGarbageCollectionThread();
+
+  /**
+   * @return the rows marked as deleted which are kept on their page until they are collected, for a checkpoint. A
+   * collection running meanwhile is waited for, so that a row is either returned or removed by a logged change.
+   */
+  std::vector<RowId> GetDeletedRows();
+
+  VersionStore *GetVersionStore() { return &version_store_; }
+
+  /** @return timestamp of the last commit */
+  uint64_t GetLastCommitTs() const { return last_commit_ts_.load(); }
+
+private:
+  /**
+   * Revert the change of one record of an aborted transaction
+   */
+  void Undo(const LogRecord &record, Transaction *txn);
+
+  /**
+   * Count an ended transaction, and collect the garbage every VERSION_GC_INTERVAL of them
+   */
+  void EndTransaction();
+
+  void GarbageCollectionThreadLoop();
+
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  LockManager *lock_manager_;
+  std::atomic<txn_id_t> next_txn_id_{0};
+  std::mutex latch_;
+  std::unordered_map<txn_id_t, std::unique_ptr<Transaction>> running_;
+  VersionStore version_store_;
+  // the commit timestamps are published in order
+  std::mutex commit_latch_;
+  std::atomic<uint64_t> last_commit_ts_{0};
+  std::atomic<uint64_t> num_ended_{0};
+  // held while the versions are collected and the deleted rows removed from their pages
+  std::mutex gc_latch_;
+  std::thread gc_thread_;
+  bool gc_thread_running_{false};
+  // a collection is due, protected by gc_thread_latch_
+  bool gc_requested_{false};
+  std::mutex gc_thread_latch_;
+  std::condition_variable gc_cv_;
+};
+
+#endif  // MINISQL_TXN_MANAGER_H
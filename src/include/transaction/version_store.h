@@ -0,0 +1,137 @@
+#ifndef MINISQL_VERSION_STORE_H
+#define MINISQL_VERSION_STORE_H
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "common/rowid.h"
+#include "transaction/transaction.h"
+
+/** Which version of a row a transaction sees */
+enum class VersionRead { kPageVersion, kOlderVersion, kNoVersion };
+
+/**
+ * VersionStore keeps the older versions of the rows changed by the running or recent transactions, so that a
+ * transaction reads the rows as they were when it started (snapshot isolation) without locking them.
+ *
+ * The table page always holds the newest version of a row. Before a transaction changes a row for the first time,
+ * the version on the page is saved in the chain of the row with the commit timestamp it was made at. A transaction
+ * sees the newest version committed at or before its read timestamp, or its own change. A row without a chain was
+ * committed before every running transaction started.
+ *
+ * Two transactions may not change a row concurrently: the second writer is aborted when the row was changed after
+ * its snapshot (first updater wins). Writers still lock the rows exclusively when there is a lock manager.
+ *
+ * The versions no running transaction can see any more are garbage collected. A row whose delete is collected can
+ * then be removed from its page, until then the deleted tuple stays marked on the page.
+ *
+ * The chains are kept in memory only: after a restart, every row on the pages is committed.
+ */
+class VersionStore {
+public:
+  VersionStore() : shards_(new Shard[VERSION_STORE_SHARDS]) {}
+
+  DISALLOW_COPY(VersionStore);
+
+  /**
+   * Find the version of a row a transaction sees. The page of the row must be latched.
+   * @param[out] tuple the older version, if any and tuple is not null
+   */
+  VersionRead ReadVersion(const RowId &rid, Transaction *txn, std::string *tuple);
+
+  /**
+   * Save the version on the page before a transaction changes a row. The page must be write latched.
+   * @param exists whether the row exists on the page, tuple being its serialized tuple
+   * @param deleted whether the change deletes the row
+   * @return false if the row was changed after the snapshot of the transaction, which is then aborted
+   */
+  bool SaveVersion(const RowId &rid, Transaction *txn, bool exists, std::string tuple, bool deleted);
+
+  /**
+   * Record a row inserted by a transaction into an empty slot. The page must be write latched. An insert never
+   * conflicts, the slot was free whatever the snapshot.
+   */
+  void SaveInsert(const RowId &rid, Transaction *txn);
+
+  /**
+   * Make the changes of a transaction visible to the transactions starting from its commit timestamp on
+   */
+  void Commit(Transaction *txn, uint64_t commit_ts);
+
+  /**
+   * Drop the versions of an aborted transaction, once its changes are undone on the pages
+   */
+  void Abort(Transaction *txn);
+
+  /**
+   * Drop the versions no transaction with a read timestamp from watermark on sees
+   * @return the rows whose delete is visible to all of them, to be removed from their page
+   */
+  std::vector<RowId> Collect(uint64_t watermark);
+
+  /**
+   * @return the rows whose version on the page deletes them, marked as deleted on their page until they are collected
+   */
+  std::vector<RowId> GetDeletedRows();
+
+  /**
+   * Drop the committed versions of the rows of pages which are freed, e.g. with their table
+   */
+  void DropPages(const std::vector<page_id_t> &page_ids);
+
+  /** @return number of rows with older versions */
+  size_t GetNumChains() const { return num_chains_.load(); }
+
+  /**
+   * @return true if some rows are deleted on their page while a transaction may still see them. Their index entries
+   * are gone, an index lookup under a snapshot misses them.
+   */
+  bool HasDeletedRows() const { return num_deleted_.load() != 0; }
+
+private:
+  struct Version {
+    uint64_t ts_;
+    bool exists_;
+    std::string tuple_;
+  };
+
+  struct VersionChain {
+    // the transaction whose uncommitted change is on the page, if any
+    txn_id_t writer_{INVALID_TXN_ID};
+    // commit timestamp of the version on the page, once committed
+    uint64_t ts_{0};
+    // the version on the page deletes the row
+    bool deleted_{false};
+    // the older versions, newest first
+    std::deque<Version> older_;
+  };
+
+  struct Shard {
+    std::mutex latch_;
+    std::unordered_map<RowId, VersionChain> chains_;
+  };
+
+  inline Shard &GetShard(const RowId &rid) { return shards_[std::hash<RowId>()(rid) % VERSION_STORE_SHARDS]; }
+
+  /**
+   * Save a version of a row, unless the transaction has saved one already
+   */
+  void Save(Shard &shard, const RowId &rid, Transaction *txn, Version version, bool deleted);
+
+  /** Set whether the version on the page deletes the row, counting the chains which do */
+  void SetDeleted(VersionChain &chain, bool deleted);
+
+  std::unique_ptr<Shard[]> shards_;
+  std::atomic<size_t> num_chains_{0};
+  std::atomic<size_t> num_deleted_{0};
+};
+
+#endif  // MINISQL_VERSION_STORE_H
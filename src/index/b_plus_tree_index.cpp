@@ -21,6 +21,9 @@ dberr_t BPLUSTREE_INDEX_TYPE::InsertEntry(const Row &key, RowId row_id, Transact
   if (!status) {
     return DB_FAILED;
   }
+  if (txn != nullptr) {
+    txn->GetIndexWriteSet().emplace_back(true, this, key, row_id);
+  }
   return DB_SUCCESS;
 }
 
@@ -29,6 +32,13 @@ dberr_t BPLUSTREE_INDEX_TYPE::RemoveEntry(const Row &key, RowId row_id, Transact
   KeyType index_key;
   index_key.SerializeFromKey(key, key_schema_);
 
+  if (txn != nullptr) {
+    // only an entry which was there is put back by an abort
+    std::vector<RowId> result;
+    if (container_.GetValue(index_key, result, txn) && result[0].Get() == row_id.Get()) {
+      txn->GetIndexWriteSet().emplace_back(false, this, key, row_id);
+    }
+  }
   container_.Remove(index_key, txn);
   return DB_SUCCESS;
 }
@@ -79,5 +79,5 @@ void BPlusTreePage::SetPageId(page_id_t page_id) {
  * Helper methods to set lsn
  */
 void BPlusTreePage::SetLSN(lsn_t lsn) {
-  lsn_ = lsn;
+  memcpy(lsn_, &lsn, sizeof(lsn_t));
 }
\ No newline at end of file
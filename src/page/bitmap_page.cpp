@@ -17,29 +17,34 @@ void Set_Bit_map(uint32_t page_offset, unsigned char bytes[], bool bit){
 template<size_t PageSize>
 bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
   //page_offset needs to be modified to the index of that allocated page
-  if(this->page_allocated_==GetMaxSupportedSize())
+  if(this->page_allocated_>=GetMaxSupportedSize())
     return false;
-  else{
-    this->page_allocated_++;
-    //using first fit: find the first free bit as the next free page
-    uint32_t count=0;
-    uint8_t bit_pos=0;
-    while(count<MAX_CHARS){
-      if (this->bytes[count]==255){//all bits in that byte has been aloocated
-        count++;
-        continue;
-      }
-      else break;
-    }
-    while(true){
-      page_offset=(count<<3)+bit_pos;
-      if(IsPageFree(page_offset)) break;
-      else bit_pos++;
+  //using first fit: the pages below next_free_page_ are all allocated, so the first word with a zero bit from
+  //there holds the first free page
+  for(size_t word=this->next_free_page_/64;word<MAX_WORDS;word++){
+    uint64_t free_bits=~LoadWord(word);
+    if(free_bits!=0){
+      page_offset=word*64+__builtin_ctzll(free_bits);
+      this->page_allocated_++;
+      this->next_free_page_=page_offset+1;
+      //set bitmap
+      Set_Bit_map(page_offset, this->bytes, true);
+      return true;
     }
-    //set bitmap
-    Set_Bit_map(page_offset, this->bytes, true);
-    return true;
   }
+  return false;
+}
+
+template<size_t PageSize>
+bool BitmapPage<PageSize>::AllocatePageAt(uint32_t page_offset) {
+  if(page_offset>=GetMaxSupportedSize() || !IsPageFree(page_offset))
+    return false;
+  this->page_allocated_++;
+  //the pages below next_free_page_ stay allocated
+  if(page_offset==this->next_free_page_)
+    this->next_free_page_=page_offset+1;
+  Set_Bit_map(page_offset, this->bytes, true);
+  return true;
 }
 
 template<size_t PageSize>
@@ -49,6 +54,8 @@ bool BitmapPage<PageSize>::DeAllocatePage(uint32_t page_offset) {
   else{
     this->page_allocated_--;
     Set_Bit_map(page_offset, this->bytes, false);
+    if(page_offset<this->next_free_page_)
+      this->next_free_page_=page_offset;
     return true;
   }
 }
@@ -1,11 +1,29 @@
 #include "page/table_page.h"
 
+namespace {
+
+inline txn_id_t GetTxnId(Transaction *txn) { return txn == nullptr ? INVALID_TXN_ID : txn->GetTransactionId(); }
+
+inline lsn_t GetPrevLSN(Transaction *txn) { return txn == nullptr ? INVALID_LSN : txn->GetPrevLSN(); }
+
+}  // namespace
+
+void TablePage::Log(LogRecord &record, Transaction *txn, LogManager *log_manager) {
+  SetLSN(log_manager->AppendLogRecord(&record, txn));
+}
+
 void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr, Transaction *txn) {
   memcpy(GetData(), &page_id, sizeof(page_id));
   SetPrevPageId(prev_id);
   SetNextPageId(INVALID_PAGE_ID);
   SetFreeSpacePointer(PAGE_SIZE);
   SetTupleCount(0);
+  if (log_mgr != nullptr) {
+    LogRecord record(GetTxnId(txn), GetPrevLSN(txn), prev_id, page_id);
+    Log(record, txn, log_mgr);
+  } else {
+    SetLSN(INVALID_LSN);
+  }
 }
 
 bool TablePage::InsertTuple(Row &row, Schema *schema, Transaction *txn,
@@ -18,13 +36,14 @@ bool TablePage::InsertTuple(Row &row, Schema *schema, Transaction *txn,
   // Try to find a free slot to reuse.
   uint32_t i;
   for (i = 0; i < GetTupleCount(); i++) {
-    // If the slot is empty, i.e. its tuple has size 0,
-    if (GetTupleSize(i) == 0) {
+    // If the slot is empty, i.e. its tuple has size 0, and its row is not locked by another transaction,
+    if (GetTupleSize(i) == 0 && LockSlot(i, txn, lock_manager)) {
       // Then we break out of the loop at index i.
       break;
     }
   }
-  if (i == GetTupleCount() && GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
+  if (i == GetTupleCount() &&
+      (GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE || !LockSlot(i, txn, lock_manager))) {
     return false;
   }
   // Otherwise we claim available free space..
@@ -40,9 +59,22 @@ bool TablePage::InsertTuple(Row &row, Schema *schema, Transaction *txn,
   if (i == GetTupleCount()) {
     SetTupleCount(GetTupleCount() + 1);
   }
+  if (log_manager != nullptr) {
+    LogRecord record(kInsertLog, GetTxnId(txn), GetPrevLSN(txn), row.GetRowId(),
+                     std::string(GetData() + GetFreeSpacePointer(), serialized_size));
+    Log(record, txn, log_manager);
+  }
   return true;
 }
 
+bool TablePage::LockSlot(uint32_t slot_num, Transaction *txn, LockManager *lock_manager) {
+  if (lock_manager == nullptr) {
+    return true;
+  }
+  RowId rid(GetTablePageId(), slot_num);
+  return txn != nullptr ? lock_manager->TryLockExclusive(txn, rid) : !lock_manager->IsLocked(rid);
+}
+
 bool TablePage::MarkDelete(const RowId &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager) {
   uint32_t slot_num = rid.GetSlotNum();
   // If the slot number is invalid, abort.
@@ -56,6 +88,11 @@ bool TablePage::MarkDelete(const RowId &rid, Transaction *txn, LockManager *lock
   }
   // Mark the tuple as deleted.
   if (tuple_size > 0) {
+    if (log_manager != nullptr) {
+      LogRecord record(kMarkDeleteLog, GetTxnId(txn), GetPrevLSN(txn), rid,
+                       std::string(GetData() + GetTupleOffsetAtSlot(slot_num), tuple_size));
+      Log(record, txn, log_manager);
+    }
     SetTupleSize(slot_num, SetDeletedFlag(tuple_size));
   }
   return true;
@@ -84,6 +121,10 @@ int TablePage::UpdateTuple(const Row &new_row, Row *old_row, Schema *schema,
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
   uint32_t __attribute__((unused)) read_bytes = old_row->DeserializeFrom(GetData() + tuple_offset, schema);
   ASSERT(tuple_size == read_bytes, "Unexpected behavior in tuple deserialize.");
+  std::string old_tuple;
+  if (log_manager != nullptr) {
+    old_tuple.assign(GetData() + tuple_offset, tuple_size);
+  }
   uint32_t free_space_pointer = GetFreeSpacePointer();
   ASSERT(tuple_offset >= free_space_pointer, "Offset should appear after current free space position.");
   memmove(GetData() + free_space_pointer + tuple_size - serialized_size, GetData() + free_space_pointer,
@@ -99,6 +140,11 @@ int TablePage::UpdateTuple(const Row &new_row, Row *old_row, Schema *schema,
       SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size - new_row.GetSerializedSize(schema));
     }
   }
+  if (log_manager != nullptr) {
+    LogRecord record(GetTxnId(txn), GetPrevLSN(txn), old_row->GetRowId(), std::move(old_tuple),
+                     std::string(GetData() + GetTupleOffsetAtSlot(slot_num), serialized_size));
+    Log(record, txn, log_manager);
+  }
   return 3;
 }
 
@@ -112,6 +158,11 @@ void TablePage::ApplyDelete(const RowId &rid, Transaction *txn, LogManager *log_
   if (IsDeleted(tuple_size)) {
     tuple_size = UnsetDeletedFlag(tuple_size);
   }
+  if (log_manager != nullptr) {
+    LogRecord record(kApplyDeleteLog, GetTxnId(txn), GetPrevLSN(txn), rid,
+                     std::string(GetData() + tuple_offset, tuple_size));
+    Log(record, txn, log_manager);
+  }
 
   uint32_t free_space_pointer = GetFreeSpacePointer();
   ASSERT(tuple_offset >= free_space_pointer, "Free space appears before tuples.");
@@ -138,10 +189,112 @@ void TablePage::RollbackDelete(const RowId &rid, Transaction *txn, LogManager *l
 
   // Unset the deleted flag.
   if (IsDeleted(tuple_size)) {
+    if (log_manager != nullptr) {
+      LogRecord record(kRollbackDeleteLog, GetTxnId(txn), GetPrevLSN(txn), rid,
+                       std::string(GetData() + GetTupleOffsetAtSlot(slot_num), UnsetDeletedFlag(tuple_size)));
+      Log(record, txn, log_manager);
+    }
     SetTupleSize(slot_num, UnsetDeletedFlag(tuple_size));
   }
 }
 
+void TablePage::InsertTupleAt(uint32_t slot_num, const std::string &tuple) {
+  ASSERT(slot_num < GetTupleCount() ? GetTupleSize(slot_num) == 0 : slot_num == GetTupleCount(), "Slot in use.");
+  ASSERT(GetFreeSpaceRemaining() >= tuple.size() + (slot_num == GetTupleCount() ? SIZE_TUPLE : 0),
+         "Not enough space for the tuple.");
+  SetFreeSpacePointer(GetFreeSpacePointer() - tuple.size());
+  memcpy(GetData() + GetFreeSpacePointer(), tuple.data(), tuple.size());
+  SetTupleOffsetAtSlot(slot_num, GetFreeSpacePointer());
+  SetTupleSize(slot_num, tuple.size());
+  if (slot_num == GetTupleCount()) {
+    SetTupleCount(GetTupleCount() + 1);
+  }
+}
+
+void TablePage::UpdateTupleAt(uint32_t slot_num, const std::string &tuple) {
+  ASSERT(slot_num < GetTupleCount(), "Cannot have more slots than tuples.");
+  uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
+  uint32_t tuple_size = UnsetDeletedFlag(GetTupleSize(slot_num));
+  uint32_t size = tuple.size();
+  ASSERT(GetFreeSpaceRemaining() + tuple_size >= size, "Not enough space for the tuple.");
+  // Same as UpdateTuple: the tuples in front of the updated one are moved by the difference of the sizes.
+  uint32_t free_space_pointer = GetFreeSpacePointer();
+  memmove(GetData() + free_space_pointer + tuple_size - size, GetData() + free_space_pointer,
+          tuple_offset - free_space_pointer);
+  SetFreeSpacePointer(free_space_pointer + tuple_size - size);
+  memcpy(GetData() + tuple_offset + tuple_size - size, tuple.data(), size);
+  SetTupleSize(slot_num, size);
+  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
+    uint32_t tuple_offset_i = GetTupleOffsetAtSlot(i);
+    if (GetTupleSize(i) > 0 && tuple_offset_i < tuple_offset + tuple_size) {
+      SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size - size);
+    }
+  }
+}
+
+void TablePage::Redo(const LogRecord &record) {
+  uint32_t slot_num = record.GetRowId().GetSlotNum();
+  switch (record.GetType()) {
+    case kInsertLog:
+      InsertTupleAt(slot_num, record.GetTuple());
+      break;
+    case kMarkDeleteLog:
+      SetTupleSize(slot_num, SetDeletedFlag(GetTupleSize(slot_num)));
+      break;
+    case kRollbackDeleteLog:
+      SetTupleSize(slot_num, UnsetDeletedFlag(GetTupleSize(slot_num)));
+      break;
+    case kApplyDeleteLog:
+      ApplyDelete(record.GetRowId(), nullptr, nullptr);
+      break;
+    case kUpdateLog:
+      UpdateTupleAt(slot_num, record.GetNewTuple());
+      break;
+    case kNewPageLog:
+      if (GetPageId() == record.GetPageId()) {
+        Init(record.GetPageId(), record.GetPrevPageId(), nullptr, nullptr);
+      } else {
+        SetNextPageId(record.GetPageId());
+      }
+      break;
+    default:
+      return;
+  }
+  SetLSN(record.GetLSN());
+}
+
+void TablePage::Undo(const LogRecord &record, Transaction *txn, LogManager *log_manager) {
+  const RowId &rid = record.GetRowId();
+  uint32_t slot_num = rid.GetSlotNum();
+  LogRecord compensation;
+  switch (record.GetType()) {
+    case kInsertLog:
+      compensation = LogRecord(kApplyDeleteLog, GetTxnId(txn), GetPrevLSN(txn), rid, record.GetTuple());
+      ApplyDelete(rid, nullptr, nullptr);
+      break;
+    case kMarkDeleteLog:
+      compensation = LogRecord(kRollbackDeleteLog, GetTxnId(txn), GetPrevLSN(txn), rid, record.GetTuple());
+      RollbackDelete(rid, nullptr, nullptr);
+      break;
+    case kRollbackDeleteLog:
+      compensation = LogRecord(kMarkDeleteLog, GetTxnId(txn), GetPrevLSN(txn), rid, record.GetTuple());
+      SetTupleSize(slot_num, SetDeletedFlag(GetTupleSize(slot_num)));
+      break;
+    case kApplyDeleteLog:
+      compensation = LogRecord(kInsertLog, GetTxnId(txn), GetPrevLSN(txn), rid, record.GetTuple());
+      InsertTupleAt(slot_num, record.GetTuple());
+      break;
+    case kUpdateLog:
+      compensation = LogRecord(GetTxnId(txn), GetPrevLSN(txn), rid, record.GetNewTuple(), record.GetTuple());
+      UpdateTupleAt(slot_num, record.GetTuple());
+      break;
+    default:
+      return;
+  }
+  compensation.SetUndoNextLSN(record.GetPrevLSN());
+  Log(compensation, txn, log_manager);
+}
+
 bool TablePage::GetTuple(Row *row, Schema *schema, Transaction *txn, LockManager *lock_manager) {
   ASSERT(row != nullptr && row->GetRowId().Get() != INVALID_ROWID.Get(), "Invalid row.");
   // Get the current slot number.
@@ -163,6 +316,81 @@ bool TablePage::GetTuple(Row *row, Schema *schema, Transaction *txn, LockManager
   return true;
 }
 
+bool TablePage::GetTupleOptimistic(Row *row, Schema *schema, Transaction *txn, LockManager *lock_manager) {
+  ASSERT(row != nullptr && row->GetRowId().Get() != INVALID_ROWID.Get(), "Invalid row.");
+  uint32_t slot_num = row->GetRowId().GetSlotNum();
+  char buf[PAGE_SIZE];
+  for (int i = 0; i < OPTIMISTIC_READ_RETRIES; i++) {
+    uint64_t version;
+    if (!OptimisticRLatch(&version)) {
+      continue;
+    }
+    // Copy the tuple out of the page, every value read here may be torn until the version is validated.
+    bool exists = slot_num < GetTupleCount() && OFFSET_TUPLE_OFFSET + SIZE_TUPLE * (slot_num + 1) <= PAGE_SIZE;
+    uint32_t tuple_size = exists ? GetTupleSize(slot_num) : 0;
+    exists = exists && !IsDeleted(tuple_size);
+    if (exists) {
+      uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
+      if (tuple_offset > PAGE_SIZE || tuple_size > PAGE_SIZE - tuple_offset) {
+        continue;
+      }
+      memcpy(buf, GetData() + tuple_offset, tuple_size);
+    }
+    if (!ValidateOptimisticRead(version)) {
+      continue;
+    }
+    if (!exists) {
+      return false;
+    }
+    uint32_t __attribute__((unused)) read_bytes = row->DeserializeFrom(buf, schema);
+    ASSERT(tuple_size == read_bytes, "Unexpected behavior in tuple deserialize.");
+    return true;
+  }
+  RLatch();
+  bool res = GetTuple(row, schema, txn, lock_manager);
+  RUnlatch();
+  return res;
+}
+
+bool TablePage::GetVisibleTuple(Row *row, Schema *schema, Transaction *txn, VersionStore *version_store) {
+  std::string tuple;
+  switch (version_store->ReadVersion(row->GetRowId(), txn, &tuple)) {
+    case VersionRead::kPageVersion:
+      return GetTuple(row, schema, txn, nullptr);
+    case VersionRead::kOlderVersion:
+      row->DeserializeFrom(tuple.data(), schema);
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool TablePage::GetFirstVisibleTupleRid(uint32_t slot_num, RowId *rid, Transaction *txn,
+                                        VersionStore *version_store) {
+  // a deleted tuple may still be seen in an older version
+  for (uint32_t i = slot_num; i < GetTupleCount(); i++) {
+    rid->Set(GetTablePageId(), i);
+    VersionRead read = version_store->ReadVersion(*rid, txn, nullptr);
+    if (read == VersionRead::kOlderVersion || (read == VersionRead::kPageVersion && !IsDeleted(GetTupleSize(i)))) {
+      return true;
+    }
+  }
+  rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+bool TablePage::GetTupleData(uint32_t slot_num, std::string *tuple) {
+  if (slot_num >= GetTupleCount() || IsDeleted(GetTupleSize(slot_num))) {
+    return false;
+  }
+  tuple->assign(GetData() + GetTupleOffsetAtSlot(slot_num), GetTupleSize(slot_num));
+  return true;
+}
+
+bool TablePage::IsMarkedDeleted(uint32_t slot_num) {
+  return slot_num < GetTupleCount() && GetTupleSize(slot_num) != 0 && IsDeleted(GetTupleSize(slot_num));
+}
+
 bool TablePage::GetFirstTupleRid(RowId *first_rid) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); i++) {
@@ -169,6 +169,10 @@ const char *GetSyntaxNodeTypeStr(SyntaxNodeType type) {
       return "kNodeTrxCommit";
     case kNodeTrxRollback:
       return "kNodeTrxRollback";
+    case kNodeShowStatus:
+      return "kNodeShowStatus";
+    case kNodeSetVariable:
+      return "kNodeSetVariable";
     default:
       return "error type";
   }
@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "glog/logging.h"
+#include "storage/compressed_page_store.h"
+#include "storage/lz_page_codec.h"
+
+CompressedPageStore::CompressedPageStore(const std::string &file_name, page_id_t max_page_id)
+    : file_name_(file_name), max_page_id_(max_page_id) {
+  fd_ = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw std::exception();
+  }
+  LoadMap();
+}
+
+uint64_t CompressedPageStore::Checksum(const Header &header) {
+  // FNV-1a over the fields, the padding of the struct is not hashed
+  uint64_t fields[] = {header.magic, header.num_entries, header.num_units, header.map_region.offset,
+                       header.map_region.units, header.sequence};
+  uint64_t hash = 14695981039346656037ULL;
+  for (uint64_t field : fields) {
+    for (int i = 0; i < 8; i++) {
+      hash = (hash ^ ((field >> (i * 8)) & 0xff)) * 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
+void CompressedPageStore::LoadMap() {
+  struct stat stat_buf;
+  if (fstat(fd_, &stat_buf) != 0 || stat_buf.st_size == 0) {
+    return;
+  }
+  size_t file_size = stat_buf.st_size;
+  // the valid copy of the header saved last, a copy torn by a crash fails its checksum
+  Header header{};
+  bool found = false;
+  for (size_t copy = 0; copy < 2 && file_size >= HEADER_UNITS * SLOT_SIZE; copy++) {
+    Header candidate;
+    if (!ReadAt(reinterpret_cast<char *>(&candidate), sizeof(candidate), copy * HEADER_COPY_SIZE) ||
+        candidate.magic != MAGIC || candidate.checksum != Checksum(candidate) ||
+        candidate.map_region.offset < HEADER_UNITS ||
+        static_cast<uint64_t>(candidate.map_region.offset) + candidate.map_region.units > candidate.num_units ||
+        static_cast<uint64_t>(candidate.num_entries) * sizeof(MapEntry) >
+            static_cast<uint64_t>(candidate.map_region.units) * SLOT_SIZE ||
+        static_cast<uint64_t>(candidate.num_units) * SLOT_SIZE > file_size) {
+      continue;
+    }
+    if (!found || candidate.sequence > header.sequence) {
+      header = candidate;
+      found = true;
+    }
+  }
+  if (!found) {
+    LOG(ERROR) << "No valid map in " << file_name_ << ", the compressed pages are lost";
+    return;
+  }
+  std::vector<MapEntry> entries(header.num_entries);
+  if (!ReadAt(reinterpret_cast<char *>(entries.data()), entries.size() * sizeof(MapEntry),
+              static_cast<size_t>(header.map_region.offset) * SLOT_SIZE)) {
+    LOG(ERROR) << "Can't read the map of " << file_name_ << ", the compressed pages are lost";
+    return;
+  }
+  num_units_ = header.num_units;
+  sequence_ = header.sequence;
+  map_regions_[sequence_ % 2] = header.map_region;
+  // an entry must be a slot within the file, off the header, the map and the slots before it
+  std::sort(entries.begin(), entries.end(),
+            [](const MapEntry &a, const MapEntry &b) { return a.slot.offset < b.slot.offset; });
+  std::vector<Slot> used{header.map_region};
+  const Slot &map = header.map_region;
+  uint64_t end = HEADER_UNITS;
+  size_t num_invalid = 0;
+  for (auto &entry : entries) {
+    uint64_t entry_end = static_cast<uint64_t>(entry.slot.offset) + entry.slot.units;
+    bool overlaps_map = entry.slot.offset < map.offset + map.units && entry_end > map.offset;
+    if (entry.physical_page_id < 0 || entry.physical_page_id >= max_page_id_ || entry.slot.units == 0 ||
+        entry.slot.units > MAX_SLOT_UNITS || entry.slot.offset < end || entry_end > num_units_ || overlaps_map ||
+        (static_cast<size_t>(entry.physical_page_id) < slots_.size() && slots_[entry.physical_page_id].units != 0)) {
+      num_invalid++;
+      continue;
+    }
+    if (static_cast<size_t>(entry.physical_page_id) >= slots_.size()) {
+      slots_.resize(entry.physical_page_id + 1);
+    }
+    slots_[entry.physical_page_id] = entry.slot;
+    used.push_back(entry.slot);
+    end = entry_end;
+  }
+  if (num_invalid > 0) {
+    LOG(ERROR) << "Dropped " << num_invalid << " invalid map entries of " << file_name_;
+  }
+  // the gaps between the slots and the map region are free
+  std::sort(used.begin(), used.end(), [](const Slot &a, const Slot &b) { return a.offset < b.offset; });
+  used.push_back({num_units_, 0});
+  uint32_t gap = HEADER_UNITS;
+  for (auto &slot : used) {
+    if (gap < slot.offset) {
+      FreeUnits(gap, slot.offset - gap);
+    }
+    gap = std::max(gap, slot.offset + slot.units);
+  }
+}
+
+size_t CompressedPageStore::ReadPage(page_id_t physical_page_id, char *page_data) {
+  Slot slot;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (static_cast<size_t>(physical_page_id) >= slots_.size() || slots_[physical_page_id].units == 0) {
+      return 0;
+    }
+    slot = slots_[physical_page_id];
+  }
+  char buf[MAX_SLOT_UNITS * SLOT_SIZE];
+  size_t size = slot.units * SLOT_SIZE;
+  bool ok = ReadAt(buf, size, static_cast<size_t>(slot.offset) * SLOT_SIZE);
+  if (ok) {
+    uint16_t length;
+    memcpy(&length, buf, sizeof(length));
+    ok = sizeof(length) + length <= size && LZPageCodec::Decompress(buf + sizeof(length), length, page_data, PAGE_SIZE);
+  }
+  if (!ok) {
+    LOG(ERROR) << "Corrupted compressed page " << physical_page_id << " in " << file_name_;
+    memset(page_data, 0, PAGE_SIZE);
+  }
+  return size;
+}
+
+bool CompressedPageStore::WritePage(page_id_t physical_page_id, const char *page_data) {
+  char buf[MAX_SLOT_UNITS * SLOT_SIZE];
+  uint16_t length = LZPageCodec::Compress(page_data, PAGE_SIZE, buf + sizeof(length),
+                                          MAX_COMPRESSED_SIZE - sizeof(length));
+  uint32_t units = (sizeof(length) + length + SLOT_SIZE - 1) / SLOT_SIZE;
+  Slot slot;
+  bool in_place;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (static_cast<size_t>(physical_page_id) >= slots_.size()) {
+      if (length == 0) {
+        return false;
+      }
+      slots_.resize(std::max<size_t>(physical_page_id + 1, slots_.size() * 2));
+    }
+    Slot &current = slots_[physical_page_id];
+    if (length == 0) {
+      DropSlot(current);
+      return false;
+    }
+    // an image of another size goes to another slot, the map points to it once it is written
+    in_place = current.units == units;
+    slot = in_place ? current : Slot{AllocateSlot(units), units};
+  }
+  memcpy(buf, &length, sizeof(length));
+  memset(buf + sizeof(length) + length, 0, units * SLOT_SIZE - sizeof(length) - length);
+  bool written = WriteAt(buf, units * SLOT_SIZE, static_cast<size_t>(slot.offset) * SLOT_SIZE);
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    Slot &current = slots_[physical_page_id];
+    if (!written) {
+      // the page is written to the db file instead, its slot can't be trusted any more
+      if (!in_place) {
+        FreeUnits(slot.offset, slot.units);
+      }
+      DropSlot(current);
+      return false;
+    }
+    if (!in_place) {
+      DropSlot(current);
+      current = slot;
+      map_dirty_ = true;
+    }
+  }
+  num_bytes_written_ += length;
+  return true;
+}
+
+uint32_t CompressedPageStore::AllocateSlot(uint32_t units) {
+  // the smallest free slot which is large enough, the rest of it stays free
+  for (size_t size = units; size <= MAX_SLOT_UNITS; size++) {
+    if (!free_slots_[size].empty()) {
+      uint32_t offset = free_slots_[size].back();
+      free_slots_[size].pop_back();
+      if (size > units) {
+        free_slots_[size - units].push_back(offset + units);
+      }
+      return offset;
+    }
+  }
+  uint32_t offset = num_units_;
+  num_units_ += units;
+  return offset;
+}
+
+void CompressedPageStore::DropSlot(Slot &slot) {
+  if (slot.units != 0) {
+    dropped_slots_.push_back(slot);
+    slot = Slot();
+    map_dirty_ = true;
+  }
+}
+
+void CompressedPageStore::FreeUnits(uint32_t offset, uint32_t units) {
+  while (units > 0) {
+    uint32_t size = std::min<uint32_t>(units, MAX_SLOT_UNITS);
+    free_slots_[size].push_back(offset);
+    offset += size;
+    units -= size;
+  }
+}
+
+size_t CompressedPageStore::GetNumPages() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return std::count_if(slots_.begin(), slots_.end(), [](const Slot &slot) { return slot.units != 0; });
+}
+
+void CompressedPageStore::Sync() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (fd_ >= 0) {
+    SaveMap(true);
+  }
+}
+
+bool CompressedPageStore::SaveMap(bool sync) {
+  if (!map_dirty_) {
+    return !sync || SyncFile();
+  }
+  std::vector<MapEntry> entries;
+  for (size_t i = 0; i < slots_.size(); i++) {
+    if (slots_[i].units != 0) {
+      entries.push_back({static_cast<page_id_t>(i), slots_[i]});
+    }
+  }
+  uint64_t sequence = sequence_ + 1;
+  uint32_t map_units = (entries.size() * sizeof(MapEntry) + SLOT_SIZE - 1) / SLOT_SIZE;
+  Slot &region = map_regions_[sequence % 2];
+  if (region.units < map_units) {
+    // the region of the copy not in use is free, the new one at the end of the file leaves room to grow
+    FreeUnits(region.offset, region.units);
+    region = {num_units_, map_units * 2};
+    num_units_ += region.units;
+  }
+  std::vector<char> buf(static_cast<size_t>(region.units) * SLOT_SIZE);
+  memcpy(buf.data(), entries.data(), entries.size() * sizeof(MapEntry));
+  Header header{MAGIC, static_cast<uint32_t>(entries.size()), num_units_, region, sequence, 0};
+  header.checksum = Checksum(header);
+  char header_buf[HEADER_COPY_SIZE]{};
+  memcpy(header_buf, &header, sizeof(header));
+  // the slots and the map are on the disk before the header points to them
+  if (!WriteAt(buf.data(), buf.size(), static_cast<size_t>(region.offset) * SLOT_SIZE) || (sync && !SyncFile()) ||
+      !WriteAt(header_buf, sizeof(header_buf), (sequence % 2) * HEADER_COPY_SIZE) || (sync && !SyncFile())) {
+    return false;
+  }
+  // the map saved before and the slots it kept are not needed any more
+  sequence_ = sequence;
+  for (auto &slot : dropped_slots_) {
+    FreeUnits(slot.offset, slot.units);
+  }
+  dropped_slots_.clear();
+  map_dirty_ = false;
+  return true;
+}
+
+bool CompressedPageStore::SyncFile() {
+  if (fdatasync(fd_) != 0) {
+    LOG(ERROR) << "I/O error while syncing: " << strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+void CompressedPageStore::Close(bool sync) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (fd_ < 0) {
+    return;
+  }
+  SaveMap(sync);
+  close(fd_);
+  fd_ = -1;
+}
+
+bool CompressedPageStore::WriteAt(const char *data, size_t size, size_t offset) {
+  size_t written = 0;
+  while (written < size) {
+    ssize_t res = pwrite(fd_, data + written, size - written, offset + written);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      LOG(ERROR) << "I/O error while writing " << file_name_ << ": " << strerror(errno);
+      return false;
+    }
+    written += res;
+  }
+  return true;
+}
+
+bool CompressedPageStore::ReadAt(char *data, size_t size, size_t offset) {
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t res = pread(fd_, data + read_count, size - read_count, offset + read_count);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      LOG(ERROR) << "I/O error while reading " << file_name_ << ": " << (res < 0 ? strerror(errno) : "end of file");
+      return false;
+    }
+    read_count += res;
+  }
+  return true;
+}
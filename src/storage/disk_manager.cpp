@@ -1,50 +1,141 @@
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
 #include <stdexcept>
+#include <climits>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 #include "storage/disk_manager.h"
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file){
+DiskManager::DiskManager(const std::string &db_file, SyncPolicy sync_policy, DiskReadMode read_mode,
+                         PageCompression compression)
+    : file_name_(db_file), sync_policy_(sync_policy) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  db_fd_ = open(db_file.c_str(), O_RDWR);
   // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
+  if (db_fd_ < 0) {
     // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (db_fd_ < 0) {
       throw std::exception();
     }
-    //memset(meta_data_,0,PAGE_SIZE);
+    // the compressed pages and the log of a db file which was there before
+    remove(GetSlotFileName(db_file).c_str());
+    remove(GetLogFileName(db_file).c_str());
+    memset(meta_data_, 0, PAGE_SIZE);
     Meta_Page_ = new DiskFileMetaPage;
     Meta_Page_->num_allocated_pages_=0;
     Meta_Page_->num_extents_=0;
   }
   else{
+    struct stat stat_buf;
+    if (fstat(db_fd_, &stat_buf) == 0) {
+      file_size_ = stat_buf.st_size;
+    }
+    if (read_mode == kReadMmap && file_size_ > 0) {
+      void *map = mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, db_fd_, 0);
+      if (map == MAP_FAILED) {
+        LOG(WARNING) << "Can't map " << db_file << ", pages are read with pread: " << strerror(errno);
+      } else {
+        map_ = static_cast<char *>(map);
+        map_size_ = file_size_;
+      }
+    }
     ReadPhysicalPage(META_PAGE_ID, meta_data_);
     Meta_Page_ = new DiskFileMetaPage(meta_data_);
+    uint32_t version = Meta_Page_->GetFormatVersion();
+    // the pages of an older version can't be converted here, only the catalog knows which ones are table pages
+    if (version != DISK_FILE_FORMAT_VERSION || Meta_Page_->num_extents_ > META_EXTENT_SLOTS) {
+      LOG(ERROR) << "Can't open " << db_file << ", unsupported format version " << version;
+      if (map_ != nullptr) {
+        munmap(map_, map_size_);
+      }
+      close(db_fd_);
+      delete Meta_Page_;
+      throw std::exception();
+    }
     uint32_t num = Meta_Page_->num_extents_;
+    // a bitmap page is saved as a whole, with its allocation counter and hint
+    static_assert(sizeof(BitmapPage<PAGE_SIZE>) == PAGE_SIZE, "A bitmap page must fill a page.");
     for (uint32_t i = 0; i < num; ++i) {
-      char *bitmap_data = new char[DiskManager::BITMAP_SIZE];
-      ReadPhysicalPage(i * (DiskManager::BITMAP_SIZE + 1) + 1, bitmap_data);
-      memcpy(Bitmap_Page_[i].GetBitmap_Data(), bitmap_data, DiskManager::BITMAP_SIZE);
-      delete [] bitmap_data;
+      ReadPhysicalPage(i * (DiskManager::BITMAP_SIZE + 1) + 1, reinterpret_cast<char *>(&Bitmap_Page_[i]));
     }
   }
+  preallocated_size_ = file_size_;
+  if (compression == kCompressionLZ || access(GetSlotFileName(db_file).c_str(), F_OK) == 0) {
+    compressed_pages_ =
+        std::make_unique<CompressedPageStore>(GetSlotFileName(db_file), MapPageId(MAX_VALID_PAGE_ID - 1) + 1);
+    // the compressed pages are never written to their place in the db file, don't reserve it
+    preallocation_pages_ = 0;
+  }
+  for (uint32_t extent = 0; extent < MAX_EXTENTS; extent++) {
+    SetExtentHasFree(extent, Meta_Page_->extent_used_page_[extent] < BITMAP_SIZE);
+  }
+}
+
+void DiskManager::Sync() {
+  if (sync_policy_ == kSyncNever) {
+    return;
+  }
+  num_syncs_++;
+  if (fdatasync(db_fd_) != 0) {
+    LOG(ERROR) << "I/O error while syncing: " << strerror(errno);
+  }
+  if (compressed_pages_ != nullptr) {
+    compressed_pages_->Sync();
+  }
+}
+
+void DiskManager::AdviseAccess(AccessHint hint, page_id_t logical_page_id, size_t num_pages) {
+  if (logical_page_id < 0 || logical_page_id >= MAX_VALID_PAGE_ID || num_pages == 0 || compressed_pages_ != nullptr) {
+    return;
+  }
+  // the pages of an extent are contiguous in the file, the range stops at the end of the extent of the first one
+  size_t extent_end = (logical_page_id / BITMAP_SIZE + 1) * BITMAP_SIZE;
+  num_pages = std::min(num_pages, extent_end - logical_page_id);
+  size_t offset = static_cast<size_t>(MapPageId(logical_page_id)) * PAGE_SIZE;
+  size_t length = num_pages * PAGE_SIZE;
+  if (map_ != nullptr && offset < map_size_) {
+    length = std::min(length, map_size_ - offset);
+    int advice = hint == kAccessHintSequential ? MADV_WILLNEED : hint == kAccessHintRandom ? MADV_RANDOM : MADV_NORMAL;
+    madvise(map_ + offset, length, advice);
+  } else if (hint == kAccessHintSequential) {
+    // the random and sequential advices of posix_fadvise apply to the whole file whatever the range, only the read
+    // ahead of the range itself is asked for
+    posix_fadvise(db_fd_, offset, length, POSIX_FADV_WILLNEED);
+  }
 }
 
 void DiskManager::Close() {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
   if (!closed) {
-     db_io_.close();
+    if (map_ != nullptr) {
+      munmap(map_, map_size_);
+      map_ = nullptr;
+    }
+    write_queue_.reset();
+    if (compressed_pages_ != nullptr) {
+      compressed_pages_->Close(sync_policy_ != kSyncNever);
+    }
+    Sync();
+    close(db_fd_);
+    db_fd_ = -1;
+    std::scoped_lock<std::recursive_mutex> log_lock(log_io_latch_);
+    if (log_fd_ >= 0) {
+      close(log_fd_);
+      log_fd_ = -1;
+    }
     closed = true;
   }
 }
 
+// The page reads and writes don't take db_io_latch_: MapPageId only depends on the page id, and positional I/O
+// doesn't share a cursor between threads.
 void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
   ReadPhysicalPage(MapPageId(logical_page_id), page_data);
@@ -55,24 +146,161 @@ void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
   WritePhysicalPage(MapPageId(logical_page_id), page_data);
 }
 
+void DiskManager::WritePages(std::vector<std::pair<page_id_t, const char *>> pages) {
+  for (auto &page : pages) {
+    ASSERT(page.first >= 0, "Invalid page id.");
+    page.first = MapPageId(page.first);
+  }
+  std::sort(pages.begin(), pages.end());
+  std::scoped_lock<std::mutex> lock(write_queue_latch_);
+  if (write_queue_ == nullptr) {
+    write_queue_ = NewIOQueue();
+  }
+  // the runs of adjacent pages point into iovecs, which must live until the writes are done
+  std::vector<iovec> iovecs(pages.size());
+  for (size_t i = 0; i < pages.size(); i++) {
+    iovecs[i] = {const_cast<char *>(pages[i].second), PAGE_SIZE};
+  }
+  std::vector<PageIOCompletion> completions;
+  size_t begin = 0;
+  while (begin < pages.size()) {
+    // find the run of adjacent pages starting from begin
+    size_t end = begin + 1;
+    while (end < pages.size() && end - begin < IOV_MAX && pages[end].first == pages[end - 1].first + 1) {
+      end++;
+    }
+    while (!write_queue_->PreparePhysical(pages[begin].first, &iovecs[begin], end - begin, true, begin)) {
+      write_queue_->Wait(completions, 1);
+    }
+    begin = end;
+  }
+  write_queue_->Wait(completions, write_queue_->GetPending());
+  if (sync_policy_ == kSyncOnCheckpoint && !pages.empty()) {
+    Sync();
+  }
+}
+
+bool DiskManager::OpenLog() {
+  if (log_fd_ < 0) {
+    log_fd_ = open(GetLogFileName(file_name_).c_str(), O_RDWR | O_CREAT, 0644);
+    if (log_fd_ < 0) {
+      LOG(ERROR) << "Can't open the log of " << file_name_ << ": " << strerror(errno);
+      return false;
+    }
+    struct stat stat_buf;
+    log_size_ = fstat(log_fd_, &stat_buf) == 0 ? stat_buf.st_size : 0;
+  }
+  return true;
+}
+
+bool DiskManager::WriteLog(const char *log_data, size_t size) {
+  std::scoped_lock<std::recursive_mutex> lock(log_io_latch_);
+  if (!OpenLog()) {
+    return false;
+  }
+  return WriteLogAt(log_data, size, log_size_);
+}
+
+bool DiskManager::WriteLogAt(const char *log_data, size_t size, size_t offset) {
+  std::scoped_lock<std::recursive_mutex> lock(log_io_latch_);
+  if (!OpenLog()) {
+    return false;
+  }
+  size_t written = 0;
+  while (written < size) {
+    ssize_t res = pwrite(log_fd_, log_data + written, size - written, offset + written);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      LOG(ERROR) << "I/O error while writing the log: " << strerror(errno);
+      return false;
+    }
+    written += res;
+  }
+  log_size_ = std::max(log_size_, offset + size);
+  if (sync_policy_ != kSyncNever && fdatasync(log_fd_) != 0) {
+    LOG(ERROR) << "I/O error while syncing the log: " << strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+void DiskManager::TruncateLog(size_t size) {
+  std::scoped_lock<std::recursive_mutex> lock(log_io_latch_);
+  if (!OpenLog()) {
+    return;
+  }
+  if (ftruncate(log_fd_, size) != 0) {
+    LOG(ERROR) << "I/O error while truncating the log: " << strerror(errno);
+    return;
+  }
+  log_size_ = size;
+}
+
+bool DiskManager::DiscardLog(size_t offset, size_t size) {
+  std::scoped_lock<std::recursive_mutex> lock(log_io_latch_);
+  if (!OpenLog()) {
+    return false;
+  }
+  if (fallocate(log_fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, size) != 0) {
+    LOG_FIRST_N(WARNING, 1) << "Can't free the space of the old records of the log: " << strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+size_t DiskManager::GetLogSize() {
+  std::scoped_lock<std::recursive_mutex> lock(log_io_latch_);
+  return OpenLog() ? log_size_ : 0;
+}
+
+size_t DiskManager::ReadLog(char *log_data, size_t size, size_t offset) {
+  std::scoped_lock<std::recursive_mutex> lock(log_io_latch_);
+  if (!OpenLog()) {
+    return 0;
+  }
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t res = pread(log_fd_, log_data + read_count, size - read_count, offset + read_count);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res < 0) {
+      LOG(ERROR) << "I/O error while reading the log: " << strerror(errno);
+    }
+    if (res <= 0) {
+      break;
+    }
+    read_count += res;
+  }
+  return read_count;
+}
+
+std::unique_ptr<PageIOQueue> DiskManager::NewIOQueue(size_t queue_depth, bool use_io_uring) {
+  // io_uring reads and writes the db file directly, compressed pages must go through ReadPhysicalPage and
+  // WritePhysicalPages
+  if (use_io_uring && compressed_pages_ == nullptr) {
+    auto queue = PageIOQueue::NewIoUringQueue(this, db_fd_, queue_depth);
+    if (queue != nullptr) {
+      return queue;
+    }
+    LOG_FIRST_N(WARNING, 1) << "io_uring is not available, page I/Os are done synchronously";
+  }
+  return PageIOQueue::NewSyncQueue(this, queue_depth);
+}
+
 page_id_t DiskManager::AllocatePage(){
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
   if(Meta_Page_->GetAllocatedPages()==MAX_VALID_PAGE_ID){//no free page
     LOG(ERROR)<<"No free page";
     return INVALID_PAGE_ID;
   }
   //#pages of every extent
-  size_t SIZE = DiskManager::BITMAP_SIZE;   
-  //find the next_allocate_page
-  uint32_t extent;
+  size_t SIZE = DiskManager::BITMAP_SIZE;
   uint32_t page_offset;
-  //find the extent that has free page to allocate 
-  for(extent = 0; extent < PAGE_SIZE/4; extent++)
-    if(Meta_Page_->GetExtentUsedPage(extent) >= DiskManager::BITMAP_SIZE)
-      //this extent has no free page to allocate 
-      continue;
-    else
-      //this extent has free page to allocate 
-      break;
+  //find the extent that has free page to allocate
+  uint32_t extent = FindExtentWithFreePage();
   if(extent >= Meta_Page_->GetExtentNums()){
     //this extent has not been allocate
     //need to allocate a new extent
@@ -84,20 +312,39 @@ page_id_t DiskManager::AllocatePage(){
   }
   else Meta_Page_->extent_used_page_[extent]++; // modify extent_used_page_
   Meta_Page_->num_allocated_pages_++;
+  if(Meta_Page_->extent_used_page_[extent] == SIZE) SetExtentHasFree(extent, false);
   //allocate page
   if(!Bitmap_Page_[extent].AllocatePage(page_offset)) return INVALID_PAGE_ID;//fail
-  //write bit_map
-  //WritePhysicalPage(extent*( SIZE + 1 ) + 1, (char *)Bitmap_Page_[extent].GetBitmap_Data());
   //write meta_page
-  memcpy(meta_data_, &(Meta_Page_->num_allocated_pages_), sizeof(uint32_t));
-  memcpy(meta_data_ + sizeof(uint32_t), &(Meta_Page_->num_extents_), sizeof(uint32_t));
-  memcpy(meta_data_ + 2 * sizeof(uint32_t), Meta_Page_->extent_used_page_, (PAGE_SIZE - 8) / 4 * sizeof(uint32_t));
-  //WritePhysicalPage(META_PAGE_ID, meta_data_);
+  UpdateMetaData(extent);
   page_id_t page_index = extent * SIZE + page_offset;
+  Preallocate(MapPageId(page_index));
   return page_index;
 }
 
+bool DiskManager::AllocatePageAt(page_id_t logical_page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if(logical_page_id<0 || logical_page_id>=MAX_VALID_PAGE_ID){
+    LOG(ERROR) << "Invalid page id.";
+    return false;
+  }
+  size_t SIZE = DiskManager::BITMAP_SIZE;
+  uint32_t extent = logical_page_id / SIZE;
+  if(!Bitmap_Page_[extent].AllocatePageAt(logical_page_id % SIZE)) return false;
+  //the extents are opened in order, their bitmap pages are at fixed places in the file
+  while(Meta_Page_->num_extents_ <= extent){
+    Meta_Page_->num_extents_++;
+  }
+  Meta_Page_->extent_used_page_[extent]++;
+  Meta_Page_->num_allocated_pages_++;
+  if(Meta_Page_->extent_used_page_[extent] == SIZE) SetExtentHasFree(extent, false);
+  UpdateMetaData(extent);
+  Preallocate(MapPageId(logical_page_id));
+  return true;
+}
+
 void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
   if(logical_page_id<0){
     LOG(ERROR) << "Invalid page id.";
     return;
@@ -106,26 +353,66 @@ void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
   uint32_t extent = logical_page_id / SIZE; //Get the corresponding extent
   uint32_t page_offset = logical_page_id % SIZE;
   if(!Bitmap_Page_[extent].DeAllocatePage(page_offset)) return;//fail
-  //write bit_map
-  //WritePhysicalPage(extent*( SIZE + 1 ) + 1, (char *)Bitmap_Page_[extent].GetBitmap_Data());
+  // an emptied extent stays opened, its bitmap page is still in the file
   Meta_Page_->num_allocated_pages_--;
   Meta_Page_->extent_used_page_[extent]--;
-  if(Meta_Page_->GetExtentUsedPage(extent)==0)
-    Meta_Page_->num_extents_--;
+  SetExtentHasFree(extent, true);
   //write meta_page
+  UpdateMetaData(extent);
+}
+
+uint32_t DiskManager::FindExtentWithFreePage() const {
+  for(uint32_t word = 0; word < (MAX_EXTENTS + 63) / 64; word++){
+    if(extent_has_free_[word] != 0){
+      return word * 64 + __builtin_ctzll(extent_has_free_[word]);
+    }
+  }
+  return MAX_EXTENTS;
+}
+
+void DiskManager::SetExtentHasFree(uint32_t extent, bool has_free) {
+  if(has_free) extent_has_free_[extent / 64] |= 1ULL << (extent % 64);
+  else extent_has_free_[extent / 64] &= ~(1ULL << (extent % 64));
+}
+
+void DiskManager::UpdateMetaData(uint32_t extent) {
   memcpy(meta_data_, &(Meta_Page_->num_allocated_pages_), sizeof(uint32_t));
   memcpy(meta_data_ + sizeof(uint32_t), &(Meta_Page_->num_extents_), sizeof(uint32_t));
-  memcpy(meta_data_ + 2 * sizeof(uint32_t), Meta_Page_->extent_used_page_, (PAGE_SIZE - 8) / 4 * sizeof(uint32_t));
-  //WritePhysicalPage(META_PAGE_ID, meta_data_);
+  memcpy(meta_data_ + (2 + extent) * sizeof(uint32_t), &(Meta_Page_->extent_used_page_[extent]), sizeof(uint32_t));
+}
+
+void DiskManager::WriteMetaData() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  memcpy(meta_data_, &(Meta_Page_->num_allocated_pages_), sizeof(uint32_t));
+  memcpy(meta_data_ + sizeof(uint32_t), &(Meta_Page_->num_extents_), sizeof(uint32_t));
+  memcpy(meta_data_ + 2 * sizeof(uint32_t), Meta_Page_->extent_used_page_, META_EXTENT_SLOTS * sizeof(uint32_t));
+  memcpy(meta_data_ + PAGE_SIZE - 2 * sizeof(uint32_t), &(Meta_Page_->magic_), sizeof(uint32_t));
+  memcpy(meta_data_ + PAGE_SIZE - sizeof(uint32_t), &(Meta_Page_->version_), sizeof(uint32_t));
+  WritePhysicalPage(META_PAGE_ID, meta_data_);
+  uint32_t SIZE = DiskManager::BITMAP_SIZE;
+  for(uint32_t extent = 0; extent < Meta_Page_->num_extents_; extent++){
+    WritePhysicalPage(extent*( SIZE + 1 ) + 1, reinterpret_cast<const char *>(&Bitmap_Page_[extent]));
+  }
+}
+
+void DiskManager::FlushMetaData() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  WriteMetaData();
+  Sync();
 }
 
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
   size_t SIZE=DiskManager::BITMAP_SIZE;
   uint32_t extent = logical_page_id / SIZE; //Get the corresponding extent
   uint32_t page_offset = logical_page_id % SIZE;
   return Bitmap_Page_[extent].IsPageFree(page_offset);
 }
 
+bool DiskManager::IsDataPage(page_id_t physical_page_id) {
+  return physical_page_id != META_PAGE_ID && (physical_page_id - 1) % (BITMAP_SIZE + 1) != 0;
+}
+
 page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
   size_t SIZE = DiskManager::BITMAP_SIZE;
   uint32_t extent = logical_page_id / SIZE; //check the extent the page is in
@@ -135,45 +422,140 @@ page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
 }
 
 
-int DiskManager::GetFileSize(const std::string &file_name) {
-  struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? stat_buf.st_size : -1;
+void DiskManager::ExtendFileSize(size_t end) {
+  size_t size = file_size_.load();
+  while (size < end && !file_size_.compare_exchange_weak(size, end)) {
+  }
+}
+
+void DiskManager::Preallocate(page_id_t physical_page_id) {
+  size_t end = (static_cast<size_t>(physical_page_id) + 1) * PAGE_SIZE;
+  if (end <= preallocated_size_ || preallocation_pages_ == 0) {
+    return;
+  }
+  // grow to the end of the chunk the page is in, a newly opened extent also gets its bitmap page reserved
+  size_t chunk_size = static_cast<size_t>(preallocation_pages_) * PAGE_SIZE;
+  size_t new_size = (end + chunk_size - 1) / chunk_size * chunk_size;
+  int res;
+  do {
+    res = fallocate(db_fd_, 0, preallocated_size_, new_size - preallocated_size_);
+  } while (res != 0 && errno == EINTR);
+  if (res != 0) {
+    // e.g. a file system without fallocate, the writes grow the file as before
+    LOG(WARNING) << "Can't preallocate " << file_name_ << ", the file grows page by page: " << strerror(errno);
+    preallocation_pages_ = 0;
+    return;
+  }
+  num_preallocations_++;
+  preallocated_size_ = new_size;
+  ExtendFileSize(new_size);
 }
 
 void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
-  int offset = physical_page_id * PAGE_SIZE;
+  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
+  num_reads_++;
+  if (compressed_pages_ != nullptr && IsDataPage(physical_page_id)) {
+    size_t length = compressed_pages_->ReadPage(physical_page_id, page_data);
+    if (length > 0) {
+      num_bytes_read_ += length;
+      return;
+    }
+  }
   // check if read beyond file length
-  if (offset >= GetFileSize(file_name_)) {
+  if (offset >= file_size_.load()) {
 #ifdef ENABLE_BPM_DEBUG
     LOG(INFO) << "Read less than a page" << std::endl;
 #endif
     memset(page_data, 0, PAGE_SIZE);
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
+    return;
+  }
+  num_bytes_read_ += PAGE_SIZE;
+  if (offset + PAGE_SIZE <= map_size_) {
+    memcpy(page_data, map_ + offset, PAGE_SIZE);
+    num_mapped_reads_++;
+    return;
+  }
+  size_t read_count = 0;
+  while (read_count < PAGE_SIZE) {
+    ssize_t res = pread(db_fd_, page_data + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res < 0) {
+      LOG(ERROR) << "I/O error while reading: " << strerror(errno);
+    }
+    if (res <= 0) {
+      break;
+    }
+    read_count += res;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
 #ifdef ENABLE_BPM_DEBUG
-      LOG(INFO) << "Read less than a page" << std::endl;
+    LOG(INFO) << "Read less than a page" << std::endl;
 #endif
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
-    }
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
   }
 }
 
 void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
+  iovec page{const_cast<char *>(page_data), PAGE_SIZE};
+  WritePhysicalPages(physical_page_id, &page, 1);
+}
+
+bool DiskManager::WritePhysicalPages(page_id_t physical_page_id, const iovec *pages, size_t num_pages) {
+  ASSERT(num_pages <= IOV_MAX, "Too many pages for one write.");
+  if (compressed_pages_ != nullptr) {
+    // every page of a run decides for itself where it goes
+    if (num_pages > 1) {
+      bool ok = true;
+      for (size_t i = 0; i < num_pages; i++) {
+        ok = WritePhysicalPages(physical_page_id + i, pages + i, 1) && ok;
+      }
+      return ok;
+    }
+    if (IsDataPage(physical_page_id) &&
+        compressed_pages_->WritePage(physical_page_id, static_cast<const char *>(pages[0].iov_base))) {
+      num_writes_++;
+      if (sync_policy_ == kSyncAlways) {
+        Sync();
+      }
+      return true;
+    }
+  }
   size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG(ERROR) << "I/O error while writing";
-    return;
+  size_t size = num_pages * PAGE_SIZE;
+  size_t written = 0;
+  // after a short write, continue from the page it stopped in
+  std::vector<iovec> rest;
+  while (written < size) {
+    size_t first = written / PAGE_SIZE;
+    const iovec *iov = pages + first;
+    if (written % PAGE_SIZE != 0) {
+      rest.assign(pages + first, pages + num_pages);
+      rest[0].iov_base = static_cast<char *>(rest[0].iov_base) + written % PAGE_SIZE;
+      rest[0].iov_len -= written % PAGE_SIZE;
+      iov = rest.data();
+    }
+    ssize_t res = pwritev(db_fd_, iov, num_pages - first, offset + written);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (res <= 0) {
+      LOG(ERROR) << "I/O error while writing: " << strerror(errno);
+      return false;
+    }
+    written += res;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
-}
\ No newline at end of file
+  WriteCompleted(physical_page_id, num_pages);
+  return true;
+}
+
+void DiskManager::WriteCompleted(page_id_t physical_page_id, size_t num_pages) {
+  num_writes_++;
+  ExtendFileSize((static_cast<size_t>(physical_page_id) + num_pages) * PAGE_SIZE);
+  if (sync_policy_ == kSyncAlways) {
+    Sync();
+  }
+}
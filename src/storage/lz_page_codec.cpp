@@ -0,0 +1,153 @@
+#include <cstring>
+
+#include "storage/lz_page_codec.h"
+
+namespace {
+
+inline uint32_t Load32(const unsigned char *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+/**
+ * Append the extension bytes of a length which did not fit into its 4 bits of the token.
+ * @return false if dst is full
+ */
+inline bool PutLength(size_t length, unsigned char *&op, const unsigned char *op_end) {
+  for (; length >= 255; length -= 255) {
+    if (op == op_end) {
+      return false;
+    }
+    *op++ = 255;
+  }
+  if (op == op_end) {
+    return false;
+  }
+  *op++ = static_cast<unsigned char>(length);
+  return true;
+}
+
+/**
+ * Read the extension bytes of a length whose 4 bits in the token are 15.
+ * @return false if src ends first
+ */
+inline bool GetLength(size_t &length, const unsigned char *&ip, const unsigned char *ip_end) {
+  unsigned char byte;
+  do {
+    if (ip == ip_end) {
+      return false;
+    }
+    byte = *ip++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/**
+ * Append a sequence of literals followed by a match, a match_length of 0 means that there is no match.
+ * @return false if dst is full
+ */
+bool PutSequence(const unsigned char *literals, size_t num_literals, size_t offset, size_t match_length,
+                 unsigned char *&op, const unsigned char *op_end) {
+  if (op == op_end) {
+    return false;
+  }
+  size_t match_code = match_length == 0 ? 0 : match_length - LZPageCodec::MIN_MATCH;
+  *op++ = static_cast<unsigned char>((num_literals < 15 ? num_literals : 15) << 4 | (match_code < 15 ? match_code : 15));
+  if (num_literals >= 15 && !PutLength(num_literals - 15, op, op_end)) {
+    return false;
+  }
+  if (static_cast<size_t>(op_end - op) < num_literals) {
+    return false;
+  }
+  memcpy(op, literals, num_literals);
+  op += num_literals;
+  if (match_length == 0) {
+    return true;
+  }
+  if (op_end - op < 2) {
+    return false;
+  }
+  *op++ = static_cast<unsigned char>(offset);
+  *op++ = static_cast<unsigned char>(offset >> 8);
+  return match_code < 15 || PutLength(match_code - 15, op, op_end);
+}
+
+}  // namespace
+
+size_t LZPageCodec::Compress(const char *src, size_t len, char *dst, size_t capacity) {
+  const auto *in = reinterpret_cast<const unsigned char *>(src);
+  auto *op = reinterpret_cast<unsigned char *>(dst);
+  const unsigned char *op_end = op + capacity;
+  // position + 1 of the last occurrence of the hash of 4 bytes, 0 if none
+  uint32_t table[1 << HASH_BITS] = {};
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + MIN_MATCH <= len) {
+    uint32_t sequence = Load32(in + pos);
+    uint32_t hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+    size_t candidate = table[hash];
+    table[hash] = pos + 1;
+    if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || Load32(in + candidate - 1) != sequence) {
+      pos++;
+      continue;
+    }
+    candidate--;
+    size_t match_length = MIN_MATCH;
+    while (pos + match_length < len && in[candidate + match_length] == in[pos + match_length]) {
+      match_length++;
+    }
+    if (!PutSequence(in + anchor, pos - anchor, pos - candidate, match_length, op, op_end)) {
+      return 0;
+    }
+    pos += match_length;
+    anchor = pos;
+  }
+  if (!PutSequence(in + anchor, len - anchor, 0, 0, op, op_end)) {
+    return 0;
+  }
+  return op - reinterpret_cast<unsigned char *>(dst);
+}
+
+bool LZPageCodec::Decompress(const char *src, size_t len, char *dst, size_t dst_len) {
+  const auto *ip = reinterpret_cast<const unsigned char *>(src);
+  const unsigned char *ip_end = ip + len;
+  auto *out = reinterpret_cast<unsigned char *>(dst);
+  size_t pos = 0;
+  while (ip < ip_end) {
+    unsigned char token = *ip++;
+    size_t num_literals = token >> 4;
+    if (num_literals == 15 && !GetLength(num_literals, ip, ip_end)) {
+      return false;
+    }
+    if (static_cast<size_t>(ip_end - ip) < num_literals || dst_len - pos < num_literals) {
+      return false;
+    }
+    memcpy(out + pos, ip, num_literals);
+    ip += num_literals;
+    pos += num_literals;
+    if (ip == ip_end) {
+      // the last sequence
+      break;
+    }
+    if (ip_end - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | ip[1] << 8;
+    ip += 2;
+    size_t match_length = token & 15;
+    if (match_length == 15 && !GetLength(match_length, ip, ip_end)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > pos || dst_len - pos < match_length) {
+      return false;
+    }
+    // byte by byte, a match may overlap the bytes it produces
+    for (size_t i = 0; i < match_length; i++, pos++) {
+      out[pos] = out[pos - offset];
+    }
+  }
+  return pos == dst_len;
+}
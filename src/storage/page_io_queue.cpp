@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "glog/logging.h"
+#include "storage/disk_manager.h"
+#include "storage/page_io_queue.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define MINISQL_HAS_IO_URING 1
+#endif
+
+bool PageIOQueue::PrepareRead(page_id_t logical_page_id, char *data, uint64_t tag) {
+  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  iovec page{data, PAGE_SIZE};
+  return PreparePhysical(DiskManager::MapPageId(logical_page_id), &page, 1, false, tag);
+}
+
+bool PageIOQueue::PrepareWrite(page_id_t logical_page_id, const char *data, uint64_t tag) {
+  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  // iovec is shared by reads and writes, the data of a write is never written to
+  iovec page{const_cast<char *>(data), PAGE_SIZE};
+  return PreparePhysical(DiskManager::MapPageId(logical_page_id), &page, 1, true, tag);
+}
+
+bool PageIOQueue::WriteSync(page_id_t physical_page_id, const iovec *pages, size_t num_pages) {
+  return disk_manager_->WritePhysicalPages(physical_page_id, pages, num_pages);
+}
+
+void PageIOQueue::ReadSync(page_id_t physical_page_id, const iovec *pages, size_t num_pages) {
+  for (size_t i = 0; i < num_pages; i++) {
+    disk_manager_->ReadPhysicalPage(physical_page_id + i, static_cast<char *>(pages[i].iov_base));
+  }
+}
+
+void PageIOQueue::ReadCompleted(size_t num_pages) {
+  disk_manager_->num_reads_ += num_pages;
+  disk_manager_->num_bytes_read_ += num_pages * PAGE_SIZE;
+}
+
+void PageIOQueue::WriteCompleted(page_id_t physical_page_id, size_t num_pages) {
+  disk_manager_->WriteCompleted(physical_page_id, num_pages);
+}
+
+namespace {
+
+/** An I/O of a queue, from its preparation until its completion */
+struct PageIORequest {
+  page_id_t physical_page_id;
+  const iovec *pages;                                       // owned by the caller for a run of pages
+  iovec page;                                               // copy of the iovec of a single page
+  size_t num_pages;
+  bool is_write;
+  uint64_t tag;
+
+  inline const iovec *GetPages() const { return num_pages == 1 ? &page : pages; }
+};
+
+/**
+ * Backend used when io_uring is not available, the I/Os are performed one after another by Submit.
+ */
+class SyncPageIOQueue : public PageIOQueue {
+public:
+  SyncPageIOQueue(DiskManager *disk_manager, size_t queue_depth) : PageIOQueue(disk_manager, queue_depth) {}
+
+  size_t Submit() override {
+    for (auto &request : prepared_) {
+      bool ok = true;
+      if (request.is_write) {
+        ok = WriteSync(request.physical_page_id, request.GetPages(), request.num_pages);
+      } else {
+        ReadSync(request.physical_page_id, request.GetPages(), request.num_pages);
+      }
+      completed_.push_back({request.tag, ok});
+    }
+    size_t submitted = prepared_.size();
+    prepared_.clear();
+    return submitted;
+  }
+
+  size_t Wait(std::vector<PageIOCompletion> &completions, size_t /* min_complete */) override {
+    Submit();
+    size_t res = completed_.size();
+    completions.insert(completions.end(), completed_.begin(), completed_.end());
+    completed_.clear();
+    pending_ -= res;
+    return res;
+  }
+
+  bool IsAsync() const override { return false; }
+
+protected:
+  bool PreparePhysical(page_id_t physical_page_id, const iovec *pages, size_t num_pages, bool is_write,
+                       uint64_t tag) override {
+    if (pending_ >= queue_depth_) {
+      return false;
+    }
+    prepared_.push_back({physical_page_id, pages, pages[0], num_pages, is_write, tag});
+    pending_++;
+    return true;
+  }
+
+private:
+  std::vector<PageIORequest> prepared_;
+  std::vector<PageIOCompletion> completed_;
+};
+
+#ifdef MINISQL_HAS_IO_URING
+
+int IoUringSetup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+/**
+ * Backend talking to io_uring through the raw syscalls, so that it does not depend on liburing.
+ *
+ * The submission queue, the completion queue and the submission entries are shared with the kernel through mmap.
+ * Every I/O in flight has a slot in requests_, whose index is passed to the kernel as user data.
+ */
+class IoUringPageIOQueue : public PageIOQueue {
+public:
+  IoUringPageIOQueue(DiskManager *disk_manager, int fd, size_t queue_depth)
+      : PageIOQueue(disk_manager, queue_depth), fd_(fd), requests_(queue_depth) {
+    for (size_t i = queue_depth; i > 0; i--) {
+      free_slots_.push_back(i - 1);
+    }
+  }
+
+  ~IoUringPageIOQueue() override {
+    if (pending_ > 0) {
+      std::vector<PageIOCompletion> completions;
+      Wait(completions, pending_);
+    }
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    if (ring_fd_ >= 0) {
+      close(ring_fd_);
+    }
+  }
+
+  /**
+   * @return false if the ring can't be set up, e.g. io_uring is disabled or blocked on this system
+   */
+  bool Init() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = IoUringSetup(queue_depth_, &params);
+    if (ring_fd_ < 0) {
+      return false;
+    }
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    void *sq_ring = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                         IORING_OFF_SQ_RING);
+    if (sq_ring == MAP_FAILED) {
+      return false;
+    }
+    sq_ring_ = static_cast<char *>(sq_ring);
+    if (single_mmap) {
+      cq_ring_ = sq_ring_;
+    } else {
+      void *cq_ring = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                           IORING_OFF_CQ_RING);
+      if (cq_ring == MAP_FAILED) {
+        return false;
+      }
+      cq_ring_ = static_cast<char *>(cq_ring);
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                      IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return false;
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq_ring_ + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq_ring_ + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq_ring_ + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned *>(cq_ring_ + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq_ring_ + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq_ring_ + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq_ring_ + params.cq_off.cqes);
+    return true;
+  }
+
+  size_t Submit() override {
+    size_t submitted = 0;
+    while (submitted < prepared_) {
+      int res = IoUringEnter(ring_fd_, prepared_ - submitted, 0, 0);
+      if (res < 0 && (errno == EINTR || errno == EAGAIN)) {
+        continue;
+      }
+      if (res <= 0) {
+        LOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+        break;
+      }
+      submitted += res;
+    }
+    prepared_ -= submitted;
+    return submitted;
+  }
+
+  size_t Wait(std::vector<PageIOCompletion> &completions, size_t min_complete) override {
+    if (prepared_ > 0) {
+      Submit();
+    }
+    size_t res = 0;
+    while (true) {
+      res += Reap(completions);
+      // the prepared I/Os which could not be submitted will not complete by themselves
+      if (res >= min_complete || pending_ == prepared_) {
+        return res;
+      }
+      int ret = IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+      if (ret < 0 && errno != EINTR && errno != EAGAIN) {
+        LOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+        return res;
+      }
+    }
+  }
+
+  bool IsAsync() const override { return true; }
+
+protected:
+  bool PreparePhysical(page_id_t physical_page_id, const iovec *pages, size_t num_pages, bool is_write,
+                       uint64_t tag) override {
+    if (pending_ >= queue_depth_) {
+      return false;
+    }
+    uint32_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    PageIORequest &request = requests_[slot];
+    request = {physical_page_id, pages, pages[0], num_pages, is_write, tag};
+    // only this thread writes the tail, the kernel reads it once it has been released
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = fd_;
+    if (num_pages == 1) {
+      sqe->opcode = is_write ? IORING_OP_WRITE : IORING_OP_READ;
+      sqe->addr = reinterpret_cast<uint64_t>(request.page.iov_base);
+      sqe->len = PAGE_SIZE;
+    } else {
+      sqe->opcode = is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+      sqe->addr = reinterpret_cast<uint64_t>(pages);
+      sqe->len = num_pages;
+    }
+    sqe->off = static_cast<uint64_t>(physical_page_id) * PAGE_SIZE;
+    sqe->user_data = slot;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    prepared_++;
+    pending_++;
+    return true;
+  }
+
+private:
+  /**
+   * Take the completions out of the completion queue.
+   */
+  size_t Reap(std::vector<PageIOCompletion> &completions) {
+    size_t res = 0;
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++, res++) {
+      io_uring_cqe *cqe = &cqes_[head & cq_mask_];
+      uint32_t slot = cqe->user_data;
+      completions.push_back({requests_[slot].tag, Complete(requests_[slot], cqe->res)});
+      free_slots_.push_back(slot);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    pending_ -= res;
+    return res;
+  }
+
+  /**
+   * Account a completed I/O. An I/O the kernel could only do in part, e.g. a read at the end of the file, or not at
+   * all, e.g. because the opcode is too new for the kernel, is done again synchronously.
+   * @param res bytes transferred, or a negated errno
+   */
+  bool Complete(const PageIORequest &request, int res) {
+    size_t size = request.num_pages * PAGE_SIZE;
+    if (res >= 0 && static_cast<size_t>(res) == size) {
+      if (request.is_write) {
+        WriteCompleted(request.physical_page_id, request.num_pages);
+      } else {
+        ReadCompleted(request.num_pages);
+      }
+      return true;
+    }
+    if (res < 0 && res != -EINVAL && res != -EOPNOTSUPP && res != -EINTR && res != -EAGAIN) {
+      LOG(ERROR) << "I/O error in io_uring: " << strerror(-res);
+      return false;
+    }
+    if (request.is_write) {
+      return WriteSync(request.physical_page_id, request.GetPages(), request.num_pages);
+    }
+    ReadSync(request.physical_page_id, request.GetPages(), request.num_pages);
+    return true;
+  }
+
+  int fd_;
+  int ring_fd_{-1};
+  char *sq_ring_{nullptr};
+  char *cq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  io_uring_cqe *cqes_{nullptr};
+  size_t prepared_{0};                                      // prepared I/Os which have not been submitted yet
+  std::vector<PageIORequest> requests_;                     // I/Os in flight, indexed by their slot
+  std::vector<uint32_t> free_slots_;
+};
+
+#endif  // MINISQL_HAS_IO_URING
+
+}  // namespace
+
+std::unique_ptr<PageIOQueue> PageIOQueue::NewIoUringQueue(DiskManager *disk_manager, int fd, size_t queue_depth) {
+#ifdef MINISQL_HAS_IO_URING
+  auto queue = std::make_unique<IoUringPageIOQueue>(disk_manager, fd, queue_depth);
+  if (queue->Init()) {
+    return queue;
+  }
+#endif
+  return nullptr;
+}
+
+std::unique_ptr<PageIOQueue> PageIOQueue::NewSyncQueue(DiskManager *disk_manager, size_t queue_depth) {
+  return std::make_unique<SyncPageIOQueue>(disk_manager, queue_depth);
+}
@@ -2,7 +2,10 @@
 #include "glog/logging.h"
 
 bool TableHeap::InsertTuple(Row &row, Transaction *txn) {
-  page_id_t last_page_id = INVALID_PAGE_ID;
+  // the row is locked by the page as it takes a slot, which an aborted transaction can't do
+  if (txn != nullptr && lock_manager_ != nullptr && txn->GetState() == kAborted) {
+    return false;
+  }
  // firstfit改为nextfit
   if (cur_pid_ != INVALID_PAGE_ID) {  //如果本页合法
     //插入本页
@@ -10,6 +13,9 @@ bool TableHeap::InsertTuple(Row &row, Transaction *txn) {
     ASSERT(page != nullptr,"Not found InsertTuple first page!");
     page->WLatch();
     bool is_insert=page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    if (is_insert && IsSnapshotRead(txn)) {
+      version_store_->SaveInsert(row.GetRowId(), txn);
+    }
     page->WUnlatch();
     buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_insert);
     if (is_insert) return true;//如果插入成功就返回
@@ -31,14 +37,24 @@ bool TableHeap::InsertTuple(Row &row, Transaction *txn) {
   page_id_t new_page_id=INVALID_PAGE_ID;
   auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id));
   ASSERT(new_page != nullptr,"Can't create new page!");
-  new_page->Init(new_page_id,last_page_id,log_manager_,txn);
+  new_page->Init(new_page_id,cur_pid_,log_manager_,txn);
   new_page->WLatch();
   bool is_insert=new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+  if (is_insert && IsSnapshotRead(txn)) {
+    version_store_->SaveInsert(row.GetRowId(), txn);
+  }
   new_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(new_page->GetTablePageId(), is_insert);
   if(cur_pid_!=INVALID_PAGE_ID){
     auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(cur_pid_));
+    page->WLatch();
     page->SetNextPageId(new_page->GetPageId());//连接新页
+    if(log_manager_ != nullptr){
+      // the link is part of the new page record
+      page->SetLSN(new_page->GetLSN());
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(cur_pid_, true);
     cur_pid_ = new_page->GetPageId();//修改curpid
   } else{
     cur_pid_=first_page_id_ = new_page->GetPageId();
@@ -47,6 +63,9 @@ bool TableHeap::InsertTuple(Row &row, Transaction *txn) {
 }
 
 bool TableHeap::MarkDelete(const RowId &rid, Transaction *txn) {
+  if (!LockRow(rid, txn, LockMode::kExclusive)) {
+    return false;
+  }
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   // If the page could not be found, then abort the transaction.
@@ -55,6 +74,11 @@ bool TableHeap::MarkDelete(const RowId &rid, Transaction *txn) {
   }
   // Otherwise, mark the tuple as deleted.
   page->WLatch();
+  if (!SaveVersion(page, rid, txn, true)) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
+    return false;
+  }
   page->MarkDelete(rid, txn, lock_manager_, log_manager_);
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
@@ -62,13 +86,30 @@ bool TableHeap::MarkDelete(const RowId &rid, Transaction *txn) {
 }
 //记得修改头文件接口
 bool TableHeap::UpdateTuple(Row &row, const RowId &rid, Transaction *txn) {
+  if (!LockRow(rid, txn, LockMode::kExclusive)) {
+    return false;
+  }
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
    ASSERT(page != nullptr,"Not found UpdateTuple page!");
   if (rid.GetPageId() == INVALID_PAGE_ID) return false;
   Row old_row(rid);
-  bool find_old_row=page->GetTuple(&old_row, schema_,txn,lock_manager_);
-  if (!find_old_row) return false;
+  // the old row is read under the latch which protects the update, it can't move in between
   page->WLatch();
+  bool find_old_row=page->GetTuple(&old_row, schema_,txn,lock_manager_);
+  if (!find_old_row) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
+    // deleted by a transaction which committed since the row was read, the statement can't go on
+    if (txn != nullptr) {
+      txn->SetState(kAborted);
+    }
+    return false;
+  }
+  if (!SaveVersion(page, rid, txn, false)) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
+    return false;
+  }
   
   //接口修改为int 返回值区分错误类型 0代表slotnum不合法，1代表这个元组已被删除，2代表没有足够的空间去update 3代表成功更新
   int is_update = page->UpdateTuple(row, &old_row, schema_, txn, lock_manager_, log_manager_);
@@ -96,6 +137,14 @@ bool TableHeap::UpdateTuple(Row &row, const RowId &rid, Transaction *txn) {
 
 
 void TableHeap::ApplyDelete(const RowId &rid, Transaction *txn) {
+  if (IsSnapshotRead(txn)) {
+    // the tuple stays marked as deleted while older snapshots see it, the garbage collection of the versions removes it
+    MarkDelete(rid, txn);
+    return;
+  }
+  if (!LockRow(rid, txn, LockMode::kExclusive)) {
+    return;
+  }
   // Step1: Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   ASSERT(page != nullptr,"Not found ApplyDelete page!");
@@ -107,64 +156,131 @@ void TableHeap::ApplyDelete(const RowId &rid, Transaction *txn) {
 }
 
 void TableHeap::RollbackDelete(const RowId &rid, Transaction *txn) {
+  if (!LockRow(rid, txn, LockMode::kExclusive)) {
+    return;
+  }
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   assert(page != nullptr);
   // Rollback the delete.
   page->WLatch();
+  if (!SaveVersion(page, rid, txn, false)) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
+    return;
+  }
   page->RollbackDelete(rid, txn, log_manager_);
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
 }
 
 void TableHeap::FreeHeap() { 
+  std::vector<page_id_t> page_ids;
   page_id_t current_page_id=first_page_id_;
-  page_id_t next_page_id;
-  TablePage * page;
   while(current_page_id!=INVALID_PAGE_ID){
-    page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(current_page_id));
-    next_page_id=page->GetNextPageId();
-    buffer_pool_manager_->UnpinPage(current_page_id,false);
-    buffer_pool_manager_->DeletePage(current_page_id);
-    current_page_id=next_page_id;
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(current_page_id));
+    page_ids.push_back(current_page_id);
+    current_page_id=page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_ids.back(),false);
   }
   cur_pid_ = INVALID_PAGE_ID;
   first_page_id_ = INVALID_PAGE_ID;  //
+  if(version_store_ != nullptr){
+    // the deleted rows are gone with the pages, the garbage collection must not remove them from whatever reuses them
+    version_store_->DropPages(page_ids);
+  }
+  if(log_manager_ != nullptr && !page_ids.empty()){
+    // a freed page may be reused by anything, recovery must know not to redo the table records before the free
+    lsn_t lsn = INVALID_LSN;
+    for(auto page_id : page_ids){
+      LogRecord record(page_id);
+      lsn = log_manager_->AppendLogRecord(&record);
+    }
+    if(!log_manager_->Flush(lsn)){
+      LOG(ERROR)<<"The pages of a dropped table are kept, the log can't be written"<<std::endl;
+      return;
+    }
+  }
+  for(auto page_id : page_ids){
+    buffer_pool_manager_->DeletePage(page_id);
+  }
 }
 
 bool TableHeap::GetTuple(Row *row, Transaction *txn) {
   RowId rid = row->GetRowId();
+  if (IsSnapshotRead(txn)) {
+    // the version the transaction sees, without a lock
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+    ASSERT(page != nullptr, "Not found gettuple page!");
+    page->RLatch();
+    bool res = page->GetVisibleTuple(row, schema_, txn, version_store_);
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+    return res;
+  }
+  if (!LockRow(rid, txn, LockMode::kShared)) {
+    return false;
+  }
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   ASSERT(page != nullptr,"Not found gettuple page!");
-  page->RLatch();
-  bool get_status=page->GetTuple(row, schema_, txn, lock_manager_);
- // row->SetRowId(rid);
-  page->RUnlatch();
+  bool get_status=page->GetTupleOptimistic(row, schema_, txn, lock_manager_);
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
   return get_status;
 }
 
-TableIterator TableHeap::Begin(Transaction *txn) {
+TableIterator TableHeap::Begin(Transaction *txn, AccessStrategy strategy) {
   RowId rid;
   auto pid = first_page_id_;
-  bool no_tuple=false;
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(pid));
+  std::shared_ptr<BufferRing> ring = nullptr;
+  if (strategy == kBulkReadAccess) {
+    ring = std::make_shared<BufferRing>();
+    buffer_pool_manager_->AdviseAccess(kAccessHintSequential, pid, READ_AHEAD_PAGES);
+  }
   while(pid!=INVALID_PAGE_ID){
-    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(pid));
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(pid, ring.get()));
+    ASSERT(page != nullptr, "Not found begin page!");
     page->RLatch();
-    bool have_tuple = page->GetFirstTupleRid(&rid);
+    bool have_tuple = IsSnapshotRead(txn) ? page->GetFirstVisibleTupleRid(0, &rid, txn, version_store_)
+                                          : page->GetFirstTupleRid(&rid);
+    auto next_page_id = page->GetNextPageId();
     page->RUnlatch();
-    buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
     if(have_tuple){
-      return TableIterator(this,page, rid);
-    }
-    else{
-      pid = page->GetNextPageId();
-      no_tuple = true;
+      //顺序扫描, 预读后面的页
+      ReadAhead(next_page_id, ring);
+      // the iterator fetches the page again to read the first row, the frame is not used after the unpin
+      buffer_pool_manager_->UnpinPage(pid, false);
+      return TableIterator(this, nullptr, rid, ring, txn);
     }
+    buffer_pool_manager_->UnpinPage(pid, false);
+    pid = next_page_id;
+  }
+  return End();
+}
+
+void TableHeap::ReadAhead(page_id_t page_id, const std::shared_ptr<BufferRing> &ring) {
+  if (ring != nullptr && page_id != INVALID_PAGE_ID) {
+    // only the range the bulk read is about to read is advised, not the whole file
+    buffer_pool_manager_->AdviseAccess(kAccessHintSequential, page_id, READ_AHEAD_PAGES);
+  }
+  buffer_pool_manager_->PrefetchChain(page_id, READ_AHEAD_PAGES, [](Page *page) {
+    return reinterpret_cast<TablePage *>(page)->GetNextPageId();
+  }, ring);
+}
+
+bool TableHeap::SaveVersion(TablePage *page, const RowId &rid, Transaction *txn, bool deleted) {
+  if (!IsSnapshotRead(txn)) {
+    return true;
+  }
+  std::string tuple;
+  bool exists = page->GetTupleData(rid.GetSlotNum(), &tuple);
+  return version_store_->SaveVersion(rid, txn, exists, std::move(tuple), deleted);
+}
+
+bool TableHeap::LockRow(const RowId &rid, Transaction *txn, LockMode mode) {
+  if (lock_manager_ == nullptr || txn == nullptr) {
+    return true;
   }
-  if (no_tuple) return TableIterator(this, nullptr, INVALID_ROWID);
-  return TableIterator(this, page, rid);
+  return mode == LockMode::kShared ? lock_manager_->LockShared(txn, rid) : lock_manager_->LockExclusive(txn, rid);
 }
 
 TableIterator TableHeap::End() {
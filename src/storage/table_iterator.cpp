@@ -4,12 +4,16 @@
 
 
 
-TableIterator:: TableIterator(TableHeap* table_heap,TablePage* page,RowId rid){
+TableIterator:: TableIterator(TableHeap* table_heap,TablePage* page,RowId rid,std::shared_ptr<BufferRing> ring,
+                              Transaction *txn){
     this->table_heap_ = table_heap;
+    this->ring_ = std::move(ring);
+    // the scans without snapshot take no lock
+    this->txn_ = table_heap_->IsSnapshotRead(txn) ? txn : nullptr;
     this->rid_ = rid;
     this->row_=new Row(rid);
     if (rid_.GetPageId() != INVALID_PAGE_ID) {
-      this->table_heap_->GetTuple(row_, nullptr);
+      this->table_heap_->GetTuple(row_, txn_);
     }
   }
 
@@ -17,6 +21,8 @@ TableIterator::TableIterator(const TableIterator &other) {
   table_heap_=other.table_heap_;
   page_=other.page_;
   rid_=other.rid_;
+  ring_=other.ring_;
+  txn_=other.txn_;
   delete row_;
   this->row_=new Row(rid_);
 }
@@ -29,97 +35,57 @@ Row *TableIterator::operator->() {
 }
 
 TableIterator &TableIterator::operator++() {
-  RowId rid = rid_;
-  auto page = reinterpret_cast<TablePage *>(this->table_heap_->buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  BufferPoolManager *bpm = this->table_heap_->buffer_pool_manager_;
+  auto page = reinterpret_cast<TablePage *>(bpm->FetchPage(rid_.GetPageId(), ring_.get()));
   ASSERT(page != nullptr,"Not found this page!");
   RowId next_rid;
-  int flag = 0;//指示是不是末尾
+  VersionStore *version_store = this->table_heap_->version_store_;
   page->RLatch();
-  bool is_get=page->GetNextTupleRid(rid,&next_rid);//获取下个rid
-  if(!is_get||next_rid.Get()==INVALID_ROWID.Get() ){//如果没获取,可能是当前页最后一条记录
-    auto next_page_id = page->GetNextPageId();
+  bool is_get=(txn_ != nullptr ? page->GetFirstVisibleTupleRid(rid_.GetSlotNum() + 1, &next_rid, txn_, version_store)
+                               : page->GetNextTupleRid(rid_,&next_rid))&&next_rid.Get()!=INVALID_ROWID.Get();//获取下个rid
+  auto next_page_id = page->GetNextPageId();
+  page->RUnlatch();
+  while(!is_get&&next_page_id!=INVALID_PAGE_ID){//当前页没有下一条记录, 沿着页链找下一个有记录的页
+    bpm->UnpinPage(page->GetTablePageId(), false);
+    page = reinterpret_cast<TablePage *>(bpm->FetchPage(next_page_id, ring_.get()));
+    ASSERT(page != nullptr,"Not found next page!");
+    page->RLatch();
+    is_get=txn_ != nullptr ? page->GetFirstVisibleTupleRid(0, &next_rid, txn_, version_store)
+                           : page->GetFirstTupleRid(&next_rid);
+    next_page_id = page->GetNextPageId();
     page->RUnlatch();
-    this->table_heap_->buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
-    while(next_page_id!=INVALID_PAGE_ID){//当下一页合法
-      auto next_page = reinterpret_cast<TablePage *>(this->table_heap_->buffer_pool_manager_->FetchPage(next_page_id));
-      next_page->RLatch();
-      if(next_page->GetFirstTupleRid(&next_rid)){//如果有第一个元组
-        this->page_ = next_page;
-        break;
-      }
-      next_page->RUnlatch();
-      this->table_heap_->buffer_pool_manager_->UnpinPage(next_page->GetTablePageId(), false);
-      next_page_id = next_page->GetNextPageId();
-    }
-    if(next_page_id==INVALID_PAGE_ID){
-      flag = 1;
-      rid_ = RowId(INVALID_PAGE_ID, 0);
-      delete row_;
-      row_ =new Row(rid_);
-      page_ = nullptr;
-    }
-  }
-  else{
-    this->page_ = page;
+    //进入新的一页, 预读页链上后面的页
+    this->table_heap_->ReadAhead(next_page_id, ring_);
   }
-  if(!flag){
+  if(!is_get){//已经到末尾
+    bpm->UnpinPage(page->GetTablePageId(), false);
+    rid_ = RowId(INVALID_PAGE_ID, 0);
     delete row_;
-    row_ =new Row(next_rid);
-    this->rid_ = next_rid;
-    page->GetTuple(this->row_, this->table_heap_->schema_, nullptr, this->table_heap_->lock_manager_);
-    page_->RUnlatch();
-    this->table_heap_->buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
+    row_ =new Row(rid_);
+    page_ = nullptr;
+    return *this;
   }
-  
+  delete row_;
+  row_ =new Row(next_rid);
+  this->rid_ = next_rid;
+  this->page_ = page;
+  if (txn_ != nullptr) {
+    page->RLatch();
+    page->GetVisibleTuple(this->row_, this->table_heap_->schema_, txn_, version_store);
+    page->RUnlatch();
+  } else {
+    page->GetTupleOptimistic(this->row_, this->table_heap_->schema_, nullptr, this->table_heap_->lock_manager_);
+  }
+  bpm->UnpinPage(page->GetTablePageId(), false);
   return *this;
-  
 }
 
 TableIterator TableIterator::operator++(int) {
   TableHeap *oldheap = this->table_heap_;
   TablePage *oldpage = this->page_;
   RowId oldrid= this->rid_;
-  RowId rid = rid_;
-  auto page = reinterpret_cast<TablePage *>(this->table_heap_->buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  ASSERT(page != nullptr,"Not found this page!");
-  RowId next_rid;
-  int flag = 0;//指示是不是末尾
-  page->RLatch();
-  bool is_get=page->GetNextTupleRid(rid,&next_rid);//获取下个rid
-  if(!is_get||next_rid.Get()==INVALID_ROWID.Get() ){//如果没获取,可能是当前页最后一条记录
-    auto next_page_id = page->GetNextPageId();
-    page->RUnlatch();
-    this->table_heap_->buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
-    while(next_page_id!=INVALID_PAGE_ID){//当下一页合法
-      auto next_page = reinterpret_cast<TablePage *>(this->table_heap_->buffer_pool_manager_->FetchPage(next_page_id));
-      next_page->RLatch();
-      if(next_page->GetFirstTupleRid(&next_rid)){//如果有第一个元组
-        this->page_ = next_page;
-        break;
-      }
-      next_page->RUnlatch();
-      this->table_heap_->buffer_pool_manager_->UnpinPage(next_page->GetTablePageId(), false);
-      next_page_id = next_page->GetNextPageId();
-    }
-    if(next_page_id==INVALID_PAGE_ID){
-      flag = 1;
-      rid_ = RowId(INVALID_PAGE_ID, 0);
-      delete row_;
-      row_ =new Row(rid_);
-      page_ = nullptr;
-    }
-  }
-  else{
-    this->page_ = page;
-  }
-  if(!flag){
-    delete row_;
-    row_ =new Row(next_rid);
-    this->rid_ = next_rid;
-    page->GetTuple(this->row_, this->table_heap_->schema_, nullptr, this->table_heap_->lock_manager_);
-    page_->RUnlatch();
-    this->table_heap_->buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
-  }
-  
-  return TableIterator(oldheap,oldpage,oldrid);
+  Transaction *oldtxn = this->txn_;
+  ++(*this);
+  return TableIterator(oldheap,oldpage,oldrid,nullptr,oldtxn);
 }
+
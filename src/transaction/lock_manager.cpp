@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <functional>
+
+#include "glog/logging.h"
+#include "transaction/lock_manager.h"
+
+namespace {
+
+/**
+ * Find a cycle in the wait-for graph, visiting the transactions in the order of their ids
+ * @return the transactions of the cycle, empty if there is none
+ */
+std::vector<txn_id_t> FindCycle(const std::unordered_map<txn_id_t, std::vector<txn_id_t>> &waits_for) {
+  std::vector<txn_id_t> txns;
+  txns.reserve(waits_for.size());
+  for (auto &edges : waits_for) {
+    txns.push_back(edges.first);
+  }
+  std::sort(txns.begin(), txns.end());
+  // 1 on the path of the search, 2 done
+  std::unordered_map<txn_id_t, int> state;
+  std::vector<txn_id_t> path;
+  std::vector<txn_id_t> cycle;
+  std::function<bool(txn_id_t)> visit = [&](txn_id_t txn_id) {
+    state[txn_id] = 1;
+    path.push_back(txn_id);
+    auto it = waits_for.find(txn_id);
+    if (it != waits_for.end()) {
+      for (txn_id_t next : it->second) {
+        if (state[next] == 1) {
+          cycle.assign(std::find(path.begin(), path.end(), next), path.end());
+          return true;
+        }
+        if (state[next] == 0 && visit(next)) {
+          return true;
+        }
+      }
+    }
+    path.pop_back();
+    state[txn_id] = 2;
+    return false;
+  };
+  for (txn_id_t txn_id : txns) {
+    if (state[txn_id] == 0 && visit(txn_id)) {
+      break;
+    }
+  }
+  return cycle;
+}
+
+}  // namespace
+
+LockManager::~LockManager() { StopDeadlockDetection(); }
+
+bool LockManager::LockShared(Transaction *txn, const RowId &rid) {
+  if (txn->GetState() == kAborted) {
+    return false;
+  }
+  if (txn->IsSharedLocked(rid) || txn->IsExclusiveLocked(rid)) {
+    return true;
+  }
+  if (!Lock(txn, rid, LockMode::kShared)) {
+    return false;
+  }
+  txn->GetSharedLockSet().insert(rid);
+  return true;
+}
+
+bool LockManager::LockExclusive(Transaction *txn, const RowId &rid) {
+  if (txn->GetState() == kAborted) {
+    return false;
+  }
+  if (txn->IsExclusiveLocked(rid)) {
+    return true;
+  }
+  if (txn->IsSharedLocked(rid)) {
+    return LockUpgrade(txn, rid);
+  }
+  if (!Lock(txn, rid, LockMode::kExclusive)) {
+    return false;
+  }
+  txn->GetExclusiveLockSet().insert(rid);
+  return true;
+}
+
+bool LockManager::LockUpgrade(Transaction *txn, const RowId &rid) {
+  if (txn->GetState() == kAborted) {
+    return false;
+  }
+  if (txn->IsExclusiveLocked(rid)) {
+    return true;
+  }
+  if (!txn->IsSharedLocked(rid)) {
+    return LockExclusive(txn, rid);
+  }
+  Shard &shard = GetShard(rid);
+  std::unique_lock<std::mutex> lock(shard.latch_);
+  auto &queue = shard.lock_table_[rid];
+  if (queue.upgrading_) {
+    // each of the two would wait for the shared lock of the other
+    txn->SetState(kAborted);
+    return false;
+  }
+  auto &requests = queue.requests_;
+  auto request = std::find_if(requests.begin(), requests.end(),
+                              [txn](const LockRequest &request) { return request.txn_ == txn; });
+  ASSERT(request != requests.end() && request->granted_, "Shared lock not found.");
+  requests.erase(request);
+  txn->GetSharedLockSet().erase(rid);
+  // ahead of the waiting requests, which would otherwise wait for the shared lock while it waits for them
+  auto first_waiting = std::find_if(requests.begin(), requests.end(),
+                                    [](const LockRequest &request) { return !request.granted_; });
+  request = requests.emplace(first_waiting, txn, LockMode::kExclusive);
+  queue.upgrading_ = true;
+  bool granted = WaitForGrant(queue, lock, request);
+  queue.upgrading_ = false;
+  if (!granted) {
+    RemoveRequest(shard, rid, txn);
+    return false;
+  }
+  txn->GetExclusiveLockSet().insert(rid);
+  return true;
+}
+
+bool LockManager::TryLockExclusive(Transaction *txn, const RowId &rid) {
+  if (txn->GetState() == kAborted) {
+    return false;
+  }
+  if (txn->IsExclusiveLocked(rid)) {
+    return true;
+  }
+  if (txn->IsSharedLocked(rid)) {
+    return false;
+  }
+  Shard &shard = GetShard(rid);
+  std::scoped_lock<std::mutex> lock(shard.latch_);
+  auto &queue = shard.lock_table_[rid];
+  if (!queue.requests_.empty()) {
+    return false;
+  }
+  queue.requests_.emplace_back(txn, LockMode::kExclusive).granted_ = true;
+  txn->GetExclusiveLockSet().insert(rid);
+  return true;
+}
+
+bool LockManager::IsLocked(const RowId &rid) {
+  Shard &shard = GetShard(rid);
+  std::scoped_lock<std::mutex> lock(shard.latch_);
+  return shard.lock_table_.count(rid) != 0;
+}
+
+bool LockManager::Lock(Transaction *txn, const RowId &rid, LockMode mode) {
+  Shard &shard = GetShard(rid);
+  std::unique_lock<std::mutex> lock(shard.latch_);
+  auto &queue = shard.lock_table_[rid];
+  auto request = queue.requests_.emplace(queue.requests_.end(), txn, mode);
+  if (!WaitForGrant(queue, lock, request)) {
+    RemoveRequest(shard, rid, txn);
+    return false;
+  }
+  return true;
+}
+
+bool LockManager::WaitForGrant(LockRequestQueue &queue, std::unique_lock<std::mutex> &lock,
+                               std::list<LockRequest>::iterator request) {
+  Transaction *txn = request->txn_;
+  queue.cv_.wait(lock, [&] { return txn->GetState() == kAborted || IsGrantable(queue, request); });
+  if (txn->GetState() == kAborted) {
+    return false;
+  }
+  request->granted_ = true;
+  return true;
+}
+
+bool LockManager::IsGrantable(const LockRequestQueue &queue, std::list<LockRequest>::const_iterator request) {
+  bool ahead = true;
+  for (auto it = queue.requests_.begin(); it != queue.requests_.end(); ++it) {
+    if (it == request) {
+      ahead = false;
+      continue;
+    }
+    bool conflict = request->mode_ == LockMode::kExclusive || it->mode_ == LockMode::kExclusive;
+    if (conflict && (ahead || it->granted_)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool LockManager::Unlock(Transaction *txn, const RowId &rid) {
+  Shard &shard = GetShard(rid);
+  {
+    std::scoped_lock<std::mutex> lock(shard.latch_);
+    if (!RemoveRequest(shard, rid, txn)) {
+      return false;
+    }
+  }
+  txn->GetSharedLockSet().erase(rid);
+  txn->GetExclusiveLockSet().erase(rid);
+  return true;
+}
+
+void LockManager::UnlockAll(Transaction *txn) {
+  for (auto *lock_set : {&txn->GetSharedLockSet(), &txn->GetExclusiveLockSet()}) {
+    for (auto &rid : *lock_set) {
+      Shard &shard = GetShard(rid);
+      std::scoped_lock<std::mutex> lock(shard.latch_);
+      RemoveRequest(shard, rid, txn);
+    }
+    lock_set->clear();
+  }
+}
+
+bool LockManager::RemoveRequest(Shard &shard, const RowId &rid, Transaction *txn) {
+  auto queue = shard.lock_table_.find(rid);
+  if (queue == shard.lock_table_.end()) {
+    return false;
+  }
+  auto &requests = queue->second.requests_;
+  auto request = std::find_if(requests.begin(), requests.end(),
+                              [txn](const LockRequest &request) { return request.txn_ == txn; });
+  if (request == requests.end()) {
+    return false;
+  }
+  requests.erase(request);
+  if (requests.empty()) {
+    // nobody waits on the queue without a request in it
+    shard.lock_table_.erase(queue);
+  } else {
+    queue->second.cv_.notify_all();
+  }
+  return true;
+}
+
+size_t LockManager::DetectDeadlocks() {
+  // A waiting transaction waits for the conflicting requests ahead of its own, and for the conflicting locks granted
+  std::unordered_map<txn_id_t, std::vector<txn_id_t>> waits_for;
+  std::unordered_map<txn_id_t, std::pair<Transaction *, RowId>> waiting;
+  {
+    // the graph is built from all the shards at once, so that it has no edge which is gone already
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(LOCK_TABLE_SHARDS);
+    for (size_t i = 0; i < LOCK_TABLE_SHARDS; i++) {
+      locks.emplace_back(shards_[i].latch_);
+    }
+    for (size_t i = 0; i < LOCK_TABLE_SHARDS; i++) {
+      for (auto &queue : shards_[i].lock_table_) {
+        auto &requests = queue.second.requests_;
+        for (auto request = requests.begin(); request != requests.end(); ++request) {
+          Transaction *txn = request->txn_;
+          if (request->granted_ || txn->GetState() == kAborted) {
+            continue;
+          }
+          waiting.emplace(txn->GetTransactionId(), std::make_pair(txn, queue.first));
+          auto &edges = waits_for[txn->GetTransactionId()];
+          bool ahead = true;
+          for (auto it = requests.begin(); it != requests.end(); ++it) {
+            if (it == request) {
+              ahead = false;
+              continue;
+            }
+            bool conflict = request->mode_ == LockMode::kExclusive || it->mode_ == LockMode::kExclusive;
+            if (conflict && (ahead || it->granted_) && it->txn_ != txn) {
+              edges.push_back(it->txn_->GetTransactionId());
+            }
+          }
+        }
+      }
+    }
+  }
+  for (auto &edges : waits_for) {
+    std::sort(edges.second.begin(), edges.second.end());
+    edges.second.erase(std::unique(edges.second.begin(), edges.second.end()), edges.second.end());
+  }
+
+  // Abort the youngest transaction of each cycle, until there is none left
+  std::vector<txn_id_t> victims;
+  for (auto cycle = FindCycle(waits_for); !cycle.empty(); cycle = FindCycle(waits_for)) {
+    txn_id_t victim = *std::max_element(cycle.begin(), cycle.end());
+    waiting[victim].first->SetState(kAborted);
+    waits_for.erase(victim);
+    victims.push_back(victim);
+  }
+  for (txn_id_t victim : victims) {
+    // under the latch, so that the victim either sees its state or is waiting for the notification
+    const RowId &rid = waiting[victim].second;
+    Shard &shard = GetShard(rid);
+    std::scoped_lock<std::mutex> lock(shard.latch_);
+    auto queue = shard.lock_table_.find(rid);
+    if (queue != shard.lock_table_.end()) {
+      queue->second.cv_.notify_all();
+    }
+    LOG(INFO) << "Transaction " << victim << " aborted to break a deadlock";
+  }
+  num_deadlocks_ += victims.size();
+  return victims.size();
+}
+
+void LockManager::RunDeadlockDetection(int interval_ms) {
+  std::scoped_lock<std::mutex> lock(detection_latch_);
+  if (detection_running_) {
+    return;
+  }
+  detection_running_ = true;
+  detection_thread_ = std::thread(&LockManager::DeadlockDetectionLoop, this, interval_ms);
+}
+
+void LockManager::StopDeadlockDetection() {
+  {
+    std::scoped_lock<std::mutex> lock(detection_latch_);
+    if (!detection_running_) {
+      return;
+    }
+    detection_running_ = false;
+  }
+  detection_cv_.notify_one();
+  detection_thread_.join();
+}
+
+void LockManager::DeadlockDetectionLoop(int interval_ms) {
+  std::unique_lock<std::mutex> lock(detection_latch_);
+  while (true) {
+    detection_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms), [this] { return !detection_running_; });
+    if (!detection_running_) {
+      break;
+    }
+    lock.unlock();
+    DetectDeadlocks();
+    lock.lock();
+  }
+}
@@ -0,0 +1,201 @@
+#include <algorithm>
+
+#include "glog/logging.h"
+#include "storage/disk_manager.h"
+#include "transaction/log_manager.h"
+
+LogManager::LogManager(DiskManager *disk_manager)
+    : disk_manager_(disk_manager),
+      log_buffer_(new char[LOG_BUFFER_SIZE]),
+      flush_buffer_(new char[LOG_BUFFER_SIZE]) {
+  size_t size = disk_manager_->GetLogSize();
+  if (size < LOG_HEADER_SIZE) {
+    char header[LOG_HEADER_SIZE];
+    MACH_WRITE_UINT32(header, LOG_MAGIC);
+    MACH_WRITE_TO(lsn_t, header + 4, INVALID_LSN);
+    disk_manager_->WriteLogAt(header, LOG_HEADER_SIZE, 0);
+    size = LOG_HEADER_SIZE;
+  }
+  // every LSN below the end of the log is on the disk
+  next_lsn_ = size;
+  last_lsn_ = size - 1;
+  persistent_lsn_ = size - 1;
+}
+
+LogManager::~LogManager() {
+  StopFlushThread();
+  std::unique_lock<std::mutex> lock(latch_);
+  FlushBuffer(lock);
+}
+
+void LogManager::RunFlushThread() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (flush_thread_running_) {
+    return;
+  }
+  flush_thread_running_ = true;
+  flush_thread_ = std::thread(&LogManager::FlushThreadLoop, this);
+}
+
+void LogManager::StopFlushThread() {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (!flush_thread_running_) {
+      return;
+    }
+    flush_thread_running_ = false;
+  }
+  flush_cv_.notify_one();
+  flush_thread_.join();
+}
+
+void LogManager::FlushThreadLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (flush_thread_running_) {
+    flush_cv_.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS),
+                       [this] { return flush_requested_ || !flush_thread_running_; });
+    flush_requested_ = false;
+    FlushBuffer(lock);
+  }
+}
+
+lsn_t LogManager::AppendLogRecord(LogRecord *log_record, Transaction *txn) {
+  ASSERT(log_record->GetSize() <= LOG_BUFFER_SIZE, "Log record larger than the log buffer.");
+  std::unique_lock<std::mutex> lock(latch_);
+  while (log_buffer_offset_ + log_record->GetSize() > LOG_BUFFER_SIZE) {
+    if (flush_thread_running_) {
+      flush_requested_ = true;
+      flush_cv_.notify_one();
+      flushed_cv_.wait(lock);
+    } else {
+      FlushBuffer(lock);
+    }
+  }
+  lsn_t lsn = next_lsn_.load();
+  next_lsn_ = lsn + log_record->GetSize();
+  last_lsn_ = lsn;
+  log_record->SetLSN(lsn);
+  if (txn != nullptr) {
+    // under the latch, so that a checkpoint appending its begin record later sees where the transaction starts
+    if (txn->GetBeginLSN() == INVALID_LSN) {
+      txn->SetBeginLSN(lsn);
+    }
+    txn->SetPrevLSN(lsn);
+  }
+  log_record->SerializeTo(log_buffer_.get() + log_buffer_offset_);
+  log_buffer_offset_ += log_record->GetSize();
+  return lsn;
+}
+
+bool LogManager::Flush(lsn_t lsn) {
+  if (lsn <= persistent_lsn_.load()) {
+    return true;
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  // e.g. the LSN of a page which is not a table page, whose header has no LSN
+  lsn = std::min(lsn, last_lsn_);
+  while (persistent_lsn_.load() < lsn) {
+    if (failed_.load()) {
+      return false;
+    }
+    if (flush_thread_running_) {
+      flush_requested_ = true;
+      flush_cv_.notify_one();
+      flushed_cv_.wait(lock);
+    } else {
+      FlushBuffer(lock);
+    }
+  }
+  return true;
+}
+
+lsn_t LogManager::GetLastLSN() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return last_lsn_;
+}
+
+bool LogManager::ReadLogRecord(lsn_t lsn, LogRecord *log_record) {
+  if (lsn < static_cast<lsn_t>(LOG_HEADER_SIZE)) {
+    return false;
+  }
+  Flush(lsn);
+  char header[LogRecord::HEADER_SIZE];
+  if (disk_manager_->ReadLog(header, LogRecord::HEADER_SIZE, lsn) < LogRecord::HEADER_SIZE) {
+    return false;
+  }
+  uint32_t size = MACH_READ_UINT32(header);
+  if (size < LogRecord::HEADER_SIZE || size > LOG_BUFFER_SIZE) {
+    return false;
+  }
+  std::unique_ptr<char[]> buf(new char[size]);
+  size_t len = disk_manager_->ReadLog(buf.get(), size, lsn);
+  return LogRecord::DeserializeFrom(buf.get(), len, log_record);
+}
+
+lsn_t LogManager::GetCheckpointLSN() {
+  char header[LOG_HEADER_SIZE];
+  if (disk_manager_->ReadLog(header, LOG_HEADER_SIZE, 0) < LOG_HEADER_SIZE || MACH_READ_UINT32(header) != LOG_MAGIC) {
+    LOG(WARNING) << "Invalid log header, the log is read from its start";
+    return INVALID_LSN;
+  }
+  return MACH_READ_FROM(lsn_t, header + 4);
+}
+
+bool LogManager::SetCheckpointLSN(lsn_t lsn) {
+  char header[LOG_HEADER_SIZE];
+  MACH_WRITE_UINT32(header, LOG_MAGIC);
+  MACH_WRITE_TO(lsn_t, header + 4, lsn);
+  return disk_manager_->WriteLogAt(header, LOG_HEADER_SIZE, 0);
+}
+
+bool LogManager::Discard(lsn_t lsn) {
+  // the header stays, it tells where the recovery starts
+  lsn = std::min(lsn, persistent_lsn_.load() + 1);
+  if (lsn <= static_cast<lsn_t>(LOG_HEADER_SIZE)) {
+    return true;
+  }
+  return disk_manager_->DiscardLog(LOG_HEADER_SIZE, lsn - LOG_HEADER_SIZE);
+}
+
+void LogManager::Truncate(lsn_t lsn) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  ASSERT(log_buffer_offset_ == 0 && !flushing_, "The log is truncated while records are appended.");
+  disk_manager_->TruncateLog(lsn);
+  next_lsn_ = lsn;
+  last_lsn_ = lsn - 1;
+  persistent_lsn_ = lsn - 1;
+}
+
+void LogManager::FlushBuffer(std::unique_lock<std::mutex> &lock) {
+  if (flushing_) {
+    flushed_cv_.wait(lock, [this] { return !flushing_; });
+    return;
+  }
+  if (log_buffer_offset_ == 0) {
+    return;
+  }
+  if (failed_.load()) {
+    // the records are never written, whoever waits for them is told by Flush
+    log_buffer_offset_ = 0;
+    flushed_cv_.notify_all();
+    return;
+  }
+  flushing_ = true;
+  std::swap(log_buffer_, flush_buffer_);
+  size_t size = log_buffer_offset_;
+  lsn_t last_lsn = last_lsn_;
+  log_buffer_offset_ = 0;
+  // the records appended from now on go to the other buffer, and are flushed together by the next write
+  flushed_cv_.notify_all();
+  lock.unlock();
+  bool ok = disk_manager_->WriteLog(flush_buffer_.get(), size);
+  lock.lock();
+  if (ok) {
+    persistent_lsn_.store(last_lsn);
+  } else if (!failed_.exchange(true)) {
+    LOG(ERROR) << "Can't write the log, no record after LSN " << persistent_lsn_.load() << " becomes durable";
+  }
+  num_flushes_++;
+  flushing_ = false;
+  flushed_cv_.notify_all();
+}
@@ -0,0 +1,209 @@
+#include <cstddef>
+#include <cstring>
+
+#include "common/macros.h"
+#include "transaction/log_record.h"
+
+LogRecord::LogRecord(LogRecordType type, txn_id_t txn_id, lsn_t prev_lsn)
+    : txn_id_(txn_id), prev_lsn_(prev_lsn), type_(type) {}
+
+LogRecord::LogRecord(LogRecordType type, txn_id_t txn_id, lsn_t prev_lsn, const RowId &rid, std::string tuple)
+    : txn_id_(txn_id), prev_lsn_(prev_lsn), type_(type), rid_(rid), tuple_(std::move(tuple)) {
+  size_ = HEADER_SIZE + sizeof(int64_t) + sizeof(uint32_t) + tuple_.size();
+}
+
+LogRecord::LogRecord(txn_id_t txn_id, lsn_t prev_lsn, const RowId &rid, std::string old_tuple, std::string new_tuple)
+    : txn_id_(txn_id), prev_lsn_(prev_lsn), type_(kUpdateLog), rid_(rid), tuple_(std::move(old_tuple)),
+      new_tuple_(std::move(new_tuple)) {
+  size_ = HEADER_SIZE + sizeof(int64_t) + 2 * sizeof(uint32_t) + tuple_.size() + new_tuple_.size();
+}
+
+LogRecord::LogRecord(txn_id_t txn_id, lsn_t prev_lsn, page_id_t prev_page_id, page_id_t page_id)
+    : txn_id_(txn_id), prev_lsn_(prev_lsn), type_(kNewPageLog), prev_page_id_(prev_page_id), page_id_(page_id) {
+  size_ = HEADER_SIZE + 2 * sizeof(page_id_t);
+}
+
+LogRecord::LogRecord(page_id_t page_id) : type_(kFreePageLog), page_id_(page_id) {
+  size_ = HEADER_SIZE + 2 * sizeof(page_id_t);
+}
+
+LogRecord::LogRecord(lsn_t begin_lsn, std::vector<std::pair<txn_id_t, lsn_t>> active_txns,
+                     std::vector<std::pair<page_id_t, lsn_t>> dirty_pages, std::vector<RowId> deleted_rows)
+    : prev_lsn_(begin_lsn), type_(kEndCheckpointLog), active_txns_(std::move(active_txns)),
+      dirty_pages_(std::move(dirty_pages)), deleted_rows_(std::move(deleted_rows)) {
+  size_ = HEADER_SIZE + 3 * sizeof(uint32_t) + active_txns_.size() * (sizeof(txn_id_t) + sizeof(lsn_t)) +
+          dirty_pages_.size() * (sizeof(page_id_t) + sizeof(lsn_t)) + deleted_rows_.size() * sizeof(int64_t);
+}
+
+namespace {
+
+void WriteTuple(char *&buf, const std::string &tuple) {
+  MACH_WRITE_UINT32(buf, tuple.size());
+  buf += sizeof(uint32_t);
+  memcpy(buf, tuple.data(), tuple.size());
+  buf += tuple.size();
+}
+
+template <typename K, typename V>
+void WritePairs(char *&buf, const std::vector<std::pair<K, V>> &pairs) {
+  MACH_WRITE_UINT32(buf, pairs.size());
+  buf += sizeof(uint32_t);
+  for (auto &pair : pairs) {
+    MACH_WRITE_TO(K, buf, pair.first);
+    MACH_WRITE_TO(V, buf + sizeof(K), pair.second);
+    buf += sizeof(K) + sizeof(V);
+  }
+}
+
+template <typename K, typename V>
+bool ReadPairs(const char *&buf, const char *end, std::vector<std::pair<K, V>> *pairs) {
+  if (end - buf < static_cast<std::ptrdiff_t>(sizeof(uint32_t))) {
+    return false;
+  }
+  uint32_t size = MACH_READ_UINT32(buf);
+  buf += sizeof(uint32_t);
+  if (static_cast<size_t>(end - buf) / (sizeof(K) + sizeof(V)) < size) {
+    return false;
+  }
+  pairs->clear();
+  pairs->reserve(size);
+  for (uint32_t i = 0; i < size; i++) {
+    pairs->emplace_back(MACH_READ_FROM(K, buf), MACH_READ_FROM(V, buf + sizeof(K)));
+    buf += sizeof(K) + sizeof(V);
+  }
+  return true;
+}
+
+void WriteRowIds(char *&buf, const std::vector<RowId> &rids) {
+  MACH_WRITE_UINT32(buf, rids.size());
+  buf += sizeof(uint32_t);
+  for (auto &rid : rids) {
+    MACH_WRITE_TO(int64_t, buf, rid.Get());
+    buf += sizeof(int64_t);
+  }
+}
+
+bool ReadRowIds(const char *&buf, const char *end, std::vector<RowId> *rids) {
+  if (end - buf < static_cast<std::ptrdiff_t>(sizeof(uint32_t))) {
+    return false;
+  }
+  uint32_t size = MACH_READ_UINT32(buf);
+  buf += sizeof(uint32_t);
+  if (static_cast<size_t>(end - buf) / sizeof(int64_t) < size) {
+    return false;
+  }
+  rids->clear();
+  rids->reserve(size);
+  for (uint32_t i = 0; i < size; i++) {
+    rids->emplace_back(MACH_READ_FROM(int64_t, buf));
+    buf += sizeof(int64_t);
+  }
+  return true;
+}
+
+bool ReadTuple(const char *&buf, const char *end, std::string *tuple) {
+  if (end - buf < static_cast<std::ptrdiff_t>(sizeof(uint32_t))) {
+    return false;
+  }
+  uint32_t size = MACH_READ_UINT32(buf);
+  buf += sizeof(uint32_t);
+  if (static_cast<size_t>(end - buf) < size) {
+    return false;
+  }
+  tuple->assign(buf, size);
+  buf += size;
+  return true;
+}
+
+}  // namespace
+
+void LogRecord::SerializeTo(char *buf) const {
+  MACH_WRITE_UINT32(buf, size_);
+  MACH_WRITE_TO(lsn_t, buf + 4, lsn_);
+  MACH_WRITE_TO(txn_id_t, buf + 12, txn_id_);
+  MACH_WRITE_TO(lsn_t, buf + 16, prev_lsn_);
+  MACH_WRITE_TO(lsn_t, buf + 24, undo_next_lsn_);
+  MACH_WRITE_UINT32(buf + 32, type_);
+  buf += HEADER_SIZE;
+  switch (type_) {
+    case kInsertLog:
+    case kMarkDeleteLog:
+    case kApplyDeleteLog:
+    case kRollbackDeleteLog:
+    case kUpdateLog:
+      MACH_WRITE_TO(int64_t, buf, rid_.Get());
+      buf += sizeof(int64_t);
+      WriteTuple(buf, tuple_);
+      if (type_ == kUpdateLog) {
+        WriteTuple(buf, new_tuple_);
+      }
+      break;
+    case kNewPageLog:
+    case kFreePageLog:
+      MACH_WRITE_TO(page_id_t, buf, prev_page_id_);
+      MACH_WRITE_TO(page_id_t, buf + sizeof(page_id_t), page_id_);
+      break;
+    case kEndCheckpointLog:
+      WritePairs(buf, active_txns_);
+      WritePairs(buf, dirty_pages_);
+      WriteRowIds(buf, deleted_rows_);
+      break;
+    default:
+      break;
+  }
+}
+
+bool LogRecord::DeserializeFrom(const char *buf, size_t len, LogRecord *record) {
+  if (len < HEADER_SIZE) {
+    return false;
+  }
+  uint32_t size = MACH_READ_UINT32(buf);
+  uint32_t type = MACH_READ_UINT32(buf + 32);
+  if (size < HEADER_SIZE || size > len || type == kInvalidLog || type > kEndCheckpointLog) {
+    return false;
+  }
+  *record = LogRecord(static_cast<LogRecordType>(type), MACH_READ_FROM(txn_id_t, buf + 12),
+                      MACH_READ_FROM(lsn_t, buf + 16));
+  record->lsn_ = MACH_READ_FROM(lsn_t, buf + 4);
+  record->undo_next_lsn_ = MACH_READ_FROM(lsn_t, buf + 24);
+  record->size_ = size;
+  const char *end = buf + size;
+  buf += HEADER_SIZE;
+  switch (record->type_) {
+    case kInsertLog:
+    case kMarkDeleteLog:
+    case kApplyDeleteLog:
+    case kRollbackDeleteLog:
+    case kUpdateLog:
+      if (end - buf < static_cast<std::ptrdiff_t>(sizeof(int64_t))) {
+        return false;
+      }
+      record->rid_ = RowId(MACH_READ_FROM(int64_t, buf));
+      buf += sizeof(int64_t);
+      if (!ReadTuple(buf, end, &record->tuple_)) {
+        return false;
+      }
+      if (record->type_ == kUpdateLog && !ReadTuple(buf, end, &record->new_tuple_)) {
+        return false;
+      }
+      break;
+    case kNewPageLog:
+    case kFreePageLog:
+      if (end - buf < static_cast<std::ptrdiff_t>(2 * sizeof(page_id_t))) {
+        return false;
+      }
+      record->prev_page_id_ = MACH_READ_FROM(page_id_t, buf);
+      record->page_id_ = MACH_READ_FROM(page_id_t, buf + sizeof(page_id_t));
+      buf += 2 * sizeof(page_id_t);
+      break;
+    case kEndCheckpointLog:
+      if (!ReadPairs(buf, end, &record->active_txns_) || !ReadPairs(buf, end, &record->dirty_pages_) ||
+          !ReadRowIds(buf, end, &record->deleted_rows_)) {
+        return false;
+      }
+      break;
+    default:
+      break;
+  }
+  return buf == end;
+}
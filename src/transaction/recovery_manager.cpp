@@ -0,0 +1,293 @@
+#include <cstring>
+#include <iterator>
+#include <unordered_set>
+
+#include "glog/logging.h"
+#include "page/table_page.h"
+#include "transaction/recovery_manager.h"
+
+RecoveryManager::~RecoveryManager() { StopCheckpointThread(); }
+
+void RecoveryManager::Recover() {
+  lsn_t checkpoint_lsn = log_manager_->GetCheckpointLSN();
+  lsn_t start_lsn = checkpoint_lsn != INVALID_LSN ? checkpoint_lsn : static_cast<lsn_t>(LogManager::LOG_HEADER_SIZE);
+  last_checkpoint_lsn_ = checkpoint_lsn;
+
+  // Analysis: the transactions without an end record, and the pages which may miss some changes
+  std::unordered_map<txn_id_t, lsn_t> active_txns;
+  std::unordered_set<txn_id_t> ended_txns;
+  std::unordered_map<page_id_t, lsn_t> dirty_pages;
+  std::unordered_map<page_id_t, lsn_t> freed_pages;
+  std::unordered_set<RowId> deleted_rows;
+  lsn_t end_lsn = ScanLog(start_lsn, [&](const LogRecord &record) {
+    txn_id_t txn_id = record.GetTxnId();
+    if (txn_id != INVALID_TXN_ID) {
+      if (record.GetType() == kCommitLog || record.GetType() == kAbortLog) {
+        active_txns.erase(txn_id);
+        ended_txns.insert(txn_id);
+      } else {
+        active_txns[txn_id] = record.GetLSN();
+      }
+    }
+    switch (record.GetType()) {
+      case kMarkDeleteLog:
+        deleted_rows.insert(record.GetRowId());
+        dirty_pages.emplace(record.GetRowId().GetPageId(), record.GetLSN());
+        break;
+      case kApplyDeleteLog:
+      case kRollbackDeleteLog:
+        deleted_rows.erase(record.GetRowId());
+        dirty_pages.emplace(record.GetRowId().GetPageId(), record.GetLSN());
+        break;
+      case kInsertLog:
+      case kUpdateLog:
+        dirty_pages.emplace(record.GetRowId().GetPageId(), record.GetLSN());
+        break;
+      case kNewPageLog:
+        dirty_pages.emplace(record.GetPageId(), record.GetLSN());
+        if (record.GetPrevPageId() != INVALID_PAGE_ID) {
+          dirty_pages.emplace(record.GetPrevPageId(), record.GetLSN());
+        }
+        break;
+      case kFreePageLog:
+        // the page may have been reused for anything since, e.g. by an index, only the records of its next allocation
+        // as a table page are redone
+        dirty_pages.erase(record.GetPageId());
+        freed_pages[record.GetPageId()] = record.GetLSN();
+        for (auto it = deleted_rows.begin(); it != deleted_rows.end();) {
+          it = it->GetPageId() == record.GetPageId() ? deleted_rows.erase(it) : std::next(it);
+        }
+        break;
+      case kEndCheckpointLog:
+        // the tables were taken after the begin record, a transaction may have ended since
+        for (auto &txn : record.GetActiveTransactions()) {
+          if (ended_txns.count(txn.first) == 0) {
+            auto it = active_txns.emplace(txn.first, txn.second).first;
+            it->second = std::max(it->second, txn.second);
+          }
+        }
+        for (auto &page : record.GetDirtyPages()) {
+          auto freed = freed_pages.find(page.first);
+          if (freed != freed_pages.end() && page.second < freed->second) {
+            continue;
+          }
+          auto it = dirty_pages.emplace(page.first, page.second).first;
+          it->second = std::min(it->second, page.second);
+        }
+        for (auto &rid : record.GetDeletedRows()) {
+          auto freed = freed_pages.find(rid.GetPageId());
+          if (freed == freed_pages.end() || freed->second < record.GetPrevLSN()) {
+            deleted_rows.insert(rid);
+          }
+        }
+        break;
+      default:
+        break;
+    }
+  });
+  if (static_cast<size_t>(end_lsn) < disk_manager_->GetLogSize()) {
+    LOG(WARNING) << "The log is cut at " << end_lsn << ", where a record torn by a crash starts";
+    log_manager_->Truncate(end_lsn);
+  }
+
+  // Redo: from the oldest change which may not be on the disk, or from the checkpoint for the allocations of pages
+  lsn_t redo_lsn = start_lsn;
+  for (auto &page : dirty_pages) {
+    redo_lsn = std::min(redo_lsn, page.second);
+  }
+  num_redo_records_ = 0;
+  ScanLog(redo_lsn, [&](const LogRecord &record) {
+    num_redo_records_++;
+    switch (record.GetType()) {
+      case kInsertLog:
+      case kMarkDeleteLog:
+      case kApplyDeleteLog:
+      case kRollbackDeleteLog:
+      case kUpdateLog:
+        RedoPage(record, record.GetRowId().GetPageId(), dirty_pages);
+        break;
+      case kNewPageLog:
+        // the page may have been allocated after the meta data was saved for the last time, the older allocations
+        // are in it, as well as the frees which followed them
+        if (record.GetLSN() >= start_lsn) {
+          disk_manager_->AllocatePageAt(record.GetPageId());
+        }
+        RedoPage(record, record.GetPageId(), dirty_pages);
+        if (record.GetPrevPageId() != INVALID_PAGE_ID) {
+          RedoPage(record, record.GetPrevPageId(), dirty_pages);
+        }
+        break;
+      case kFreePageLog:
+        if (record.GetLSN() >= start_lsn) {
+          disk_manager_->DeAllocatePage(record.GetPageId());
+        }
+        break;
+      default:
+        break;
+    }
+  });
+
+  // Undo: the transactions which were running are aborted
+  for (auto &txn : active_txns) {
+    txn_manager_->Abort(txn_manager_->Resume(txn.first, txn.second));
+  }
+  // The deleted rows were kept on their page for the snapshots of the transactions, there are none after a restart.
+  // A row is still marked as deleted only if its delete is committed.
+  size_t num_deleted_rows = 0;
+  for (auto &rid : deleted_rows) {
+    if (disk_manager_->IsPageFree(rid.GetPageId())) {
+      continue;
+    }
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+    ASSERT(page != nullptr, "Can't fetch the page of a deleted row.");
+    page->WLatch();
+    bool marked = page->IsMarkedDeleted(rid.GetSlotNum());
+    if (marked) {
+      page->ApplyDelete(rid, nullptr, log_manager_);
+      num_deleted_rows++;
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(rid.GetPageId(), marked);
+  }
+  LOG(INFO) << "Recovered from the log: " << num_redo_records_.load() << " records redone from LSN " << redo_lsn
+            << ", " << active_txns.size() << " transactions undone, " << num_deleted_rows << " deleted rows removed";
+  Checkpoint();
+}
+
+lsn_t RecoveryManager::ScanLog(lsn_t lsn, const std::function<void(const LogRecord &)> &visit) {
+  // a record is at most as large as the log buffer, so the buffer always holds at least one whole record
+  const size_t capacity = 2 * LOG_BUFFER_SIZE;
+  std::unique_ptr<char[]> buf(new char[capacity]);
+  size_t begin = 0;
+  size_t end = 0;
+  LogRecord record;
+  while (true) {
+    // buf[begin, end) is the log from lsn on
+    if (!LogRecord::DeserializeFrom(buf.get() + begin, end - begin, &record)) {
+      memmove(buf.get(), buf.get() + begin, end - begin);
+      end -= begin;
+      begin = 0;
+      size_t len = end < capacity ? disk_manager_->ReadLog(buf.get() + end, capacity - end, lsn + end) : 0;
+      if (len == 0) {
+        break;
+      }
+      end += len;
+      continue;
+    }
+    if (record.GetLSN() != lsn) {
+      // the remains of a torn write
+      break;
+    }
+    visit(record);
+    begin += record.GetSize();
+    lsn += record.GetSize();
+  }
+  return lsn;
+}
+
+void RecoveryManager::RedoPage(const LogRecord &record, page_id_t page_id,
+                               const std::unordered_map<page_id_t, lsn_t> &dirty_pages) {
+  auto it = dirty_pages.find(page_id);
+  if (it == dirty_pages.end() || record.GetLSN() < it->second) {
+    // the change was on the disk by the time of the checkpoint
+    return;
+  }
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  ASSERT(page != nullptr, "Can't fetch the page to redo.");
+  bool redo = page->GetLSN() < record.GetLSN();
+  if (redo) {
+    page->Redo(record);
+  }
+  buffer_pool_manager_->UnpinPage(page_id, redo);
+}
+
+void RecoveryManager::Checkpoint() {
+  std::scoped_lock<std::mutex> lock(checkpoint_latch_);
+  // The pages dirty since before the last checkpoint are written, so that the next redo starts after it
+  if (last_checkpoint_lsn_ != INVALID_LSN) {
+    for (auto &page : buffer_pool_manager_->GetDirtyPageTable()) {
+      if (static_cast<lsn_t>(page.second) < last_checkpoint_lsn_) {
+        WritePage(page.first);
+      }
+    }
+  }
+  LogRecord begin_record(kBeginCheckpointLog, INVALID_TXN_ID, INVALID_LSN);
+  lsn_t begin_lsn = log_manager_->AppendLogRecord(&begin_record);
+  auto active_txns = txn_manager_->GetActiveTransactions();
+  // the recovery from this checkpoint reads nothing older than the oldest change of a dirty page, and the undo of a
+  // running transaction nothing older than its first record
+  lsn_t oldest_lsn = txn_manager_->GetOldestBeginLSN();
+  oldest_lsn = oldest_lsn != INVALID_LSN ? std::min(oldest_lsn, begin_lsn) : begin_lsn;
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages;
+  for (auto &page : buffer_pool_manager_->GetDirtyPageTable()) {
+    // a page pinned before the log manager was set may have changes from the start of the log
+    lsn_t rec_lsn = static_cast<lsn_t>(page.second);
+    dirty_pages.emplace_back(page.first, rec_lsn >= 0 ? rec_lsn : static_cast<lsn_t>(LogManager::LOG_HEADER_SIZE));
+    oldest_lsn = std::min(oldest_lsn, dirty_pages.back().second);
+  }
+  // The pages cleaned so far are forced to the disk together with the allocations, the ones made from the begin
+  // record on are redone from the log
+  // the rows whose delete waits for the garbage collection, which a restart must remove itself
+  std::vector<RowId> deleted_rows = txn_manager_->GetDeletedRows();
+  if (deleted_rows.size() > MAX_CHECKPOINT_DELETED_ROWS) {
+    LOG(WARNING) << deleted_rows.size() << " deleted rows wait for the garbage collection, only "
+                 << MAX_CHECKPOINT_DELETED_ROWS << " of them are removed by a recovery from this checkpoint";
+    deleted_rows.resize(MAX_CHECKPOINT_DELETED_ROWS);
+  }
+  disk_manager_->FlushMetaData();
+  LogRecord end_record(begin_lsn, std::move(active_txns), std::move(dirty_pages), std::move(deleted_rows));
+  // a checkpoint which is not entirely on the disk is not recorded, the recovery starts from the previous one
+  if (!log_manager_->Flush(log_manager_->AppendLogRecord(&end_record)) || !log_manager_->SetCheckpointLSN(begin_lsn)) {
+    LOG(ERROR) << "Can't write the checkpoint at " << begin_lsn;
+    return;
+  }
+  last_checkpoint_lsn_ = begin_lsn;
+  num_checkpoints_++;
+  log_manager_->Discard(oldest_lsn);
+}
+
+void RecoveryManager::WritePage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    return;
+  }
+  page->RLatch();
+  buffer_pool_manager_->FlushPage(page_id);
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, false);
+}
+
+void RecoveryManager::RunCheckpointThread(int interval_ms) {
+  std::scoped_lock<std::mutex> lock(thread_latch_);
+  if (checkpoint_thread_running_) {
+    return;
+  }
+  checkpoint_thread_running_ = true;
+  checkpoint_thread_ = std::thread(&RecoveryManager::CheckpointThreadLoop, this, interval_ms);
+}
+
+void RecoveryManager::StopCheckpointThread() {
+  {
+    std::scoped_lock<std::mutex> lock(thread_latch_);
+    if (!checkpoint_thread_running_) {
+      return;
+    }
+    checkpoint_thread_running_ = false;
+  }
+  checkpoint_cv_.notify_one();
+  checkpoint_thread_.join();
+}
+
+void RecoveryManager::CheckpointThreadLoop(int interval_ms) {
+  std::unique_lock<std::mutex> lock(thread_latch_);
+  while (true) {
+    checkpoint_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms),
+                            [this] { return !checkpoint_thread_running_; });
+    if (!checkpoint_thread_running_) {
+      break;
+    }
+    lock.unlock();
+    Checkpoint();
+    lock.lock();
+  }
+}
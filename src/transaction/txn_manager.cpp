@@ -0,0 +1,244 @@
+#include <algorithm>
+
+#include "buffer/buffer_pool_manager.h"
+#include "glog/logging.h"
+#include "index/index.h"
+#include "page/table_page.h"
+#include "transaction/lock_manager.h"
+#include "transaction/txn_manager.h"
+
+TransactionManager::~TransactionManager() { StopGarbageCollectionThread(); }
+
+Transaction *TransactionManager::Begin() {
+  auto txn = std::make_unique<Transaction>(next_txn_id_++);
+  // nothing is logged until the first change, a transaction which only reads never writes the log. The garbage
+  // collection sees the read timestamp of every running transaction.
+  std::scoped_lock<std::mutex> lock(latch_);
+  txn->SetReadTs(last_commit_ts_.load());
+  return running_.emplace(txn->GetTransactionId(), std::move(txn)).first->second.get();
+}
+
+bool TransactionManager::Commit(Transaction *txn) {
+  LogRecord record(kCommitLog, txn->GetTransactionId(), txn->GetPrevLSN());
+  // a transaction without a record has nothing to make durable
+  bool read_only = txn->GetPrevLSN() == INVALID_LSN;
+  // the transaction is kept until its locks are released
+  decltype(running_)::node_type ended;
+  {
+    // a checkpoint sees the transaction either running, or ended by a record it reads
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (!read_only) {
+      log_manager_->AppendLogRecord(&record);
+    }
+    txn->SetState(kCommitted);
+    ended = running_.extract(txn->GetTransactionId());
+  }
+  // the commits of concurrent transactions share the flushes of the log
+  bool durable = read_only || log_manager_->Flush(record.GetLSN());
+  if (!durable) {
+    LOG(ERROR) << "The commit of transaction " << txn->GetTransactionId() << " can't be written to the log";
+  }
+  // no other transaction sees the changes before they are durable
+  {
+    std::scoped_lock<std::mutex> lock(commit_latch_);
+    uint64_t commit_ts = last_commit_ts_.load() + 1;
+    txn->SetCommitTs(commit_ts);
+    version_store_.Commit(txn, commit_ts);
+    last_commit_ts_.store(commit_ts);
+  }
+  if (lock_manager_ != nullptr) {
+    lock_manager_->UnlockAll(txn);
+  }
+  EndTransaction();
+  return durable;
+}
+
+void TransactionManager::Abort(Transaction *txn) {
+  ASSERT(buffer_pool_manager_ != nullptr, "No buffer pool to undo the transaction.");
+  // the indexes are not logged, their entries are put back from the index write set, newest first
+  auto &index_write_set = txn->GetIndexWriteSet();
+  for (auto it = index_write_set.rbegin(); it != index_write_set.rend(); ++it) {
+    if (it->is_insert_) {
+      it->index_->RemoveEntry(it->key_, it->rid_, nullptr);
+    } else {
+      it->index_->InsertEntry(it->key_, it->rid_, nullptr);
+    }
+  }
+  index_write_set.clear();
+  // The records are read back from the log, newest first. A compensation record tells which change was undone
+  // before it, and is skipped together with the ones it compensates.
+  lsn_t lsn = txn->GetPrevLSN();
+  LogRecord record;
+  while (lsn != INVALID_LSN) {
+    if (!log_manager_->ReadLogRecord(lsn, &record)) {
+      LOG(ERROR) << "Can't read record " << lsn << " of transaction " << txn->GetTransactionId();
+      break;
+    }
+    if (record.IsCompensation()) {
+      lsn = record.GetUndoNextLSN();
+      continue;
+    }
+    Undo(record, txn);
+    lsn = record.GetPrevLSN();
+  }
+  LogRecord abort_record(kAbortLog, txn->GetTransactionId(), txn->GetPrevLSN());
+  // the transaction is kept until its locks are released
+  decltype(running_)::node_type ended;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (txn->GetPrevLSN() != INVALID_LSN) {
+      log_manager_->AppendLogRecord(&abort_record);
+    }
+    txn->SetState(kAborted);
+    ended = running_.extract(txn->GetTransactionId());
+  }
+  // the rows are back to the versions saved before the first changes
+  version_store_.Abort(txn);
+  if (lock_manager_ != nullptr) {
+    lock_manager_->UnlockAll(txn);
+  }
+  EndTransaction();
+}
+
+void TransactionManager::Undo(const LogRecord &record, Transaction *txn) {
+  if (record.GetType() < kInsertLog || record.GetType() > kUpdateLog) {
+    // a new page is left in the table heap, empty
+    return;
+  }
+  page_id_t page_id = record.GetRowId().GetPageId();
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  ASSERT(page != nullptr, "Can't fetch the page to undo.");
+  page->WLatch();
+  page->Undo(record, txn, log_manager_);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
+
+Transaction *TransactionManager::Resume(txn_id_t txn_id, lsn_t last_lsn) {
+  auto txn = std::make_unique<Transaction>(txn_id);
+  txn->SetPrevLSN(last_lsn);
+  // its first record is not known, it may be anywhere from the start of the log
+  txn->SetBeginLSN(LogManager::LOG_HEADER_SIZE);
+  // the new transactions don't reuse the ids found in the log
+  txn_id_t next_txn_id = next_txn_id_.load();
+  while (next_txn_id <= txn_id && !next_txn_id_.compare_exchange_weak(next_txn_id, txn_id + 1)) {
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  return running_.emplace(txn_id, std::move(txn)).first->second.get();
+}
+
+std::vector<std::pair<txn_id_t, lsn_t>> TransactionManager::GetActiveTransactions() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns;
+  active_txns.reserve(running_.size());
+  for (auto &txn : running_) {
+    // the recovery has nothing to undo for a transaction without a record
+    if (txn.second->GetPrevLSN() != INVALID_LSN) {
+      active_txns.emplace_back(txn.first, txn.second->GetPrevLSN());
+    }
+  }
+  return active_txns;
+}
+
+lsn_t TransactionManager::GetOldestBeginLSN() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  lsn_t oldest_lsn = INVALID_LSN;
+  for (auto &txn : running_) {
+    // a transaction which has not written a record yet writes its first one after the caller's begin record
+    lsn_t begin_lsn = txn.second->GetBeginLSN();
+    if (begin_lsn == INVALID_LSN) {
+      continue;
+    }
+    oldest_lsn = oldest_lsn == INVALID_LSN ? begin_lsn : std::min(oldest_lsn, begin_lsn);
+  }
+  return oldest_lsn;
+}
+
+size_t TransactionManager::GetNumRunning() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return running_.size();
+}
+
+void TransactionManager::EndTransaction() {
+  if (++num_ended_ % VERSION_GC_INTERVAL != 0) {
+    return;
+  }
+  {
+    std::scoped_lock<std::mutex> lock(gc_thread_latch_);
+    if (gc_thread_running_) {
+      gc_requested_ = true;
+      gc_cv_.notify_one();
+      return;
+    }
+  }
+  CollectGarbage();
+}
+
+void TransactionManager::RunGarbageCollectionThread() {
+  std::scoped_lock<std::mutex> lock(gc_thread_latch_);
+  if (gc_thread_running_) {
+    return;
+  }
+  gc_thread_running_ = true;
+  gc_thread_ = std::thread(&TransactionManager::GarbageCollectionThreadLoop, this);
+}
+
+void TransactionManager::StopGarbageCollectionThread() {
+  {
+    std::scoped_lock<std::mutex> lock(gc_thread_latch_);
+    if (!gc_thread_running_) {
+      return;
+    }
+    gc_thread_running_ = false;
+  }
+  gc_cv_.notify_one();
+  gc_thread_.join();
+}
+
+void TransactionManager::GarbageCollectionThreadLoop() {
+  std::unique_lock<std::mutex> lock(gc_thread_latch_);
+  while (true) {
+    gc_cv_.wait(lock, [this] { return !gc_thread_running_ || gc_requested_; });
+    if (!gc_thread_running_) {
+      break;
+    }
+    gc_requested_ = false;
+    lock.unlock();
+    CollectGarbage();
+    lock.lock();
+  }
+}
+
+std::vector<RowId> TransactionManager::GetDeletedRows() {
+  std::scoped_lock<std::mutex> gc_lock(gc_latch_);
+  return version_store_.GetDeletedRows();
+}
+
+void TransactionManager::CollectGarbage() {
+  std::scoped_lock<std::mutex> gc_lock(gc_latch_);
+  uint64_t watermark;
+  {
+    // a transaction beginning later reads from the last commit timestamp on
+    std::scoped_lock<std::mutex> lock(latch_);
+    watermark = last_commit_ts_.load();
+    for (auto &txn : running_) {
+      watermark = std::min(watermark, txn.second->GetReadTs());
+    }
+  }
+  for (auto &rid : version_store_.Collect(watermark)) {
+    if (buffer_pool_manager_ == nullptr) {
+      continue;
+    }
+    // no transaction sees the deleted tuple any more, and no other one can change it
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+    if (page == nullptr) {
+      continue;
+    }
+    page->WLatch();
+    if (page->IsMarkedDeleted(rid.GetSlotNum())) {
+      page->ApplyDelete(rid, nullptr, log_manager_);
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(rid.GetPageId(), true);
+  }
+}
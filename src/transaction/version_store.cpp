@@ -0,0 +1,174 @@
+#include <algorithm>
+
+#include "transaction/version_store.h"
+
+VersionRead VersionStore::ReadVersion(const RowId &rid, Transaction *txn, std::string *tuple) {
+  if (txn == nullptr || num_chains_.load() == 0) {
+    return VersionRead::kPageVersion;
+  }
+  Shard &shard = GetShard(rid);
+  std::scoped_lock<std::mutex> lock(shard.latch_);
+  auto it = shard.chains_.find(rid);
+  if (it == shard.chains_.end()) {
+    return VersionRead::kPageVersion;
+  }
+  auto &chain = it->second;
+  if (chain.writer_ == txn->GetTransactionId() ||
+      (chain.writer_ == INVALID_TXN_ID && chain.ts_ <= txn->GetReadTs())) {
+    return VersionRead::kPageVersion;
+  }
+  for (auto &version : chain.older_) {
+    if (version.ts_ <= txn->GetReadTs()) {
+      if (!version.exists_) {
+        return VersionRead::kNoVersion;
+      }
+      if (tuple != nullptr) {
+        *tuple = version.tuple_;
+      }
+      return VersionRead::kOlderVersion;
+    }
+  }
+  // inserted after the snapshot
+  return VersionRead::kNoVersion;
+}
+
+bool VersionStore::SaveVersion(const RowId &rid, Transaction *txn, bool exists, std::string tuple, bool deleted) {
+  Shard &shard = GetShard(rid);
+  std::scoped_lock<std::mutex> lock(shard.latch_);
+  auto it = shard.chains_.find(rid);
+  if (it != shard.chains_.end() && it->second.writer_ != txn->GetTransactionId() &&
+      (it->second.writer_ != INVALID_TXN_ID || it->second.ts_ > txn->GetReadTs())) {
+    txn->SetState(kAborted);
+    return false;
+  }
+  Save(shard, rid, txn, Version{0, exists, std::move(tuple)}, deleted);
+  return true;
+}
+
+void VersionStore::SaveInsert(const RowId &rid, Transaction *txn) {
+  Shard &shard = GetShard(rid);
+  std::scoped_lock<std::mutex> lock(shard.latch_);
+  Save(shard, rid, txn, Version{0, false, std::string()}, false);
+}
+
+void VersionStore::Save(Shard &shard, const RowId &rid, Transaction *txn, Version version, bool deleted) {
+  auto result = shard.chains_.try_emplace(rid);
+  auto &chain = result.first->second;
+  if (result.second) {
+    num_chains_++;
+  }
+  SetDeleted(chain, deleted);
+  if (chain.writer_ == txn->GetTransactionId()) {
+    // the version before the first change of the transaction is saved already
+    return;
+  }
+  version.ts_ = chain.ts_;
+  chain.older_.push_front(std::move(version));
+  chain.writer_ = txn->GetTransactionId();
+  txn->GetWriteSet().insert(rid);
+}
+
+void VersionStore::SetDeleted(VersionChain &chain, bool deleted) {
+  if (chain.deleted_ == deleted) {
+    return;
+  }
+  chain.deleted_ = deleted;
+  if (deleted) {
+    num_deleted_++;
+  } else {
+    num_deleted_--;
+  }
+}
+
+void VersionStore::Commit(Transaction *txn, uint64_t commit_ts) {
+  for (auto &rid : txn->GetWriteSet()) {
+    Shard &shard = GetShard(rid);
+    std::scoped_lock<std::mutex> lock(shard.latch_);
+    auto &chain = shard.chains_[rid];
+    chain.writer_ = INVALID_TXN_ID;
+    chain.ts_ = commit_ts;
+  }
+}
+
+void VersionStore::Abort(Transaction *txn) {
+  for (auto &rid : txn->GetWriteSet()) {
+    Shard &shard = GetShard(rid);
+    std::scoped_lock<std::mutex> lock(shard.latch_);
+    auto it = shard.chains_.find(rid);
+    ASSERT(it != shard.chains_.end() && it->second.writer_ == txn->GetTransactionId(), "Version chain not found.");
+    // the page is back to the version saved before the first change
+    auto &chain = it->second;
+    Version &version = chain.older_.front();
+    chain.writer_ = INVALID_TXN_ID;
+    chain.ts_ = version.ts_;
+    SetDeleted(chain, !version.exists_);
+    chain.older_.pop_front();
+    if (chain.older_.empty()) {
+      SetDeleted(chain, false);
+      shard.chains_.erase(it);
+      num_chains_--;
+    }
+  }
+  txn->GetWriteSet().clear();
+}
+
+std::vector<RowId> VersionStore::Collect(uint64_t watermark) {
+  std::vector<RowId> deleted;
+  for (size_t i = 0; i < VERSION_STORE_SHARDS; i++) {
+    Shard &shard = shards_[i];
+    std::scoped_lock<std::mutex> lock(shard.latch_);
+    for (auto it = shard.chains_.begin(); it != shard.chains_.end();) {
+      auto &chain = it->second;
+      if (chain.writer_ == INVALID_TXN_ID && chain.ts_ <= watermark) {
+        // everybody sees the version on the page
+        if (chain.deleted_) {
+          deleted.push_back(it->first);
+        }
+        SetDeleted(chain, false);
+        it = shard.chains_.erase(it);
+        num_chains_--;
+        continue;
+      }
+      // the newest version committed at the watermark is the oldest one still seen
+      auto oldest = std::find_if(chain.older_.begin(), chain.older_.end(),
+                                 [watermark](const Version &version) { return version.ts_ <= watermark; });
+      if (oldest != chain.older_.end()) {
+        chain.older_.erase(oldest + 1, chain.older_.end());
+      }
+      ++it;
+    }
+  }
+  return deleted;
+}
+
+std::vector<RowId> VersionStore::GetDeletedRows() {
+  std::vector<RowId> deleted;
+  for (size_t i = 0; i < VERSION_STORE_SHARDS; i++) {
+    Shard &shard = shards_[i];
+    std::scoped_lock<std::mutex> lock(shard.latch_);
+    for (auto &chain : shard.chains_) {
+      if (chain.second.deleted_) {
+        deleted.push_back(chain.first);
+      }
+    }
+  }
+  return deleted;
+}
+
+void VersionStore::DropPages(const std::vector<page_id_t> &page_ids) {
+  std::unordered_set<page_id_t> pages(page_ids.begin(), page_ids.end());
+  for (size_t i = 0; i < VERSION_STORE_SHARDS; i++) {
+    Shard &shard = shards_[i];
+    std::scoped_lock<std::mutex> lock(shard.latch_);
+    for (auto it = shard.chains_.begin(); it != shard.chains_.end();) {
+      // the chain of a running writer goes when it ends
+      if (pages.count(it->first.GetPageId()) != 0 && it->second.writer_ == INVALID_TXN_ID) {
+        SetDeleted(it->second, false);
+        it = shard.chains_.erase(it);
+        num_chains_--;
+        continue;
+      }
+      ++it;
+    }
+  }
+}
@@ -1,8 +1,11 @@
+#include <chrono>
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>
+#include <unistd.h>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
 
 TEST(BufferPoolManagerTest, BinaryDataTest) {
@@ -15,7 +18,7 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   remove(db_name.c_str());
   auto *disk_manager = new DiskManager(db_name);
-  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
 
   page_id_t page_id_temp;
   auto *page0 = bpm->NewPage(page_id_temp);
@@ -70,4 +73,464 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+TEST(BufferPoolManagerTest, BackgroundFlusherTest) {
+  const std::string db_name = "bpm_flusher_test.db";
+  const size_t buffer_pool_size = 64;
+  const size_t low_watermark = 16;
+  const size_t high_watermark = 32;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: fill up the pool with dirty pages and unpin them, nothing is clean any more.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    memset(page->GetData(), static_cast<int>(i + 1), PAGE_SIZE);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  bpm->StartFlusher(low_watermark, high_watermark);
+
+  // Scenario: the flusher cleans the least recently unpinned pages until high_watermark frames are clean.
+  for (int i = 0; i < 100 && bpm->GetBackgroundFlushCount() < high_watermark; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  EXPECT_EQ(high_watermark, bpm->GetBackgroundFlushCount());
+
+  // Scenario: the victims of the new pages are exactly the cleaned ones, no write back is needed in the foreground.
+  for (size_t i = 0; i < high_watermark; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(0, bpm->GetForegroundFlushCount());
+
+  // Scenario: the pages written back in the background can be read again.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    char expected[PAGE_SIZE];
+    memset(expected, static_cast<int>(i + 1), PAGE_SIZE);
+    EXPECT_EQ(0, memcmp(page->GetData(), expected, PAGE_SIZE));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  bpm->StopFlusher();
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, BackgroundFlusherFollowsReplacerTest) {
+  const std::string db_name = "bpm_flusher_replacer_test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t low_watermark = 4;
+  const size_t high_watermark = 8;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, kLRUKReplacer);
+
+  // Scenario: pages 0~7 are accessed twice, then pages 8~15 once. All of them are dirty.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    memset(page->GetData(), static_cast<int>(i + 1), PAGE_SIZE);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+    if (i < high_watermark) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id_temp));
+      EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+    }
+  }
+  bpm->StartFlusher(low_watermark, high_watermark);
+
+  // Scenario: LRU-K evicts pages 8~15 first although they were unpinned last, the flusher cleans exactly those.
+  for (int i = 0; i < 100 && bpm->GetBackgroundFlushCount() < high_watermark; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  EXPECT_EQ(high_watermark, bpm->GetBackgroundFlushCount());
+  auto dirty_page_table = bpm->GetDirtyPageTable();
+  EXPECT_EQ(high_watermark, dirty_page_table.size());
+  for (page_id_t i = 0; i < static_cast<page_id_t>(high_watermark); ++i) {
+    EXPECT_EQ(1, dirty_page_table.count(i));
+  }
+  bpm->StopFlusher();
+
+  // Scenario: the new pages take the frames of the cleaned pages, without a write back in the foreground.
+  for (size_t i = 0; i < high_watermark; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(0, bpm->GetForegroundFlushCount());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, DirtyPageCheckpointTest) {
+  const std::string db_name = "bpm_checkpoint_test.db";
+  const size_t buffer_pool_size = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: pages {0, 1, 2, 3} and {5, ..., 9} are modified, the other ones stay clean.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    bool is_dirty = i < 10 && i != 4;
+    if (is_dirty) {
+      memset(page->GetData(), static_cast<int>(i + 1), PAGE_SIZE);
+    }
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, is_dirty));
+  }
+  auto dirty_page_table = bpm->GetDirtyPageTable();
+  EXPECT_EQ(9, dirty_page_table.size());
+  EXPECT_EQ(0, dirty_page_table.count(4));
+  EXPECT_LT(dirty_page_table[0], dirty_page_table[9]);
+
+  // Scenario: dirtying a page again keeps the time it was first dirtied.
+  bpm->FetchPage(0);
+  EXPECT_TRUE(bpm->UnpinPage(0, true));
+  EXPECT_EQ(dirty_page_table[0], bpm->GetDirtyPageTable()[0]);
+
+  // Scenario: the checkpoint writes the two runs of adjacent dirty pages with two write calls, and cleans them.
+  uint64_t num_writes = disk_manager->GetNumWrites();
+  EXPECT_TRUE(bpm->FlushAllPage());
+  EXPECT_EQ(num_writes + 2, disk_manager->GetNumWrites());
+  EXPECT_TRUE(bpm->GetDirtyPageTable().empty());
+
+  // Scenario: nothing is left to write.
+  EXPECT_TRUE(bpm->FlushAllPage());
+  EXPECT_EQ(num_writes + 2, disk_manager->GetNumWrites());
+
+  // Scenario: the content on disk is the one written by the checkpoint.
+  char data[PAGE_SIZE];
+  char expected[PAGE_SIZE];
+  for (size_t i = 0; i < 10; ++i) {
+    disk_manager->ReadPage(i, data);
+    memset(expected, i == 4 ? 0 : static_cast<int>(i + 1), PAGE_SIZE);
+    EXPECT_EQ(0, memcmp(data, expected, PAGE_SIZE));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "bpm_stats_test.db";
+  const size_t buffer_pool_size = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: fill the pool with pinned pages, there is no frame left for another one.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(buffer_pool_size, stats.pool_size);
+  EXPECT_EQ(buffer_pool_size, stats.resident_pages);
+  EXPECT_EQ(buffer_pool_size, stats.pinned_pages);
+  EXPECT_EQ(1, stats.new_page_failures);
+
+  // Scenario: page 0 is dirty, page 1 is used again after all of them are unpinned.
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(i, i == 0));
+  }
+  EXPECT_EQ(1, bpm->GetStats().dirty_pages);
+  EXPECT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+
+  // Scenario: a new page evicts page 0 which is written back, fetching page 0 again evicts another page.
+  ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  EXPECT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+
+  stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRate());
+  EXPECT_EQ(2, stats.evictions);
+  EXPECT_EQ(1, stats.dirty_writebacks);
+  EXPECT_EQ(1, stats.foreground_flushes);
+  EXPECT_EQ(0, stats.dirty_pages);
+  EXPECT_EQ(0, stats.pinned_pages);
+  EXPECT_EQ(buffer_pool_size, stats.resident_pages);
+
+  // Scenario: every release of the last pin is recorded once in the histogram.
+  uint64_t pins = 0;
+  for (size_t i = 0; i < PIN_HISTOGRAM_BUCKETS; ++i) {
+    pins += stats.pin_duration_histogram[i];
+  }
+  EXPECT_EQ(buffer_pool_size + 3, pins);
+
+  // Scenario: a duration is counted by the bucket whose bounds, as shown by SHOW STATUS, hold it.
+  for (uint64_t us : {0, 1, 2, 3, 4, 7, 8, 1000, 16383, 16384, 1000000}) {
+    size_t bucket = BufferPoolStats::GetPinBucket(us);
+    EXPECT_LE(BufferPoolStats::GetPinBucketLowerBound(bucket), us);
+    if (bucket < PIN_HISTOGRAM_BUCKETS - 1) {
+      EXPECT_LT(us, BufferPoolStats::GetPinBucketLowerBound(bucket + 1));
+    }
+  }
+  EXPECT_EQ(0, BufferPoolStats::GetPinBucket(0));
+  EXPECT_EQ(1, BufferPoolStats::GetPinBucket(1));
+  EXPECT_EQ(3, BufferPoolStats::GetPinBucket(7));
+  EXPECT_EQ(PIN_HISTOGRAM_BUCKETS - 1, BufferPoolStats::GetPinBucket(UINT64_MAX));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, PinnedFrameAccountingTest) {
+  const std::string db_name = "bpm_pinned_test.db";
+  const size_t buffer_pool_size = 8;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: free frames count as unpinned.
+  EXPECT_FALSE(bpm->CheckAllPinned());
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: a page pinned twice needs two unpins before its frame can be used again.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+  }
+  EXPECT_TRUE(bpm->CheckAllPinned());
+  EXPECT_NE(nullptr, bpm->FetchPage(3));
+  EXPECT_TRUE(bpm->UnpinPage(3, false));
+  EXPECT_TRUE(bpm->CheckAllPinned());
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_TRUE(bpm->UnpinPage(3, false));
+  EXPECT_FALSE(bpm->UnpinPage(3, false));
+  EXPECT_FALSE(bpm->CheckAllPinned());
+
+  // Scenario: the new page takes the only unpinned frame, deleting an unpinned page frees it again.
+  ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_TRUE(bpm->CheckAllPinned());
+  EXPECT_EQ(nullptr, bpm->FetchPage(3));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  EXPECT_TRUE(bpm->DeletePage(page_id_temp));
+  EXPECT_FALSE(bpm->CheckAllPinned());
+  EXPECT_EQ(buffer_pool_size - 1, bpm->GetStats().pinned_pages);
+
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); ++i) {
+    if (i != 3) {
+      EXPECT_TRUE(bpm->UnpinPage(i, false));
+    }
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "bpm_resize_test.db";
+  const size_t buffer_pool_size = 8;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, kLRUKReplacer);
+
+  // Scenario: fill the pool, page 0 stays pinned, the other pages are dirty.
+  page_id_t page_id_temp;
+  Page *page0 = bpm->NewPage(page_id_temp);
+  ASSERT_NE(nullptr, page0);
+  for (size_t i = 1; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    memset(page->GetData(), static_cast<int>(i), PAGE_SIZE);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: growing adds free frames, the pinned page does not move.
+  EXPECT_TRUE(bpm->Resize(2 * buffer_pool_size));
+  EXPECT_EQ(2 * buffer_pool_size, bpm->GetPoolSize());
+  Page *tail_page = nullptr;
+  for (size_t i = buffer_pool_size; i < 2 * buffer_pool_size; ++i) {
+    tail_page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, tail_page);
+  }
+  EXPECT_EQ(2 * buffer_pool_size, bpm->GetStats().resident_pages);
+  EXPECT_EQ(buffer_pool_size + 1, bpm->GetStats().pinned_pages);
+  memset(page0->GetData(), 42, PAGE_SIZE);
+  EXPECT_EQ(page0, bpm->FetchPage(0));
+  EXPECT_TRUE(bpm->UnpinPage(0, true));
+
+  // Scenario: the frames to be dropped hold pinned pages, they stay valid until their last unpin.
+  EXPECT_TRUE(bpm->Resize(buffer_pool_size / 2));
+  EXPECT_EQ(buffer_pool_size / 2, bpm->GetPoolSize());
+  EXPECT_EQ(buffer_pool_size + 1, bpm->GetStats().pinned_pages);
+  memset(tail_page->GetData(), 43, PAGE_SIZE);
+  for (size_t i = buffer_pool_size; i < 2 * buffer_pool_size; ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(i, i == 2 * buffer_pool_size - 1));
+  }
+
+  // Scenario: shrinking below the pinned page 0 evicts the other pages, and writes back the dirty ones.
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(buffer_pool_size / 2, stats.pool_size);
+  EXPECT_GE(buffer_pool_size / 2, stats.resident_pages);
+  EXPECT_EQ(1, stats.pinned_pages);
+  EXPECT_EQ(page0, bpm->FetchPage(0));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  for (page_id_t i = 1; i < static_cast<page_id_t>(buffer_pool_size); ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    char expected[PAGE_SIZE];
+    memset(expected, static_cast<int>(i), PAGE_SIZE);
+    EXPECT_EQ(0, memcmp(page->GetData(), expected, PAGE_SIZE));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  auto *page = bpm->FetchPage(2 * buffer_pool_size - 1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(43, page->GetData()[0]);
+  EXPECT_TRUE(bpm->UnpinPage(2 * buffer_pool_size - 1, false));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: the evictable pages are still evictable after a resize.
+  for (size_t i = 0; i < buffer_pool_size / 2; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+  }
+  EXPECT_TRUE(bpm->CheckAllPinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ResizeWriteFailureTest) {
+  const std::string db_name = "bpm_resize_failure_test.db";
+  const size_t buffer_pool_size = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name, kSyncNever);
+  // every write of the log fails, like on a full disk, a page with a change logged since can't be written back
+  std::string log_name = DiskManager::GetLogFileName(db_name);
+  remove(log_name.c_str());
+  ASSERT_EQ(0, symlink("/dev/full", log_name.c_str()));
+  auto *log_manager = new LogManager(disk_manager);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  bpm->SetLogManager(log_manager);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+  }
+  LogRecord record(page_id_temp);
+  bpm->FetchPage(page_id_temp)->SetLSN(log_manager->AppendLogRecord(&record));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: the dirty page stays in its dropped frame like a pinned one, the other frames are unpinned.
+  EXPECT_TRUE(bpm->Resize(buffer_pool_size / 2));
+  EXPECT_EQ(1, bpm->GetStats().pinned_pages);
+  EXPECT_FALSE(bpm->CheckAllPinned());
+  // Scenario: fetching the page and unpinning it again leaves the frames of the pool as they were.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id_temp));
+  EXPECT_EQ(1, bpm->GetStats().pinned_pages);
+  EXPECT_FALSE(bpm->CheckAllPinned());
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  EXPECT_EQ(1, bpm->GetStats().pinned_pages);
+
+  // Scenario: growing takes the frame back with its unpinned page.
+  EXPECT_TRUE(bpm->Resize(buffer_pool_size));
+  EXPECT_EQ(0, bpm->GetStats().pinned_pages);
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  for (size_t i = 0; i < buffer_pool_size - 1; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+  }
+  EXPECT_FALSE(bpm->CheckAllPinned());
+
+  delete bpm;
+  delete log_manager;
+  delete disk_manager;
+  remove(log_name.c_str());
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, WarmUpTest) {
+  const std::string db_name = "bpm_warm_up_test.db";
+  const std::string dump_name = "bpm_warm_up_test.bpdump";
+  const size_t buffer_pool_size = 16;
+  const page_id_t num_pages = 64;
+
+  remove(db_name.c_str());
+  remove(dump_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    memset(page->GetData(), static_cast<int>(i), PAGE_SIZE);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  // Scenario: the working set is made of every fourth page, page 60 is the most recently used one.
+  for (page_id_t i = 0; i < num_pages; i += 4) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  auto resident_pages = bpm->GetResidentPages();
+  ASSERT_EQ(buffer_pool_size, resident_pages.size());
+  EXPECT_EQ(60, resident_pages.front());
+  EXPECT_TRUE(bpm->DumpResidentPages(dump_name));
+  delete bpm;
+
+  // Scenario: after a restart the working set is read back, fetching it never misses.
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  EXPECT_EQ(buffer_pool_size, bpm->WarmUp(dump_name));
+  bpm->WaitForWarmUp();
+  for (page_id_t i = 0; i < num_pages; i += 4) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(static_cast<char>(i), page->GetData()[0]);
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(buffer_pool_size, bpm->GetStats().hits);
+  EXPECT_EQ(0, bpm->GetStats().misses);
+  delete bpm;
+
+  // Scenario: a smaller pool only reads the most recently used pages which fit in its free frames,
+  // and never evicts a page fetched before.
+  bpm = new BufferPoolManagerInstance(buffer_pool_size / 2, disk_manager);
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_EQ(buffer_pool_size / 2 - 1, bpm->WarmUp(dump_name));
+  bpm->WaitForWarmUp();
+  EXPECT_EQ(buffer_pool_size / 2, bpm->GetStats().resident_pages);
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  for (page_id_t i = num_pages - 4; i > num_pages - 4 * static_cast<page_id_t>(buffer_pool_size / 2); i -= 4) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(buffer_pool_size / 2 - 1, bpm->GetStats().hits);
+  delete bpm;
+
+  // Scenario: a missing dump is not an error.
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  remove(dump_name.c_str());
+  EXPECT_EQ(0, bpm->WarmUp(dump_name));
+  delete bpm;
+
+  delete disk_manager;
+  remove(db_name.c_str());
+}
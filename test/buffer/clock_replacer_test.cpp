@@ -0,0 +1,107 @@
+#include <thread>
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "gtest/gtest.h"
+
+TEST(ClockReplacerTest, SampleTest) {
+  ClockReplacer clock_replacer(7);
+
+  // Scenario: unpin six elements, i.e. add them to the replacer.
+  clock_replacer.Unpin(1);
+  clock_replacer.Unpin(2);
+  clock_replacer.Unpin(3);
+  clock_replacer.Unpin(4);
+  clock_replacer.Unpin(5);
+  clock_replacer.Unpin(6);
+  clock_replacer.Unpin(1);
+  EXPECT_EQ(6, clock_replacer.Size());
+
+  // Scenario: every element is referenced, the hand clears them all on its first round and takes them on its second.
+  EXPECT_EQ(std::vector<frame_id_t>({1, 2, 3, 4}), clock_replacer.NextVictims(4));
+  EXPECT_EQ(6, clock_replacer.Size());
+
+  // Scenario: get three victims from the clock.
+  int value;
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+
+  // Scenario: pin elements in the replacer.
+  // Note that 3 has already been victimized, so pinning 3 should have no effect.
+  clock_replacer.Pin(3);
+  clock_replacer.Pin(4);
+  EXPECT_EQ(2, clock_replacer.Size());
+
+  // Scenario: unpin 4. We expect that the reference bit of 4 will be set to 1.
+  clock_replacer.Unpin(4);
+
+  // Scenario: continue looking for victims. We expect these victims.
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(6, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+TEST(ClockReplacerTest, ConcurrentPinUnpinTest) {
+  const size_t num_frames = 64;
+  const size_t num_threads = 4;
+  const int rounds = 10000;
+  ClockReplacer clock_replacer(num_frames);
+
+  // Scenario: every thread pins and unpins its own frames while another thread keeps looking for victims.
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < rounds; i++) {
+        frame_id_t frame_id = t + num_threads * (i % (num_frames / num_threads));
+        clock_replacer.Pin(frame_id);
+        clock_replacer.Unpin(frame_id);
+      }
+    });
+  }
+  std::vector<frame_id_t> victims;
+  std::thread sweeper([&]() {
+    for (int i = 0; i < rounds; i++) {
+      frame_id_t frame_id;
+      if (clock_replacer.Victim(&frame_id)) {
+        victims.push_back(frame_id);
+      }
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  sweeper.join();
+
+  // Scenario: the sweeper got at most one frame per call, and only frames which exist.
+  EXPECT_LE(victims.size(), static_cast<size_t>(rounds));
+  for (auto victim : victims) {
+    EXPECT_LT(static_cast<size_t>(victim), num_frames);
+  }
+
+  // Scenario: the size stays consistent, unpin every frame again to give back the frames taken by the sweeper.
+  EXPECT_LE(clock_replacer.Size(), num_frames);
+  for (size_t i = 0; i < num_frames; i++) {
+    clock_replacer.Unpin(i);
+  }
+  EXPECT_EQ(num_frames, clock_replacer.Size());
+
+  // Scenario: the first victim clears every reference bit on its round, the other frames follow in clock order.
+  frame_id_t first;
+  ASSERT_TRUE(clock_replacer.Victim(&first));
+  for (size_t i = 1; i < num_frames; i++) {
+    frame_id_t frame_id;
+    ASSERT_TRUE(clock_replacer.Victim(&frame_id));
+    EXPECT_EQ((first + i) % num_frames, static_cast<size_t>(frame_id));
+  }
+  frame_id_t frame_id;
+  EXPECT_FALSE(clock_replacer.Victim(&frame_id));
+}
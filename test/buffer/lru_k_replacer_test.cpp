@@ -0,0 +1,152 @@
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: access frames 1~6 once, and frame 1 once more, then unpin all of them.
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_k_replacer.Pin(i);
+  }
+  lru_k_replacer.Pin(1);
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+  lru_k_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames 2~6 have infinite k-distance, they go first in the order of their first access.
+  // Frame 1 has been accessed twice, it stays although its latest access is earlier than the one of frame 6.
+  EXPECT_EQ(std::vector<frame_id_t>({2, 3, 4, 5, 6, 1}), lru_k_replacer.NextVictims(7));
+  int value;
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(4, lru_k_replacer.Size());
+
+  // Scenario: pin frame 4 twice so that it gets a finite k-distance, which is more recent than frame 1's.
+  // Note that 3 has already been victimized, so pinning 3 records a fresh access.
+  lru_k_replacer.Pin(3);
+  lru_k_replacer.Pin(4);
+  lru_k_replacer.Pin(4);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+  lru_k_replacer.Unpin(4);
+  lru_k_replacer.Unpin(3);
+
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(6, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, lru_k_replacer.Size());
+}
+
+namespace {
+
+/**
+ * A tiny buffer pool which only keeps the page to frame mapping, used to replay a page access trace on a replacer.
+ */
+class ReplacerSimulator {
+public:
+  ReplacerSimulator(Replacer *replacer, size_t num_frames) : replacer_(replacer), frame_pages_(num_frames) {
+    for (size_t i = 0; i < num_frames; i++) {
+      free_list_.emplace_back(i);
+    }
+  }
+
+  /** @return true if the page is a hit */
+  bool Access(page_id_t page_id) {
+    auto iter = page_table_.find(page_id);
+    if (iter != page_table_.end()) {
+      replacer_->Pin(iter->second);
+      replacer_->Unpin(iter->second);
+      return true;
+    }
+    frame_id_t frame_id;
+    if (!free_list_.empty()) {
+      frame_id = free_list_.back();
+      free_list_.pop_back();
+    } else {
+      EXPECT_TRUE(replacer_->Victim(&frame_id));
+      page_table_.erase(frame_pages_[frame_id]);
+    }
+    frame_pages_[frame_id] = page_id;
+    page_table_[page_id] = frame_id;
+    replacer_->Pin(frame_id);
+    replacer_->Unpin(frame_id);
+    return false;
+  }
+
+private:
+  Replacer *replacer_;
+  std::vector<page_id_t> frame_pages_;
+  std::vector<frame_id_t> free_list_;
+  std::unordered_map<page_id_t, frame_id_t> page_table_;
+};
+
+/**
+ * Point lookups over a small hot set mixed with full scans over a large cold table.
+ * @return hit rate of the point lookups
+ */
+double RunMixedWorkload(Replacer *replacer, size_t num_frames) {
+  const page_id_t hot_pages = 64;
+  const page_id_t scan_pages = 1024;
+  const int rounds = 20;
+  const int lookups_per_round = 2000;
+  const int lookups_between_scans = 500;
+  ReplacerSimulator simulator(replacer, num_frames);
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<page_id_t> hot_dist(0, hot_pages - 1);
+  size_t hits = 0;
+  size_t lookups = 0;
+  size_t total_hits = 0;
+  size_t total_accesses = 0;
+  for (int round = 0; round < rounds; round++) {
+    for (int i = 0; i < lookups_per_round; i++) {
+      bool hit = simulator.Access(hot_dist(rng));
+      hits += hit;
+      total_hits += hit;
+      lookups++;
+      total_accesses++;
+      // a full scan over the cold table runs every once in a while
+      if (i % lookups_between_scans == lookups_between_scans / 2) {
+        for (page_id_t page_id = hot_pages; page_id < hot_pages + scan_pages; page_id++) {
+          total_hits += simulator.Access(page_id);
+          total_accesses++;
+        }
+      }
+    }
+  }
+  LOG(INFO) << "point lookup hit rate: " << 1.0 * hits / lookups << ", overall hit rate: "
+            << 1.0 * total_hits / total_accesses << std::endl;
+  return 1.0 * hits / lookups;
+}
+
+}  // namespace
+
+TEST(LRUKReplacerTest, ScanResistanceWorkloadTest) {
+  const size_t num_frames = 128;
+  auto lru = std::make_unique<LRUReplacer>(num_frames);
+  auto lru_k = std::make_unique<LRUKReplacer>(num_frames, 2);
+  LOG(INFO) << "LRU:" << std::endl;
+  double lru_hit_rate = RunMixedWorkload(lru.get(), num_frames);
+  LOG(INFO) << "LRU-2:" << std::endl;
+  double lru_k_hit_rate = RunMixedWorkload(lru_k.get(), num_frames);
+  // every scan flushes the hot pages out of LRU, but hardly touches them under LRU-2
+  EXPECT_GT(lru_k_hit_rate, lru_hit_rate);
+  EXPECT_GT(lru_k_hit_rate, 0.95);
+}
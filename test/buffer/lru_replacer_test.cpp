@@ -1,3 +1,5 @@
+#include <vector>
+
 #include "buffer/lru_replacer.h"
 #include "gtest/gtest.h"
 
@@ -14,6 +16,10 @@ TEST(LRUReplacerTest, SampleTest) {
   lru_replacer.Unpin(1);
   EXPECT_EQ(6, lru_replacer.Size());
 
+  // Scenario: the next victims are the least recently unpinned elements, nothing is removed by looking at them.
+  EXPECT_EQ(std::vector<frame_id_t>({1, 2, 3}), lru_replacer.NextVictims(3));
+  EXPECT_EQ(6, lru_replacer.Size());
+
   // Scenario: get three victims from the lru.
   int value;
   lru_replacer.Victim(&value);
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/page_table.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+TEST(PageTableTest, SampleTest) {
+  PageTable page_table(4);
+  frame_id_t frame_id;
+  EXPECT_TRUE(page_table.Empty());
+  EXPECT_FALSE(page_table.Find(0, &frame_id));
+
+  page_table.Insert(0, 3);
+  page_table.Insert(8, 2);
+  page_table.Insert(16, 1);
+  EXPECT_EQ(3, page_table.Size());
+  EXPECT_TRUE(page_table.Find(8, &frame_id));
+  EXPECT_EQ(2, frame_id);
+
+  // Scenario: inserting a page again moves it to another frame.
+  page_table.Insert(8, 0);
+  EXPECT_EQ(3, page_table.Size());
+  EXPECT_TRUE(page_table.Find(8, &frame_id));
+  EXPECT_EQ(0, frame_id);
+
+  EXPECT_TRUE(page_table.Erase(0));
+  EXPECT_FALSE(page_table.Erase(0));
+  EXPECT_FALSE(page_table.Find(0, &frame_id));
+  EXPECT_TRUE(page_table.Find(16, &frame_id));
+  EXPECT_EQ(1, frame_id);
+  EXPECT_EQ(2, page_table.Size());
+}
+
+TEST(PageTableTest, RandomOperationTest) {
+  // Scenario: replay random operations on a small table, so that probe sequences collide and wrap around,
+  // and compare the content with std::unordered_map after every operation.
+  const size_t capacity = 64;
+  PageTable page_table(capacity);
+  std::unordered_map<page_id_t, frame_id_t> expected;
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<page_id_t> page_dist(0, 4 * capacity);
+  for (int i = 0; i < 100000; i++) {
+    page_id_t page_id = page_dist(rng);
+    if (expected.size() < capacity && rng() % 2 == 0) {
+      frame_id_t frame_id = static_cast<frame_id_t>(rng() % capacity);
+      page_table.Insert(page_id, frame_id);
+      expected[page_id] = frame_id;
+    } else {
+      EXPECT_EQ(expected.erase(page_id) == 1, page_table.Erase(page_id));
+    }
+    ASSERT_EQ(expected.size(), page_table.Size());
+    if (i % 100 == 0) {
+      for (page_id_t j = 0; j <= static_cast<page_id_t>(4 * capacity); j++) {
+        frame_id_t frame_id;
+        auto iter = expected.find(j);
+        ASSERT_EQ(iter != expected.end(), page_table.Find(j, &frame_id));
+        if (iter != expected.end()) {
+          ASSERT_EQ(iter->second, frame_id);
+        }
+      }
+    }
+  }
+}
+
+namespace {
+
+/**
+ * @return average nanoseconds per lookup, looking up all the given pages several times
+ */
+template <typename Lookup>
+double MeasureLookup(const std::vector<page_id_t> &page_ids, Lookup lookup) {
+  const int rounds = 20;
+  frame_id_t sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (page_id_t page_id : page_ids) {
+      sum += lookup(page_id);
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  // keep the lookups from being optimized away
+  EXPECT_NE(-1, sum);
+  return 1.0 * std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / (rounds * page_ids.size());
+}
+
+}  // namespace
+
+/**
+ * Compare the lookup latency of PageTable and std::unordered_map on the same keys. The numbers depend on the machine
+ * and on the build type, measure them with a release build:
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target page_table_test
+ *   ./build/test/page_table_test --gtest_filter=PageTableTest.LookupBenchmark
+ */
+TEST(PageTableTest, LookupBenchmark) {
+  for (size_t pool_size : {1024, 16384, 262144}) {
+    // a pool filled by several tables, whose page ids are scattered over a file twice as large
+    std::mt19937 rng(0);
+    std::vector<page_id_t> page_ids;
+    for (page_id_t i = 0; page_ids.size() < pool_size; i++) {
+      if (rng() % 2 == 0) {
+        page_ids.push_back(i);
+      }
+    }
+    PageTable page_table(pool_size);
+    std::unordered_map<page_id_t, frame_id_t> map;
+    for (size_t i = 0; i < pool_size; i++) {
+      page_table.Insert(page_ids[i], static_cast<frame_id_t>(i));
+      map.emplace(page_ids[i], static_cast<frame_id_t>(i));
+    }
+    // fetches come in random order
+    std::shuffle(page_ids.begin(), page_ids.end(), rng);
+    double page_table_ns = MeasureLookup(page_ids, [&](page_id_t page_id) {
+      frame_id_t frame_id = INVALID_FRAME_ID;
+      page_table.Find(page_id, &frame_id);
+      return frame_id;
+    });
+    double map_ns = MeasureLookup(page_ids, [&](page_id_t page_id) { return map.find(page_id)->second; });
+    LOG(INFO) << "pool size " << pool_size << ": PageTable " << page_table_ns << " ns/lookup, unordered_map "
+              << map_ns << " ns/lookup" << std::endl;
+  }
+}
@@ -0,0 +1,236 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+TEST(ParallelBufferPoolManagerTest, BinaryDataTest) {
+  const std::string db_name = "pbpm_test.db";
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 20;
+
+  std::random_device r;
+  std::default_random_engine rng(r());
+  std::uniform_int_distribution<char> uniform_dist(0);
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  ASSERT_EQ(buffer_pool_size, bpm->GetPoolSize());
+  ASSERT_EQ(num_instances, bpm->GetNumInstances());
+
+  // Scenario: fill up the whole pool, page ids are spread over the instances round-robin.
+  char data[buffer_pool_size][PAGE_SIZE];
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id_temp);
+    for (char &c : data[i]) {
+      c = uniform_dist(rng);
+    }
+    std::memcpy(page->GetData(), data[i], PAGE_SIZE);
+  }
+  EXPECT_TRUE(bpm->CheckAllPinned());
+
+  // Scenario: Once the buffer pool is full, we should not be able to create any new pages.
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+
+  // Scenario: unpin everything and create as many new pages, which evicts all the old ones.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(page_id_temp));
+    EXPECT_EQ(buffer_pool_size + i, page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: the evicted pages must have been written back.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, std::memcmp(page->GetData(), data[i], PAGE_SIZE));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: pages can be deleted from the instance which holds them.
+  EXPECT_TRUE(bpm->DeletePage(3));
+  EXPECT_TRUE(bpm->IsPageFree(3));
+  EXPECT_NE(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_EQ(3, page_id_temp);
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(ParallelBufferPoolManagerTest, NewPageInPinnedInstanceTest) {
+  const std::string db_name = "pbpm_new_page_test.db";
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 8;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: pages 0 and 4 keep the first instance full, the pages of the other instances can be evicted.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+    EXPECT_EQ(i, page_id_temp);
+  }
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); ++i) {
+    if (i % num_instances != 0) {
+      EXPECT_TRUE(bpm->UnpinPage(i, false));
+    }
+  }
+
+  // Scenario: the lowest free page id 8 belongs to the full instance, the pages are created with the lowest free
+  // page ids of the other instances instead, and page id 8 is given back every time.
+  const std::vector<page_id_t> expected_page_ids = {9, 13, 10, 14, 11, 15};
+  for (auto expected_page_id : expected_page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+    EXPECT_EQ(expected_page_id, page_id_temp);
+  }
+  EXPECT_TRUE(bpm->CheckAllPinned());
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_EQ(1, bpm->GetStats().new_page_failures);
+  EXPECT_TRUE(bpm->IsPageFree(8));
+  EXPECT_TRUE(bpm->IsPageFree(12));
+  EXPECT_TRUE(bpm->IsPageFree(16));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+namespace {
+
+/**
+ * Run num_threads threads, each of which fetches and unpins random resident pages. Every page holds its own id.
+ * @return million operations per second
+ */
+double RunFetchUnpinWorkload(BufferPoolManager *bpm, size_t num_pages, size_t num_threads, size_t ops_per_thread) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([=]() {
+      std::mt19937 rng(t);
+      std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        page_id_t page_id = dist(rng);
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        ASSERT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+        ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return num_threads * ops_per_thread / elapsed.count() / 1e6;
+}
+
+}  // namespace
+
+TEST(ParallelBufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "pbpm_resize_test.db";
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 20;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: every instance is grown, so that pages can be created in all of them.
+  EXPECT_FALSE(bpm->Resize(num_instances - 1));
+  EXPECT_TRUE(bpm->Resize(2 * buffer_pool_size + 1));
+  EXPECT_EQ(2 * buffer_pool_size + 1, bpm->GetPoolSize());
+  EXPECT_EQ(2 * buffer_pool_size + 1, bpm->GetStats().pool_size);
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 2 * buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+  }
+
+  // Scenario: page 7 is pinned in the second frame of the last instance, which shrinks to a single frame anyway.
+  // The page stays valid until it is unpinned, and is written back then.
+  Page *page7 = bpm->FetchPage(7);
+  ASSERT_NE(nullptr, page7);
+  for (page_id_t i = 0; i < static_cast<page_id_t>(2 * buffer_pool_size); ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_TRUE(bpm->Resize(num_instances));
+  EXPECT_EQ(num_instances, bpm->GetPoolSize());
+  EXPECT_EQ(num_instances, bpm->GetStats().pool_size);
+  EXPECT_EQ(1, bpm->GetStats().pinned_pages);
+  memset(page7->GetData(), 7, PAGE_SIZE);
+  EXPECT_TRUE(bpm->UnpinPage(7, true));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  EXPECT_EQ(0, bpm->GetStats().pinned_pages);
+  page7 = bpm->FetchPage(7);
+  ASSERT_NE(nullptr, page7);
+  EXPECT_EQ(7, page7->GetData()[PAGE_SIZE - 1]);
+  EXPECT_TRUE(bpm->UnpinPage(7, false));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(ParallelBufferPoolManagerTest, ConcurrentFetchUnpinBenchmark) {
+  const std::string db_name = "pbpm_bench.db";
+  const size_t buffer_pool_size = 512;
+  const size_t num_instances = 16;
+  const size_t ops_per_thread = 50000;
+  const std::vector<size_t> thread_counts = {1, 2, 4, 8};
+
+  for (size_t instances : {static_cast<size_t>(1), num_instances}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    BufferPoolManager *bpm;
+    if (instances > 1) {
+      bpm = new ParallelBufferPoolManager(instances, buffer_pool_size, disk_manager);
+    } else {
+      bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+    }
+    // Every page stays resident, so that the workload only measures the latch overhead.
+    page_id_t page_id;
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      Page *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      *reinterpret_cast<page_id_t *>(page->GetData()) = page_id;
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+    for (auto num_threads : thread_counts) {
+      double mops = RunFetchUnpinWorkload(bpm, buffer_pool_size, num_threads, ops_per_thread);
+      LOG(INFO) << "instances: " << instances << ", threads: " << num_threads << ", fetch/unpin: " << mops
+                << " Mops/s" << std::endl;
+    }
+    // every fetch found its page, and gave its pin back
+    BufferPoolStats stats = bpm->GetStats();
+    size_t total_ops = 0;
+    for (auto num_threads : thread_counts) {
+      total_ops += num_threads * ops_per_thread;
+    }
+    EXPECT_EQ(total_ops, stats.hits);
+    EXPECT_EQ(0, stats.misses);
+    EXPECT_EQ(0, stats.evictions);
+    EXPECT_EQ(buffer_pool_size, stats.resident_pages);
+    EXPECT_EQ(0, stats.pinned_pages);
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+    delete bpm;
+    delete disk_manager;
+    remove(db_name.c_str());
+  }
+}
@@ -0,0 +1,146 @@
+#include <atomic>
+#include <chrono>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "common/rwlatch.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+TEST(RWLatchTest, HybridLatchExclusionTest) {
+  for (bool prefer_writer : {true, false}) {
+    // Scenario: writers increase two counters which readers must always see equal.
+    HybridReaderWriterLatch latch(prefer_writer);
+    uint64_t first = 0;
+    uint64_t second = 0;
+    std::atomic<size_t> torn{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+      threads.emplace_back([&, i] {
+        for (int j = 0; j < 20000; j++) {
+          if ((i + j) % 4 == 0) {
+            latch.WLock();
+            first++;
+            second++;
+            latch.WUnlock();
+          } else {
+            latch.RLock();
+            if (first != second) {
+              torn++;
+            }
+            latch.RUnlock();
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(0, torn.load());
+    EXPECT_EQ(20000, first);
+  }
+}
+
+TEST(RWLatchTest, HybridLatchWriterPreferenceTest) {
+  for (bool prefer_writer : {true, false}) {
+    HybridReaderWriterLatch latch(prefer_writer);
+    EXPECT_TRUE(latch.TryRLock());
+    EXPECT_TRUE(latch.TryRLock());
+    EXPECT_FALSE(latch.TryWLock());
+    latch.RUnlock();
+
+    // Scenario: a writer waits for the remaining reader, new readers only get in without writer preference.
+    std::atomic<bool> written{false};
+    std::thread writer([&] {
+      latch.WLock();
+      written = true;
+      latch.WUnlock();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(written.load());
+    bool reader_in = latch.TryRLock();
+    EXPECT_EQ(!prefer_writer, reader_in);
+    if (reader_in) {
+      latch.RUnlock();
+    }
+    latch.RUnlock();
+    writer.join();
+    EXPECT_TRUE(written.load());
+    EXPECT_TRUE(latch.TryWLock());
+    EXPECT_FALSE(latch.TryRLock());
+    latch.WUnlock();
+  }
+}
+
+namespace {
+
+/**
+ * @return million latch operations per second, when threads take the latch for reading except for every
+ * write_interval-th operation, and hold it for a few loads and stores of a shared array
+ */
+template <typename Latch, typename RLock, typename RUnlock, typename WLock, typename WUnlock>
+double MeasureLatch(Latch &latch, size_t num_threads, int write_interval, RLock rlock, RUnlock runlock, WLock wlock,
+                    WUnlock wunlock) {
+  const int ops_per_thread = 100000;
+  uint64_t data[8]{};
+  std::atomic<uint64_t> sum{0};
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      uint64_t local = 0;
+      for (int j = 0; j < ops_per_thread; j++) {
+        if (write_interval != 0 && (j + i) % write_interval == 0) {
+          wlock(latch);
+          data[j % 8]++;
+          wunlock(latch);
+        } else {
+          rlock(latch);
+          local += data[j % 8];
+          runlock(latch);
+        }
+      }
+      sum += local;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  // keep the reads from being optimized away
+  EXPECT_NE(~0ULL, sum.load());
+  return 1.0 * num_threads * ops_per_thread /
+         std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+template <typename Latch>
+double MeasureLatch(Latch &latch, size_t num_threads, int write_interval) {
+  return MeasureLatch(latch, num_threads, write_interval, [](Latch &l) { l.RLock(); }, [](Latch &l) { l.RUnlock(); },
+                      [](Latch &l) { l.WLock(); }, [](Latch &l) { l.WUnlock(); });
+}
+
+}  // namespace
+
+TEST(RWLatchTest, ContentionBenchmark) {
+  for (size_t num_threads : {1, 4, 16}) {
+    // read only, mostly reads, and balanced workloads
+    for (int write_interval : {0, 10, 2}) {
+      ReaderWriterLatch mutex_latch;
+      HybridReaderWriterLatch hybrid_latch;
+      HybridReaderWriterLatch reader_latch(false);
+      std::shared_mutex shared_mutex;
+      double mutex_ops = MeasureLatch(mutex_latch, num_threads, write_interval);
+      double hybrid_ops = MeasureLatch(hybrid_latch, num_threads, write_interval);
+      double reader_ops = MeasureLatch(reader_latch, num_threads, write_interval);
+      double shared_mutex_ops = MeasureLatch(
+              shared_mutex, num_threads, write_interval, [](std::shared_mutex &l) { l.lock_shared(); },
+              [](std::shared_mutex &l) { l.unlock_shared(); }, [](std::shared_mutex &l) { l.lock(); },
+              [](std::shared_mutex &l) { l.unlock(); });
+      LOG(INFO) << num_threads << " threads, " << (write_interval == 0 ? 0 : 100 / write_interval)
+                << "% writes (Mops/s): ReaderWriterLatch " << mutex_ops << ", HybridReaderWriterLatch " << hybrid_ops
+                << ", without writer preference " << reader_ops << ", std::shared_mutex " << shared_mutex_ops
+                << std::endl;
+    }
+  }
+}
@@ -78,4 +78,55 @@ TEST(BPlusTreeTests, BPlusTreeIndexSimpleTest) {
     ASSERT_EQ(i, (*iter).second.GetSlotNum());
     i++;
   }
-}
\ No newline at end of file
+}
+
+TEST(BPlusTreeTests, BPlusTreeIndexRollbackTest) {
+  using INDEX_KEY_TYPE = GenericKey<32>;
+  using INDEX_COMPARATOR_TYPE = GenericComparator<32>;
+  using BP_TREE_INDEX = BPlusTreeIndex<INDEX_KEY_TYPE, RowId, INDEX_COMPARATOR_TYPE>;
+  DBStorageEngine engine(db_name);
+  ASSERT_NE(nullptr, engine.txn_mgr_);
+  SimpleMemHeap heap;
+  std::vector<Column *> columns = {ALLOC_COLUMN(heap)("id", TypeId::kTypeInt, 0, false, false)};
+  std::vector<uint32_t> index_key_map{0};
+  const TableSchema table_schema(columns);
+  auto *index_schema = Schema::ShallowCopySchema(&table_schema, index_key_map, &heap);
+  auto *index = ALLOC(heap, BP_TREE_INDEX)(0, index_schema, engine.bpm_);
+  auto make_key = [](int id) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, id)};
+    return Row(fields);
+  };
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(DB_SUCCESS, index->InsertEntry(make_key(i), RowId(1000, i), nullptr));
+  }
+
+  // an aborted transaction leaves the entries as they were before it
+  Transaction *txn = engine.txn_mgr_->Begin();
+  for (int i = 10; i < 20; i++) {
+    ASSERT_EQ(DB_SUCCESS, index->InsertEntry(make_key(i), RowId(1000, i), txn));
+  }
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(DB_SUCCESS, index->RemoveEntry(make_key(i), RowId(1000, i), txn));
+  }
+  // removing an entry which is not there puts nothing back
+  ASSERT_EQ(DB_SUCCESS, index->RemoveEntry(make_key(30), RowId(1000, 30), txn));
+  // an entry inserted and removed again by the transaction is not put back
+  ASSERT_EQ(DB_SUCCESS, index->RemoveEntry(make_key(15), RowId(1000, 15), txn));
+  engine.txn_mgr_->Abort(txn);
+  for (int i = 0; i < 40; i++) {
+    std::vector<RowId> result;
+    if (i < 10) {
+      ASSERT_EQ(DB_SUCCESS, index->ScanKey(make_key(i), result, nullptr)) << "key " << i;
+      ASSERT_EQ(RowId(1000, i).Get(), result[0].Get());
+    } else {
+      ASSERT_EQ(DB_KEY_NOT_FOUND, index->ScanKey(make_key(i), result, nullptr)) << "key " << i;
+    }
+  }
+
+  // a committed transaction keeps its changes
+  txn = engine.txn_mgr_->Begin();
+  ASSERT_EQ(DB_SUCCESS, index->RemoveEntry(make_key(0), RowId(1000, 0), txn));
+  ASSERT_TRUE(engine.txn_mgr_->Commit(txn));
+  std::vector<RowId> result;
+  ASSERT_EQ(DB_KEY_NOT_FOUND, index->ScanKey(make_key(0), result, nullptr));
+}
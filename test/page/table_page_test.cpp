@@ -0,0 +1,81 @@
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "page/table_page.h"
+#include "record/field.h"
+#include "record/row.h"
+#include "record/schema.h"
+
+namespace {
+
+/** A row whose int field is the length of its char field, so that a torn row can be told from a real one. */
+Row MakeRow(const std::string &name) {
+  std::vector<Field> fields = {
+          Field(TypeId::kTypeInt, static_cast<int32_t>(name.size())),
+          Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)
+  };
+  return Row(fields);
+}
+
+}  // namespace
+
+TEST(PageTests, TablePageOptimisticReadTest) {
+  SimpleMemHeap heap;
+  std::vector<Column *> columns = {
+          ALLOC_COLUMN(heap)("length", TypeId::kTypeInt, 0, false, false),
+          ALLOC_COLUMN(heap)("name", TypeId::kTypeChar, 64, 1, false, false)
+  };
+  auto schema = std::make_shared<Schema>(columns);
+  TablePage table_page;
+  table_page.Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+  // a few rows around the one being updated, so that updates of different sizes move it around the page
+  std::vector<RowId> rids;
+  for (int i = 0; i < 8; i++) {
+    Row row = MakeRow(std::string(i + 1, 'a'));
+    ASSERT_TRUE(table_page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+
+  // Scenario: a quiet page is read without falling back to the latch.
+  Row row(rids[3]);
+  ASSERT_TRUE(table_page.GetTupleOptimistic(&row, schema.get(), nullptr, nullptr));
+  Field expected(TypeId::kTypeChar, const_cast<char *>("aaaa"), 4, true);
+  EXPECT_EQ(CmpBool::kTrue, row.GetFields()[1]->CompareEquals(expected));
+  Row missing(RowId(0, 100));
+  EXPECT_FALSE(table_page.GetTupleOptimistic(&missing, schema.get(), nullptr, nullptr));
+
+  // Scenario: a writer keeps resizing the rows while a reader reads them optimistically, every row read must be
+  // one of the rows written.
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    for (int i = 0; i < 20000; i++) {
+      Row new_row = MakeRow(std::string(1 + i % 60, 'a' + i % 26));
+      Row old_row(rids[i % rids.size()]);
+      table_page.WLatch();
+      table_page.UpdateTuple(new_row, &old_row, schema.get(), nullptr, nullptr, nullptr);
+      table_page.WUnlatch();
+    }
+    done = true;
+  });
+  size_t reads = 0;
+  size_t torn = 0;
+  while (!done.load()) {
+    for (auto &rid : rids) {
+      Row read_row(rid);
+      ASSERT_TRUE(table_page.GetTupleOptimistic(&read_row, schema.get(), nullptr, nullptr));
+      auto &fields = read_row.GetFields();
+      Field length(TypeId::kTypeInt, static_cast<int32_t>(fields[1]->GetLength()));
+      if (fields[0]->CompareEquals(length) != CmpBool::kTrue) {
+        torn++;
+      }
+      reads++;
+    }
+  }
+  writer.join();
+  EXPECT_LT(0, reads);
+  EXPECT_EQ(0, torn);
+}
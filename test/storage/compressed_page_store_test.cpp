@@ -0,0 +1,213 @@
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/compressed_page_store.h"
+#include "storage/disk_manager.h"
+#include "storage/lz_page_codec.h"
+
+namespace {
+
+/**
+ * A page of rows like the ones of the account tables, the larger the seed the longer the names.
+ */
+void FillPage(char *data, int seed) {
+  memset(data, 0, PAGE_SIZE);
+  int offset = 0;
+  for (int i = 0; offset + 64 < PAGE_SIZE; i++) {
+    offset += snprintf(data + offset, 64, "name%d|%d|%.2f;", seed * 1000 + i, i, 0.5 * i) + std::min(seed, 16);
+  }
+}
+
+/**
+ * Copy a file as it is, like a crash leaves it behind, the store writing to it is not closed.
+ */
+void CopyFile(const std::string &from, const std::string &to) {
+  std::ifstream in(from, std::ios::binary);
+  std::ofstream out(to, std::ios::binary | std::ios::trunc);
+  out << in.rdbuf();
+}
+
+}  // namespace
+
+TEST(CompressedPageStoreTest, CodecTest) {
+  char page[PAGE_SIZE];
+  char compressed[2 * PAGE_SIZE];
+  char decompressed[PAGE_SIZE];
+  std::mt19937 rng(0);
+  for (int round = 0; round < 100; round++) {
+    if (round % 3 == 0) {
+      for (auto &c : page) {
+        c = static_cast<char>(rng());
+      }
+    } else {
+      FillPage(page, round);
+    }
+    // Scenario: whatever compresses comes back as it was.
+    size_t length = LZPageCodec::Compress(page, PAGE_SIZE, compressed, sizeof(compressed));
+    ASSERT_LT(0, length);
+    if (round % 3 != 0) {
+      EXPECT_GE(CompressedPageStore::MAX_COMPRESSED_SIZE, length);
+    }
+    ASSERT_TRUE(LZPageCodec::Decompress(compressed, length, decompressed, PAGE_SIZE));
+    ASSERT_EQ(0, memcmp(page, decompressed, PAGE_SIZE));
+    // Scenario: a destination too small is reported, a truncated block is rejected.
+    EXPECT_EQ(0, LZPageCodec::Compress(page, PAGE_SIZE, compressed, length - 1));
+    EXPECT_FALSE(LZPageCodec::Decompress(compressed, length / 2, decompressed, PAGE_SIZE));
+  }
+  // a page of zeros is one long match
+  memset(page, 0, PAGE_SIZE);
+  size_t length = LZPageCodec::Compress(page, PAGE_SIZE, compressed, sizeof(compressed));
+  EXPECT_GT(32, length);
+  ASSERT_TRUE(LZPageCodec::Decompress(compressed, length, decompressed, PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(page, decompressed, PAGE_SIZE));
+}
+
+TEST(CompressedPageStoreTest, DiskManagerTest) {
+  std::string db_name = "compressed_page_store_test.db";
+  remove(db_name.c_str());
+  const int num_pages = 200;
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+  std::mt19937 rng(0);
+  auto fill = [&](int i, int seed) {
+    if (seed % 5 == 0) {
+      // incompressible, written to the db file
+      for (auto &c : pages[i]) {
+        c = static_cast<char>(rng());
+      }
+    } else {
+      FillPage(pages[i].data(), seed);
+    }
+  };
+  {
+    auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever, kReadPread, kCompressionLZ);
+    std::vector<std::pair<page_id_t, const char *>> batch;
+    for (int i = 0; i < num_pages; i++) {
+      ASSERT_EQ(i, disk_mgr->AllocatePage());
+      fill(i, i);
+      batch.emplace_back(i, pages[i].data());
+    }
+    disk_mgr->WritePages(batch);
+    EXPECT_EQ(num_pages - num_pages / 5, disk_mgr->GetCompressedPageStore()->GetNumPages());
+    // Scenario: the pages are rewritten with images of other sizes, moving between slots and between the files.
+    for (int i = 0; i < num_pages; i++) {
+      fill(i, i * 7 + 3);
+      disk_mgr->WritePage(i, pages[i].data());
+    }
+    char buf[PAGE_SIZE];
+    for (int i = 0; i < num_pages; i++) {
+      disk_mgr->ReadPage(i, buf);
+      ASSERT_EQ(0, memcmp(pages[i].data(), buf, PAGE_SIZE)) << "page " << i;
+    }
+    // the queue of the flusher and the warm up goes through the store too
+    auto io_queue = disk_mgr->NewIOQueue();
+    EXPECT_FALSE(io_queue->IsAsync());
+    std::vector<PageIOCompletion> completions;
+    ASSERT_TRUE(io_queue->PrepareRead(1, buf, 0));
+    io_queue->Wait(completions, 1);
+    EXPECT_EQ(0, memcmp(pages[1].data(), buf, PAGE_SIZE));
+  }
+  // Scenario: the map is saved with the slot file, the pages survive reopening it, also without asking for
+  // compression, and the freed slots are reused.
+  auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+  ASSERT_NE(nullptr, disk_mgr->GetCompressedPageStore());
+  char buf[PAGE_SIZE];
+  for (int i = 0; i < num_pages; i++) {
+    disk_mgr->ReadPage(i, buf);
+    ASSERT_EQ(0, memcmp(pages[i].data(), buf, PAGE_SIZE)) << "page " << i;
+  }
+  for (int i = 0; i < num_pages; i++) {
+    fill(i, i + 1);
+    disk_mgr->WritePage(i, pages[i].data());
+  }
+  for (int i = 0; i < num_pages; i++) {
+    disk_mgr->ReadPage(i, buf);
+    ASSERT_EQ(0, memcmp(pages[i].data(), buf, PAGE_SIZE)) << "page " << i;
+  }
+  disk_mgr.reset();
+  // Scenario: a new db file drops the compressed pages of the old one.
+  disk_mgr = std::make_unique<DiskManager>(db_name + ".new", kSyncNever);
+  EXPECT_EQ(nullptr, disk_mgr->GetCompressedPageStore());
+  disk_mgr.reset();
+  remove((db_name + ".new").c_str());
+  remove(db_name.c_str());
+  disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+  EXPECT_EQ(nullptr, disk_mgr->GetCompressedPageStore());
+  disk_mgr.reset();
+  remove(db_name.c_str());
+}
+
+TEST(CompressedPageStoreTest, CrashTest) {
+  std::string file_name = "compressed_page_store_test.slots";
+  std::string crash_name = file_name + ".crash";
+  remove(file_name.c_str());
+  const page_id_t max_page_id = 1000;
+  const int num_pages = 100;
+  std::vector<std::vector<char>> synced(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<std::vector<char>> latest(2 * num_pages, std::vector<char>(PAGE_SIZE));
+  char buf[PAGE_SIZE];
+  {
+    CompressedPageStore store(file_name, max_page_id);
+    for (int i = 0; i < num_pages; i++) {
+      FillPage(synced[i].data(), i + 1);
+      ASSERT_TRUE(store.WritePage(i, synced[i].data()));
+    }
+    // Scenario: a crash before the first sync leaves no map, the slots are reused.
+    CopyFile(file_name, crash_name);
+    {
+      CompressedPageStore crashed(crash_name, max_page_id);
+      EXPECT_EQ(0, crashed.GetNumPages());
+      EXPECT_EQ(0, crashed.ReadPage(0, buf));
+      ASSERT_TRUE(crashed.WritePage(0, synced[0].data()));
+      ASSERT_LT(0, crashed.ReadPage(0, buf));
+      EXPECT_EQ(0, memcmp(synced[0].data(), buf, PAGE_SIZE));
+    }
+    store.Sync();
+    // after the sync, the pages are rewritten, in place or in other slots, and new pages take slots at the end of
+    // the file, where a map appended to the slots would be
+    for (int i = 0; i < 2 * num_pages; i++) {
+      FillPage(latest[i].data(), i * 7 + 3);
+      ASSERT_TRUE(store.WritePage(i, latest[i].data()));
+    }
+    CopyFile(file_name, crash_name);
+  }
+  {
+    // Scenario: after a crash, the pages of the synced map are found, as they were then or as rewritten since.
+    CompressedPageStore store(crash_name, max_page_id);
+    EXPECT_EQ(num_pages, store.GetNumPages());
+    for (int i = 0; i < num_pages; i++) {
+      ASSERT_LT(0, store.ReadPage(i, buf));
+      EXPECT_TRUE(memcmp(synced[i].data(), buf, PAGE_SIZE) == 0 || memcmp(latest[i].data(), buf, PAGE_SIZE) == 0)
+          << "page " << i;
+    }
+    for (int i = num_pages; i < 2 * num_pages; i++) {
+      EXPECT_EQ(0, store.ReadPage(i, buf)) << "page " << i;
+    }
+    for (int i = 0; i < 2 * num_pages; i++) {
+      ASSERT_TRUE(store.WritePage(i, latest[i].data()));
+    }
+  }
+  {
+    // the store goes on from the recovered map, and is closed this time
+    CompressedPageStore store(crash_name, max_page_id);
+    EXPECT_EQ(2 * num_pages, store.GetNumPages());
+    for (int i = 0; i < 2 * num_pages; i++) {
+      ASSERT_LT(0, store.ReadPage(i, buf));
+      ASSERT_EQ(0, memcmp(latest[i].data(), buf, PAGE_SIZE)) << "page " << i;
+    }
+  }
+  // Scenario: a map pointing beyond the end of a truncated file is rejected as a whole.
+  ASSERT_EQ(0, truncate(crash_name.c_str(), 4 * CompressedPageStore::SLOT_SIZE));
+  {
+    CompressedPageStore store(crash_name, max_page_id);
+    EXPECT_EQ(0, store.GetNumPages());
+    EXPECT_EQ(0, store.ReadPage(0, buf));
+  }
+  remove(file_name.c_str());
+  remove(crash_name.c_str());
+}
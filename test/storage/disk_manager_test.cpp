@@ -1,5 +1,14 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sys/stat.h>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
+#include "glog/logging.h"
 #include "gtest/gtest.h"
 #include "storage/disk_manager.h"
 
@@ -56,4 +65,306 @@ TEST(DiskManagerTest, FreePageAllocationTest) {
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 2, meta_page->GetExtentUsedPage(0));
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 3, meta_page->GetExtentUsedPage(1));
   remove(db_name.c_str());
-}
\ No newline at end of file
+}
+
+TEST(DiskManagerTest, PositionalIOTest) {
+  std::string db_name = "disk_io_test.db";
+  remove(db_name.c_str());
+  const int num_pages = 64;
+  char data[PAGE_SIZE];
+  char buf[PAGE_SIZE];
+  {
+    auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncAlways);
+    for (int i = 0; i < num_pages; i++) {
+      ASSERT_EQ(i, disk_mgr->AllocatePage());
+      memset(data, 'a' + i % 26, PAGE_SIZE);
+      disk_mgr->WritePage(i, data);
+    }
+    EXPECT_EQ(num_pages, disk_mgr->GetNumSyncs());
+    // Scenario: a page beyond the end of the file reads as zeros.
+    memset(buf, 1, PAGE_SIZE);
+    disk_mgr->ReadPage(num_pages + 10, buf);
+    memset(data, 0, PAGE_SIZE);
+    EXPECT_EQ(0, memcmp(buf, data, PAGE_SIZE));
+
+    // Scenario: threads read different pages at the same time.
+    std::vector<std::thread> readers;
+    std::atomic<int> errors{0};
+    for (int t = 0; t < 4; t++) {
+      readers.emplace_back([&, t] {
+        char page[PAGE_SIZE];
+        for (int round = 0; round < 20; round++) {
+          for (int i = t; i < num_pages; i += 2) {
+            disk_mgr->ReadPage(i, page);
+            if (page[0] != 'a' + i % 26 || page[PAGE_SIZE - 1] != 'a' + i % 26) {
+              errors++;
+            }
+          }
+        }
+      });
+    }
+    for (auto &reader : readers) {
+      reader.join();
+    }
+    EXPECT_EQ(0, errors.load());
+  }
+
+  // Scenario: the pages and the allocation survive reopening the file.
+  {
+    auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+    DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+    EXPECT_EQ(num_pages, meta_page->GetAllocatedPages());
+    for (int i = 0; i < num_pages; i++) {
+      disk_mgr->ReadPage(i, buf);
+      memset(data, 'a' + i % 26, PAGE_SIZE);
+      ASSERT_EQ(0, memcmp(buf, data, PAGE_SIZE));
+    }
+    disk_mgr->WritePages({{0, data}, {1, data}});
+    EXPECT_EQ(0, disk_mgr->GetNumSyncs());
+  }
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, VectoredWriteTest) {
+  std::string db_name = "disk_writev_test.db";
+  remove(db_name.c_str());
+  auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+  const page_id_t num_pages = DiskManager::BITMAP_SIZE + 2;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+  }
+  // Scenario: a batch in random order, with a long run, a short run, a single page, and two pages which are
+  // adjacent logically but separated by the bitmap page of the second extent.
+  std::vector<page_id_t> page_ids;
+  for (page_id_t i = 10; i < 10 + 2000; i++) {
+    page_ids.push_back(i);
+  }
+  std::vector<page_id_t> others = {3000, 3001, 5000, DiskManager::BITMAP_SIZE - 1, DiskManager::BITMAP_SIZE};
+  page_ids.insert(page_ids.end(), others.begin(), others.end());
+  std::vector<std::vector<char>> data;
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (auto page_id : page_ids) {
+    data.emplace_back(PAGE_SIZE, static_cast<char>('a' + page_id % 26));
+  }
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    pages.emplace_back(page_ids[i], data[i].data());
+  }
+  std::reverse(pages.begin(), pages.end());
+  uint64_t writes = disk_mgr->GetNumWrites();
+  disk_mgr->WritePages(pages);
+  // the long run is split at IOV_MAX pages, the pages on both sides of the bitmap page are written separately
+  EXPECT_EQ(2 + 1 + 1 + 2, disk_mgr->GetNumWrites() - writes);
+  char buf[PAGE_SIZE];
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    disk_mgr->ReadPage(page_ids[i], buf);
+    ASSERT_EQ(0, memcmp(data[i].data(), buf, PAGE_SIZE));
+  }
+  // the pages in between are still zeros
+  disk_mgr->ReadPage(9, buf);
+  EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), std::vector<char>(buf, buf + PAGE_SIZE));
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, AllocationReopenTest) {
+  std::string db_name = "disk_alloc_test.db";
+  remove(db_name.c_str());
+  const page_id_t num_pages = DiskManager::BITMAP_SIZE + 100;
+  std::vector<page_id_t> freed = {5, 64, 65, DiskManager::BITMAP_SIZE - 1, DiskManager::BITMAP_SIZE + 7};
+  {
+    auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+    for (page_id_t i = 0; i < num_pages; i++) {
+      ASSERT_EQ(i, disk_mgr->AllocatePage());
+    }
+    for (auto page_id : freed) {
+      disk_mgr->DeAllocatePage(page_id);
+    }
+  }
+  // Scenario: the bitmaps survive reopening the file, the freed pages are allocated again first, lowest first.
+  auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+  DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(num_pages - freed.size(), meta_page->GetAllocatedPages());
+  EXPECT_EQ(2, meta_page->GetExtentNums());
+  for (page_id_t i = 0; i < num_pages + 10; i++) {
+    bool is_freed = std::find(freed.begin(), freed.end(), i) != freed.end();
+    ASSERT_EQ(is_freed || i >= num_pages, disk_mgr->IsPageFree(i));
+  }
+  for (auto page_id : freed) {
+    EXPECT_EQ(page_id, disk_mgr->AllocatePage());
+  }
+  EXPECT_EQ(num_pages, disk_mgr->AllocatePage());
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, FormatVersionTest) {
+  std::string db_name = "disk_format_test.db";
+  remove(db_name.c_str());
+  const page_id_t num_pages = 200;
+  std::vector<page_id_t> freed = {3, 70, 150};
+  {
+    auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+    for (page_id_t i = 0; i < num_pages; i++) {
+      ASSERT_EQ(i, disk_mgr->AllocatePage());
+    }
+    for (auto page_id : freed) {
+      disk_mgr->DeAllocatePage(page_id);
+    }
+    auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+    disk_mgr->FlushMetaData();
+    EXPECT_EQ(DISK_FILE_FORMAT_VERSION, meta_page->GetFormatVersion());
+  }
+  auto patch = [&db_name](size_t offset, std::vector<uint32_t> words) {
+    std::fstream file(db_name, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char *>(words.data()), words.size() * sizeof(uint32_t));
+  };
+
+  // Scenario: the file is opened again as it is.
+  {
+    auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+    auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+    EXPECT_EQ(num_pages - freed.size(), meta_page->GetAllocatedPages());
+    for (auto page_id : freed) {
+      EXPECT_EQ(page_id, disk_mgr->AllocatePage());
+    }
+  }
+
+  // Scenario: a file of version 0 has neither magic nor version, its table pages have a shorter LSN. It is rejected.
+  patch(PAGE_SIZE - 2 * sizeof(uint32_t), {0, 0});
+  EXPECT_ANY_THROW(std::make_unique<DiskManager>(db_name, kSyncNever));
+
+  // Scenario: a file of version 1 is rejected for the same reason.
+  patch(PAGE_SIZE - 2 * sizeof(uint32_t), {DISK_FILE_MAGIC, 1});
+  EXPECT_ANY_THROW(std::make_unique<DiskManager>(db_name, kSyncNever));
+
+  // Scenario: a file of a newer version is rejected.
+  patch(PAGE_SIZE - 2 * sizeof(uint32_t), {DISK_FILE_MAGIC, DISK_FILE_FORMAT_VERSION + 1});
+  EXPECT_ANY_THROW(std::make_unique<DiskManager>(db_name, kSyncNever));
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, AllocationBenchmark) {
+  std::string db_name = "disk_alloc_bench.db";
+  remove(db_name.c_str());
+  const size_t num_pages = 1 << 20;
+  const size_t chunk = num_pages / 4;
+  {
+    auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+    // the pages are never written, don't reserve gigabytes for them
+    disk_mgr->SetPreallocationPages(0);
+    // the time per allocation should not grow with the number of allocated pages
+    for (size_t begin = 0; begin < num_pages; begin += chunk) {
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = begin; i < begin + chunk; i++) {
+        ASSERT_EQ(static_cast<page_id_t>(i), disk_mgr->AllocatePage());
+      }
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      LOG(INFO) << "pages " << begin << " to " << begin + chunk << ": "
+                << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / chunk << " ns/allocation"
+                << std::endl;
+    }
+    // free pages spread over the file, and allocate them again
+    std::mt19937 rng(0);
+    std::vector<page_id_t> freed;
+    for (int i = 0; i < 10000; i++) {
+      page_id_t page_id = rng() % num_pages;
+      if (!disk_mgr->IsPageFree(page_id)) {
+        disk_mgr->DeAllocatePage(page_id);
+        freed.push_back(page_id);
+      }
+    }
+    std::sort(freed.begin(), freed.end());
+    auto start = std::chrono::steady_clock::now();
+    for (auto page_id : freed) {
+      ASSERT_EQ(page_id, disk_mgr->AllocatePage());
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    LOG(INFO) << "reallocating " << freed.size() << " scattered pages: "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / freed.size()
+              << " ns/allocation" << std::endl;
+  }
+  remove(db_name.c_str());
+}
+
+namespace {
+
+size_t GetFileSize(const std::string &file_name) {
+  struct stat stat_buf;
+  return stat(file_name.c_str(), &stat_buf) == 0 ? stat_buf.st_size : 0;
+}
+
+}  // namespace
+
+TEST(DiskManagerTest, PreallocationTest) {
+  std::string db_name = "disk_prealloc_test.db";
+  remove(db_name.c_str());
+  const uint32_t chunk_pages = 64;
+  const size_t chunk_size = chunk_pages * PAGE_SIZE;
+  char data[PAGE_SIZE];
+  char buf[PAGE_SIZE];
+  {
+    auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+    disk_mgr->SetPreallocationPages(chunk_pages);
+    // Scenario: the file grows a chunk at a time, ahead of the writes.
+    for (page_id_t i = 0; i < 100; i++) {
+      ASSERT_EQ(i, disk_mgr->AllocatePage());
+      memset(data, 'a' + i % 26, PAGE_SIZE);
+      disk_mgr->WritePage(i, data);
+      // pages 0 to 99 are physical pages 2 to 101
+      size_t chunks = (i + 2) / chunk_pages + 1;
+      ASSERT_EQ(chunks, disk_mgr->GetNumPreallocations());
+      ASSERT_EQ(chunks * chunk_size, GetFileSize(db_name));
+    }
+    // the preallocated pages which are not written yet read as zeros
+    page_id_t page_id = disk_mgr->AllocatePage();
+    disk_mgr->ReadPage(page_id, buf);
+    EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), std::vector<char>(buf, buf + PAGE_SIZE));
+
+    // Scenario: opening a new extent preallocates its bitmap page and first page, i.e. physical pages BITMAP_SIZE + 2
+    // and BITMAP_SIZE + 3.
+    for (page_id_t i = page_id + 1; i < static_cast<page_id_t>(DiskManager::BITMAP_SIZE); i++) {
+      ASSERT_EQ(i, disk_mgr->AllocatePage());
+    }
+    ASSERT_EQ(DiskManager::BITMAP_SIZE, disk_mgr->AllocatePage());
+    EXPECT_LE((DiskManager::BITMAP_SIZE + 4) * PAGE_SIZE, GetFileSize(db_name));
+    EXPECT_EQ(0, GetFileSize(db_name) % chunk_size);
+    disk_mgr->WritePage(DiskManager::BITMAP_SIZE, data);
+  }
+  // Scenario: the pages survive reopening the file, the preallocated space is not reserved again.
+  auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+  disk_mgr->SetPreallocationPages(chunk_pages);
+  disk_mgr->ReadPage(DiskManager::BITMAP_SIZE, buf);
+  EXPECT_EQ(0, memcmp(data, buf, PAGE_SIZE));
+  disk_mgr->ReadPage(50, buf);
+  EXPECT_EQ(std::vector<char>(PAGE_SIZE, 'a' + 50 % 26), std::vector<char>(buf, buf + PAGE_SIZE));
+  EXPECT_EQ(DiskManager::BITMAP_SIZE + 1, disk_mgr->AllocatePage());
+  EXPECT_EQ(0, disk_mgr->GetNumPreallocations());
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, PreallocationBenchmark) {
+  std::string db_name = "disk_prealloc_bench.db";
+  const int num_pages = 20000;
+  char data[PAGE_SIZE];
+  memset(data, 'x', PAGE_SIZE);
+  for (uint32_t preallocation_pages : {0u, PREALLOCATION_PAGES}) {
+    remove(db_name.c_str());
+    auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+    disk_mgr->SetPreallocationPages(preallocation_pages);
+    // an insert heavy workload, every page is allocated and appended to the file
+    std::vector<int64_t> latencies;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_pages; i++) {
+      auto append_start = std::chrono::steady_clock::now();
+      disk_mgr->WritePage(disk_mgr->AllocatePage(), data);
+      latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - append_start).count());
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::sort(latencies.begin(), latencies.end());
+    LOG(INFO) << "preallocating " << preallocation_pages << " pages: "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / num_pages
+              << " ns/append, p50 " << latencies[num_pages / 2] << " ns, p99 " << latencies[num_pages * 99 / 100]
+              << " ns, max " << latencies.back() << " ns" << std::endl;
+  }
+  remove(db_name.c_str());
+}
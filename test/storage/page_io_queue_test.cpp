@@ -0,0 +1,125 @@
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "storage/disk_manager.h"
+
+TEST(PageIOQueueTest, ReadWriteTest) {
+  std::string db_name = "page_io_queue_test.db";
+  remove(db_name.c_str());
+  const int num_pages = 100;
+  auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+  for (int i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+  }
+  for (bool use_io_uring : {true, false}) {
+    auto io_queue = disk_mgr->NewIOQueue(8, use_io_uring);
+    std::vector<char> data(num_pages * PAGE_SIZE);
+    for (int i = 0; i < num_pages; i++) {
+      memset(&data[i * PAGE_SIZE], use_io_uring ? 'a' + i % 26 : 'A' + i % 26, PAGE_SIZE);
+    }
+    // Scenario: more writes than the queue depth, the queue refuses the ones which don't fit.
+    std::vector<PageIOCompletion> completions;
+    for (int i = 0; i < num_pages; i++) {
+      while (!io_queue->PrepareWrite(i, &data[i * PAGE_SIZE], i)) {
+        EXPECT_EQ(8, io_queue->GetPending());
+        io_queue->Wait(completions, 1);
+      }
+    }
+    io_queue->Wait(completions, io_queue->GetPending());
+    EXPECT_EQ(0, io_queue->GetPending());
+    ASSERT_EQ(num_pages, completions.size());
+    std::vector<bool> done(num_pages, false);
+    for (auto &completion : completions) {
+      EXPECT_TRUE(completion.ok);
+      done[completion.tag] = true;
+    }
+    EXPECT_EQ(std::vector<bool>(num_pages, true), done);
+
+    // Scenario: the pages read back through the queue and directly are the ones written, a page beyond the end of
+    // the file reads as zeros.
+    std::vector<char> buf((num_pages + 1) * PAGE_SIZE, 1);
+    completions.clear();
+    for (int i = 0; i <= num_pages; i++) {
+      while (!io_queue->PrepareRead(i + (i == num_pages ? 1000 : 0), &buf[i * PAGE_SIZE], i)) {
+        io_queue->Wait(completions, 1);
+      }
+    }
+    io_queue->Wait(completions, io_queue->GetPending());
+    EXPECT_EQ(num_pages + 1, completions.size());
+    EXPECT_EQ(0, memcmp(data.data(), buf.data(), num_pages * PAGE_SIZE));
+    EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), std::vector<char>(buf.end() - PAGE_SIZE, buf.end()));
+    char page[PAGE_SIZE];
+    disk_mgr->ReadPage(num_pages - 1, page);
+    EXPECT_EQ(0, memcmp(&data[(num_pages - 1) * PAGE_SIZE], page, PAGE_SIZE));
+  }
+  remove(db_name.c_str());
+}
+
+namespace {
+
+/**
+ * @return MB/s of random page reads, keeping queue_depth reads in flight
+ */
+double MeasureReads(DiskManager &disk_mgr, size_t queue_depth, bool use_io_uring, int num_pages) {
+  auto io_queue = disk_mgr.NewIOQueue(queue_depth, use_io_uring);
+  const int num_reads = 20000;
+  std::mt19937 rng(0);
+  std::vector<char> buf(queue_depth * PAGE_SIZE);
+  std::vector<PageIOCompletion> completions;
+  std::vector<size_t> free_buffers;
+  for (size_t i = 0; i < queue_depth; i++) {
+    free_buffers.push_back(i);
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_reads; i++) {
+    if (free_buffers.empty()) {
+      completions.clear();
+      io_queue->Wait(completions, 1);
+      for (auto &completion : completions) {
+        free_buffers.push_back(completion.tag);
+      }
+    }
+    size_t buffer = free_buffers.back();
+    free_buffers.pop_back();
+    io_queue->PrepareRead(rng() % num_pages, &buf[buffer * PAGE_SIZE], buffer);
+    // submit in batches as large as the queue, which is how the flusher and the warm up use it
+    if (free_buffers.empty()) {
+      io_queue->Submit();
+    }
+  }
+  completions.clear();
+  io_queue->Wait(completions, io_queue->GetPending());
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return 1.0 * num_reads * PAGE_SIZE / std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+}  // namespace
+
+TEST(PageIOQueueTest, QueueDepthBenchmark) {
+  std::string db_name = "page_io_queue_benchmark.db";
+  remove(db_name.c_str());
+  const int num_pages = 4096;
+  {
+    auto disk_mgr = std::make_unique<DiskManager>(db_name, kSyncNever);
+    char data[PAGE_SIZE];
+    memset(data, 'x', PAGE_SIZE);
+    std::vector<std::pair<page_id_t, const char *>> pages;
+    for (int i = 0; i < num_pages; i++) {
+      pages.emplace_back(disk_mgr->AllocatePage(), data);
+    }
+    disk_mgr->WritePages(pages);
+    LOG_IF(WARNING, !disk_mgr->NewIOQueue(1)->IsAsync()) << "io_uring is not available, both runs use pread";
+    for (size_t queue_depth : {1, 4, 16, 64}) {
+      double sync_mbps = MeasureReads(*disk_mgr, queue_depth, false, num_pages);
+      double io_uring_mbps = MeasureReads(*disk_mgr, queue_depth, true, num_pages);
+      LOG(INFO) << "queue depth " << queue_depth << ": io_uring " << io_uring_mbps << " MB/s, pread "
+                << sync_mbps << " MB/s" << std::endl;
+    }
+  }
+  remove(db_name.c_str());
+}
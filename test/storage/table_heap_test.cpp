@@ -1,3 +1,8 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
 #include <vector>
 #include <unordered_map>
 
@@ -52,5 +57,360 @@ TEST(TableHeapTest, TableHeapSampleTest) {
     // free spaces
     delete row_kv.second;
   }
+
+  // a scan sees every row, and gives back every page it pinned
+  size_t num_rows = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+    num_rows++;
+  }
+  ASSERT_EQ(row_nums, num_rows);
+  ASSERT_TRUE(engine.bpm_->CheckAllUnpinned());
+}
+
+
+namespace {
+
+/**
+ * A buffer pool which ignores read ahead hints.
+ */
+class NoPrefetchBufferPoolManager : public BufferPoolManagerInstance {
+public:
+  NoPrefetchBufferPoolManager(size_t pool_size, DiskManager *disk_manager)
+          : BufferPoolManagerInstance(pool_size, disk_manager) {}
+
+  void PrefetchChain(page_id_t, size_t, std::function<page_id_t(Page *)>, std::shared_ptr<BufferRing>) override {}
+};
+
+/**
+ * Parse the insert statements of data/account*.txt, e.g. insert into account values(12500000, "name0", 514.35);
+ */
+bool LoadAccounts(std::vector<std::tuple<int32_t, std::string, float>> &accounts) {
+  for (int i = 0; i < 10; i++) {
+    char file_name[64];
+    snprintf(file_name, sizeof(file_name), "%saccount%02d.txt", TEST_DATA_DIR, i);
+    std::ifstream in(file_name);
+    if (!in.is_open()) {
+      return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+      int32_t id;
+      char name[64];
+      float balance;
+      if (sscanf(line.c_str(), "insert into account values(%d, \"%63[^\"]\", %f);", &id, name, &balance) == 3) {
+        accounts.emplace_back(id, name, balance);
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Insert the accounts into a new table heap, with a pool large enough to hold the whole table.
+ * @return the first page id of the table heap
+ */
+page_id_t BuildAccountTable(DiskManager *disk_manager, Schema *schema, MemHeap *heap,
+                            const std::vector<std::tuple<int32_t, std::string, float>> &accounts) {
+  const size_t load_pool_size = 4096;
+  auto *bpm = new BufferPoolManagerInstance(load_pool_size, disk_manager);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema, nullptr, nullptr, nullptr, heap);
+  for (auto &account : accounts) {
+    std::string name = std::get<1>(account);
+    Fields fields{
+            Field(TypeId::kTypeInt, std::get<0>(account)),
+            Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true),
+            Field(TypeId::kTypeFloat, std::get<2>(account))
+    };
+    Row row(fields);
+    EXPECT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  delete bpm;
+  return first_page_id;
+}
+
+}  // namespace
+
+TEST(TableHeapTest, SequentialScanReadAheadBenchmark) {
+  const std::string db_name = "table_heap_scan_bench.db";
+  const size_t scan_pool_size = 256;
+  SimpleMemHeap heap;
+  std::vector<std::tuple<int32_t, std::string, float>> accounts;
+  if (!LoadAccounts(accounts)) {
+    GTEST_SKIP() << "data set not found";
+  }
+  std::vector<Column *> columns = {
+          ALLOC_COLUMN(heap)("id", TypeId::kTypeInt, 0, true, false),
+          ALLOC_COLUMN(heap)("name", TypeId::kTypeChar, 16, 1, false, false),
+          ALLOC_COLUMN(heap)("balance", TypeId::kTypeFloat, 2, false, false)
+  };
+  auto schema = std::make_shared<Schema>(columns);
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  page_id_t first_page_id = BuildAccountTable(disk_manager, schema.get(), &heap, accounts);
+
+  // Scan the table with a pool much smaller than the table, with and without read ahead.
+  for (bool read_ahead : {false, true}) {
+    BufferPoolManager *bpm;
+    if (read_ahead) {
+      bpm = new BufferPoolManagerInstance(scan_pool_size, disk_manager);
+    } else {
+      bpm = new NoPrefetchBufferPoolManager(scan_pool_size, disk_manager);
+    }
+    TableHeap *table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr, &heap);
+    auto start = std::chrono::steady_clock::now();
+    // rows come back in the order they were inserted
+    size_t num_rows = 0;
+    size_t num_matched = 0;
+    for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+      if (num_rows < accounts.size() &&
+          iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, std::get<0>(accounts[num_rows]))) == CmpBool::kTrue) {
+        num_matched++;
+      }
+      num_rows++;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(accounts.size(), num_rows);
+    EXPECT_EQ(accounts.size(), num_matched);
+    LOG(INFO) << "read ahead: " << (read_ahead ? "on" : "off") << ", rows: " << num_rows << ", scan: "
+              << elapsed.count() * 1000 << " ms, pages read ahead: " << bpm->GetPrefetchCount() << std::endl;
+    if (read_ahead) {
+      EXPECT_GT(bpm->GetPrefetchCount(), 0);
+    }
+    delete bpm;
+  }
+  delete disk_manager;
+  remove(db_name.c_str());
 }
 
+TEST(TableHeapTest, BulkReadPointLookupHitRateTest) {
+  const std::string db_name = "table_heap_ring_test.db";
+  const size_t pool_size = 128;
+  const page_id_t hot_pages = 64;
+  const size_t rows_between_lookups = 500;
+  SimpleMemHeap heap;
+  std::vector<std::tuple<int32_t, std::string, float>> accounts;
+  if (!LoadAccounts(accounts)) {
+    GTEST_SKIP() << "data set not found";
+  }
+  std::vector<Column *> columns = {
+          ALLOC_COLUMN(heap)("id", TypeId::kTypeInt, 0, true, false),
+          ALLOC_COLUMN(heap)("name", TypeId::kTypeChar, 16, 1, false, false),
+          ALLOC_COLUMN(heap)("balance", TypeId::kTypeFloat, 2, false, false)
+  };
+  auto schema = std::make_shared<Schema>(columns);
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  page_id_t first_page_id = BuildAccountTable(disk_manager, schema.get(), &heap, accounts);
+
+  // The hot pages stand for index and catalog pages, which are looked up while a large scan runs.
+  std::vector<page_id_t> hot_page_ids;
+  {
+    auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+    for (page_id_t i = 0; i < hot_pages; i++) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPage(page_id));
+      bpm->UnpinPage(page_id, true);
+      hot_page_ids.push_back(page_id);
+    }
+    delete bpm;
+  }
+
+  double hit_rates[2];
+  for (AccessStrategy strategy : {kNormalAccess, kBulkReadAccess}) {
+    // read ahead is left out, its reads would be mixed up with the ones of the lookups
+    auto *bpm = new NoPrefetchBufferPoolManager(pool_size, disk_manager);
+    TableHeap *table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr, &heap);
+    for (auto page_id : hot_page_ids) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      bpm->UnpinPage(page_id, false);
+    }
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<size_t> dist(0, hot_page_ids.size() - 1);
+    size_t num_rows = 0;
+    size_t lookups = 0;
+    size_t hits = 0;
+    for (auto iter = table_heap->Begin(nullptr, strategy); iter != table_heap->End(); ++iter) {
+      if (++num_rows % rows_between_lookups == 0) {
+        // a lookup is a hit if it does not read the disk
+        uint64_t num_reads = disk_manager->GetNumReads();
+        page_id_t page_id = hot_page_ids[dist(rng)];
+        ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+        bpm->UnpinPage(page_id, false);
+        hits += disk_manager->GetNumReads() == num_reads;
+        lookups++;
+      }
+    }
+    EXPECT_EQ(accounts.size(), num_rows);
+    hit_rates[strategy] = 1.0 * hits / lookups;
+    LOG(INFO) << "strategy: " << (strategy == kBulkReadAccess ? "bulk read" : "normal") << ", lookups: " << lookups
+              << ", point lookup hit rate: " << hit_rates[strategy] << std::endl;
+    delete bpm;
+  }
+  // the scan wipes the hot pages out of the shared pool, but not out of the one with a buffer ring
+  EXPECT_GT(hit_rates[kBulkReadAccess], hit_rates[kNormalAccess]);
+  EXPECT_GT(hit_rates[kBulkReadAccess], 0.95);
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, BulkReadScanStaysInRingTest) {
+  const std::string db_name = "table_heap_ring_scan_test.db";
+  const page_id_t hot_pages = 48;
+  const size_t pool_size = hot_pages + BUFFER_RING_SIZE;
+  const int num_accounts = 20000;
+  SimpleMemHeap heap;
+  std::vector<std::tuple<int32_t, std::string, float>> accounts;
+  for (int i = 0; i < num_accounts; i++) {
+    accounts.emplace_back(i, "name" + std::to_string(i), 1.0f * i);
+  }
+  std::vector<Column *> columns = {
+          ALLOC_COLUMN(heap)("id", TypeId::kTypeInt, 0, true, false),
+          ALLOC_COLUMN(heap)("name", TypeId::kTypeChar, 16, 1, false, false),
+          ALLOC_COLUMN(heap)("balance", TypeId::kTypeFloat, 2, false, false)
+  };
+  auto schema = std::make_shared<Schema>(columns);
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  page_id_t first_page_id = BuildAccountTable(disk_manager, schema.get(), &heap, accounts);
+  std::vector<page_id_t> hot_page_ids;
+  {
+    auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+    for (page_id_t i = 0; i < hot_pages; i++) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPage(page_id));
+      bpm->UnpinPage(page_id, true);
+      hot_page_ids.push_back(page_id);
+    }
+    delete bpm;
+  }
+
+  // Scenario: the hot pages are the most recently used ones, the ring takes all the other frames of the pool. A scan
+  // which takes a single frame outside of its ring, e.g. for its first page, makes the ring evict a hot page.
+  auto *bpm = new NoPrefetchBufferPoolManager(pool_size, disk_manager);
+  TableHeap *table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr, &heap);
+  for (auto page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+  uint64_t scan_reads = disk_manager->GetNumReads();
+  size_t num_rows = 0;
+  for (auto iter = table_heap->Begin(nullptr, kBulkReadAccess); iter != table_heap->End(); ++iter) {
+    num_rows++;
+  }
+  EXPECT_EQ(accounts.size(), num_rows);
+  scan_reads = disk_manager->GetNumReads() - scan_reads;
+  EXPECT_GT(scan_reads, pool_size);
+  uint64_t num_reads = disk_manager->GetNumReads();
+  for (auto page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+  EXPECT_EQ(num_reads, disk_manager->GetNumReads());
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, MmapScanBenchmark) {
+  const std::string db_name = "table_heap_mmap_bench.db";
+  const size_t scan_pool_size = 256;
+  SimpleMemHeap heap;
+  std::vector<std::tuple<int32_t, std::string, float>> accounts;
+  if (!LoadAccounts(accounts)) {
+    GTEST_SKIP() << "data set not found";
+  }
+  std::vector<Column *> columns = {
+          ALLOC_COLUMN(heap)("id", TypeId::kTypeInt, 0, true, false),
+          ALLOC_COLUMN(heap)("name", TypeId::kTypeChar, 16, 1, false, false),
+          ALLOC_COLUMN(heap)("balance", TypeId::kTypeFloat, 2, false, false)
+  };
+  auto schema = std::make_shared<Schema>(columns);
+  remove(db_name.c_str());
+  page_id_t first_page_id;
+  {
+    auto disk_manager = std::make_unique<DiskManager>(db_name);
+    first_page_id = BuildAccountTable(disk_manager.get(), schema.get(), &heap, accounts);
+  }
+
+  // Scan the table from a reopened file with a pool much smaller than the table, so that every page is read.
+  for (DiskReadMode read_mode : {kReadPread, kReadMmap}) {
+    auto disk_manager = std::make_unique<DiskManager>(db_name, kSyncOnCheckpoint, read_mode);
+    auto *bpm = new NoPrefetchBufferPoolManager(scan_pool_size, disk_manager.get());
+    TableHeap *table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr, &heap);
+    auto start = std::chrono::steady_clock::now();
+    size_t num_rows = 0;
+    for (auto iter = table_heap->Begin(nullptr, kBulkReadAccess); iter != table_heap->End(); ++iter) {
+      num_rows++;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(accounts.size(), num_rows);
+    if (read_mode == kReadMmap) {
+      EXPECT_EQ(disk_manager->GetNumReads(), disk_manager->GetNumMappedReads());
+    } else {
+      EXPECT_EQ(0, disk_manager->GetNumMappedReads());
+    }
+    LOG(INFO) << "read mode: " << (read_mode == kReadMmap ? "mmap" : "pread") << ", rows: " << num_rows
+              << ", scan: " << elapsed.count() * 1000 << " ms, pages read: " << disk_manager->GetNumReads()
+              << std::endl;
+    delete bpm;
+  }
+  remove(db_name.c_str());
+}
+
+TEST(TableHeapTest, CompressedScanBenchmark) {
+  const std::string db_name = "table_heap_compressed_bench.db";
+  const size_t scan_pool_size = 256;
+  SimpleMemHeap heap;
+  std::vector<std::tuple<int32_t, std::string, float>> accounts;
+  if (!LoadAccounts(accounts)) {
+    GTEST_SKIP() << "data set not found";
+  }
+  std::vector<Column *> columns = {
+          ALLOC_COLUMN(heap)("id", TypeId::kTypeInt, 0, true, false),
+          ALLOC_COLUMN(heap)("name", TypeId::kTypeChar, 16, 1, false, false),
+          ALLOC_COLUMN(heap)("balance", TypeId::kTypeFloat, 2, false, false)
+  };
+  auto schema = std::make_shared<Schema>(columns);
+
+  // Scan the table from a reopened file with a pool much smaller than the table, so that every page is read.
+  for (PageCompression compression : {kCompressionNone, kCompressionLZ}) {
+    remove(db_name.c_str());
+    page_id_t first_page_id;
+    {
+      auto disk_manager = std::make_unique<DiskManager>(db_name, kSyncOnCheckpoint, kReadPread, compression);
+      first_page_id = BuildAccountTable(disk_manager.get(), schema.get(), &heap, accounts);
+    }
+    auto disk_manager = std::make_unique<DiskManager>(db_name);
+    auto *bpm = new NoPrefetchBufferPoolManager(scan_pool_size, disk_manager.get());
+    TableHeap *table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr, &heap);
+    auto start = std::chrono::steady_clock::now();
+    size_t num_rows = 0;
+    for (auto iter = table_heap->Begin(nullptr, kBulkReadAccess); iter != table_heap->End(); ++iter) {
+      // the rows come back intact, in the order they were inserted
+      ASSERT_LT(num_rows, accounts.size());
+      ASSERT_EQ(CmpBool::kTrue,
+                iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, std::get<0>(accounts[num_rows]))));
+      num_rows++;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(accounts.size(), num_rows);
+    size_t compressed_pages = 0;
+    if (compression == kCompressionLZ) {
+      // the slot file is found again when the db file is reopened
+      ASSERT_NE(nullptr, disk_manager->GetCompressedPageStore());
+      compressed_pages = disk_manager->GetCompressedPageStore()->GetNumPages();
+      EXPECT_LT(0, compressed_pages);
+    } else {
+      EXPECT_EQ(nullptr, disk_manager->GetCompressedPageStore());
+    }
+    LOG(INFO) << "compression: " << (compression == kCompressionLZ ? "lz" : "none") << ", rows: " << num_rows
+              << ", compressed pages: " << compressed_pages << ", scan: " << elapsed.count() * 1000
+              << " ms, bytes read per row: " << 1.0 * disk_manager->GetNumBytesRead() / num_rows << std::endl;
+    delete bpm;
+  }
+  remove(db_name.c_str());
+  remove(DiskManager::GetSlotFileName(db_name).c_str());
+}
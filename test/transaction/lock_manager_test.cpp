@@ -0,0 +1,224 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "record/field.h"
+#include "record/schema.h"
+#include "storage/table_heap.h"
+#include "transaction/lock_manager.h"
+#include "transaction/txn_manager.h"
+
+using namespace std::chrono_literals;
+
+TEST(LockManagerTest, SharedTest) {
+  LockManager lock_manager;
+  RowId rid(1, 0);
+  std::vector<std::unique_ptr<Transaction>> txns;
+  for (int i = 0; i < 4; i++) {
+    txns.emplace_back(new Transaction(i));
+    ASSERT_TRUE(lock_manager.LockShared(txns.back().get(), rid));
+    ASSERT_TRUE(txns.back()->IsSharedLocked(rid));
+  }
+  // held already
+  ASSERT_TRUE(lock_manager.LockShared(txns[0].get(), rid));
+  for (auto &txn : txns) {
+    ASSERT_TRUE(lock_manager.Unlock(txn.get(), rid));
+    ASSERT_FALSE(txn->IsSharedLocked(rid));
+  }
+  ASSERT_FALSE(lock_manager.Unlock(txns[0].get(), rid));
+}
+
+TEST(LockManagerTest, ExclusiveTest) {
+  LockManager lock_manager;
+  RowId rid(1, 0);
+  Transaction writer(0), reader(1);
+  ASSERT_TRUE(lock_manager.LockExclusive(&writer, rid));
+  auto read = std::async(std::launch::async, [&] { return lock_manager.LockShared(&reader, rid); });
+  ASSERT_EQ(std::future_status::timeout, read.wait_for(50ms));
+  // a lock on another row is not held up
+  Transaction other(2);
+  ASSERT_TRUE(lock_manager.LockExclusive(&other, RowId(1, 1)));
+  lock_manager.UnlockAll(&writer);
+  ASSERT_TRUE(read.get());
+  ASSERT_TRUE(writer.GetExclusiveLockSet().empty());
+  // the reader is now ahead of a writer
+  auto write = std::async(std::launch::async, [&] { return lock_manager.LockExclusive(&writer, rid); });
+  ASSERT_EQ(std::future_status::timeout, write.wait_for(50ms));
+  lock_manager.UnlockAll(&reader);
+  ASSERT_TRUE(write.get());
+  ASSERT_TRUE(writer.IsExclusiveLocked(rid));
+}
+
+TEST(LockManagerTest, UpgradeTest) {
+  LockManager lock_manager;
+  RowId rid(1, 0);
+  Transaction txn0(0), txn1(1), txn2(2);
+  ASSERT_TRUE(lock_manager.LockShared(&txn0, rid));
+  ASSERT_TRUE(lock_manager.LockShared(&txn1, rid));
+  // the upgrade waits for the other shared lock, and goes ahead of a waiting writer
+  auto upgrade = std::async(std::launch::async, [&] { return lock_manager.LockUpgrade(&txn0, rid); });
+  ASSERT_EQ(std::future_status::timeout, upgrade.wait_for(50ms));
+  auto write = std::async(std::launch::async, [&] { return lock_manager.LockExclusive(&txn2, rid); });
+  ASSERT_EQ(std::future_status::timeout, write.wait_for(50ms));
+  // a second upgrade would deadlock with the first one
+  ASSERT_FALSE(lock_manager.LockUpgrade(&txn1, rid));
+  ASSERT_EQ(kAborted, txn1.GetState());
+  lock_manager.UnlockAll(&txn1);
+  ASSERT_TRUE(upgrade.get());
+  ASSERT_TRUE(txn0.IsExclusiveLocked(rid));
+  ASSERT_FALSE(txn0.IsSharedLocked(rid));
+  ASSERT_EQ(std::future_status::timeout, write.wait_for(50ms));
+  lock_manager.UnlockAll(&txn0);
+  ASSERT_TRUE(write.get());
+}
+
+TEST(LockManagerTest, DeadlockTest) {
+  LockManager lock_manager;
+  lock_manager.RunDeadlockDetection(10);
+  RowId rid0(1, 0), rid1(2, 0);
+  Transaction txn0(0), txn1(1);
+  ASSERT_TRUE(lock_manager.LockExclusive(&txn0, rid0));
+  ASSERT_TRUE(lock_manager.LockShared(&txn1, rid1));
+  auto lock0 = std::async(std::launch::async, [&] { return lock_manager.LockExclusive(&txn0, rid1); });
+  auto lock1 = std::async(std::launch::async, [&] { return lock_manager.LockShared(&txn1, rid0); });
+  // the younger transaction is aborted, which lets the older one go on once it is rolled back
+  ASSERT_FALSE(lock1.get());
+  ASSERT_EQ(kAborted, txn1.GetState());
+  ASSERT_EQ(std::future_status::timeout, lock0.wait_for(20ms));
+  lock_manager.UnlockAll(&txn1);
+  ASSERT_TRUE(lock0.get());
+  ASSERT_EQ(kRunning, txn0.GetState());
+  ASSERT_EQ(1, lock_manager.GetNumDeadlocks());
+  // no lock is given to an aborted transaction
+  ASSERT_FALSE(lock_manager.LockShared(&txn1, RowId(3, 0)));
+  lock_manager.UnlockAll(&txn0);
+  ASSERT_EQ(0, lock_manager.DetectDeadlocks());
+}
+
+TEST(LockManagerTest, TableHeapTest) {
+  const std::string db_file_name = "lock_manager_test.db";
+  remove(db_file_name.c_str());
+  auto disk_manager = std::make_unique<DiskManager>(db_file_name);
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(16, disk_manager.get());
+  bpm->SetLogManager(log_manager.get());
+  LockManager lock_manager;
+  TransactionManager txn_manager(log_manager.get(), bpm.get(), &lock_manager);
+  SimpleMemHeap heap;
+  std::vector<Column *> columns = {ALLOC_COLUMN(heap)("id", TypeId::kTypeInt, 0, false, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm.get(), schema.get(), nullptr, log_manager.get(), &lock_manager, &heap);
+  std::vector<Field> fields{Field(TypeId::kTypeInt, 1)};
+  Row row(fields);
+  ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  RowId rid = row.GetRowId();
+
+  // a reader waits for the delete to commit, and does not find the row
+  Transaction *writer = txn_manager.Begin();
+  ASSERT_TRUE(table_heap->MarkDelete(rid, writer));
+  ASSERT_TRUE(writer->IsExclusiveLocked(rid));
+  Transaction *reader = txn_manager.Begin();
+  auto read = std::async(std::launch::async, [&] {
+    Row read_row(rid);
+    return table_heap->GetTuple(&read_row, reader);
+  });
+  ASSERT_EQ(std::future_status::timeout, read.wait_for(50ms));
+  txn_manager.Commit(writer);
+  ASSERT_FALSE(read.get());
+  txn_manager.Commit(reader);
+  ASSERT_EQ(0, txn_manager.GetNumRunning());
+  remove(db_file_name.c_str());
+  remove(DiskManager::GetLogFileName(db_file_name).c_str());
+}
+
+TEST(LockManagerTest, SlotReuseTest) {
+  const std::string db_file_name = "lock_manager_test.db";
+  remove(db_file_name.c_str());
+  auto disk_manager = std::make_unique<DiskManager>(db_file_name);
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(16, disk_manager.get());
+  bpm->SetLogManager(log_manager.get());
+  LockManager lock_manager;
+  TransactionManager txn_manager(log_manager.get(), bpm.get(), &lock_manager);
+  SimpleMemHeap heap;
+  std::vector<Column *> columns = {ALLOC_COLUMN(heap)("id", TypeId::kTypeInt, 0, false, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm.get(), schema.get(), nullptr, log_manager.get(), &lock_manager, &heap);
+  auto make_row = [](int id) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, id)};
+    return Row(fields);
+  };
+  Row first_row = make_row(1);
+  ASSERT_TRUE(table_heap->InsertTuple(first_row, nullptr));
+  RowId rid = first_row.GetRowId();
+
+  // the slot emptied by a running transaction is not reused, its rollback puts the row back there
+  Transaction *deleter = txn_manager.Begin();
+  ASSERT_TRUE(table_heap->MarkDelete(rid, deleter));
+  table_heap->ApplyDelete(rid, deleter);
+  Row second_row = make_row(2);
+  ASSERT_TRUE(table_heap->InsertTuple(second_row, nullptr));
+  ASSERT_FALSE(rid == second_row.GetRowId());
+  Transaction *inserter = txn_manager.Begin();
+  Row third_row = make_row(3);
+  ASSERT_TRUE(table_heap->InsertTuple(third_row, inserter));
+  ASSERT_FALSE(rid == third_row.GetRowId());
+  ASSERT_TRUE(inserter->IsExclusiveLocked(third_row.GetRowId()));
+  txn_manager.Abort(deleter);
+  txn_manager.Commit(inserter);
+  Row read_row(rid);
+  ASSERT_TRUE(table_heap->GetTuple(&read_row, nullptr));
+
+  // the update of a row deleted meanwhile aborts the transaction
+  deleter = txn_manager.Begin();
+  ASSERT_TRUE(table_heap->MarkDelete(third_row.GetRowId(), deleter));
+  table_heap->ApplyDelete(third_row.GetRowId(), deleter);
+  txn_manager.Commit(deleter);
+  Transaction *updater = txn_manager.Begin();
+  Row updated_row = make_row(4);
+  ASSERT_FALSE(table_heap->UpdateTuple(updated_row, third_row.GetRowId(), updater));
+  ASSERT_EQ(kAborted, updater->GetState());
+  txn_manager.Abort(updater);
+  size_t num_rows = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    num_rows++;
+  }
+  ASSERT_EQ(2, num_rows);
+  ASSERT_EQ(0, txn_manager.GetNumRunning());
+  remove(db_file_name.c_str());
+  remove(DiskManager::GetLogFileName(db_file_name).c_str());
+}
+
+TEST(LockManagerTest, ShardedBenchmark) {
+  // each thread locks its own rows, so the threads only meet on the latches of the lock table
+  const int thread_nums = 8;
+  const int txn_nums = 2000;
+  const int rows_per_txn = 8;
+  LockManager lock_manager;
+  std::atomic<int> next_txn_id{0};
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_nums; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < txn_nums / thread_nums; i++) {
+        Transaction txn(next_txn_id++);
+        for (int r = 0; r < rows_per_txn; r++) {
+          RowId rid(t, i * rows_per_txn + r);
+          ASSERT_TRUE(r % 2 == 0 ? lock_manager.LockShared(&txn, rid) : lock_manager.LockExclusive(&txn, rid));
+        }
+        lock_manager.UnlockAll(&txn);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  LOG(INFO) << thread_nums << " threads: " << txn_nums * rows_per_txn / seconds << " locks/s";
+  ASSERT_EQ(0, lock_manager.DetectDeadlocks());
+}
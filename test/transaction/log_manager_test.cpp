@@ -0,0 +1,260 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "record/field.h"
+#include "record/schema.h"
+#include "storage/table_heap.h"
+#include "transaction/txn_manager.h"
+
+static const std::string db_file_name = "log_manager_test.db";
+
+/** Read back all the records of the log file */
+static std::vector<LogRecord> ReadLogRecords(DiskManager *disk_manager) {
+  std::vector<LogRecord> records;
+  std::string log;
+  char buf[PAGE_SIZE];
+  size_t size;
+  while ((size = disk_manager->ReadLog(buf, PAGE_SIZE, log.size())) > 0) {
+    log.append(buf, size);
+  }
+  size_t offset = LogManager::LOG_HEADER_SIZE;
+  LogRecord record;
+  while (LogRecord::DeserializeFrom(log.data() + offset, log.size() - offset, &record)) {
+    offset += record.GetSize();
+    records.push_back(record);
+  }
+  EXPECT_EQ(log.size(), offset);
+  return records;
+}
+
+TEST(LogManagerTest, LogRecordTest) {
+  char buf[PAGE_SIZE];
+  LogRecord update(3, 7, RowId(5, 2), "old tuple", "new tuple");
+  update.SetLSN(8);
+  update.SetUndoNextLSN(5);
+  update.SerializeTo(buf);
+  LogRecord record;
+  ASSERT_TRUE(LogRecord::DeserializeFrom(buf, update.GetSize(), &record));
+  EXPECT_EQ(kUpdateLog, record.GetType());
+  EXPECT_EQ(8, record.GetLSN());
+  EXPECT_EQ(3, record.GetTxnId());
+  EXPECT_EQ(7, record.GetPrevLSN());
+  EXPECT_EQ(5, record.GetUndoNextLSN());
+  EXPECT_TRUE(record.IsCompensation());
+  EXPECT_EQ(RowId(5, 2).Get(), record.GetRowId().Get());
+  EXPECT_EQ("old tuple", record.GetTuple());
+  EXPECT_EQ("new tuple", record.GetNewTuple());
+  EXPECT_EQ(update.GetSize(), record.GetSize());
+  // a truncated record is not a record
+  ASSERT_FALSE(LogRecord::DeserializeFrom(buf, update.GetSize() - 1, &record));
+
+  LogRecord new_page(3, 8, 1, 2);
+  new_page.SerializeTo(buf);
+  ASSERT_TRUE(LogRecord::DeserializeFrom(buf, new_page.GetSize(), &record));
+  EXPECT_EQ(kNewPageLog, record.GetType());
+  EXPECT_EQ(1, record.GetPrevPageId());
+  EXPECT_EQ(2, record.GetPageId());
+  EXPECT_FALSE(record.IsCompensation());
+
+  LogRecord checkpoint(16, {{3, 40}, {4, 56}}, {{2, 24}}, {RowId(2, 7)});
+  checkpoint.SerializeTo(buf);
+  ASSERT_TRUE(LogRecord::DeserializeFrom(buf, checkpoint.GetSize(), &record));
+  EXPECT_EQ(kEndCheckpointLog, record.GetType());
+  EXPECT_EQ(16, record.GetPrevLSN());
+  ASSERT_EQ(2, record.GetActiveTransactions().size());
+  EXPECT_EQ(4, record.GetActiveTransactions()[1].first);
+  EXPECT_EQ(56, record.GetActiveTransactions()[1].second);
+  ASSERT_EQ(1, record.GetDirtyPages().size());
+  EXPECT_EQ(24, record.GetDirtyPages()[0].second);
+  ASSERT_EQ(1, record.GetDeletedRows().size());
+  EXPECT_EQ(RowId(2, 7).Get(), record.GetDeletedRows()[0].Get());
+}
+
+TEST(LogManagerTest, WriteAheadTest) {
+  remove(db_file_name.c_str());
+  auto disk_manager = std::make_unique<DiskManager>(db_file_name, kSyncNever);
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(4, disk_manager.get());
+  bpm->SetLogManager(log_manager.get());
+  SimpleMemHeap heap;
+  std::vector<Column *> columns = {
+          ALLOC_COLUMN(heap)("id", TypeId::kTypeInt, 0, false, false),
+          ALLOC_COLUMN(heap)("name", TypeId::kTypeChar, 64, 1, false, false)
+  };
+  auto schema = std::make_shared<Schema>(columns);
+  // without the flush thread, the log is only written when a dirty page is written
+  TableHeap *table_heap = TableHeap::Create(bpm.get(), schema.get(), nullptr, log_manager.get(), nullptr, &heap);
+  const int row_nums = 2000;
+  char name[64];
+  memset(name, 'a', sizeof(name));
+  Transaction txn(0);
+  for (int i = 0; i < row_nums; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, sizeof(name), false)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, &txn));
+  }
+  ASSERT_LT(0, log_manager->GetNumFlushes());
+  // no page on the disk is ahead of the log, even while the pages are evicted by the scan below
+  char data[PAGE_SIZE];
+  size_t num_checked = 0;
+  for (page_id_t page_id = table_heap->GetFirstPageId(); page_id != INVALID_PAGE_ID;) {
+    disk_manager->ReadPage(page_id, data);
+    lsn_t lsn;
+    // the LSN follows the page id in the header
+    memcpy(&lsn, data + sizeof(page_id_t), sizeof(lsn_t));
+    ASSERT_LE(lsn, log_manager->GetPersistentLSN());
+    num_checked += lsn != 0;
+    auto page = reinterpret_cast<TablePage *>(bpm->FetchPage(page_id)->GetData());
+    bpm->UnpinPage(page_id, false);
+    page_id = page->GetNextPageId();
+  }
+  ASSERT_LT(0, num_checked);
+  ASSERT_EQ(txn.GetPrevLSN(), log_manager->GetLastLSN());
+
+  // the log holds every change, in the order of the LSNs
+  bpm.reset();
+  log_manager.reset();
+  auto records = ReadLogRecords(disk_manager.get());
+  int num_inserts = 0, num_new_pages = 0;
+  lsn_t lsn = LogManager::LOG_HEADER_SIZE;
+  for (auto &record : records) {
+    // the LSN of a record is its offset in the log
+    ASSERT_EQ(lsn, record.GetLSN());
+    lsn += record.GetSize();
+    num_inserts += record.GetType() == kInsertLog;
+    num_new_pages += record.GetType() == kNewPageLog;
+  }
+  EXPECT_EQ(row_nums, num_inserts);
+  EXPECT_LT(1, num_new_pages);
+}
+
+TEST(LogManagerTest, WriteFailureTest) {
+  remove(db_file_name.c_str());
+  auto disk_manager = std::make_unique<DiskManager>(db_file_name, kSyncNever);
+  // every write of the log fails, like on a full disk
+  std::string log_file_name = DiskManager::GetLogFileName(db_file_name);
+  ASSERT_EQ(0, symlink("/dev/full", log_file_name.c_str()));
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(4, disk_manager.get());
+  bpm->SetLogManager(log_manager.get());
+  auto txn_manager = std::make_unique<TransactionManager>(log_manager.get(), bpm.get(), nullptr);
+  SimpleMemHeap heap;
+  std::vector<Column *> columns = {ALLOC_COLUMN(heap)("id", TypeId::kTypeInt, 0, false, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm.get(), schema.get(), nullptr, log_manager.get(), nullptr, &heap);
+  lsn_t persistent_lsn = log_manager->GetPersistentLSN();
+  Transaction *txn = txn_manager->Begin();
+  std::vector<Field> fields{Field(TypeId::kTypeInt, 1)};
+  Row row(fields);
+  ASSERT_TRUE(table_heap->InsertTuple(row, txn));
+
+  // Scenario: the commit is not acknowledged, and no LSN after the failed write is taken as durable.
+  EXPECT_FALSE(txn_manager->Commit(txn));
+  EXPECT_TRUE(log_manager->HasFailed());
+  EXPECT_EQ(persistent_lsn, log_manager->GetPersistentLSN());
+  Transaction *next = txn_manager->Begin();
+  Row next_row(fields);
+  ASSERT_TRUE(table_heap->InsertTuple(next_row, next));
+  EXPECT_FALSE(txn_manager->Commit(next));
+  EXPECT_EQ(persistent_lsn, log_manager->GetPersistentLSN());
+  // a transaction which only reads writes nothing, it does not need the log
+  lsn_t next_lsn = log_manager->GetNextLSN();
+  Transaction *reader = txn_manager->Begin();
+  EXPECT_TRUE(txn_manager->Commit(reader));
+  reader = txn_manager->Begin();
+  txn_manager->Abort(reader);
+  EXPECT_EQ(next_lsn, log_manager->GetNextLSN());
+
+  // Scenario: the dirty page is not written ahead of its log.
+  EXPECT_FALSE(bpm->FlushPage(table_heap->GetFirstPageId()));
+  EXPECT_FALSE(bpm->FlushAllPage());
+  EXPECT_EQ(1, bpm->GetDirtyPageTable().count(table_heap->GetFirstPageId()));
+
+  txn_manager.reset();
+  bpm.reset();
+  log_manager.reset();
+  disk_manager.reset();
+  remove(log_file_name.c_str());
+  remove(db_file_name.c_str());
+}
+
+TEST(LogManagerTest, LargeLSNTest) {
+  remove(db_file_name.c_str());
+  auto disk_manager = std::make_unique<DiskManager>(db_file_name, kSyncNever);
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  // the log file is sparse, only its end is written
+  const lsn_t start_lsn = (static_cast<lsn_t>(1) << 32) + 8;
+  log_manager->Truncate(start_lsn);
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(4, disk_manager.get());
+  bpm->SetLogManager(log_manager.get());
+  SimpleMemHeap heap;
+  std::vector<Column *> columns = {ALLOC_COLUMN(heap)("id", TypeId::kTypeInt, 0, false, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm.get(), schema.get(), nullptr, log_manager.get(), nullptr, &heap);
+  std::vector<Field> fields{Field(TypeId::kTypeInt, 1)};
+  Row row(fields);
+  ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+
+  // the page LSN and the records keep every bit of an LSN beyond 4 GB
+  Page *page = bpm->FetchPage(table_heap->GetFirstPageId());
+  lsn_t page_lsn = page->GetLSN();
+  bpm->UnpinPage(page->GetPageId(), false);
+  ASSERT_LT(start_lsn, page_lsn);
+  ASSERT_TRUE(log_manager->Flush(page_lsn));
+  LogRecord record;
+  ASSERT_TRUE(log_manager->ReadLogRecord(page_lsn, &record));
+  EXPECT_EQ(kInsertLog, record.GetType());
+  EXPECT_EQ(page_lsn, record.GetLSN());
+  ASSERT_TRUE(log_manager->SetCheckpointLSN(start_lsn));
+  EXPECT_EQ(start_lsn, log_manager->GetCheckpointLSN());
+
+  bpm.reset();
+  log_manager.reset();
+  disk_manager.reset();
+  remove(db_file_name.c_str());
+  remove(DiskManager::GetLogFileName(db_file_name).c_str());
+}
+
+TEST(LogManagerTest, GroupCommitBenchmark) {
+  const int commit_nums = 400;
+  for (int thread_nums : {1, 8}) {
+    remove(db_file_name.c_str());
+    auto disk_manager = std::make_unique<DiskManager>(db_file_name);
+    auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+    log_manager->RunFlushThread();
+    TransactionManager txn_manager(log_manager.get());
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_nums; t++) {
+      threads.emplace_back([&] {
+        for (int i = 0; i < commit_nums / thread_nums; i++) {
+          Transaction *txn = txn_manager.Begin();
+          LogRecord record(kInsertLog, txn->GetTransactionId(), txn->GetPrevLSN(), RowId(0, i), "tuple");
+          txn->SetPrevLSN(log_manager->AppendLogRecord(&record));
+          txn_manager.Commit(txn);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // every commit is durable once it returns
+    ASSERT_EQ(log_manager->GetLastLSN(), log_manager->GetPersistentLSN());
+    ASSERT_EQ(0, txn_manager.GetNumRunning());
+    uint64_t num_flushes = log_manager->GetNumFlushes();
+    if (thread_nums > 1) {
+      EXPECT_LT(num_flushes, commit_nums);
+    }
+    LOG(INFO) << thread_nums << " threads: " << commit_nums / seconds << " commits/s, "
+              << static_cast<double>(num_flushes) / commit_nums << " flushes per commit";
+  }
+}
@@ -0,0 +1,406 @@
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "record/field.h"
+#include "record/schema.h"
+#include "storage/table_heap.h"
+#include "transaction/recovery_manager.h"
+
+static const std::string db_file_name = "recovery_test.db";
+
+/** The storage of a database, as DBStorageEngine sets it up */
+struct Storage {
+  explicit Storage(size_t pool_size) {
+    disk_manager = std::make_unique<DiskManager>(db_file_name);
+    log_manager = std::make_unique<LogManager>(disk_manager.get());
+    bpm = std::make_unique<BufferPoolManagerInstance>(pool_size, disk_manager.get());
+    bpm->SetLogManager(log_manager.get());
+    txn_manager = std::make_unique<TransactionManager>(log_manager.get(), bpm.get());
+    recovery_manager = std::make_unique<RecoveryManager>(disk_manager.get(), bpm.get(), log_manager.get(),
+                                                         txn_manager.get());
+  }
+
+  std::unique_ptr<DiskManager> disk_manager;
+  std::unique_ptr<LogManager> log_manager;
+  std::unique_ptr<BufferPoolManager> bpm;
+  std::unique_ptr<TransactionManager> txn_manager;
+  std::unique_ptr<RecoveryManager> recovery_manager;
+};
+
+class RecoveryTest : public testing::Test {
+protected:
+  void SetUp() override {
+    remove(db_file_name.c_str());
+    remove(DiskManager::GetLogFileName(db_file_name).c_str());
+    columns_ = {ALLOC_COLUMN(heap_)("id", TypeId::kTypeInt, 0, false, false),
+                ALLOC_COLUMN(heap_)("name", TypeId::kTypeChar, 64, 1, false, false)};
+    schema_ = std::make_shared<Schema>(columns_);
+  }
+
+  void TearDown() override {
+    remove(db_file_name.c_str());
+    remove(DiskManager::GetLogFileName(db_file_name).c_str());
+  }
+
+  Row MakeRow(int id, char c) {
+    char name[64];
+    memset(name, c, sizeof(name));
+    std::vector<Field> fields{Field(TypeId::kTypeInt, id), Field(TypeId::kTypeChar, name, sizeof(name), true)};
+    return Row(fields);
+  }
+
+  /** The ids of the rows in the table, with the first letter of their name */
+  std::vector<std::pair<int, char>> ReadTable(TableHeap *table_heap) {
+    std::vector<std::pair<int, char>> rows;
+    for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+      int32_t id;
+      iter->GetField(0)->SerializeTo(reinterpret_cast<char *>(&id));
+      rows.emplace_back(id, iter->GetField(1)->GetData()[0]);
+    }
+    return rows;
+  }
+
+  /**
+   * Run work in a child process which is killed at its end, with the pages and the log it has not written yet lost
+   * @return what work returns, through a pipe
+   */
+  page_id_t RunAndCrash(const std::function<page_id_t()> &work) {
+    int fds[2];
+    EXPECT_EQ(0, pipe(fds));
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(fds[0]);
+      page_id_t result = work();
+      EXPECT_EQ(static_cast<ssize_t>(sizeof(result)), write(fds[1], &result, sizeof(result)));
+      _exit(HasFailure() ? 1 : 0);
+    }
+    close(fds[1]);
+    page_id_t result = INVALID_PAGE_ID;
+    EXPECT_EQ(static_cast<ssize_t>(sizeof(result)), read(fds[0], &result, sizeof(result)));
+    close(fds[0]);
+    int status;
+    EXPECT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    return result;
+  }
+
+  /** @return the space the log file takes on the disk, without its holes */
+  static size_t GetLogSpace() {
+    struct stat stat_buf;
+    EXPECT_EQ(0, stat(DiskManager::GetLogFileName(db_file_name).c_str(), &stat_buf));
+    return stat_buf.st_blocks * 512;
+  }
+
+  SimpleMemHeap heap_;
+  std::vector<Column *> columns_;
+  std::shared_ptr<Schema> schema_;
+};
+
+TEST_F(RecoveryTest, CrashTest) {
+  const int row_nums = 1000;
+  page_id_t first_page_id = RunAndCrash([&] {
+    // never shut down, the process ends with it
+    auto &storage = *new Storage(16);
+    auto table_heap = TableHeap::Create(storage.bpm.get(), schema_.get(), nullptr, storage.log_manager.get(), nullptr,
+                                        &heap_);
+    storage.recovery_manager->Checkpoint();
+    // committed: the rows, and the removal of some of them
+    Transaction *txn = storage.txn_manager->Begin();
+    std::vector<RowId> rids;
+    for (int i = 0; i < row_nums; i++) {
+      Row row = MakeRow(i, 'a');
+      EXPECT_TRUE(table_heap->InsertTuple(row, txn));
+      rids.push_back(row.GetRowId());
+    }
+    storage.txn_manager->Commit(txn);
+    txn = storage.txn_manager->Begin();
+    for (int i = 0; i < 10; i++) {
+      table_heap->MarkDelete(rids[i], txn);
+      table_heap->ApplyDelete(rids[i], txn);
+    }
+    storage.txn_manager->Commit(txn);
+    // running at the crash: changes of every kind, across a checkpoint
+    Transaction *loser = storage.txn_manager->Begin();
+    for (int i = 10; i < 110; i++) {
+      Row row = MakeRow(i, 'b');
+      EXPECT_TRUE(table_heap->UpdateTuple(row, rids[i], loser));
+    }
+    storage.recovery_manager->Checkpoint();
+    for (int i = 110; i < 210; i++) {
+      table_heap->MarkDelete(rids[i], loser);
+    }
+    for (int i = 210; i < 220; i++) {
+      table_heap->MarkDelete(rids[i], loser);
+      table_heap->ApplyDelete(rids[i], loser);
+    }
+    for (int i = row_nums; i < row_nums + 500; i++) {
+      Row row = MakeRow(i, 'c');
+      EXPECT_TRUE(table_heap->InsertTuple(row, loser));
+    }
+    storage.log_manager->Flush(storage.log_manager->GetLastLSN());
+    return table_heap->GetFirstPageId();
+  });
+  ASSERT_NE(INVALID_PAGE_ID, first_page_id);
+
+  Storage storage(16);
+  storage.recovery_manager->Recover();
+  EXPECT_LT(0, storage.recovery_manager->GetNumRedoRecords());
+  EXPECT_EQ(0, storage.txn_manager->GetNumRunning());
+  auto table_heap = TableHeap::Create(storage.bpm.get(), first_page_id, schema_.get(), storage.log_manager.get(),
+                                      nullptr, &heap_);
+  auto rows = ReadTable(table_heap);
+  std::set<int> ids;
+  for (auto &row : rows) {
+    EXPECT_EQ('a', row.second) << "row " << row.first;
+    ids.insert(row.first);
+  }
+  ASSERT_EQ(rows.size(), ids.size());
+  ASSERT_EQ(static_cast<size_t>(row_nums - 10), ids.size());
+  EXPECT_EQ(10, *ids.begin());
+  EXPECT_EQ(row_nums - 1, *ids.rbegin());
+}
+
+TEST_F(RecoveryTest, PinnedPageCheckpointTest) {
+  page_id_t first_page_id = RunAndCrash([&] {
+    // never shut down, the process ends with it
+    auto &storage = *new Storage(16);
+    auto table_heap = TableHeap::Create(storage.bpm.get(), schema_.get(), nullptr, storage.log_manager.get(), nullptr,
+                                        &heap_);
+    Transaction *txn = storage.txn_manager->Begin();
+    Row first_row = MakeRow(0, 'a');
+    EXPECT_TRUE(table_heap->InsertTuple(first_row, txn));
+    storage.txn_manager->Commit(txn);
+    storage.bpm->FlushAllPage();
+    storage.recovery_manager->Checkpoint();
+    // a change logged while the page stays pinned, the page is only marked dirty when it is unpinned
+    auto page = reinterpret_cast<TablePage *>(storage.bpm->FetchPage(table_heap->GetFirstPageId()));
+    txn = storage.txn_manager->Begin();
+    Row second_row = MakeRow(1, 'a');
+    page->WLatch();
+    EXPECT_TRUE(page->InsertTuple(second_row, schema_.get(), txn, nullptr, storage.log_manager.get()));
+    page->WUnlatch();
+    storage.txn_manager->Commit(txn);
+    // the recovery starts from this checkpoint, after the record of the change
+    storage.recovery_manager->Checkpoint();
+    return table_heap->GetFirstPageId();
+  });
+  ASSERT_NE(INVALID_PAGE_ID, first_page_id);
+
+  Storage storage(16);
+  storage.recovery_manager->Recover();
+  auto table_heap = TableHeap::Create(storage.bpm.get(), first_page_id, schema_.get(), storage.log_manager.get(),
+                                      nullptr, &heap_);
+  std::vector<std::pair<int, char>> expected = {{0, 'a'}, {1, 'a'}};
+  EXPECT_EQ(expected, ReadTable(table_heap));
+}
+
+TEST_F(RecoveryTest, FreedPageTest) {
+  page_id_t reused_page_id = RunAndCrash([&] {
+    // never shut down, the process ends with it
+    auto &storage = *new Storage(16);
+    auto dropped = TableHeap::Create(storage.bpm.get(), schema_.get(), nullptr, storage.log_manager.get(), nullptr,
+                                     &heap_);
+    Row first_row = MakeRow(0, 'a');
+    EXPECT_TRUE(dropped->InsertTuple(first_row, nullptr));
+    storage.bpm->FlushAllPage();
+    storage.recovery_manager->Checkpoint();
+    // changes of a table page and the allocation of another one after the checkpoint, then both are freed
+    Transaction *txn = storage.txn_manager->Begin();
+    Row second_row = MakeRow(1, 'a');
+    EXPECT_TRUE(dropped->InsertTuple(second_row, txn));
+    auto other = TableHeap::Create(storage.bpm.get(), schema_.get(), txn, storage.log_manager.get(), nullptr, &heap_);
+    EXPECT_EQ(dropped->GetFirstPageId() + 1, other->GetFirstPageId());
+    storage.txn_manager->Commit(txn);
+    dropped->FreeHeap();
+    other->FreeHeap();
+    // the first page is reused, e.g. by an index, and written before the crash
+    page_id_t page_id;
+    Page *page = storage.bpm->NewPage(page_id);
+    EXPECT_NE(nullptr, page);
+    memset(page->GetData(), 0, PAGE_SIZE);
+    memset(page->GetData() + PAGE_SIZE / 2, 'x', PAGE_SIZE / 2);
+    storage.bpm->UnpinPage(page_id, true);
+    storage.bpm->FlushPage(page_id);
+    return page_id;
+  });
+  ASSERT_NE(INVALID_PAGE_ID, reused_page_id);
+
+  Storage storage(16);
+  storage.recovery_manager->Recover();
+  // the records of the table before the free are not redone on the reused page, and the other page stays free
+  EXPECT_TRUE(storage.disk_manager->IsPageFree(reused_page_id + 1));
+  Page *page = storage.bpm->FetchPage(reused_page_id);
+  ASSERT_NE(nullptr, page);
+  std::vector<char> expected(PAGE_SIZE / 2, 'x');
+  EXPECT_EQ(0, memcmp(expected.data(), page->GetData() + PAGE_SIZE / 2, PAGE_SIZE / 2));
+  storage.bpm->UnpinPage(reused_page_id, false);
+}
+
+TEST_F(RecoveryTest, DeletedRowTest) {
+  page_id_t first_page_id = RunAndCrash([&] {
+    // never shut down, the process ends with it
+    auto &storage = *new Storage(16);
+    auto table_heap = TableHeap::Create(storage.bpm.get(), schema_.get(), nullptr, storage.log_manager.get(), nullptr,
+                                        &heap_, storage.txn_manager->GetVersionStore());
+    Transaction *txn = storage.txn_manager->Begin();
+    std::vector<RowId> rids;
+    for (int i = 0; i < 4; i++) {
+      Row row = MakeRow(i, 'a');
+      EXPECT_TRUE(table_heap->InsertTuple(row, txn));
+      rids.push_back(row.GetRowId());
+    }
+    storage.txn_manager->Commit(txn);
+    // the deleted rows stay marked on their page for the snapshot of the reader, before and after the checkpoint
+    storage.txn_manager->Begin();
+    txn = storage.txn_manager->Begin();
+    table_heap->ApplyDelete(rids[0], txn);
+    table_heap->ApplyDelete(rids[1], txn);
+    storage.txn_manager->Commit(txn);
+    storage.recovery_manager->Checkpoint();
+    Transaction *running = storage.txn_manager->Begin();
+    table_heap->ApplyDelete(rids[3], running);
+    txn = storage.txn_manager->Begin();
+    table_heap->ApplyDelete(rids[2], txn);
+    storage.txn_manager->Commit(txn);
+    storage.txn_manager->CollectGarbage();
+    EXPECT_EQ(4, storage.txn_manager->GetVersionStore()->GetNumChains());
+    return table_heap->GetFirstPageId();
+  });
+  ASSERT_NE(INVALID_PAGE_ID, first_page_id);
+
+  Storage storage(16);
+  storage.recovery_manager->Recover();
+  // the committed deletes are applied, the running one is rolled back
+  auto page = reinterpret_cast<TablePage *>(storage.bpm->FetchPage(first_page_id));
+  for (uint32_t slot = 0; slot < 4; slot++) {
+    EXPECT_FALSE(page->IsMarkedDeleted(slot));
+  }
+  storage.bpm->UnpinPage(first_page_id, false);
+  auto table_heap = TableHeap::Create(storage.bpm.get(), first_page_id, schema_.get(), storage.log_manager.get(),
+                                      nullptr, &heap_);
+  std::vector<std::pair<int, char>> expected = {{3, 'a'}};
+  EXPECT_EQ(expected, ReadTable(table_heap));
+}
+
+TEST_F(RecoveryTest, RollbackTest) {
+  Storage storage(8);
+  auto table_heap = TableHeap::Create(storage.bpm.get(), schema_.get(), nullptr, storage.log_manager.get(), nullptr,
+                                      &heap_);
+  std::vector<RowId> rids;
+  for (int i = 0; i < 200; i++) {
+    Row row = MakeRow(i, 'a');
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  auto before = ReadTable(table_heap);
+
+  Transaction *txn = storage.txn_manager->Begin();
+  for (int i = 0; i < 50; i++) {
+    Row row = MakeRow(i, 'b');
+    ASSERT_TRUE(table_heap->UpdateTuple(row, rids[i], txn));
+  }
+  for (int i = 50; i < 100; i++) {
+    table_heap->MarkDelete(rids[i], txn);
+    table_heap->ApplyDelete(rids[i], txn);
+  }
+  for (int i = 200; i < 400; i++) {
+    Row row = MakeRow(i, 'c');
+    ASSERT_TRUE(table_heap->InsertTuple(row, txn));
+  }
+  ASSERT_NE(before, ReadTable(table_heap));
+  storage.txn_manager->Abort(txn);
+  EXPECT_EQ(before, ReadTable(table_heap));
+  EXPECT_EQ(0, storage.txn_manager->GetNumRunning());
+}
+
+TEST_F(RecoveryTest, CheckpointTest) {
+  const int round_nums = 20;
+  const int rows_per_round = 100;
+  page_id_t first_page_id = RunAndCrash([&] {
+    // never shut down, the process ends with it
+    auto &storage = *new Storage(16);
+    auto table_heap = TableHeap::Create(storage.bpm.get(), schema_.get(), nullptr, storage.log_manager.get(), nullptr,
+                                        &heap_);
+    for (int r = 0; r < round_nums; r++) {
+      Transaction *txn = storage.txn_manager->Begin();
+      for (int i = 0; i < rows_per_round; i++) {
+        Row row = MakeRow(r * rows_per_round + i, 'a');
+        EXPECT_TRUE(table_heap->InsertTuple(row, txn));
+      }
+      storage.txn_manager->Commit(txn);
+      storage.recovery_manager->Checkpoint();
+    }
+    EXPECT_EQ(static_cast<uint64_t>(round_nums), storage.recovery_manager->GetNumCheckpoints());
+    return table_heap->GetFirstPageId();
+  });
+
+  Storage storage(16);
+  storage.recovery_manager->Recover();
+  // the redo starts at most two checkpoints back, not at the start of the log
+  uint64_t num_redo_records = storage.recovery_manager->GetNumRedoRecords();
+  LOG(INFO) << num_redo_records << " records redone after " << round_nums << " checkpoints";
+  EXPECT_LT(num_redo_records, static_cast<uint64_t>(3 * rows_per_round));
+  auto table_heap = TableHeap::Create(storage.bpm.get(), first_page_id, schema_.get(), storage.log_manager.get(),
+                                      nullptr, &heap_);
+  EXPECT_EQ(static_cast<size_t>(round_nums * rows_per_round), ReadTable(table_heap).size());
+}
+
+TEST_F(RecoveryTest, DiscardTest) {
+  const int round_nums = 20;
+  const int rows_per_round = 100;
+  auto storage_ptr = std::make_unique<Storage>(16);
+  auto &storage = *storage_ptr;
+  auto table_heap = TableHeap::Create(storage.bpm.get(), schema_.get(), nullptr, storage.log_manager.get(), nullptr,
+                                      &heap_);
+  auto insert_rounds = [&] {
+    for (int r = 0; r < round_nums; r++) {
+      Transaction *txn = storage.txn_manager->Begin();
+      for (int i = 0; i < rows_per_round; i++) {
+        Row row = MakeRow(r * rows_per_round + i, 'a');
+        ASSERT_TRUE(table_heap->InsertTuple(row, txn));
+      }
+      storage.txn_manager->Commit(txn);
+      storage.recovery_manager->Checkpoint();
+    }
+  };
+
+  // Scenario: the log is kept from the begin record of a running transaction on, its abort reads it back.
+  Transaction *long_txn = storage.txn_manager->Begin();
+  Row row = MakeRow(-1, 'b');
+  ASSERT_TRUE(table_heap->InsertTuple(row, long_txn));
+  insert_rounds();
+  size_t log_size = storage.disk_manager->GetLogSize();
+  EXPECT_LT(log_size / 2, GetLogSpace());
+  storage.txn_manager->Abort(long_txn);
+  EXPECT_EQ(static_cast<size_t>(round_nums * rows_per_round), ReadTable(table_heap).size());
+
+  // Scenario: without running transactions, only the records of the last checkpoints take space.
+  insert_rounds();
+  log_size = storage.disk_manager->GetLogSize();
+  size_t log_space = GetLogSpace();
+  LOG(INFO) << "The log takes " << log_space << " bytes for " << log_size << " bytes of records";
+  EXPECT_GT(log_size / 4, log_space);
+  // a discarded record can't be read any more
+  LogRecord record;
+  EXPECT_FALSE(storage.log_manager->ReadLogRecord(LogManager::LOG_HEADER_SIZE, &record));
+
+  // Scenario: the recovery from the last checkpoint never reads a discarded record.
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  storage_ptr.reset();
+  Storage recovered(16);
+  recovered.recovery_manager->Recover();
+  auto recovered_heap = TableHeap::Create(recovered.bpm.get(), first_page_id, schema_.get(),
+                                          recovered.log_manager.get(), nullptr, &heap_);
+  EXPECT_EQ(static_cast<size_t>(2 * round_nums * rows_per_round), ReadTable(recovered_heap).size());
+}
@@ -0,0 +1,243 @@
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "page/table_page.h"
+#include "gtest/gtest.h"
+#include "record/field.h"
+#include "record/schema.h"
+#include "storage/table_heap.h"
+#include "transaction/lock_manager.h"
+#include "transaction/txn_manager.h"
+
+using namespace std::chrono_literals;
+
+class VersionStoreTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    remove(db_file_name_.c_str());
+    disk_manager_ = std::make_unique<DiskManager>(db_file_name_);
+    log_manager_ = std::make_unique<LogManager>(disk_manager_.get());
+    bpm_ = std::make_unique<BufferPoolManagerInstance>(16, disk_manager_.get());
+    bpm_->SetLogManager(log_manager_.get());
+    txn_manager_ = std::make_unique<TransactionManager>(log_manager_.get(), bpm_.get(), &lock_manager_);
+    std::vector<Column *> columns = {ALLOC_COLUMN(heap_)("id", TypeId::kTypeInt, 0, false, false),
+                                     ALLOC_COLUMN(heap_)("value", TypeId::kTypeInt, 1, false, false)};
+    schema_ = std::make_shared<Schema>(columns);
+    table_heap_ = TableHeap::Create(bpm_.get(), schema_.get(), nullptr, log_manager_.get(), &lock_manager_, &heap_,
+                                    txn_manager_->GetVersionStore());
+  }
+
+  void TearDown() override {
+    txn_manager_.reset();
+    bpm_.reset();
+    log_manager_.reset();
+    disk_manager_.reset();
+    remove(db_file_name_.c_str());
+    remove(DiskManager::GetLogFileName(db_file_name_).c_str());
+  }
+
+  static Row MakeRow(int id, int value) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, id), Field(TypeId::kTypeInt, value)};
+    return Row(fields);
+  }
+
+  /** @return the value of a row as seen by a transaction, -1 if it does not see the row */
+  int ReadValue(const RowId &rid, Transaction *txn) {
+    Row row(rid);
+    if (!table_heap_->GetTuple(&row, txn)) {
+      return -1;
+    }
+    return GetInt(row);
+  }
+
+  static int GetInt(const Row &row) {
+    for (int value = 0; value < 1000; value++) {
+      if (row.GetField(1)->CompareEquals(Field(TypeId::kTypeInt, value)) == CmpBool::kTrue) {
+        return value;
+      }
+    }
+    return -1;
+  }
+
+  /** @return the sum of the values of the rows a transaction sees */
+  int ScanSum(Transaction *txn, int *num_rows) {
+    int sum = 0;
+    *num_rows = 0;
+    for (auto it = table_heap_->Begin(txn); it != table_heap_->End(); ++it) {
+      sum += GetInt(*it);
+      (*num_rows)++;
+    }
+    return sum;
+  }
+
+  /** Insert the committed rows (i, i), seen by every transaction */
+  std::vector<RowId> InsertRows(int num_rows) {
+    Transaction *txn = txn_manager_->Begin();
+    std::vector<RowId> rids;
+    for (int i = 1; i <= num_rows; i++) {
+      Row row = MakeRow(i, i);
+      EXPECT_TRUE(table_heap_->InsertTuple(row, txn));
+      rids.push_back(row.GetRowId());
+    }
+    txn_manager_->Commit(txn);
+    txn_manager_->CollectGarbage();
+    EXPECT_EQ(0, txn_manager_->GetVersionStore()->GetNumChains());
+    return rids;
+  }
+
+  const std::string db_file_name_ = "version_store_test.db";
+  std::unique_ptr<DiskManager> disk_manager_;
+  std::unique_ptr<LogManager> log_manager_;
+  std::unique_ptr<BufferPoolManager> bpm_;
+  LockManager lock_manager_;
+  std::unique_ptr<TransactionManager> txn_manager_;
+  SimpleMemHeap heap_;
+  std::shared_ptr<Schema> schema_;
+  TableHeap *table_heap_{nullptr};
+};
+
+TEST_F(VersionStoreTest, SnapshotReadTest) {
+  auto rids = InsertRows(3);
+  Transaction *reader = txn_manager_->Begin();
+  Transaction *writer = txn_manager_->Begin();
+  Row updated = MakeRow(1, 10);
+  ASSERT_TRUE(table_heap_->UpdateTuple(updated, rids[0], writer));
+  ASSERT_TRUE(table_heap_->MarkDelete(rids[1], writer));
+  Row inserted = MakeRow(4, 4);
+  ASSERT_TRUE(table_heap_->InsertTuple(inserted, writer));
+
+  // the writer sees its own changes, the reader does not wait for them
+  ASSERT_EQ(10, ReadValue(rids[0], writer));
+  ASSERT_EQ(-1, ReadValue(rids[1], writer));
+  ASSERT_EQ(4, ReadValue(inserted.GetRowId(), writer));
+  ASSERT_EQ(1, ReadValue(rids[0], reader));
+  ASSERT_EQ(2, ReadValue(rids[1], reader));
+  ASSERT_EQ(-1, ReadValue(inserted.GetRowId(), reader));
+  int num_rows;
+  ASSERT_EQ(1 + 2 + 3, ScanSum(reader, &num_rows));
+  ASSERT_EQ(3, num_rows);
+  ASSERT_EQ(10 + 3 + 4, ScanSum(writer, &num_rows));
+  ASSERT_EQ(3, num_rows);
+
+  // the reader keeps its snapshot after the commit, a later transaction sees the changes
+  txn_manager_->Commit(writer);
+  ASSERT_EQ(1 + 2 + 3, ScanSum(reader, &num_rows));
+  Transaction *later = txn_manager_->Begin();
+  ASSERT_EQ(10 + 3 + 4, ScanSum(later, &num_rows));
+  ASSERT_EQ(-1, ReadValue(rids[1], later));
+
+  // the versions are kept as long as the reader runs
+  txn_manager_->CollectGarbage();
+  ASSERT_LT(0, txn_manager_->GetVersionStore()->GetNumChains());
+  ASSERT_EQ(2, ReadValue(rids[1], reader));
+  txn_manager_->Commit(reader);
+  txn_manager_->Commit(later);
+  txn_manager_->CollectGarbage();
+  ASSERT_EQ(0, txn_manager_->GetVersionStore()->GetNumChains());
+  // the deleted tuple is gone from the page
+  auto page = reinterpret_cast<TablePage *>(bpm_->FetchPage(rids[1].GetPageId()));
+  ASSERT_FALSE(page->IsMarkedDeleted(rids[1].GetSlotNum()));
+  bpm_->UnpinPage(rids[1].GetPageId(), false);
+  ASSERT_EQ(10 + 3 + 4, ScanSum(nullptr, &num_rows));
+}
+
+TEST_F(VersionStoreTest, ConflictTest) {
+  auto rids = InsertRows(2);
+  Transaction *first = txn_manager_->Begin();
+  Transaction *second = txn_manager_->Begin();
+  Row first_row = MakeRow(1, 10);
+  ASSERT_TRUE(table_heap_->UpdateTuple(first_row, rids[0], first));
+  // the second writer waits for the lock of the first one, and finds the row changed since it started
+  auto update = std::async(std::launch::async, [&] {
+    Row second_row = MakeRow(1, 20);
+    return table_heap_->UpdateTuple(second_row, rids[0], second);
+  });
+  ASSERT_EQ(std::future_status::timeout, update.wait_for(50ms));
+  txn_manager_->Commit(first);
+  ASSERT_FALSE(update.get());
+  ASSERT_EQ(kAborted, second->GetState());
+  txn_manager_->Abort(second);
+
+  // a transaction started after the commit changes the row
+  Transaction *third = txn_manager_->Begin();
+  ASSERT_EQ(10, ReadValue(rids[0], third));
+  ASSERT_TRUE(table_heap_->MarkDelete(rids[0], third));
+  txn_manager_->Commit(third);
+  ASSERT_EQ(-1, ReadValue(rids[0], nullptr));
+  ASSERT_EQ(2, ReadValue(rids[1], nullptr));
+}
+
+TEST_F(VersionStoreTest, AbortTest) {
+  auto rids = InsertRows(2);
+  Transaction *writer = txn_manager_->Begin();
+  Row updated = MakeRow(1, 10);
+  ASSERT_TRUE(table_heap_->UpdateTuple(updated, rids[0], writer));
+  Row updated_again = MakeRow(1, 11);
+  ASSERT_TRUE(table_heap_->UpdateTuple(updated_again, rids[0], writer));
+  ASSERT_TRUE(table_heap_->MarkDelete(rids[1], writer));
+  Transaction *reader = txn_manager_->Begin();
+  ASSERT_EQ(1, ReadValue(rids[0], reader));
+  txn_manager_->Abort(writer);
+
+  // the rows are back, and nobody needs an older version of them
+  ASSERT_EQ(0, txn_manager_->GetVersionStore()->GetNumChains());
+  ASSERT_EQ(1, ReadValue(rids[0], reader));
+  ASSERT_EQ(2, ReadValue(rids[1], reader));
+  int num_rows;
+  ASSERT_EQ(1 + 2, ScanSum(reader, &num_rows));
+  txn_manager_->Commit(reader);
+  // the aborted changes left no trace for the next writer
+  Transaction *next = txn_manager_->Begin();
+  Row next_row = MakeRow(1, 12);
+  ASSERT_TRUE(table_heap_->UpdateTuple(next_row, rids[0], next));
+  txn_manager_->Commit(next);
+  ASSERT_EQ(12 + 2, ScanSum(nullptr, &num_rows));
+}
+
+TEST_F(VersionStoreTest, GarbageCollectionThreadTest) {
+  auto rids = InsertRows(1);
+  txn_manager_->RunGarbageCollectionThread();
+  // the versions of the updates are collected in the background once enough transactions have ended, the one
+  // inserting the row being the first
+  for (int i = 0; i < VERSION_GC_INTERVAL - 1; i++) {
+    Transaction *txn = txn_manager_->Begin();
+    Row row = MakeRow(1, i);
+    ASSERT_TRUE(table_heap_->UpdateTuple(row, rids[0], txn));
+    txn_manager_->Commit(txn);
+  }
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (txn_manager_->GetVersionStore()->GetNumChains() != 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  ASSERT_EQ(0, txn_manager_->GetVersionStore()->GetNumChains());
+  txn_manager_->StopGarbageCollectionThread();
+  ASSERT_EQ(VERSION_GC_INTERVAL - 2, ReadValue(rids[0], nullptr));
+}
+
+TEST_F(VersionStoreTest, IndexMayMissRowsTest) {
+  auto rids = InsertRows(2);
+  Transaction *reader = txn_manager_->Begin();
+  ASSERT_FALSE(table_heap_->IndexMayMissRows(reader));
+  // the index entries of a deleted row are removed at once, the reader has to scan the table for it
+  Transaction *writer = txn_manager_->Begin();
+  ASSERT_TRUE(table_heap_->MarkDelete(rids[0], writer));
+  ASSERT_TRUE(table_heap_->IndexMayMissRows(reader));
+  txn_manager_->Commit(writer);
+  ASSERT_TRUE(table_heap_->IndexMayMissRows(reader));
+  txn_manager_->Commit(reader);
+  txn_manager_->CollectGarbage();
+  Transaction *later = txn_manager_->Begin();
+  ASSERT_FALSE(table_heap_->IndexMayMissRows(later));
+  txn_manager_->Commit(later);
+
+  // an aborted delete leaves nothing to miss
+  Transaction *aborted = txn_manager_->Begin();
+  ASSERT_TRUE(table_heap_->MarkDelete(rids[1], aborted));
+  txn_manager_->Abort(aborted);
+  Transaction *next = txn_manager_->Begin();
+  ASSERT_FALSE(table_heap_->IndexMayMissRows(next));
+  txn_manager_->Commit(next);
+}